@@ -0,0 +1,837 @@
+#include "BatchReader.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define NOVELREADER_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+
+namespace {
+    constexpr size_t MAX_QUEUE_DEPTH = 256;
+    constexpr size_t THREAD_POOL_SIZE = 16;          // Helper tasks at most, if the scheduler has the workers
+    constexpr size_t MAX_READ_CHUNK = 1u << 30;      // Larger ranges are read in several requests
+#ifdef __linux__
+    constexpr int IOPRIO_WHO_PROCESS = 1;            // With who = 0: the calling thread
+    constexpr uint16_t IDLE_IO_PRIORITY = 3 << 13;   // IOPRIO_CLASS_IDLE: served only when the disk is otherwise idle
+#endif
+
+    enum class Backend {
+        CompletionPort,
+        IoUring,
+        ThreadPool
+    };
+
+    // Start and length of the part of a fileSize-byte file that request covers
+    void ClampRange(const BatchReader::Request& request, uint64_t fileSize, uint64_t& start, uint64_t& length) {
+        start = std::min(request.offset, fileSize);
+        length = std::min(request.length, fileSize - start);
+    }
+
+#ifdef __linux__
+    // Background reads hand their pages straight back. Pages someone has mapped (the chapter
+    // being read) are left alone by the kernel.
+    void ReleaseCachedPages(int fd) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    void ReleaseCachedPages(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        ReleaseCachedPages(fd);
+        ::close(fd);
+    }
+#endif
+
+    bool ReadRangeBlocking(const BatchReader::Request& request, std::string& data) {
+        std::ifstream file(std::filesystem::path(request.path), std::ios::binary);
+        if (!file.is_open()) return false;
+
+        file.seekg(0, std::ios::end);
+        std::streamoff fileSize = file.tellg();
+        if (fileSize < 0) return false;
+
+        uint64_t start = 0, length = 0;
+        ClampRange(request, static_cast<uint64_t>(fileSize), start, length);
+        data.resize(static_cast<size_t>(length));
+        file.seekg(static_cast<std::streamoff>(start), std::ios::beg);
+        file.read(data.data(), static_cast<std::streamsize>(length));
+        data.resize(static_cast<size_t>(file.gcount()));   // Shorter if the file shrank meanwhile
+        return true;
+    }
+
+    // ============================================================================
+    // Thread pool (everywhere)
+    // ============================================================================
+
+    // Background I/O priority for the calling thread until the scope ends. The pool's readers
+    // run on shared scheduler workers, so they can't keep it the way a thread of their own could.
+    class BackgroundIoScope {
+    public:
+        explicit BackgroundIoScope(bool enabled) : enabled(enabled) {
+            if (!enabled) return;
+#if defined(_WIN32)
+            SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+            previous = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+            syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IDLE_IO_PRIORITY);
+#endif
+        }
+
+        ~BackgroundIoScope() {
+            if (!enabled) return;
+#if defined(_WIN32)
+            SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+#elif defined(__linux__)
+            if (previous >= 0) syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, previous);
+#endif
+        }
+
+        BackgroundIoScope(const BackgroundIoScope&) = delete;
+        BackgroundIoScope& operator=(const BackgroundIoScope&) = delete;
+
+    private:
+        bool enabled;
+        long previous = -1;
+    };
+
+    // Blocking reads by the calling thread plus helper tasks on the shared scheduler. The caller
+    // reads whenever nothing is ready, so the batch completes even when no worker is free.
+    // Helpers never wait on the caller: when it falls behind they give their worker back, and
+    // the caller posts them again once it has caught up.
+    size_t ReadWithThreadPool(const std::vector<BatchReader::Request>& requests, const BatchReader::Completion& onComplete,
+        size_t queueDepth, BatchReader::Priority priority) {
+        bool background = priority == BatchReader::Priority::Background;
+        struct Completed {
+            size_t index = 0;
+            bool ok = false;
+            std::string data;
+        };
+
+        std::atomic<size_t> next{ 0 };
+        std::mutex mutex;
+        std::condition_variable readyChanged;
+        std::deque<Completed> ready;   // About queueDepth at most, so a slow consumer doesn't buffer the whole batch
+        size_t helpersPosted = 0;      // Guarded by mutex; queued or running
+
+        auto read = [&](size_t index, Completed& completed) {
+            completed.index = index;
+            completed.ok = ReadRangeBlocking(requests[index], completed.data);
+            if (!completed.ok) completed.data.clear();
+#ifdef __linux__
+            if (background && completed.ok) ReleaseCachedPages(requests[index].path);
+#endif
+        };
+
+        auto helperLoop = [&]() {
+            BackgroundIoScope backgroundIo(background);
+
+            while (true) {
+                size_t index = requests.size();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (ready.size() < queueDepth) index = next.fetch_add(1);
+                    if (index >= requests.size()) {
+                        helpersPosted--;
+                        return;
+                    }
+                }
+
+                Completed completed;
+                read(index, completed);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready.push_back(std::move(completed));
+                }
+                readyChanged.notify_all();
+            }
+        };
+
+        TaskScheduler& scheduler = TaskScheduler::Shared();
+        TaskScheduler::Priority lane = background ? TaskScheduler::Priority::Background : TaskScheduler::Priority::Prefetch;
+        size_t helperCount = std::min({ queueDepth, THREAD_POOL_SIZE, scheduler.WorkerCount(), requests.size() });
+        TaskScheduler::TaskGroup helpers;
+        auto postHelpers = [&]() {   // Caller holds mutex
+            while (helpersPosted < helperCount) {
+                helpersPosted++;
+                scheduler.Post(helpers, [&helperLoop] { helperLoop(); }, lane);
+            }
+        };
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            postHelpers();
+        }
+
+        size_t succeeded = 0;
+        for (size_t done = 0; done < requests.size(); done++) {
+            Completed completed;
+            bool taken = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ready.empty()) {
+                    completed = std::move(ready.front());
+                    ready.pop_front();
+                    taken = true;
+                    if (ready.size() < queueDepth / 2 && next.load() < requests.size()) postHelpers();
+                }
+            }
+            if (!taken) {
+                size_t index = next.fetch_add(1);
+                if (index < requests.size()) {
+                    read(index, completed);
+                }
+                else {
+                    // Everything is claimed; the rest is being read by helpers
+                    std::unique_lock<std::mutex> lock(mutex);
+                    readyChanged.wait(lock, [&]() { return !ready.empty(); });
+                    completed = std::move(ready.front());
+                    ready.pop_front();
+                }
+            }
+
+            succeeded += completed.ok;
+            onComplete(completed.index, completed.ok, completed.data);
+        }
+
+        // Helpers still queued have nothing left to read
+        helpers.Close();
+        return succeeded;
+    }
+
+#ifdef _WIN32
+    // ============================================================================
+    // I/O completion port (Windows)
+    // ============================================================================
+    struct PortSlot {
+        OVERLAPPED overlapped{};   // A completion's OVERLAPPED* leads back to its slot
+        HANDLE file = INVALID_HANDLE_VALUE;
+        size_t index = 0;
+        uint64_t offset = 0;       // File offset of data[0]
+        size_t filled = 0;
+        std::string data;
+    };
+
+    bool IssueRead(PortSlot& slot) {
+        uint64_t at = slot.offset + slot.filled;
+        slot.overlapped = OVERLAPPED{};
+        slot.overlapped.Offset = static_cast<DWORD>(at & 0xFFFFFFFFu);
+        slot.overlapped.OffsetHigh = static_cast<DWORD>(at >> 32);
+        DWORD chunk = static_cast<DWORD>(std::min(slot.data.size() - slot.filled, MAX_READ_CHUNK));
+        if (ReadFile(slot.file, slot.data.data() + slot.filled, chunk, nullptr, &slot.overlapped)) return true;
+        return GetLastError() == ERROR_IO_PENDING;   // Either way the result arrives through the port
+    }
+
+    // Returns false only if the port could not be created, before anything was read
+    bool ReadWithCompletionPort(const std::vector<BatchReader::Request>& requests, const BatchReader::Completion& onComplete,
+        size_t queueDepth, BatchReader::Priority priority, size_t& succeeded) {
+        HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        if (!port) return false;
+
+        std::vector<PortSlot> slots(queueDepth);
+        std::vector<size_t> freeSlots;
+        for (size_t i = queueDepth; i > 0; i--) freeSlots.push_back(i - 1);
+
+        succeeded = 0;
+        auto complete = [&](size_t index, bool ok, std::string& data) {
+            if (!ok) data.clear();
+            succeeded += ok;
+            onComplete(index, ok, data);
+        };
+        auto finish = [&](size_t slotIndex, bool ok) {
+            PortSlot& slot = slots[slotIndex];
+            CloseHandle(slot.file);
+            slot.file = INVALID_HANDLE_VALUE;
+            slot.data.resize(slot.filled);
+            complete(slot.index, ok, slot.data);
+            slot.data = std::string();
+            freeSlots.push_back(slotIndex);
+        };
+
+        size_t next = 0;
+        size_t inFlight = 0;
+        while (next < requests.size() || inFlight > 0) {
+            while (next < requests.size() && !freeSlots.empty()) {
+                size_t index = next++;
+                std::string empty;
+
+                // Opening stays synchronous; only the reads go through the port
+                HANDLE file = CreateFileW(std::filesystem::path(requests[index].path).c_str(), GENERIC_READ,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+                if (file == INVALID_HANDLE_VALUE) {
+                    complete(index, false, empty);
+                    continue;
+                }
+                if (priority == BatchReader::Priority::Background) {
+                    FILE_IO_PRIORITY_HINT_INFO hint{};
+                    hint.PriorityHint = IoPriorityHintVeryLow;
+                    SetFileInformationByHandle(file, FileIoPriorityHintInfo, &hint, sizeof(hint));
+                }
+
+                LARGE_INTEGER fileSize;
+                uint64_t start = 0, length = 0;
+                if (!GetFileSizeEx(file, &fileSize)) {
+                    CloseHandle(file);
+                    complete(index, false, empty);
+                    continue;
+                }
+                ClampRange(requests[index], static_cast<uint64_t>(fileSize.QuadPart), start, length);
+                if (length == 0) {
+                    CloseHandle(file);
+                    complete(index, true, empty);
+                    continue;
+                }
+                if (!CreateIoCompletionPort(file, port, 0, 0)) {
+                    CloseHandle(file);
+                    complete(index, false, empty);
+                    continue;
+                }
+
+                size_t slotIndex = freeSlots.back();
+                freeSlots.pop_back();
+                PortSlot& slot = slots[slotIndex];
+                slot.file = file;
+                slot.index = index;
+                slot.offset = start;
+                slot.filled = 0;
+                slot.data.resize(static_cast<size_t>(length));
+                if (!IssueRead(slot)) {
+                    finish(slotIndex, false);
+                    continue;
+                }
+                inFlight++;
+            }
+            if (inFlight == 0) continue;
+
+            OVERLAPPED_ENTRY entries[64];
+            ULONG count = 0;
+            if (!GetQueuedCompletionStatusEx(port, entries, 64, &count, INFINITE, FALSE)) continue;
+
+            for (ULONG e = 0; e < count; e++) {
+                size_t slotIndex = CONTAINING_RECORD(entries[e].lpOverlapped, PortSlot, overlapped) - slots.data();
+                PortSlot& slot = slots[slotIndex];
+
+                DWORD transferred = 0;
+                if (!GetOverlappedResult(slot.file, &slot.overlapped, &transferred, FALSE)) {
+                    inFlight--;
+                    finish(slotIndex, GetLastError() == ERROR_HANDLE_EOF);   // EOF: the file shrank
+                    continue;
+                }
+
+                slot.filled += transferred;
+                if (transferred > 0 && slot.filled < slot.data.size()) {
+                    if (IssueRead(slot)) continue;   // Still in flight
+                    inFlight--;
+                    finish(slotIndex, false);
+                    continue;
+                }
+                inFlight--;
+                finish(slotIndex, true);
+            }
+        }
+
+        CloseHandle(port);
+        return true;
+    }
+#endif
+
+#ifdef NOVELREADER_IO_URING
+    // ============================================================================
+    // io_uring (Linux)
+    // ============================================================================
+    // The rings are driven through the raw system calls, so there is no liburing to ship
+    class IoRing {
+    public:
+        IoRing() = default;
+        ~IoRing() { Close(); }
+
+        IoRing(const IoRing&) = delete;
+        IoRing& operator=(const IoRing&) = delete;
+
+        bool Setup(unsigned entries) {
+            io_uring_params params{};
+            int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) return false;
+            ringFd = fd;
+
+            sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+            sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+            if (sqRing == MAP_FAILED) {
+                sqRing = nullptr;
+                Close();
+                return false;
+            }
+            if (singleMap) {
+                cqRing = sqRing;
+            }
+            else {
+                cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+                if (cqRing == MAP_FAILED) {
+                    cqRing = nullptr;
+                    Close();
+                    return false;
+                }
+            }
+            sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqesMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+            if (sqesMap == MAP_FAILED) {
+                Close();
+                return false;
+            }
+            sqes = static_cast<io_uring_sqe*>(sqesMap);
+
+            char* sq = static_cast<char*>(sqRing);
+            sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            sqEntries = params.sq_entries;
+
+            char* cq = static_cast<char*>(cqRing);
+            cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            return true;
+        }
+
+        void Close() {
+            if (sqes) munmap(sqes, sqesSize);
+            if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+            if (sqRing) munmap(sqRing, sqRingSize);
+            if (ringFd >= 0) ::close(ringFd);
+            sqes = nullptr;
+            sqRing = cqRing = nullptr;
+            ringFd = -1;
+        }
+
+        unsigned Capacity() const { return sqEntries; }
+
+        // Queues a vectored read; false if the submission queue is full
+        bool QueueRead(int fd, const iovec* buffer, uint64_t offset, uint16_t ioPriority, uint64_t userData) {
+            unsigned tail = *sqTail;   // Only this thread writes the tail
+            if (tail - std::atomic_ref<unsigned>(*sqHead).load(std::memory_order_acquire) >= sqEntries) return false;
+
+            unsigned slot = tail & sqMask;
+            io_uring_sqe& sqe = sqes[slot];
+            sqe = io_uring_sqe{};
+            sqe.opcode = IORING_OP_READV;   // Plain READ needs 5.6; READV works on every io_uring kernel
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<uint64_t>(buffer);
+            sqe.len = 1;
+            sqe.off = offset;
+            sqe.ioprio = ioPriority;
+            sqe.user_data = userData;
+            sqArray[slot] = slot;
+
+            std::atomic_ref<unsigned>(*sqTail).store(tail + 1, std::memory_order_release);
+            unsubmitted++;
+            return true;
+        }
+
+        // Submits everything queued, then waits until at least one completion is ready
+        bool SubmitAndWait() {
+            while (true) {
+                int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, unsubmitted, 1u,
+                    IORING_ENTER_GETEVENTS, nullptr, 0));
+                if (submitted >= 0) {
+                    unsubmitted -= std::min<unsigned>(unsubmitted, static_cast<unsigned>(submitted));
+                    return true;
+                }
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY) return false;
+                if (HasCompletion()) return true;   // EBUSY: drain completions before submitting more
+            }
+        }
+
+        bool HasCompletion() const {
+            return std::atomic_ref<unsigned>(*cqHead).load(std::memory_order_relaxed) !=
+                std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire);
+        }
+
+        // Calls handle(userData, result) for every completion ready
+        template <typename Handler>
+        void Reap(Handler handle) {
+            unsigned head = std::atomic_ref<unsigned>(*cqHead).load(std::memory_order_relaxed);
+            unsigned tail = std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire);
+            for (; head != tail; head++) {
+                const io_uring_cqe& cqe = cqes[head & cqMask];
+                uint64_t userData = cqe.user_data;
+                int result = cqe.res;
+                std::atomic_ref<unsigned>(*cqHead).store(head + 1, std::memory_order_release);
+                handle(userData, result);
+            }
+        }
+
+    private:
+        int ringFd = -1;
+        void* sqRing = nullptr;
+        void* cqRing = nullptr;
+        size_t sqRingSize = 0;
+        size_t cqRingSize = 0;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqesSize = 0;
+
+        unsigned* sqHead = nullptr;
+        unsigned* sqTail = nullptr;
+        unsigned* sqArray = nullptr;
+        unsigned sqMask = 0;
+        unsigned sqEntries = 0;
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned cqMask = 0;
+        io_uring_cqe* cqes = nullptr;
+
+        unsigned unsubmitted = 0;
+    };
+
+    struct RingSlot {
+        int fd = -1;
+        size_t index = 0;
+        uint64_t offset = 0;   // File offset of data[0]
+        size_t filled = 0;
+        std::string data;
+        iovec buffer{};        // Read by the kernel until the read completes
+    };
+
+    // Finishes a read with pread, for completions the ring could not deliver
+    bool FinishWithPread(RingSlot& slot) {
+        while (slot.filled < slot.data.size()) {
+            ssize_t got = pread(slot.fd, slot.data.data() + slot.filled, slot.data.size() - slot.filled,
+                static_cast<off_t>(slot.offset + slot.filled));
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) return false;
+            if (got == 0) break;
+            slot.filled += static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    // Returns false only if no ring could be set up, before anything was read
+    bool ReadWithIoRing(const std::vector<BatchReader::Request>& requests, const BatchReader::Completion& onComplete,
+        size_t queueDepth, BatchReader::Priority priority, size_t& succeeded) {
+        bool background = priority == BatchReader::Priority::Background;
+        auto ring = std::make_unique<IoRing>();
+        if (!ring->Setup(static_cast<unsigned>(queueDepth))) return false;
+        queueDepth = std::min<size_t>(queueDepth, ring->Capacity());   // Never more in flight than SQ entries, so the CQ can't overflow
+
+        auto slots = std::make_unique<RingSlot[]>(queueDepth);
+        std::vector<size_t> freeSlots;
+        for (size_t i = queueDepth; i > 0; i--) freeSlots.push_back(i - 1);
+
+        succeeded = 0;
+        auto complete = [&](size_t index, bool ok, std::string& data) {
+            if (!ok) data.clear();
+            succeeded += ok;
+            onComplete(index, ok, data);
+        };
+        auto finish = [&](size_t slotIndex, bool ok) {
+            RingSlot& slot = slots[slotIndex];
+            if (background) ReleaseCachedPages(slot.fd);
+            ::close(slot.fd);
+            slot.fd = -1;
+            slot.data.resize(slot.filled);
+            complete(slot.index, ok, slot.data);
+            slot.data = std::string();
+            freeSlots.push_back(slotIndex);
+        };
+        auto queueRead = [&](size_t slotIndex) {
+            RingSlot& slot = slots[slotIndex];
+            slot.buffer.iov_base = slot.data.data() + slot.filled;
+            slot.buffer.iov_len = std::min(slot.data.size() - slot.filled, MAX_READ_CHUNK);
+            return ring->QueueRead(slot.fd, &slot.buffer, slot.offset + slot.filled,
+                background ? IDLE_IO_PRIORITY : 0, slotIndex);
+        };
+
+        size_t next = 0;
+        size_t inFlight = 0;
+        while (next < requests.size() || inFlight > 0) {
+            while (next < requests.size() && !freeSlots.empty()) {
+                size_t index = next++;
+                std::string empty;
+
+                // Opening stays synchronous; only the reads go through the ring
+                int fd = ::open(requests[index].path.c_str(), O_RDONLY | O_CLOEXEC);
+                struct stat fileStat;
+                if (fd < 0 || fstat(fd, &fileStat) != 0) {
+                    if (fd >= 0) ::close(fd);
+                    complete(index, false, empty);
+                    continue;
+                }
+
+                uint64_t start = 0, length = 0;
+                ClampRange(requests[index], static_cast<uint64_t>(fileStat.st_size), start, length);
+                if (length == 0) {
+                    ::close(fd);
+                    complete(index, true, empty);
+                    continue;
+                }
+
+                size_t slotIndex = freeSlots.back();
+                freeSlots.pop_back();
+                RingSlot& slot = slots[slotIndex];
+                slot.fd = fd;
+                slot.index = index;
+                slot.offset = start;
+                slot.filled = 0;
+                slot.data.resize(static_cast<size_t>(length));
+                if (!queueRead(slotIndex)) {
+                    finish(slotIndex, FinishWithPread(slot));
+                    continue;
+                }
+                inFlight++;
+            }
+            if (inFlight == 0) continue;
+
+            if (!ring->SubmitAndWait()) {
+                // Reads already submitted may still land in their buffers, so the slots are left
+                // to them for good and everything outstanding is read again the slow way
+                std::cout << "io_uring submission failed (errno " << errno << "), finishing with blocking reads" << std::endl;
+                RingSlot* abandoned = slots.release();
+                for (size_t i = 0; i < queueDepth; i++) {
+                    if (abandoned[i].fd < 0) continue;
+                    std::string data;
+                    bool ok = ReadRangeBlocking(requests[abandoned[i].index], data);
+                    complete(abandoned[i].index, ok, data);
+                }
+                for (; next < requests.size(); next++) {
+                    std::string data;
+                    bool ok = ReadRangeBlocking(requests[next], data);
+                    complete(next, ok, data);
+                }
+                return true;
+            }
+
+            ring->Reap([&](uint64_t slotIndex, int result) {
+                RingSlot& slot = slots[slotIndex];
+                if ((result == -EINTR || result == -EAGAIN) && queueRead(slotIndex)) return;
+                if (result < 0) {
+                    inFlight--;
+                    finish(slotIndex, FinishWithPread(slot));
+                    return;
+                }
+
+                slot.filled += static_cast<size_t>(result);
+                if (result > 0 && slot.filled < slot.data.size()) {
+                    if (queueRead(slotIndex)) return;   // Short read, still in flight
+                    inFlight--;
+                    finish(slotIndex, FinishWithPread(slot));
+                    return;
+                }
+                inFlight--;
+                finish(slotIndex, true);   // Done, or EOF because the file shrank
+            });
+        }
+        return true;
+    }
+
+    bool IoRingAvailable() {
+        static const bool available = []() {
+            IoRing probe;
+            return probe.Setup(2);
+        }();
+        return available;
+    }
+#endif
+
+    Backend PlatformBackend() {
+#if defined(_WIN32)
+        return Backend::CompletionPort;
+#elif defined(NOVELREADER_IO_URING)
+        return IoRingAvailable() ? Backend::IoUring : Backend::ThreadPool;
+#else
+        return Backend::ThreadPool;
+#endif
+    }
+
+    size_t ReadWith(Backend backend, const std::vector<BatchReader::Request>& requests,
+        const BatchReader::Completion& onComplete, size_t queueDepth,
+        BatchReader::Priority priority = BatchReader::Priority::Normal) {
+        if (requests.empty()) return 0;
+        queueDepth = std::clamp<size_t>(queueDepth, 1, MAX_QUEUE_DEPTH);
+
+        size_t succeeded = 0;
+#ifdef _WIN32
+        if (backend == Backend::CompletionPort && ReadWithCompletionPort(requests, onComplete, queueDepth, priority, succeeded)) {
+            return succeeded;
+        }
+#endif
+#ifdef NOVELREADER_IO_URING
+        if (backend == Backend::IoUring && ReadWithIoRing(requests, onComplete, queueDepth, priority, succeeded)) {
+            return succeeded;
+        }
+#endif
+        return ReadWithThreadPool(requests, onComplete, queueDepth, priority);
+    }
+}
+
+size_t BatchReader::ReadBatch(const std::vector<Request>& requests, const Completion& onComplete, size_t queueDepth,
+    Priority priority) {
+    return ReadWith(PlatformBackend(), requests, onComplete, queueDepth, priority);
+}
+
+void BatchReader::EnterBackgroundMode() {
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IDLE_IO_PRIORITY);
+#endif
+}
+
+std::vector<BatchReader::Request> BatchReader::WholeFiles(const std::vector<std::string>& paths) {
+    std::vector<Request> requests;
+    requests.reserve(paths.size());
+    for (const std::string& path : paths) {
+        Request request;
+        request.path = path;
+        requests.push_back(std::move(request));
+    }
+    return requests;
+}
+
+const char* BatchReader::BackendName() {
+    switch (PlatformBackend()) {
+    case Backend::CompletionPort: return "IOCP";
+    case Backend::IoUring: return "io_uring";
+    default: return "thread pool";
+    }
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+namespace {
+    bool IsChapterPath(const std::filesystem::path& path) {
+        return path.extension() == ".json" && path.stem().string().rfind("chapter", 0) == 0;
+    }
+
+    std::vector<std::string> ListChapters(const std::string& novelsRoot) {
+        std::vector<std::string> paths;
+        std::error_code ec;
+        for (const auto& novelEntry : std::filesystem::directory_iterator(novelsRoot, ec)) {
+            for (const auto& entry : std::filesystem::directory_iterator(novelEntry.path() / "chapters", ec)) {
+                if (IsChapterPath(entry.path())) paths.push_back(entry.path().string());
+            }
+        }
+        return paths;
+    }
+
+    // Evicts a file from the page cache so the next read goes to the disk
+    void DropFromCache(const std::string& path) {
+#if defined(_WIN32)
+        // Opening without buffering makes the cache manager flush and purge the file's pages
+        // (best effort: other open handles or mappings keep them alive)
+        HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#elif defined(__linux__)
+        ReleaseCachedPages(path);
+#else
+        (void)path;
+#endif
+    }
+
+    void DropLibraryFromCache(const std::vector<std::string>& paths) {
+#ifndef _WIN32
+        sync();   // Dirty pages can't be dropped
+#endif
+        for (const std::string& path : paths) DropFromCache(path);
+    }
+}
+
+void BatchReader::RunBenchmark(const std::string& novelsRoot, int passes) {
+    std::vector<std::string> paths = ListChapters(novelsRoot);
+    if (paths.empty()) {
+        std::cout << "No chapters found under " << novelsRoot << std::endl;
+        return;
+    }
+    passes = std::max(1, passes);
+    std::cout << paths.size() << " chapter files, platform backend: " << BackendName() << std::endl;
+
+    struct Result {
+        size_t files = 0;
+        uint64_t bytes = 0;
+    };
+
+    // What bulk passes did before: walk the folders and read each file in turn
+    auto ifstreamLoop = [&]() {
+        Result result;
+        std::error_code ec;
+        for (const auto& novelEntry : std::filesystem::directory_iterator(novelsRoot, ec)) {
+            for (const auto& entry : std::filesystem::directory_iterator(novelEntry.path() / "chapters", ec)) {
+                if (!IsChapterPath(entry.path())) continue;
+                std::ifstream file(entry.path(), std::ios::binary);
+                std::stringstream buffer;
+                buffer << file.rdbuf();
+                result.files++;
+                result.bytes += buffer.str().size();
+            }
+        }
+        return result;
+    };
+    auto batched = [&](Backend backend) {
+        Result result;
+        std::vector<Request> requests = WholeFiles(ListChapters(novelsRoot));
+        result.files = ReadWith(backend, requests, [&](size_t, bool, std::string& data) {
+            result.bytes += data.size();
+        }, DEFAULT_QUEUE_DEPTH);
+        return result;
+    };
+
+    std::vector<std::pair<std::string, std::function<Result()>>> modes;
+    modes.push_back({ "ifstream loop", ifstreamLoop });
+    modes.push_back({ "thread pool", [&]() { return batched(Backend::ThreadPool); } });
+    if (PlatformBackend() != Backend::ThreadPool) {
+        modes.push_back({ BackendName(), [&]() { return batched(PlatformBackend()); } });
+    }
+
+    for (bool cold : { true, false }) {
+        std::cout << (cold ? "Cold page cache:" : "Warm page cache:") << std::endl;
+        for (auto& [name, run] : modes) {
+            std::vector<double> times;
+            Result result;
+            for (int pass = 0; pass < passes; pass++) {
+                if (cold) DropLibraryFromCache(paths);
+                else run();   // Warm-up
+
+                auto begin = std::chrono::steady_clock::now();
+                result = run();
+                times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+            }
+            std::sort(times.begin(), times.end());
+            double seconds = times[times.size() / 2];
+            std::cout << "  " << name << ": " << result.files << " files, " << result.bytes / (1024.0 * 1024.0)
+                << " MB in " << seconds * 1000.0 << " ms (" << result.files / seconds << " files/s, "
+                << result.bytes / (1024.0 * 1024.0) / seconds << " MB/s)" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// Reads many small files (or ranges of them) at once, for bulk passes over a library:
+// indexing, dictionary training, integrity checks.
+//
+// Reading thousands of chapters one ifstream at a time leaves the disk idle between
+// requests. Here up to queueDepth reads are in flight together, so the drive and the kernel
+// can reorder and overlap them. The platform's own async I/O is used where there is one:
+// I/O completion ports on Windows, io_uring on Linux. Anywhere else, or if the platform
+// refuses (io_uring is often disabled in containers), the calling thread and a few helper
+// tasks on the shared TaskScheduler do blocking reads instead.
+//
+// Completions are delivered on the calling thread, in completion order rather than
+// request order, and ReadBatch returns once every request has completed.
+//
+// Background batches (the integrity scanner's) ask the disk to serve everything else first:
+// idle I/O class on Linux, a very low I/O priority hint on Windows. They also leave the page
+// cache as they found it, so a pass over the whole library doesn't evict what the reader uses.
+class BatchReader {
+public:
+    static constexpr uint64_t WHOLE_FILE = ~0ull;
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 64;
+
+    enum class Priority {
+        Normal,
+        Background
+    };
+
+    struct Request {
+        std::string path;
+        uint64_t offset = 0;
+        uint64_t length = WHOLE_FILE;   // Clamped to the end of the file
+    };
+
+    // index is the request's position; data holds the bytes read and may be moved from.
+    // ok is false if the file could not be opened or read (data is then empty).
+    using Completion = std::function<void(size_t index, bool ok, std::string& data)>;
+
+    // Returns how many requests were read successfully
+    static size_t ReadBatch(const std::vector<Request>& requests, const Completion& onComplete,
+        size_t queueDepth = DEFAULT_QUEUE_DEPTH, Priority priority = Priority::Normal);
+
+    // Lowers the calling thread's own I/O (and on Windows, CPU) priority for good, for workers
+    // whose every read is background work
+    static void EnterBackgroundMode();
+
+    // Convenience for whole files
+    static std::vector<Request> WholeFiles(const std::vector<std::string>& paths);
+
+    // "IOCP", "io_uring" or "thread pool": what ReadBatch will use in this process
+    static const char* BackendName();
+
+    // Headless benchmark: every chapter under novelsRoot read with a directory_iterator + ifstream
+    // loop vs ReadBatch, with the page cache dropped before each cold pass
+    static void RunBenchmark(const std::string& novelsRoot, int passes);
+};
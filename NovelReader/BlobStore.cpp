@@ -0,0 +1,479 @@
+#include "BlobStore.h"
+#include "MappedFile.h"
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+namespace {
+    // ============================================================================
+    // BLAKE2b (RFC 7693), unkeyed, 16-byte digest
+    // ============================================================================
+    constexpr uint64_t BLAKE2B_IV[8] = {
+        0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull, 0xa54ff53a5f1d36f1ull,
+        0x510e527fade682d1ull, 0x9b05688c2b3e6c1full, 0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull
+    };
+
+    constexpr uint8_t BLAKE2B_SIGMA[12][16] = {
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+        { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+        { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+        { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+        { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+        { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+        { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+        { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+        { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+    };
+
+    constexpr size_t BLAKE2B_BLOCK = 128;
+    constexpr size_t DIGEST_BYTES = 16;
+
+    inline uint64_t RotateRight(uint64_t value, int bits) {
+        return (value >> bits) | (value << (64 - bits));
+    }
+
+    inline uint64_t LoadLittleEndian64(const uint8_t* bytes) {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; i--) value = (value << 8) | bytes[i];
+        return value;
+    }
+
+    void Blake2bCompress(uint64_t h[8], const uint8_t block[BLAKE2B_BLOCK], uint64_t counter, bool last) {
+        uint64_t m[16];
+        for (int i = 0; i < 16; i++) m[i] = LoadLittleEndian64(block + i * 8);
+
+        uint64_t v[16];
+        for (int i = 0; i < 8; i++) {
+            v[i] = h[i];
+            v[i + 8] = BLAKE2B_IV[i];
+        }
+        v[12] ^= counter;   // Inputs stay far below 2^64 bytes, so the counter's high word is 0
+        if (last) v[14] = ~v[14];
+
+        auto mix = [&v](int a, int b, int c, int d, uint64_t x, uint64_t y) {
+            v[a] = v[a] + v[b] + x;
+            v[d] = RotateRight(v[d] ^ v[a], 32);
+            v[c] = v[c] + v[d];
+            v[b] = RotateRight(v[b] ^ v[c], 24);
+            v[a] = v[a] + v[b] + y;
+            v[d] = RotateRight(v[d] ^ v[a], 16);
+            v[c] = v[c] + v[d];
+            v[b] = RotateRight(v[b] ^ v[c], 63);
+        };
+
+        for (int round = 0; round < 12; round++) {
+            const uint8_t* s = BLAKE2B_SIGMA[round];
+            mix(0, 4, 8, 12, m[s[0]], m[s[1]]);
+            mix(1, 5, 9, 13, m[s[2]], m[s[3]]);
+            mix(2, 6, 10, 14, m[s[4]], m[s[5]]);
+            mix(3, 7, 11, 15, m[s[6]], m[s[7]]);
+            mix(0, 5, 10, 15, m[s[8]], m[s[9]]);
+            mix(1, 6, 11, 12, m[s[10]], m[s[11]]);
+            mix(2, 7, 8, 13, m[s[12]], m[s[13]]);
+            mix(3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+
+        for (int i = 0; i < 8; i++) h[i] ^= v[i] ^ v[i + 8];
+    }
+
+    bool WriteWholeFile(const std::filesystem::path& path, std::string_view bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size());
+        return static_cast<bool>(file);
+    }
+
+    bool IsBlobName(const std::string& name) {
+        if (name.size() != DIGEST_BYTES * 2) return false;
+        for (char c : name) {
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+        }
+        return true;
+    }
+}
+
+// ============================================================================
+// Ids
+// ============================================================================
+std::string BlobStore::BlobId::Hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(DIGEST_BYTES * 2, '0');
+    for (size_t i = 0; i < DIGEST_BYTES; i++) {
+        hex[i * 2] = digits[bytes[i] >> 4];
+        hex[i * 2 + 1] = digits[bytes[i] & 0x0F];
+    }
+    return hex;
+}
+
+bool BlobStore::BlobId::FromHex(std::string_view hex, BlobId& id) {
+    if (hex.size() != DIGEST_BYTES * 2) return false;
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < DIGEST_BYTES; i++) {
+        int high = nibble(hex[i * 2]), low = nibble(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) return false;
+        id.bytes[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+BlobStore::BlobId BlobStore::Hash(std::string_view bytes) {
+    uint64_t h[8];
+    std::memcpy(h, BLAKE2B_IV, sizeof(h));
+    h[0] ^= 0x01010000ull ^ DIGEST_BYTES;   // Parameter block: digest length, no key, fanout 1, depth 1
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes.data());
+    size_t remaining = bytes.size();
+    uint64_t counter = 0;
+
+    // The last block (even an empty one) is compressed with the final flag
+    while (remaining > BLAKE2B_BLOCK) {
+        counter += BLAKE2B_BLOCK;
+        Blake2bCompress(h, data, counter, false);
+        data += BLAKE2B_BLOCK;
+        remaining -= BLAKE2B_BLOCK;
+    }
+    uint8_t last[BLAKE2B_BLOCK] = {};
+    if (remaining > 0) std::memcpy(last, data, remaining);
+    counter += remaining;
+    Blake2bCompress(h, last, counter, true);
+
+    BlobId id;
+    for (size_t i = 0; i < DIGEST_BYTES; i++) {
+        id.bytes[i] = static_cast<uint8_t>(h[i / 8] >> (8 * (i % 8)));
+    }
+    return id;
+}
+
+// ============================================================================
+// Store
+// ============================================================================
+BlobStore::BlobStore(std::string root)
+    : root(std::move(root)) {
+}
+
+BlobStore BlobStore::ForChapterFile(const std::string& chapterPath) {
+    std::filesystem::path library = std::filesystem::path(chapterPath).parent_path().parent_path().parent_path();
+    return BlobStore((library / DIRECTORY_NAME).string());
+}
+
+std::string BlobStore::BlobPath(const BlobId& id) const {
+    std::string hex = id.Hex();
+    return (std::filesystem::path(root) / "blobs" / hex.substr(0, 2) / hex).string();
+}
+
+bool BlobStore::Has(const BlobId& id) const {
+    std::error_code ec;
+    return std::filesystem::is_regular_file(BlobPath(id), ec);
+}
+
+size_t BlobStore::References(const BlobId& id) const {
+    std::error_code ec;
+    uintmax_t links = std::filesystem::hard_link_count(BlobPath(id), ec);
+    return (ec || links == 0) ? 0 : static_cast<size_t>(links - 1);
+}
+
+bool BlobStore::LinkEntry(const std::string& blobPath, const std::string& path, uint64_t expectedSize) const {
+    std::error_code ec;
+    if (std::filesystem::file_size(blobPath, ec) != expectedSize || ec) return false;
+    if (std::filesystem::equivalent(blobPath, path, ec)) return true;   // Already an entry of this blob
+
+    // Linked under a temporary name first, so the entry is replaced in one step
+    std::filesystem::path linkPath = path + ".link";
+    std::filesystem::remove(linkPath, ec);
+    std::filesystem::create_hard_link(blobPath, linkPath, ec);
+    if (ec) return false;   // Collected meanwhile, at the link limit, or no links on this volume
+
+    std::filesystem::rename(linkPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(linkPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool BlobStore::Put(const std::string& path, std::string_view bytes, BlobId* id) const {
+    BlobId blobId = Hash(bytes);
+    if (id) *id = blobId;
+
+    std::string blobPath = BlobPath(blobId);
+    if (LinkEntry(blobPath, path, bytes.size())) return true;
+
+    // New content: written beside the entry, named as the blob, then moved into place
+    std::filesystem::path tempPath = path + ".tmp";
+    if (!WriteWholeFile(tempPath, bytes)) {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(blobPath).parent_path(), ec);
+    std::filesystem::create_hard_link(tempPath, blobPath, ec);
+    if (ec && std::filesystem::exists(blobPath) && LinkEntry(blobPath, path, bytes.size())) {
+        // Someone else stored the same bytes in the meantime
+        std::filesystem::remove(tempPath, ec);
+        return true;
+    }
+    // Without a link the entry is just a private file
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool BlobStore::Adopt(const std::string& path, BlobId* id) const {
+    MappedFile file;
+    if (!file.Open(path)) return false;
+    BlobId blobId = Hash(file.View());
+    uint64_t size = file.Size();
+    file.Close();
+    if (id) *id = blobId;
+
+    std::string blobPath = BlobPath(blobId);
+    if (LinkEntry(blobPath, path, size)) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(blobPath).parent_path(), ec);
+    std::filesystem::create_hard_link(path, blobPath, ec);
+    return !ec || LinkEntry(blobPath, path, size);
+}
+
+bool BlobStore::VerifyEntry(const std::string& path) const {
+    MappedFile file;
+    if (!file.Open(path)) return false;
+    std::string blobPath = BlobPath(Hash(file.View()));
+    file.Close();
+
+    std::error_code ec;
+    return std::filesystem::equivalent(blobPath, path, ec);
+}
+
+bool BlobStore::VerifyBlob(const BlobId& id) const {
+    MappedFile file;
+    if (!file.Open(BlobPath(id))) return false;
+    return Hash(file.View()) == id;
+}
+
+bool BlobStore::Evict(const std::string& entryPath) const {
+    // The blob's name is the hash its bytes no longer have, so find it by file identity
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(entryPath, ec);
+    if (ec) return false;
+
+    std::filesystem::path blobsDir = std::filesystem::path(root) / "blobs";
+    for (const auto& shard : std::filesystem::directory_iterator(blobsDir, ec)) {
+        if (!shard.is_directory(ec)) continue;
+
+        for (const auto& entry : std::filesystem::directory_iterator(shard.path(), ec)) {
+            std::error_code statError;
+            if (!IsBlobName(entry.path().filename().string()) ||
+                std::filesystem::file_size(entry.path(), statError) != size ||
+                !std::filesystem::equivalent(entry.path(), entryPath, statError)) {
+                continue;
+            }
+
+            std::cout << "Evicting damaged blob " << entry.path().filename().string() << std::endl;
+            std::error_code removeError;
+            return std::filesystem::remove(entry.path(), removeError);
+        }
+    }
+    return false;
+}
+
+bool BlobStore::SupportsLinks() const {
+    std::error_code ec;
+    std::filesystem::path probe = std::filesystem::path(root) / "link_probe";
+    std::filesystem::path probeLink = std::filesystem::path(root) / "link_probe.link";
+    std::filesystem::create_directories(root, ec);
+    if (!WriteWholeFile(probe, "probe")) return false;
+
+    std::filesystem::remove(probeLink, ec);
+    std::filesystem::create_hard_link(probe, probeLink, ec);
+    bool supported = !ec;
+    std::filesystem::remove(probeLink, ec);
+    std::filesystem::remove(probe, ec);
+    return supported;
+}
+
+BlobStore::Stats BlobStore::CollectGarbage() const {
+    Stats stats;
+    std::error_code ec;
+    std::filesystem::path blobsDir = std::filesystem::path(root) / "blobs";
+    for (const auto& shard : std::filesystem::directory_iterator(blobsDir, ec)) {
+        if (!shard.is_directory(ec)) continue;
+
+        for (const auto& entry : std::filesystem::directory_iterator(shard.path(), ec)) {
+            if (!IsBlobName(entry.path().filename().string())) continue;
+
+            std::error_code statError;
+            uintmax_t links = std::filesystem::hard_link_count(entry.path(), statError);
+            uint64_t size = std::filesystem::file_size(entry.path(), statError);
+            if (statError) continue;
+
+            if (links <= 1) {
+                std::error_code removeError;
+                if (std::filesystem::remove(entry.path(), removeError)) {
+                    stats.collected++;
+                    stats.collectedBytes += size;
+                }
+                continue;
+            }
+
+            stats.blobs++;
+            stats.storedBytes += size;
+            stats.references += static_cast<size_t>(links - 1);
+            stats.referencedBytes += size * (links - 1);
+        }
+    }
+
+    if (stats.collected > 0) {
+        std::cout << "Collected " << stats.collected << " unreferenced blobs (" << stats.collectedBytes / 1024 << " KB)" << std::endl;
+    }
+    return stats;
+}
+
+// ============================================================================
+// Self-test
+// ============================================================================
+bool BlobStore::RunTests(const std::string& workDir) {
+    int failures = 0;
+    auto check = [&failures](bool condition, const std::string& what) {
+        if (!condition) {
+            std::cout << "FAILED: " << what << std::endl;
+            failures++;
+        }
+    };
+
+    // BLAKE2b-128 against hashlib.blake2b(digest_size=16), on both sides of the block boundary
+    auto pattern = [](size_t size, int step) {
+        std::string bytes(size, '\0');
+        for (size_t i = 0; i < size; i++) bytes[i] = static_cast<char>((i * step) & 0xFF);
+        return bytes;
+    };
+    const std::pair<std::string, const char*> vectors[] = {
+        { "", "cae66941d9efbd404e4d88758ea67670" },
+        { "abc", "cf4ab791c62b8d2b2109c90275287816" },
+        { pattern(127, 1), "28b1296c7d4807883de6ee4ec04dcc0a" },
+        { pattern(128, 1), "a74787004ef589e31149183900d0294a" },
+        { pattern(129, 1), "aaf1b0371f6d4ee49ee4fb5ddd9c49ef" },
+        { pattern(256, 1), "c2472c0ac37a8dbdb25f05ada0d82643" },
+        { pattern(1000, 7), "8095a6f38992fefe1c12ac8ec5e70791" },
+    };
+    for (const auto& [bytes, hex] : vectors) {
+        check(Hash(bytes).Hex() == hex, "BLAKE2b-128 of " + std::to_string(bytes.size()) + " bytes");
+    }
+
+    // Ids
+    {
+        BlobId id = Hash("abc");
+        BlobId parsed;
+        std::string upper = id.Hex();
+        for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        check(BlobId::FromHex(id.Hex(), parsed) && parsed == id, "id hex round trip");
+        check(BlobId::FromHex(upper, parsed) && parsed == id, "upper case hex is read");
+        check(!BlobId::FromHex(id.Hex().substr(1), parsed), "short hex is refused");
+        check(!BlobId::FromHex(id.Hex() + "0", parsed), "long hex is refused");
+        check(!BlobId::FromHex("g" + id.Hex().substr(1), parsed), "non-hex digit is refused");
+        check(!(Hash("abc") == Hash("abd")), "different bytes, different ids");
+    }
+
+    std::filesystem::path library = std::filesystem::path(workDir) / "Novels";
+    std::filesystem::path chapters = library / "Novel" / "chapters";
+    std::filesystem::remove_all(workDir);
+    std::filesystem::create_directories(chapters);
+    BlobStore store = ForChapterFile((chapters / "chapter1.json").string());
+    check(std::filesystem::path(store.Root()) == library / DIRECTORY_NAME, "store of a chapter file");
+
+    auto entry = [&](int number) { return (chapters / ("chapter" + std::to_string(number) + ".json")).string(); };
+    auto contents = [](const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    auto same = [](const std::string& a, const std::string& b) {
+        std::error_code ec;
+        return std::filesystem::equivalent(a, b, ec);
+    };
+
+    const std::string first = "{\"content\":\"first\"}";
+    const std::string second = "{\"content\":\"second\"}";
+
+    if (!store.SupportsLinks()) {
+        // Entries are private files: Put must still write them
+        check(store.Put(entry(1), first) && contents(entry(1)) == first, "put without links");
+        std::cout << "Volume can't hard link; link tests skipped" << std::endl;
+    }
+    else {
+        // Identical bytes share one blob
+        BlobId firstId, secondId, id;
+        check(store.Put(entry(1), first, &firstId) && store.Put(entry(2), first, &id) && id == firstId, "put of equal bytes");
+        check(store.Has(firstId) && store.References(firstId) == 2 && same(entry(1), entry(2)) &&
+            same(entry(1), store.BlobPath(firstId)), "equal bytes share one blob");
+        check(contents(entry(2)) == first, "an entry reads its bytes");
+        check(store.VerifyEntry(entry(1)) && store.VerifyBlob(firstId), "fresh entries verify");
+        check(store.Put(entry(1), first) && store.References(firstId) == 2, "putting the same bytes again is a no-op");
+
+        // Rewriting an entry replaces it, and leaves the blob and its other entries alone
+        check(store.Put(entry(2), second, &secondId) && contents(entry(2)) == second && contents(entry(1)) == first,
+            "rewriting an entry");
+        check(store.References(firstId) == 1 && store.References(secondId) == 1, "references follow the rewrite");
+
+        // Files written outside the store become entries
+        std::filesystem::path outside = entry(3);
+        std::ofstream(outside, std::ios::binary) << first;
+        check(store.Adopt(outside.string(), &id) && id == firstId && same(outside.string(), entry(1)) &&
+            store.References(firstId) == 2, "adopting a file with stored bytes links it");
+        std::ofstream(entry(4), std::ios::binary) << "unique bytes";
+        check(store.Adopt(entry(4), &id) && store.Has(id) && same(entry(4), store.BlobPath(id)), "adopting new bytes makes a blob");
+        check(store.Adopt(entry(4)) && store.References(id) == 1, "adopting twice is a no-op");
+
+        // Damage written through one link shows in all of them; eviction lets a fresh blob replace it
+        {
+            std::fstream file(entry(1), std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(2);
+            file.put('X');
+        }
+        check(!store.VerifyEntry(entry(1)) && !store.VerifyEntry(entry(3)) && !store.VerifyBlob(firstId), "damage is detected");
+        check(store.Evict(entry(1)) && !store.Has(firstId), "eviction removes the damaged blob");
+        check(!store.Evict(entry(1)), "nothing left to evict");
+        check(store.Put(entry(1), first, &id) && id == firstId && store.VerifyBlob(firstId) && store.VerifyEntry(entry(1)) &&
+            store.References(firstId) == 1, "the right bytes make a fresh blob");
+        check(contents(entry(3)) != first && !same(entry(1), entry(3)), "other damaged entries keep their own bytes");
+        check(store.Put(entry(3), first) && store.References(firstId) == 2, "a damaged entry is repaired by a put");
+
+        // Collection drops blobs nothing links to and measures the rest
+        std::filesystem::remove(entry(2));
+        std::filesystem::remove(entry(4));
+        Stats stats = store.CollectGarbage();
+        check(stats.collected == 2 && stats.collectedBytes == second.size() + std::string("unique bytes").size(),
+            "unreferenced blobs are collected");
+        check(stats.blobs == 1 && stats.storedBytes == first.size() && stats.references == 2 &&
+            stats.referencedBytes == 2 * first.size(), "store statistics");
+        check(!store.Has(secondId) && store.Has(firstId), "referenced blobs survive collection");
+        check(store.CollectGarbage().collected == 0, "a second collection finds nothing");
+    }
+
+    std::error_code ec;
+    for (const auto& file : std::filesystem::recursive_directory_iterator(workDir, ec)) {
+        std::string extension = file.path().extension().string();
+        check(extension != ".tmp" && extension != ".link", "leftover " + file.path().string());
+    }
+
+    std::filesystem::remove_all(workDir);
+    std::cout << (failures == 0 ? "Blob store tests passed" : "Blob store tests FAILED (" +
+        std::to_string(failures) + ")") << std::endl;
+    return failures == 0;
+}
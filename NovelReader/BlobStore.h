@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Content-addressed store for downloaded bytes: chapter files, manga pages and covers.
+//
+// Every blob is kept once under <root>/blobs/<first two hex digits>/<BLAKE2b-128 in hex>, and
+// the files the rest of the app opens (Novels/<name>/chapters/chapter12.json, Manga/...) are
+// hard links to it. Readers open and map entries exactly as before, a re-download or a mirror
+// with identical bytes costs no space, and the file system's link count is the blob's
+// reference count: deleting a novel's folder drops its references and CollectGarbage removes
+// blobs nothing links to anymore.
+//
+// Entries are never written in place. Rewriting one (a tier move, a fresh download) replaces
+// the directory entry, so the blob and its other entries are untouched. Where a volume can't
+// link (FAT, a blob at the link limit) an entry simply stays a private file.
+// download_manager.py writes entries the same way, with hashlib's blake2b.
+class BlobStore {
+public:
+    static constexpr const char* DIRECTORY_NAME = ".store";   // Inside the library folder (Novels/)
+
+    struct BlobId {
+        uint8_t bytes[16] = {};
+
+        std::string Hex() const;
+        static bool FromHex(std::string_view hex, BlobId& id);
+        bool operator==(const BlobId& other) const = default;
+    };
+
+    struct Stats {
+        size_t blobs = 0;
+        uint64_t storedBytes = 0;       // On disk, once per blob
+        size_t references = 0;          // Entries linked to a blob
+        uint64_t referencedBytes = 0;   // What those entries would take as private files
+        size_t collected = 0;           // Unreferenced blobs removed by the pass
+        uint64_t collectedBytes = 0;
+    };
+
+    explicit BlobStore(std::string root);
+
+    // The store of the library that a chapter file (<library>/<novel>/chapters/<file>) is in
+    static BlobStore ForChapterFile(const std::string& chapterPath);
+
+    static BlobId Hash(std::string_view bytes);
+
+    const std::string& Root() const { return root; }
+    std::string BlobPath(const BlobId& id) const;
+    bool Has(const BlobId& id) const;
+    size_t References(const BlobId& id) const;
+
+    // Writes bytes to path as an entry, replacing whatever was there in one step: linked to the
+    // blob that already holds these bytes, or becoming that blob
+    bool Put(const std::string& path, std::string_view bytes, BlobId* id = nullptr) const;
+
+    // Turns a file written outside the store (an older download) into an entry
+    bool Adopt(const std::string& path, BlobId* id = nullptr) const;
+
+    // An entry is intact when its bytes still hash to the blob it is a link of
+    bool VerifyEntry(const std::string& path) const;
+    bool VerifyBlob(const BlobId& id) const;
+
+    // Drops the blob an entry is a link of from the store, once its bytes no longer match its
+    // name, so later writes of the right bytes make a fresh blob instead of linking to the bad
+    // one. The entry and any other links keep the damaged bytes until they are replaced.
+    bool Evict(const std::string& entryPath) const;
+
+    // Whether the store's volume can hard link at all (creates the store if needed)
+    bool SupportsLinks() const;
+
+    // Removes blobs that no entry links to and measures what is left
+    Stats CollectGarbage() const;
+
+    // Hash test vectors, then entries, rewrites, adoption, damage and eviction, and collection in a
+    // scratch library under workDir; prints failures
+    static bool RunTests(const std::string& workDir);
+
+private:
+    bool LinkEntry(const std::string& blobPath, const std::string& path, uint64_t expectedSize) const;
+
+    std::string root;
+};
@@ -0,0 +1,574 @@
+#include "BookExporter.h"
+#include "ChapterStore.h"
+#include "ZipArchive.h"
+#include "TaskScheduler.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr const char* STYLESHEET =
+        "body { margin: 0 5%; line-height: 1.5; }\n"
+        "h1 { text-align: center; margin: 1.5em 0; }\n"
+        "p { margin: 0 0 0.8em 0; text-align: justify; }\n"
+        "hr { margin: 1.5em 25%; }\n";
+
+    // A chapter on its way from storage to the writer
+    struct Converted {
+        bool ok = false;
+        std::string title;
+        std::string text;             // Markdown and text exports
+        ZipWriter::Prepared entry;    // EPUB exports
+    };
+
+    struct ChapterFile {
+        int number = 0;
+        std::string path;
+    };
+
+    std::string_view Trim(std::string_view text) {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string_view::npos) return {};
+        return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+    }
+
+    std::vector<ChapterFile> ListChapters(const std::filesystem::path& chaptersDir, int first, int last) {
+        std::vector<ChapterFile> chapters;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(chaptersDir, ec)) {
+            std::string stem = entry.path().stem().string();
+            if (entry.path().extension() != ".json" || stem.rfind("chapter", 0) != 0 || stem.size() == 7) continue;
+            if (stem.find_first_not_of("0123456789", 7) != std::string::npos || stem.size() > 16) continue;
+            int number = std::stoi(stem.substr(7));
+            if (number < first || (last > 0 && number > last)) continue;
+            chapters.push_back({ number, entry.path().string() });
+        }
+        std::sort(chapters.begin(), chapters.end(),
+            [](const ChapterFile& a, const ChapterFile& b) { return a.number < b.number; });
+        return chapters;
+    }
+
+    // ============================================================================
+    // Conversion
+    // ============================================================================
+    void AppendEscaped(std::string_view text, std::string& out) {
+        for (char c : text) {
+            switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default:
+                // Control characters are not allowed in XML
+                if (static_cast<unsigned char>(c) >= 0x20 || c == '\t' || c == '\n') out += c;
+            }
+        }
+    }
+
+    // The reader's **bold** and *italic* as XHTML tags, or dropped for plain text. A marker
+    // without a partner later on the line is text, as in ChapterManager::ParseInlineFormatting.
+    void AppendInline(std::string_view line, bool xhtml, std::string& out) {
+        std::vector<size_t> open;   // Marker lengths: 2 bold, 1 italic
+        auto tag = [&](size_t kind, bool closing) {
+            if (!xhtml) return;
+            out += closing ? (kind == 2 ? "</strong>" : "</em>") : (kind == 2 ? "<strong>" : "<em>");
+        };
+        auto text = [&](std::string_view part) {
+            if (xhtml) AppendEscaped(part, out);
+            else out += part;
+        };
+
+        size_t textStart = 0;
+        size_t i = 0;
+        while (i < line.size()) {
+            if (line[i] != '*') {
+                i++;
+                continue;
+            }
+            size_t kind = line.compare(i, 2, "**") == 0 ? 2 : 1;
+            auto openAt = std::find(open.begin(), open.end(), kind);
+            if (openAt == open.end() && line.find(kind == 2 ? "**" : "*", i + kind) == std::string_view::npos) {
+                i += kind;
+                continue;
+            }
+
+            text(line.substr(textStart, i - textStart));
+            if (openAt == open.end()) {
+                open.push_back(kind);
+                tag(kind, false);
+            }
+            else {
+                // Tags opened inside this one are closed and reopened so the XHTML stays nested
+                for (auto it = open.rbegin(); it != open.rend() && &*it != &*openAt; ++it) tag(*it, true);
+                tag(kind, true);
+                for (auto it = openAt + 1; it != open.end(); ++it) tag(*it, false);
+                open.erase(openAt);
+            }
+            i += kind;
+            textStart = i;
+        }
+        text(line.substr(textStart));
+        for (auto it = open.rbegin(); it != open.rend(); ++it) tag(*it, true);
+    }
+
+    size_t HeadingLevel(std::string_view line) {
+        size_t level = line.find_first_not_of('#');
+        if (level == 0 || level > 3 || level == std::string_view::npos || line[level] != ' ') return 0;
+        return level;
+    }
+
+    bool IsSceneBreak(std::string_view line) {
+        return line.size() >= 3 && line.find_first_not_of(line[0] == '*' ? "* " : "- ") == std::string_view::npos &&
+            (line[0] == '*' || line[0] == '-');
+    }
+
+    // Calls onLine for every non-empty line of the body, skipping a first line that repeats the title
+    template<typename OnLine>
+    void ForEachLine(std::string_view body, std::string_view title, OnLine onLine) {
+        bool first = true;
+        size_t lineStart = 0;
+        while (lineStart < body.size()) {
+            size_t lineEnd = body.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos) lineEnd = body.size();
+            std::string_view line = Trim(body.substr(lineStart, lineEnd - lineStart));
+            lineStart = lineEnd + 1;
+            if (line.empty()) continue;
+            if (first) {
+                first = false;
+                std::string_view bare = Trim(line.substr(HeadingLevel(line)));
+                if (bare == title) continue;
+            }
+            onLine(line);
+        }
+    }
+
+    std::string ChapterXhtml(std::string_view title, std::string_view body) {
+        std::string out;
+        out.reserve(body.size() + body.size() / 8 + 512);
+        out += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<!DOCTYPE html>\n"
+            "<html xmlns=\"http://www.w3.org/1999/xhtml\" xmlns:epub=\"http://www.idpf.org/2007/ops\">\n<head>\n<title>";
+        AppendEscaped(title, out);
+        out += "</title>\n<link rel=\"stylesheet\" type=\"text/css\" href=\"../style.css\"/>\n</head>\n"
+            "<body>\n<section epub:type=\"chapter\">\n<h1>";
+        AppendEscaped(title, out);
+        out += "</h1>\n";
+
+        bool inList = false;
+        ForEachLine(body, title, [&](std::string_view line) {
+            bool item = (line.starts_with("- ") || line.starts_with("* ")) && !IsSceneBreak(line);
+            if (inList && !item) out += "</ul>\n";
+            if (!inList && item) out += "<ul>\n";
+            inList = item;
+
+            if (size_t level = HeadingLevel(line)) {
+                // h1 is the chapter title
+                std::string tag = "h" + std::to_string(level + 1);
+                out += "<" + tag + ">";
+                AppendInline(Trim(line.substr(level)), true, out);
+                out += "</" + tag + ">\n";
+            }
+            else if (item) {
+                out += "<li>";
+                AppendInline(line.substr(2), true, out);
+                out += "</li>\n";
+            }
+            else if (IsSceneBreak(line)) {
+                out += "<hr/>\n";
+            }
+            else {
+                out += "<p>";
+                AppendInline(line, true, out);
+                out += "</p>\n";
+            }
+        });
+        if (inList) out += "</ul>\n";
+        out += "</section>\n</body>\n</html>\n";
+        return out;
+    }
+
+    std::string ChapterMarkdown(std::string_view title, std::string_view body) {
+        std::string out;
+        out.reserve(body.size() + title.size() + 16);
+        out += "## ";
+        out += title;
+        out += "\n\n";
+        ForEachLine(body, title, [&](std::string_view line) {
+            // One level down: the book title is the only #
+            if (HeadingLevel(line)) out += '#';
+            out += line;
+            out += "\n\n";
+        });
+        out += "\n";
+        return out;
+    }
+
+    std::string ChapterPlainText(std::string_view title, std::string_view body) {
+        std::string out;
+        out.reserve(body.size() + title.size() + 16);
+        out += title;
+        out += "\n\n";
+        ForEachLine(body, title, [&](std::string_view line) {
+            if (size_t level = HeadingLevel(line)) line = Trim(line.substr(level));
+            if (IsSceneBreak(line)) out += "* * *";
+            else AppendInline(line, false, out);
+            out += "\n\n";
+        });
+        out += "\n";
+        return out;
+    }
+
+    // ============================================================================
+    // EPUB parts
+    // ============================================================================
+    struct SpineItem {
+        int number = 0;
+        std::string title;
+    };
+
+    std::string ChapterEntryName(int number) {
+        return "text/chapter" + std::to_string(number) + ".xhtml";
+    }
+
+    const char* ImageMediaType(std::string_view bytes) {
+        if (bytes.starts_with("\x89PNG")) return "image/png";
+        if (bytes.starts_with("GIF8")) return "image/gif";
+        if (bytes.size() > 12 && bytes.substr(8, 4) == "WEBP") return "image/webp";
+        if (bytes.starts_with("\xFF\xD8")) return "image/jpeg";
+        return nullptr;
+    }
+
+    std::string ImageExtension(std::string_view mediaType) {
+        if (mediaType == "image/png") return ".png";
+        if (mediaType == "image/gif") return ".gif";
+        if (mediaType == "image/webp") return ".webp";
+        return ".jpg";
+    }
+
+    std::string ContainerXml() {
+        return "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+            "<container version=\"1.0\" xmlns=\"urn:oasis:names:tc:opendocument:xmlns:container\">\n"
+            "<rootfiles>\n<rootfile full-path=\"OEBPS/content.opf\" media-type=\"application/oebps-package+xml\"/>\n"
+            "</rootfiles>\n</container>\n";
+    }
+
+    std::string NavXhtml(const std::string& title, const std::vector<SpineItem>& spine) {
+        std::string out = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<!DOCTYPE html>\n"
+            "<html xmlns=\"http://www.w3.org/1999/xhtml\" xmlns:epub=\"http://www.idpf.org/2007/ops\">\n<head>\n<title>";
+        AppendEscaped(title, out);
+        out += "</title>\n</head>\n<body>\n<nav epub:type=\"toc\" id=\"toc\">\n<h1>Contents</h1>\n<ol>\n";
+        for (const SpineItem& item : spine) {
+            out += "<li><a href=\"" + ChapterEntryName(item.number) + "\">";
+            AppendEscaped(item.title, out);
+            out += "</a></li>\n";
+        }
+        out += "</ol>\n</nav>\n</body>\n</html>\n";
+        return out;
+    }
+
+    std::string PackageOpf(const BookExporter::Options& options, const std::string& title,
+        const std::vector<SpineItem>& spine, const std::string& coverHref, const char* coverType) {
+        std::time_t now = std::time(nullptr);
+        std::tm utc{};
+#ifdef _WIN32
+        gmtime_s(&utc, &now);
+#else
+        gmtime_r(&now, &utc);
+#endif
+        char modified[32];
+        std::strftime(modified, sizeof(modified), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+        // The same book exported again keeps its identifier, so readers replace rather than duplicate it
+        char identifier[16];
+        snprintf(identifier, sizeof(identifier), "%08x", ZipReader::Crc32(options.author, ZipReader::Crc32(title)));
+
+        std::string out = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+            "<package xmlns=\"http://www.idpf.org/2007/opf\" version=\"3.0\" unique-identifier=\"book-id\">\n"
+            "<metadata xmlns:dc=\"http://purl.org/dc/elements/1.1/\">\n";
+        out += "<dc:identifier id=\"book-id\">novelreader:" + std::string(identifier) + "</dc:identifier>\n<dc:title>";
+        AppendEscaped(title, out);
+        out += "</dc:title>\n";
+        if (!options.author.empty()) {
+            out += "<dc:creator>";
+            AppendEscaped(options.author, out);
+            out += "</dc:creator>\n";
+        }
+        out += "<dc:language>en</dc:language>\n";
+        if (!options.synopsis.empty()) {
+            out += "<dc:description>";
+            AppendEscaped(options.synopsis, out);
+            out += "</dc:description>\n";
+        }
+        out += "<meta property=\"dcterms:modified\">" + std::string(modified) + "</meta>\n";
+        if (coverType) out += "<meta name=\"cover\" content=\"cover-image\"/>\n";
+        out += "</metadata>\n<manifest>\n"
+            "<item id=\"nav\" href=\"nav.xhtml\" media-type=\"application/xhtml+xml\" properties=\"nav\"/>\n"
+            "<item id=\"style\" href=\"style.css\" media-type=\"text/css\"/>\n";
+        if (coverType) {
+            out += "<item id=\"cover-image\" href=\"" + coverHref + "\" media-type=\"" + coverType +
+                "\" properties=\"cover-image\"/>\n";
+        }
+        for (const SpineItem& item : spine) {
+            out += "<item id=\"c" + std::to_string(item.number) + "\" href=\"" + ChapterEntryName(item.number) +
+                "\" media-type=\"application/xhtml+xml\"/>\n";
+        }
+        out += "</manifest>\n<spine>\n";
+        for (const SpineItem& item : spine) {
+            out += "<itemref idref=\"c" + std::to_string(item.number) + "\"/>\n";
+        }
+        out += "</spine>\n</package>\n";
+        return out;
+    }
+
+    // ============================================================================
+    // Pipeline
+    // ============================================================================
+
+    // Runs convert(index, slot) as background tasks on the shared scheduler, never more than
+    // BookExporter::WINDOW indices ahead of the writer, and write(index, slot) for every index
+    // in order on the calling thread
+    void RunOrdered(size_t count, const std::function<void(size_t, Converted&)>& convert,
+        const std::function<void(size_t, Converted&)>& write) {
+        const size_t window = BookExporter::WINDOW;
+        TaskScheduler& scheduler = TaskScheduler::Shared();
+        std::vector<Converted> slots(window);
+        std::vector<TaskScheduler::TaskHandle> handles(window);
+
+        auto submit = [&](size_t index) {
+            Converted& slot = slots[index % window];
+            slot = Converted();
+            handles[index % window] = scheduler.Submit([&convert, &slot, index] { convert(index, slot); });
+        };
+
+        for (size_t index = 0; index < std::min(count, window); index++) {
+            submit(index);
+        }
+        for (size_t index = 0; index < count; index++) {
+            handles[index % window].Wait();
+            Converted converted = std::move(slots[index % window]);
+            if (index + window < count) submit(index + window);
+            write(index, converted);
+        }
+    }
+
+    uint64_t PeakResidentBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+}
+
+const char* BookExporter::Extension(Format format) {
+    switch (format) {
+    case Format::Markdown: return ".md";
+    case Format::Text: return ".txt";
+    default: return ".epub";
+    }
+}
+
+bool BookExporter::Export(const std::string& novelDir, const std::string& outputPath, const Options& options,
+    Result& result, const Progress& progress) {
+    result = Result();
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<ChapterFile> chapters = ListChapters(std::filesystem::path(novelDir) / "chapters",
+        options.firstChapter, options.lastChapter);
+    if (chapters.empty()) {
+        result.error = "No chapters to export in " + novelDir;
+        std::cout << "Export failed: " << result.error << std::endl;
+        return false;
+    }
+    std::string title = options.title.empty() ? std::filesystem::path(novelDir).filename().string() : options.title;
+
+    // Written next to the destination and renamed over it at the end
+    std::string tempPath = outputPath + ".tmp";
+    ZipWriter zip;
+    std::ofstream textFile;
+    bool epub = options.format == Format::Epub;
+    bool opened = epub ? zip.Open(tempPath) : (textFile.open(tempPath, std::ios::binary | std::ios::trunc), textFile.is_open());
+    if (!opened) {
+        result.error = "Could not create " + tempPath;
+        std::cout << "Export failed: " << result.error << std::endl;
+        return false;
+    }
+
+    // Everything that comes before the chapters
+    if (epub) {
+        zip.Add("mimetype", "application/epub+zip", 0);   // First and stored, as EPUB requires
+        zip.Add("META-INF/container.xml", ContainerXml());
+        zip.Add("OEBPS/style.css", STYLESHEET);
+    }
+    else {
+        std::string header;
+        if (options.format == Format::Markdown) {
+            header = "# " + title + "\n\n";
+            if (!options.author.empty()) header += "*" + options.author + "*\n\n";
+            if (!options.synopsis.empty()) header += options.synopsis + "\n\n";
+            header += "---\n\n";
+        }
+        else {
+            header = title + "\n";
+            if (!options.author.empty()) header += "by " + options.author + "\n";
+            header += "\n";
+            if (!options.synopsis.empty()) header += options.synopsis + "\n\n";
+            header += "\n";
+        }
+        textFile << header;
+    }
+
+    std::vector<SpineItem> spine;
+    spine.reserve(chapters.size());
+    RunOrdered(chapters.size(),
+        [&](size_t index, Converted& converted) {
+            ChapterStore::MappedChapter chapter;
+            if (!ChapterStore::OpenChapter(chapters[index].path, chapter)) return;
+            converted.title = std::string(Trim(chapter.Title()));
+            if (converted.title.empty()) converted.title = "Chapter " + std::to_string(chapters[index].number);
+
+            if (epub) {
+                std::string xhtml = ChapterXhtml(converted.title, chapter.Body());
+                converted.entry = ZipWriter::Prepare(xhtml, COMPRESSION_LEVEL);
+            }
+            else if (options.format == Format::Markdown) {
+                converted.text = ChapterMarkdown(converted.title, chapter.Body());
+            }
+            else {
+                converted.text = ChapterPlainText(converted.title, chapter.Body());
+            }
+            converted.ok = true;
+        },
+        [&](size_t index, Converted& converted) {
+            if (!converted.ok) {
+                std::cout << "Export skipped unreadable " << chapters[index].path << std::endl;
+                result.skipped++;
+            }
+            else if (epub) {
+                zip.Add("OEBPS/" + ChapterEntryName(chapters[index].number), converted.entry);
+                spine.push_back({ chapters[index].number, std::move(converted.title) });
+            }
+            else {
+                textFile.write(converted.text.data(), static_cast<std::streamsize>(converted.text.size()));
+                spine.push_back({ chapters[index].number, {} });
+            }
+            if (progress) progress(index + 1, chapters.size());
+        });
+    result.chapters = spine.size();
+
+    bool written = false;
+    if (epub) {
+        std::string coverHref;
+        const char* coverType = nullptr;
+        if (!options.coverPath.empty()) {
+            std::ifstream coverFile(options.coverPath, std::ios::binary);
+            std::string cover((std::istreambuf_iterator<char>(coverFile)), std::istreambuf_iterator<char>());
+            coverType = ImageMediaType(cover);
+            if (coverType) {
+                coverHref = "cover" + ImageExtension(coverType);
+                zip.Add("OEBPS/" + coverHref, cover, 0);   // Already compressed
+            }
+        }
+        zip.Add("OEBPS/nav.xhtml", NavXhtml(title, spine));
+        zip.Add("OEBPS/content.opf", PackageOpf(options, title, spine, coverHref, coverType));
+        result.bytes = zip.BytesWritten();
+        written = zip.Finish();
+    }
+    else {
+        textFile.flush();
+        result.bytes = static_cast<uint64_t>(textFile.tellp());
+        written = textFile.good();
+        textFile.close();
+    }
+
+    std::error_code ec;
+    if (written && result.chapters > 0) {
+        std::filesystem::rename(tempPath, outputPath, ec);
+        if (ec) result.error = "Could not replace " + outputPath + ": " + ec.message();
+    }
+    else {
+        result.error = result.chapters == 0 ? "No readable chapters in " + novelDir : "Could not write " + tempPath;
+    }
+    if (!result.error.empty()) {
+        std::filesystem::remove(tempPath, ec);
+        std::cout << "Export failed: " << result.error << std::endl;
+        return false;
+    }
+
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Exported " << title << " to " << outputPath << ": " << result.chapters << " chapters, "
+        << result.bytes << " bytes in " << result.milliseconds << " ms" << std::endl;
+    return true;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+void BookExporter::RunBenchmark(const std::string& workDir, int chapters) {
+    std::filesystem::path root(workDir);
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    std::filesystem::path novelDir = root / "Benchmark Novel";
+    std::filesystem::create_directories(novelDir / "chapters", ec);
+
+    // Chapters of about 12 KB of random words, with some emphasis and a scene break
+    static const char* const WORDS[] = { "the", "sect", "elder", "sword", "qi", "heaven", "cultivation", "young",
+        "master", "realm", "breakthrough", "spirit", "stone", "ancient", "clan", "disciple", "said", "coldly" };
+    std::mt19937 random(12345);
+    uint64_t sourceBytes = 0;
+    for (int chapter = 1; chapter <= chapters; chapter++) {
+        std::string content;
+        for (int paragraph = 0; paragraph < 30; paragraph++) {
+            if (paragraph == 15) content += "* * *\n\n";
+            for (int word = 0; word < 70; word++) {
+                if (word == 10) content += "**";
+                content += WORDS[random() % 18];
+                if (word == 12) content += "**";
+                content += word == 69 ? ".\n\n" : " ";
+            }
+        }
+        json j;
+        j["chapterNumber"] = chapter;
+        j["title"] = "Chapter " + std::to_string(chapter) + ": The " + WORDS[random() % 18];
+        j["content"] = std::move(content);
+        std::string text = j.dump();
+        sourceBytes += text.size();
+        std::ofstream file(novelDir / "chapters" / ("chapter" + std::to_string(chapter) + ".json"), std::ios::binary);
+        file << text;
+    }
+
+    const double MB = 1024.0 * 1024.0;
+    std::cout << chapters << " chapters, " << sourceBytes / MB << " MB of chapter files" << std::endl;
+    for (Format format : { Format::Epub, Format::Markdown, Format::Text }) {
+        uint64_t baseline = PeakResidentBytes();
+        Options options;
+        options.format = format;
+        options.author = "Benchmark";
+        Result result;
+        std::string outputPath = (root / (std::string("export") + Extension(format))).string();
+        if (!Export(novelDir.string(), outputPath, options, result)) return;
+        std::cout << Extension(format) << ": " << result.bytes / MB << " MB in " << result.milliseconds << " ms ("
+            << sourceBytes / MB / (result.milliseconds / 1000.0) << " MB/s of chapters), peak RSS "
+            << PeakResidentBytes() / MB << " MB (+" << (PeakResidentBytes() - baseline) / MB << " MB)" << std::endl;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// Exports a novel, or a range of its chapters, as an EPUB or a single Markdown or text file
+// for e-readers.
+//
+// Chapters stream from storage to the output file: background tasks on the shared
+// TaskScheduler open chapters (mapped, as the reader does), convert them to XHTML or text
+// and, for EPUBs, compress them, at most WINDOW chapters ahead of the writer, which appends
+// them in order on the calling thread. The EPUB goes through ZipWriter entry by entry, its
+// package document and table of contents written last from the chapter titles collected on
+// the way. Memory stays at the window whatever the length of the novel.
+class BookExporter {
+public:
+    static constexpr size_t WINDOW = 64;                  // Chapters converted ahead of the writer
+    static constexpr int COMPRESSION_LEVEL = 6;
+
+    enum class Format {
+        Epub,
+        Markdown,
+        Text
+    };
+
+    struct Options {
+        Format format = Format::Epub;
+        int firstChapter = 1;
+        int lastChapter = 0;          // 0 for the last chapter on disk
+        std::string title;            // Defaults to the novel folder's name
+        std::string author;
+        std::string synopsis;
+        std::string coverPath;        // EPUB only; skipped if missing
+    };
+
+    struct Result {
+        size_t chapters = 0;
+        size_t skipped = 0;           // Chapters in the range that could not be read
+        uint64_t bytes = 0;
+        double milliseconds = 0.0;
+        std::string error;
+    };
+
+    // Called on the exporting thread after each chapter is written
+    using Progress = std::function<void(size_t written, size_t total)>;
+
+    // Writes the book to outputPath, which is replaced only once the export is complete
+    static bool Export(const std::string& novelDir, const std::string& outputPath, const Options& options,
+        Result& result, const Progress& progress = Progress());
+
+    static const char* Extension(Format format);   // ".epub", ".md", ".txt"
+
+    // Headless benchmark: exports a generated novel of `chapters` chapters in every format,
+    // reporting time, throughput and peak memory
+    static void RunBenchmark(const std::string& workDir, int chapters);
+};
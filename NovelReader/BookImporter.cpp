@@ -0,0 +1,884 @@
+#include "BookImporter.h"
+#include "BlobStore.h"
+#include "ChapterText.h"
+#include "MappedFile.h"
+#include "Regex.h"
+#include "TaskScheduler.h"
+#include "ZipArchive.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using json = nlohmann::json;
+
+const char* const BookImporter::DEFAULT_HEADING_PATTERN =
+    R"(^\s*()"
+    R"(#{1,3}\s+\S.*|)"
+    R"(((chapter|chap\.?|ch\.|part|book|volume|vol\.)\s*()"
+    R"(\d+|)"
+    R"(c{1,3}(xc|xl|l?x{0,3})(ix|iv|v?i{0,3})|(xc|xl|l?x{1,3})(ix|iv|v?i{0,3})|l(ix|iv|v?i{0,3})|ix|iv|v?i{1,3}|v|)"
+    R"((one|two|three|four|five|six|seven|eight|nine|ten|eleven|twelve|thirteen|fourteen|fifteen|sixteen|)"
+    R"(seventeen|eighteen|nineteen|twenty|thirty|forty|fifty|sixty|seventy|eighty|ninety))"
+    R"(([- ]?(one|two|three|four|five|six|seven|eight|nine))?)"
+    R"()|prologue|epilogue|interlude|afterword|foreword|preface))"
+    R"((\s*[:.)\-–—]\s*.*|\s+.*)?|)"
+    R"(第\s*[0-9０-９零〇一二三四五六七八九十百千两]+\s*[章回节話话卷].*)"
+    R"()$)";
+
+namespace {
+    // A chapter about to be written: its text is a view into the mapped book, or owned
+    struct Piece {
+        std::string title;
+        std::string_view text;
+        std::string owned;
+    };
+
+    struct Heading {
+        size_t lineStart = 0;
+        size_t lineEnd = 0;
+    };
+
+    // Runners for the shared scheduler's ParallelFor, the calling thread included
+    size_t WorkerCount() {
+        return std::clamp<size_t>(TaskScheduler::Shared().WorkerCount() + 1, 1, BookImporter::MAX_THREADS);
+    }
+
+    void ParallelFor(size_t count, size_t workerCount, const std::function<void(size_t worker, size_t index)>& work) {
+        TaskScheduler::Shared().ParallelFor(count, workerCount, work);
+    }
+
+    std::string_view Trim(std::string_view text) {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string_view::npos) return {};
+        return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+    }
+
+    // ============================================================================
+    // Text decoding
+    // ============================================================================
+    void AppendUtf8(std::string& out, uint32_t codepoint) {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        }
+        else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x110000) {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool IsValidUtf8(std::string_view text) {
+        size_t i = 0;
+        while (i < text.size()) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c < 0x80) {
+                i++;
+                continue;
+            }
+            size_t length = (c >= 0xF0 && c <= 0xF4) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC2 && c < 0xE0) ? 2 : 0;
+            if (length == 0 || i + length > text.size()) return false;
+            for (size_t k = 1; k < length; k++) {
+                if ((static_cast<unsigned char>(text[i + k]) & 0xC0) != 0x80) return false;
+            }
+            i += length;
+        }
+        return true;
+    }
+
+    std::string FromUtf16(std::string_view bytes, bool bigEndian) {
+        std::string out;
+        out.reserve(bytes.size());
+        auto unitAt = [&](size_t i) {
+            unsigned char a = static_cast<unsigned char>(bytes[i]), b = static_cast<unsigned char>(bytes[i + 1]);
+            return static_cast<uint32_t>(bigEndian ? (a << 8) | b : (b << 8) | a);
+        };
+        for (size_t i = 0; i + 1 < bytes.size(); i += 2) {
+            uint32_t unit = unitAt(i);
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < bytes.size()) {
+                uint32_t low = unitAt(i + 2);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    AppendUtf8(out, 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+                    i += 2;
+                    continue;
+                }
+            }
+            AppendUtf8(out, unit);
+        }
+        return out;
+    }
+
+    // Text that isn't UTF-8 is taken as Windows-1252, what older .txt books usually are
+    std::string FromWindows1252(std::string_view bytes) {
+        static const uint16_t HIGH[32] = {
+            0x20AC, 0x81, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x8D, 0x017D, 0x8F,
+            0x90, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x9D, 0x017E, 0x0178
+        };
+        std::string out;
+        out.reserve(bytes.size() + bytes.size() / 8);
+        for (unsigned char c : bytes) {
+            if (c < 0x80) out += static_cast<char>(c);
+            else if (c < 0xA0) AppendUtf8(out, HIGH[c - 0x80]);
+            else AppendUtf8(out, c);
+        }
+        return out;
+    }
+
+    // ============================================================================
+    // XML and XHTML
+    // ============================================================================
+    struct Tag {
+        std::string_view name;         // Without namespace prefix, as written
+        std::string_view attributes;
+        bool closing = false;
+        bool selfClosing = false;
+    };
+
+    // Finds the next tag at or after pos; comments, CDATA, declarations and processing
+    // instructions come back without a name. textEnd is where the text before it ends; pos
+    // moves past the tag.
+    bool NextTag(std::string_view xml, size_t& pos, Tag& tag, size_t& textEnd) {
+        size_t open = xml.find('<', pos);
+        if (open == std::string_view::npos) {
+            textEnd = xml.size();
+            pos = xml.size();
+            return false;
+        }
+        textEnd = open;
+        std::string_view rest = xml.substr(open);
+        const char* closer = rest.starts_with("<!--") ? "-->" : rest.starts_with("<![CDATA[") ? "]]>" :
+            rest.starts_with("<?") ? "?>" : rest.starts_with("<!") ? ">" : nullptr;
+        if (closer) {
+            // Reported as a nameless tag, so the text after it isn't lost
+            size_t end = xml.find(closer, open);
+            pos = (end == std::string_view::npos) ? xml.size() : end + std::strlen(closer);
+            tag = Tag();
+            return true;
+        }
+
+        size_t close = xml.find('>', open);
+        if (close == std::string_view::npos) {
+            pos = xml.size();
+            return false;
+        }
+        std::string_view inner = xml.substr(open + 1, close - open - 1);
+        pos = close + 1;
+
+        tag = Tag();
+        if (!inner.empty() && inner.front() == '/') {
+            tag.closing = true;
+            inner.remove_prefix(1);
+        }
+        if (!inner.empty() && inner.back() == '/') {
+            tag.selfClosing = true;
+            inner.remove_suffix(1);
+        }
+        size_t nameEnd = inner.find_first_of(" \t\r\n");
+        tag.name = inner.substr(0, nameEnd);
+        tag.attributes = nameEnd == std::string_view::npos ? std::string_view() : inner.substr(nameEnd);
+        size_t colon = tag.name.find(':');
+        if (colon != std::string_view::npos) tag.name.remove_prefix(colon + 1);
+        return true;
+    }
+
+    bool NameIs(std::string_view name, std::string_view expected) {
+        if (name.size() != expected.size()) return false;
+        for (size_t i = 0; i < name.size(); i++) {
+            char c = name[i];
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+            if (c != expected[i]) return false;
+        }
+        return true;
+    }
+
+    void AppendDecoded(std::string_view text, std::string& out) {
+        static const std::unordered_map<std::string_view, uint32_t> NAMED = {
+            {"amp", '&'}, {"lt", '<'}, {"gt", '>'}, {"quot", '"'}, {"apos", '\''}, {"nbsp", 0xA0},
+            {"mdash", 0x2014}, {"ndash", 0x2013}, {"hellip", 0x2026}, {"lsquo", 0x2018}, {"rsquo", 0x2019},
+            {"ldquo", 0x201C}, {"rdquo", 0x201D}, {"copy", 0xA9}, {"shy", 0xAD}, {"times", 0xD7}
+        };
+        size_t i = 0;
+        while (i < text.size()) {
+            size_t amp = text.find('&', i);
+            if (amp == std::string_view::npos) {
+                out.append(text.substr(i));
+                return;
+            }
+            out.append(text.substr(i, amp - i));
+            size_t semicolon = text.find(';', amp);
+            std::string_view name = semicolon == std::string_view::npos || semicolon - amp > 12 ?
+                std::string_view() : text.substr(amp + 1, semicolon - amp - 1);
+
+            uint32_t codepoint = 0;
+            if (name.size() > 1 && name[0] == '#') {
+                bool hex = name[1] == 'x' || name[1] == 'X';
+                try {
+                    codepoint = static_cast<uint32_t>(std::stoul(std::string(name.substr(hex ? 2 : 1)), nullptr, hex ? 16 : 10));
+                }
+                catch (...) {}
+            }
+            else if (auto it = NAMED.find(name); !name.empty() && it != NAMED.end()) {
+                codepoint = it->second;
+            }
+
+            if (codepoint != 0) {
+                AppendUtf8(out, codepoint);
+                i = semicolon + 1;
+            }
+            else {
+                out += '&';
+                i = amp + 1;
+            }
+        }
+    }
+
+    std::string Attribute(std::string_view attributes, std::string_view name) {
+        size_t at = 0;
+        while ((at = attributes.find(name, at)) != std::string_view::npos) {
+            bool startsName = at == 0 || attributes[at - 1] == ' ' || attributes[at - 1] == '\t' ||
+                attributes[at - 1] == '\n' || attributes[at - 1] == '\r' || attributes[at - 1] == ':';
+            size_t eq = attributes.find_first_not_of(" \t\r\n", at + name.size());
+            if (startsName && eq != std::string_view::npos && attributes[eq] == '=') {
+                size_t quote = attributes.find_first_not_of(" \t\r\n", eq + 1);
+                if (quote != std::string_view::npos && (attributes[quote] == '"' || attributes[quote] == '\'')) {
+                    size_t end = attributes.find(attributes[quote], quote + 1);
+                    if (end != std::string_view::npos) {
+                        std::string value;
+                        AppendDecoded(attributes.substr(quote + 1, end - quote - 1), value);
+                        return value;
+                    }
+                }
+            }
+            at += name.size();
+        }
+        return "";
+    }
+
+    // Text of an element up to its closing tag, with any markup inside dropped
+    std::string ElementText(std::string_view xml, size_t pos, std::string_view name) {
+        std::string text;
+        Tag tag;
+        size_t textEnd = 0;
+        size_t textStart = pos;
+        while (NextTag(xml, pos, tag, textEnd)) {
+            AppendDecoded(xml.substr(textStart, textEnd - textStart), text);
+            if (tag.closing && tag.name == name) break;
+            textStart = pos;
+        }
+        return std::string(Trim(text));
+    }
+
+    bool IsBlockElement(std::string_view name) {
+        static const char* const BLOCKS[] = { "p", "div", "section", "article", "blockquote", "ul", "ol", "li",
+            "h1", "h2", "h3", "h4", "h5", "h6", "tr", "table", "hr", "pre", "figure", "header", "footer", "aside" };
+        for (const char* block : BLOCKS) {
+            if (NameIs(name, block)) return true;
+        }
+        return false;
+    }
+
+    // XHTML body to the reader's content: paragraphs apart by a blank line, "#" headings,
+    // "**" and "*" emphasis, "- " list items. The first heading's text is the chapter title.
+    std::string XhtmlToContent(std::string_view xhtml, std::string& heading, std::string& documentTitle) {
+        std::string out;
+        out.reserve(xhtml.size() / 2);
+        size_t pos = 0;
+        size_t bodyOpen = std::string_view::npos;
+        Tag tag;
+        size_t textEnd = 0;
+
+        // Everything before <body> is head; its <title> is a fallback for the chapter title
+        while (NextTag(xhtml, pos, tag, textEnd)) {
+            if (!tag.closing && NameIs(tag.name, "title")) documentTitle = ElementText(xhtml, pos, tag.name);
+            if (!tag.closing && NameIs(tag.name, "body")) {
+                bodyOpen = pos;
+                break;
+            }
+        }
+        pos = bodyOpen == std::string_view::npos ? 0 : bodyOpen;
+
+        int skipDepth = 0;          // Inside script/style
+        int headingLevel = 0;
+        size_t headingStart = 0;
+        size_t textStart = pos;
+        auto appendText = [&](std::string_view raw) {
+            if (skipDepth > 0) return;
+            std::string decoded;
+            AppendDecoded(raw, decoded);
+            for (char c : decoded) {
+                // HTML whitespace: any run is one space; Normalize trims what lands at line ends
+                bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+                if (space) {
+                    if (!out.empty() && out.back() != ' ' && out.back() != '\n') out += ' ';
+                }
+                else {
+                    out += c;
+                }
+            }
+        };
+
+        while (true) {
+            bool found = NextTag(xhtml, pos, tag, textEnd);
+            appendText(xhtml.substr(textStart, textEnd - textStart));
+            if (!found) break;
+            textStart = pos;
+
+            std::string_view name = tag.name;
+            if (NameIs(name, "script") || NameIs(name, "style")) {
+                if (!tag.selfClosing) skipDepth += tag.closing ? -1 : 1;
+                skipDepth = std::max(skipDepth, 0);
+                continue;
+            }
+            if (NameIs(name, "body") && tag.closing) break;
+
+            if (NameIs(name, "br")) {
+                out += '\n';
+            }
+            else if (NameIs(name, "b") || NameIs(name, "strong")) {
+                out += "**";
+            }
+            else if (NameIs(name, "i") || NameIs(name, "em")) {
+                out += '*';
+            }
+            else if (name.size() == 2 && (name[0] == 'h' || name[0] == 'H') && name[1] >= '1' && name[1] <= '6') {
+                out += "\n\n";
+                if (!tag.closing) {
+                    headingLevel = name[1] - '0';
+                    out += headingLevel == 1 ? "# " : headingLevel == 2 ? "## " : "### ";
+                    headingStart = out.size();
+                }
+                else if (headingLevel > 0) {
+                    if (heading.empty()) heading = Trim(std::string_view(out).substr(headingStart));
+                    headingLevel = 0;
+                }
+            }
+            else if (NameIs(name, "li") && !tag.closing) {
+                out += "\n\n- ";
+            }
+            else if (IsBlockElement(name)) {
+                out += "\n\n";
+            }
+        }
+
+        // The heading may have carried emphasis markers
+        heading.erase(std::remove(heading.begin(), heading.end(), '*'), heading.end());
+        return out;
+    }
+
+    // Resolves an href relative to the folder of the document it appears in
+    std::string ResolvePath(std::string_view baseDir, std::string_view href) {
+        size_t fragment = href.find('#');
+        if (fragment != std::string_view::npos) href = href.substr(0, fragment);
+
+        std::string decoded;
+        for (size_t i = 0; i < href.size(); i++) {
+            if (href[i] == '%' && i + 2 < href.size()) {
+                try {
+                    decoded += static_cast<char>(std::stoi(std::string(href.substr(i + 1, 2)), nullptr, 16));
+                    i += 2;
+                    continue;
+                }
+                catch (...) {}
+            }
+            decoded += href[i];
+        }
+
+        std::vector<std::string> parts;
+        std::string joined = baseDir.empty() ? decoded : std::string(baseDir) + "/" + decoded;
+        size_t start = 0;
+        while (start <= joined.size()) {
+            size_t slash = joined.find('/', start);
+            if (slash == std::string::npos) slash = joined.size();
+            std::string part = joined.substr(start, slash - start);
+            if (part == "..") {
+                if (!parts.empty()) parts.pop_back();
+            }
+            else if (!part.empty() && part != ".") {
+                parts.push_back(std::move(part));
+            }
+            start = slash + 1;
+        }
+
+        std::string path;
+        for (const std::string& part : parts) {
+            if (!path.empty()) path += '/';
+            path += part;
+        }
+        return path;
+    }
+
+    // ============================================================================
+    // Writing
+    // ============================================================================
+
+    // Normalizes, measures and writes pieces as chapters firstNumber.. in parallel
+    bool WriteChapters(const std::filesystem::path& chaptersDir, std::vector<Piece>& pieces, int firstNumber,
+        std::atomic<uint64_t>& words) {
+        std::atomic<bool> failed{ false };
+        ParallelFor(pieces.size(), WorkerCount(), [&](size_t, size_t index) {
+            Piece& piece = pieces[index];
+            std::string content = piece.owned.empty() ? std::string(piece.text) : std::move(piece.owned);
+            ChapterText::Normalize(content);
+            ChapterText::Metrics metrics = ChapterText::Measure(content);
+            words += metrics.words;
+
+            int number = firstNumber + static_cast<int>(index);
+            json j;
+            j["chapterNumber"] = number;
+            j["title"] = piece.title;
+            j["content"] = std::move(content);
+            j["wordCount"] = metrics.words;
+            j["paragraphOffsets"] = metrics.paragraphs;
+
+            std::string path = (chaptersDir / ("chapter" + std::to_string(number) + ".json")).string();
+            if (!BlobStore::ForChapterFile(path).Put(path, j.dump(-1, ' ', false, json::error_handler_t::replace))) {
+                std::cout << "Could not write imported chapter " << path << std::endl;
+                failed = true;
+            }
+            piece = Piece();
+        });
+        return !failed;
+    }
+
+    // ============================================================================
+    // Text books
+    // ============================================================================
+
+    // Heading lines in text, each worker matching its own slice of lines
+    std::vector<Heading> FindHeadings(std::string_view text, const Regex& regex) {
+        size_t workerCount = WorkerCount();
+        size_t sliceSize = text.size() / workerCount + 1;
+        std::vector<size_t> bounds = { 0 };
+        for (size_t i = 1; i < workerCount; i++) {
+            size_t at = text.find('\n', std::max(bounds.back(), i * sliceSize));
+            if (at == std::string_view::npos) break;
+            bounds.push_back(at + 1);
+        }
+        bounds.push_back(text.size());
+
+        std::vector<std::vector<Heading>> found(bounds.size() - 1);
+        ParallelFor(found.size(), workerCount, [&](size_t, size_t slice) {
+            Regex::Matcher matcher(regex);
+            size_t lineStart = bounds[slice];
+            while (lineStart < bounds[slice + 1]) {
+                size_t lineEnd = text.find('\n', lineStart);
+                if (lineEnd == std::string_view::npos) lineEnd = text.size();
+                std::string_view line = Trim(text.substr(lineStart, lineEnd - lineStart));
+                if (!line.empty() && line.size() <= BookImporter::MAX_HEADING_LENGTH && matcher.Search(line)) {
+                    found[slice].push_back({ lineStart, lineEnd });
+                }
+                lineStart = lineEnd + 1;
+            }
+        });
+
+        std::vector<Heading> headings;
+        for (auto& slice : found) headings.insert(headings.end(), slice.begin(), slice.end());
+        return headings;
+    }
+
+    std::string HeadingTitle(std::string_view line) {
+        line = Trim(line);
+        while (!line.empty() && line.front() == '#') line.remove_prefix(1);
+        return std::string(Trim(line));
+    }
+
+    std::vector<Piece> SplitText(std::string_view text, const Regex& regex) {
+        std::vector<Piece> pieces;
+        std::vector<Heading> headings = FindHeadings(text, regex);
+
+        if (headings.empty()) {
+            // No headings: parts of about PART_BYTES, cut at a paragraph break where there is one
+            size_t start = 0;
+            while (start < text.size()) {
+                size_t end = std::min(text.size(), start + BookImporter::PART_BYTES);
+                if (end < text.size()) {
+                    size_t cut = text.find("\n\n", end);
+                    if (cut == std::string_view::npos || cut - end > BookImporter::PART_BYTES) cut = text.find('\n', end);
+                    end = cut == std::string_view::npos ? text.size() : cut + 1;
+                }
+                Piece piece;
+                piece.title = "Part " + std::to_string(pieces.size() + 1);
+                piece.text = text.substr(start, end - start);
+                if (!Trim(piece.text).empty()) pieces.push_back(std::move(piece));
+                start = end;
+            }
+            return pieces;
+        }
+
+        std::string_view front = text.substr(0, headings.front().lineStart);
+        if (ChapterText::CountWords(front) >= BookImporter::MIN_FRONT_MATTER_WORDS) {
+            Piece piece;
+            piece.title = "Front Matter";
+            piece.text = front;
+            pieces.push_back(std::move(piece));
+        }
+
+        for (size_t i = 0; i < headings.size(); i++) {
+            size_t end = i + 1 < headings.size() ? headings[i + 1].lineStart : text.size();
+            const Heading& heading = headings[i];
+            // A heading with nothing under it is a table of contents line or a part title
+            if (heading.lineEnd >= end || Trim(text.substr(heading.lineEnd, end - heading.lineEnd)).empty()) continue;
+
+            Piece piece;
+            piece.title = HeadingTitle(text.substr(heading.lineStart, heading.lineEnd - heading.lineStart));
+            piece.text = text.substr(heading.lineStart, end - heading.lineStart);
+            pieces.push_back(std::move(piece));
+        }
+        return pieces;
+    }
+
+    bool CreateNovelDir(const std::filesystem::path& novelDir, BookImporter::Result& result) {
+        std::error_code ec;
+        if (std::filesystem::exists(novelDir, ec)) {
+            result.error = "\"" + result.title + "\" is already in the library";
+            return false;
+        }
+        std::filesystem::create_directories(novelDir / "chapters", ec);
+        if (ec) {
+            result.error = "Could not create " + novelDir.string() + ": " + ec.message();
+            return false;
+        }
+        return true;
+    }
+
+    bool ImportText(const std::string& path, const std::filesystem::path& novelsRoot, const Regex& regex,
+        BookImporter::Result& result) {
+        MappedFile file;
+        if (!file.Open(path)) {
+            result.error = "Could not open " + path;
+            return false;
+        }
+        result.sourceBytes = file.Size();
+
+        // UTF-8 is split straight from the mapping; other encodings are converted once
+        std::string_view text = file.View();
+        std::string converted;
+        if (text.starts_with("\xEF\xBB\xBF")) {
+            text.remove_prefix(3);
+        }
+        else if (text.starts_with("\xFF\xFE") || text.starts_with("\xFE\xFF")) {
+            converted = FromUtf16(text.substr(2), text[0] == '\xFE');
+            text = converted;
+        }
+        if (converted.empty() && !IsValidUtf8(text)) {
+            converted = FromWindows1252(text);
+            text = converted;
+        }
+
+        std::vector<Piece> pieces = SplitText(text, regex);
+        if (pieces.empty()) {
+            result.error = "No text in " + path;
+            return false;
+        }
+
+        result.title = BookImporter::FolderName(std::filesystem::path(path).stem().string());
+        std::filesystem::path novelDir = novelsRoot / result.title;
+        if (!CreateNovelDir(novelDir, result)) return false;
+        result.novelDir = novelDir.string();
+
+        std::atomic<uint64_t> words{ 0 };
+        result.chapters = pieces.size();
+        bool written = WriteChapters(novelDir / "chapters", pieces, 1, words);
+        result.words = words;
+        if (!written) result.error = "Could not write the chapters";
+        return written;
+    }
+
+    // ============================================================================
+    // EPUB
+    // ============================================================================
+    bool ImportEpub(const std::string& path, const std::filesystem::path& novelsRoot, BookImporter::Result& result) {
+        ZipReader zip;
+        std::string zipError;
+        if (!zip.Open(path, &zipError)) {
+            result.error = zipError + ": " + path;
+            return false;
+        }
+        std::error_code ec;
+        result.sourceBytes = std::filesystem::file_size(path, ec);
+
+        // container.xml names the package document
+        std::string xml;
+        const ZipReader::Entry* container = zip.Find("META-INF/container.xml");
+        if (!container || !zip.Read(*container, xml)) {
+            result.error = "Not an EPUB (no META-INF/container.xml): " + path;
+            return false;
+        }
+        std::string packagePath;
+        {
+            size_t pos = 0, textEnd = 0;
+            Tag tag;
+            while (packagePath.empty() && NextTag(xml, pos, tag, textEnd)) {
+                if (!tag.closing && tag.name == "rootfile") packagePath = Attribute(tag.attributes, "full-path");
+            }
+        }
+        std::string package;
+        const ZipReader::Entry* packageEntry = packagePath.empty() ? nullptr : zip.Find(packagePath);
+        if (!packageEntry || !zip.Read(*packageEntry, package)) {
+            result.error = "EPUB package document missing: " + path;
+            return false;
+        }
+        size_t slash = packagePath.rfind('/');
+        std::string baseDir = slash == std::string::npos ? "" : packagePath.substr(0, slash);
+
+        // Metadata, manifest and spine
+        struct Item {
+            std::string href;
+            std::string mediaType;
+            std::string properties;
+        };
+        std::unordered_map<std::string, Item> manifest;
+        std::vector<std::string> spine;
+        std::string title, coverId;
+        {
+            size_t pos = 0, textEnd = 0;
+            Tag tag;
+            while (NextTag(package, pos, tag, textEnd)) {
+                if (tag.closing) continue;
+                if (tag.name == "title" && title.empty()) title = ElementText(package, pos, tag.name);
+                else if (tag.name == "creator" && result.author.empty()) result.author = ElementText(package, pos, tag.name);
+                else if (tag.name == "description" && result.synopsis.empty()) {
+                    // Descriptions are often escaped HTML
+                    std::string heading, documentTitle;
+                    std::string description = XhtmlToContent(ElementText(package, pos, tag.name), heading, documentTitle);
+                    ChapterText::Normalize(description);
+                    result.synopsis = std::move(description);
+                }
+                else if (tag.name == "meta" && Attribute(tag.attributes, "name") == "cover") {
+                    coverId = Attribute(tag.attributes, "content");
+                }
+                else if (tag.name == "item") {
+                    Item item{ ResolvePath(baseDir, Attribute(tag.attributes, "href")),
+                        Attribute(tag.attributes, "media-type"), Attribute(tag.attributes, "properties") };
+                    std::string id = Attribute(tag.attributes, "id");
+                    if (item.properties.find("cover-image") != std::string::npos) coverId = id;
+                    manifest[id] = std::move(item);
+                }
+                else if (tag.name == "itemref" && Attribute(tag.attributes, "linear") != "no") {
+                    spine.push_back(Attribute(tag.attributes, "idref"));
+                }
+            }
+        }
+
+        std::vector<const ZipReader::Entry*> documents;
+        for (const std::string& id : spine) {
+            auto it = manifest.find(id);
+            if (it == manifest.end()) continue;
+            const std::string& type = it->second.mediaType;
+            if (type != "application/xhtml+xml" && type != "text/html") continue;
+            if (const ZipReader::Entry* entry = zip.Find(it->second.href)) documents.push_back(entry);
+        }
+        if (documents.empty()) {
+            result.error = "EPUB has no readable documents: " + path;
+            return false;
+        }
+
+        result.title = BookImporter::FolderName(title.empty() ? std::filesystem::path(path).stem().string() : title);
+        std::filesystem::path novelDir = novelsRoot / result.title;
+        if (!CreateNovelDir(novelDir, result)) return false;
+        result.novelDir = novelDir.string();
+
+        // A window of documents is converted in parallel, numbered once the empty ones (covers,
+        // title pages) are dropped, and written in parallel
+        std::atomic<uint64_t> words{ 0 };
+        int nextNumber = 1;
+        bool written = true;
+        for (size_t begin = 0; begin < documents.size() && written; begin += BookImporter::EPUB_WINDOW) {
+            size_t end = std::min(documents.size(), begin + BookImporter::EPUB_WINDOW);
+            std::vector<Piece> converted(end - begin);
+            ParallelFor(converted.size(), WorkerCount(), [&](size_t, size_t index) {
+                std::string xhtml;
+                if (!zip.Read(*documents[begin + index], xhtml)) {
+                    std::cout << "Skipping damaged EPUB entry " << documents[begin + index]->name << std::endl;
+                    return;
+                }
+                std::string heading, documentTitle;
+                std::string content = XhtmlToContent(xhtml, heading, documentTitle);
+                if (Trim(content).empty()) return;
+                converted[index].title = !heading.empty() ? heading : documentTitle;
+                converted[index].owned = std::move(content);
+            });
+
+            std::vector<Piece> pieces;
+            for (Piece& piece : converted) {
+                if (piece.owned.empty()) continue;
+                if (piece.title.empty()) piece.title = "Chapter " + std::to_string(nextNumber + pieces.size());
+                pieces.push_back(std::move(piece));
+            }
+            written = WriteChapters(novelDir / "chapters", pieces, nextNumber, words);
+            nextNumber += static_cast<int>(pieces.size());
+        }
+        result.chapters = static_cast<size_t>(nextNumber - 1);
+        result.words = words;
+        if (!written) {
+            result.error = "Could not write the chapters";
+            return false;
+        }
+        if (result.chapters == 0) {
+            result.error = "EPUB has no text: " + path;
+            return false;
+        }
+
+        // The cover goes where downloads put theirs; the thumbnail loader reads any image format
+        auto cover = manifest.find(coverId);
+        std::string coverBytes;
+        if (cover != manifest.end()) {
+            const ZipReader::Entry* entry = zip.Find(cover->second.href);
+            if (entry && zip.Read(*entry, coverBytes)) {
+                std::ofstream coverFile(novelDir / "cover.jpg", std::ios::binary | std::ios::trunc);
+                coverFile.write(coverBytes.data(), static_cast<std::streamsize>(coverBytes.size()));
+                result.hasCover = coverFile.good();
+            }
+        }
+        return true;
+    }
+
+    uint64_t PeakResidentBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+}
+
+bool BookImporter::IsSupported(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".txt" || extension == ".md" || extension == ".markdown" || extension == ".epub";
+}
+
+std::string BookImporter::FolderName(std::string_view title) {
+    std::string name;
+    for (char c : title) {
+        bool invalid = std::string_view("<>:\"/\\|?*").find(c) != std::string_view::npos ||
+            static_cast<unsigned char>(c) < 0x20;
+        name += invalid ? '_' : c;
+    }
+    size_t first = name.find_first_not_of(" .");
+    name = first == std::string::npos ? "" : name.substr(first, name.find_last_not_of(" .") - first + 1);
+
+    // At most 100 bytes, without cutting a character in half
+    if (name.size() > 100) {
+        size_t cut = 100;
+        while (cut > 0 && (static_cast<unsigned char>(name[cut]) & 0xC0) == 0x80) cut--;
+        name.resize(cut);
+    }
+    return name.empty() ? "Imported Book" : name;
+}
+
+bool BookImporter::Import(const std::string& path, const std::string& novelsRoot, Result& result, const Options& options) {
+    result = Result();
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    bool imported = false;
+    if (extension == ".epub") {
+        imported = ImportEpub(path, novelsRoot, result);
+    }
+    else if (IsSupported(path)) {
+        Regex regex;
+        std::string patternError;
+        const std::string& pattern = options.headingPattern.empty() ? DEFAULT_HEADING_PATTERN : options.headingPattern;
+        if (!regex.Compile(pattern, true, &patternError)) {
+            result.error = "Bad heading pattern: " + patternError;
+            return false;
+        }
+        imported = ImportText(path, novelsRoot, regex, result);
+    }
+    else {
+        result.error = "Unsupported file type: " + path;
+    }
+
+    // Nothing half-imported is left behind; the folder was created by this import
+    if (!imported && !result.novelDir.empty()) {
+        std::error_code ec;
+        std::filesystem::remove_all(result.novelDir, ec);
+    }
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    if (imported) {
+        std::cout << "Imported " << result.title << ": " << result.chapters << " chapters, " << result.words << " words in "
+            << result.milliseconds << " ms" << std::endl;
+    }
+    else {
+        std::cout << "Import failed: " << result.error << std::endl;
+    }
+    return imported;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+void BookImporter::RunBenchmark(const std::string& workDir, uint64_t targetBytes, int chapters) {
+    std::filesystem::path root(workDir);
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    std::filesystem::create_directories(root / "Novels", ec);
+
+    // A generated book: numbered chapter headings over paragraphs of random words
+    static const char* const WORDS[] = { "the", "sect", "elder", "sword", "qi", "heaven", "cultivation", "young",
+        "master", "realm", "breakthrough", "spirit", "stone", "ancient", "clan", "disciple", "said", "coldly" };
+    std::mt19937 random(12345);
+    std::filesystem::path bookPath = root / "Benchmark Book.txt";
+    {
+        std::ofstream book(bookPath, std::ios::binary | std::ios::trunc);
+        uint64_t perChapter = targetBytes / std::max(1, chapters);
+        for (int chapter = 1; chapter <= chapters; chapter++) {
+            std::string text = "Chapter " + std::to_string(chapter) + ": The " + WORDS[random() % 18] + "\n\n";
+            while (text.size() < perChapter) {
+                for (int word = 0; word < 60; word++) {
+                    text += WORDS[random() % 18];
+                    text += word == 59 ? ".\n\n" : " ";
+                }
+            }
+            book << text;
+        }
+    }
+    uint64_t bookBytes = std::filesystem::file_size(bookPath, ec);
+
+    uint64_t baseline = PeakResidentBytes();
+    Result result;
+    if (!Import(bookPath.string(), (root / "Novels").string(), result)) return;
+
+    const double MB = 1024.0 * 1024.0;
+    std::cout << bookBytes / MB << " MB book, " << result.chapters << " chapters, " << result.words << " words: "
+        << result.milliseconds << " ms, peak RSS " << PeakResidentBytes() / MB << " MB (+"
+        << (PeakResidentBytes() - baseline) / MB << " MB)" << std::endl;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Imports books from local files (.txt, .md, .epub) into the library as novels, without
+// going through download_manager.py.
+//
+// Text files are mapped and split into chapters at heading lines ("Chapter 12: ...",
+// "Prologue", "# Title", "第十二章" ...). Headings are found with a compiled Regex, each
+// worker scanning its own slice of the file; lines longer than a heading could be are never
+// matched. A book without headings is cut into parts at paragraph breaks. EPUBs are read
+// through ZipReader one spine document at a time, and their XHTML is converted to the
+// reader's markdown-like content (headings, emphasis, list items, paragraphs).
+//
+// Chapters are normalized and measured (ChapterText) and written in parallel as hot chapter
+// files through the library's BlobStore, so the importer never holds more than the mapping
+// and the chapters its workers are on. ChapterTiering's sweep later cleans and tiers them
+// like downloaded chapters. The caller adds the catalog entry from the Result.
+class BookImporter {
+public:
+    static constexpr size_t MAX_HEADING_LENGTH = 120;            // Longer lines are prose whatever they start with
+    static constexpr size_t PART_BYTES = 32 * 1024;               // Part size for books without headings
+    static constexpr size_t MIN_FRONT_MATTER_WORDS = 100;         // Text before the first heading, kept if longer
+    static constexpr size_t MAX_THREADS = 8;
+    static constexpr size_t EPUB_WINDOW = 64;                     // Spine documents converted at once
+    static const char* const DEFAULT_HEADING_PATTERN;
+
+    struct Options {
+        std::string headingPattern;   // Regex syntax, case-insensitive; empty for DEFAULT_HEADING_PATTERN
+    };
+
+    struct Result {
+        std::string title;            // Also the novel's folder name
+        std::string author;
+        std::string synopsis;
+        std::string novelDir;
+        bool hasCover = false;
+        size_t chapters = 0;
+        uint64_t words = 0;
+        uint64_t sourceBytes = 0;
+        double milliseconds = 0.0;
+        std::string error;
+    };
+
+    static bool IsSupported(const std::string& path);
+
+    // Imports the book into <novelsRoot>/<title>/. Fails, leaving nothing behind, if that
+    // folder already exists or the book has no text.
+    static bool Import(const std::string& path, const std::string& novelsRoot, Result& result,
+        const Options& options = Options());
+
+    // A title as a folder name, sanitized the way download_manager.py does
+    static std::string FolderName(std::string_view title);
+
+    // Headless benchmark: imports a generated text book of about targetBytes and `chapters`
+    // chapters, reporting time and peak memory
+    static void RunBenchmark(const std::string& workDir, uint64_t targetBytes, int chapters);
+};
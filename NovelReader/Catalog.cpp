@@ -0,0 +1,271 @@
+#include "Catalog.h"
+#include "FileLock.h"
+#include "JsonReader.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using json = nlohmann::json;
+
+// JSON serialization for Novel structures
+void to_json(json& j, const Catalog::Novel::Progress& p) {
+    j = json{
+        {"readchapters", p.readchapters},
+        {"progresspercentage", p.progresspercentage}
+    };
+}
+
+void from_json(const json& j, Catalog::Novel::Progress& p) {
+    j.at("readchapters").get_to(p.readchapters);
+    j.at("progresspercentage").get_to(p.progresspercentage);
+}
+
+void to_json(json& j, const Catalog::Novel& n) {
+    j = json{
+        {"name", n.name},
+        {"authorname", n.authorname},
+        {"coverpath", n.coverpath},
+        {"synopsis", n.synopsis},
+        {"totalchapters", n.totalchapters},
+        {"progress", n.progress}
+    };
+}
+
+void from_json(const json& j, Catalog::Novel& n) {
+    j.at("name").get_to(n.name);
+    j.at("authorname").get_to(n.authorname);
+    j.at("coverpath").get_to(n.coverpath);
+    j.at("synopsis").get_to(n.synopsis);
+    j.at("totalchapters").get_to(n.totalchapters);
+    j.at("progress").get_to(n.progress);
+}
+
+namespace {
+    // On-demand reader for the catalog the app writes itself; false on anything it doesn't
+    // expect, and the caller then goes through nlohmann::json
+    bool ReadNovelList(std::string_view jsonText, std::vector<Catalog::Novel>& novels) {
+        JsonReader::Object root;
+        std::vector<JsonReader::Value> elements;
+        if (!root.Parse(jsonText) || !root.GetArray("novels", elements)) return false;
+
+        novels.clear();
+        novels.reserve(elements.size());
+        for (const JsonReader::Value& element : elements) {
+            JsonReader::Object object, progress;
+            Catalog::Novel novel;
+            if (!object.Parse(element.raw) ||
+                !object.GetString("name", novel.name) ||
+                !object.GetString("authorname", novel.authorname) ||
+                !object.GetString("coverpath", novel.coverpath) ||
+                !object.GetString("synopsis", novel.synopsis) ||
+                !object.GetInt("totalchapters", novel.totalchapters) ||
+                !object.GetObject("progress", progress) ||
+                !progress.GetInt("readchapters", novel.progress.readchapters) ||
+                !progress.GetFloat("progresspercentage", novel.progress.progresspercentage)) {
+                return false;
+            }
+            novels.push_back(std::move(novel));
+        }
+        return true;
+    }
+}
+
+namespace {
+    std::filesystem::path CatalogPath(const std::string& novelsRoot) {
+        return std::filesystem::path(novelsRoot) / Catalog::FILE_NAME;
+    }
+
+    // Every process that writes the catalog holds this lock from reading it to replacing it
+    std::string CatalogLockPath(const std::string& novelsRoot) {
+        return (std::filesystem::path(novelsRoot) / (std::string(Catalog::FILE_NAME) + ".lock")).string();
+    }
+
+    // False if the file is missing or can't be parsed (novels is then empty)
+    bool ReadCatalogFile(const std::filesystem::path& catalogPath, std::vector<Catalog::Novel>& novels) {
+        novels.clear();
+        std::string jsonText;
+        {
+            std::ifstream file(catalogPath, std::ios::binary);
+            if (!file.is_open()) return false;
+            jsonText.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        try {
+            if (!ReadNovelList(jsonText, novels)) {
+                json j = json::parse(jsonText);
+                if (!j.contains("novels")) return false;
+                novels = j["novels"].get<std::vector<Catalog::Novel>>();
+            }
+            return true;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error loading novels: " << e.what() << std::endl;
+            novels.clear();
+            return false;
+        }
+    }
+
+    // Write-then-rename, so a reader in another process never sees a half-written catalog
+    bool WriteCatalogFile(const std::string& novelsRoot, const std::vector<Catalog::Novel>& novels) {
+        try {
+            for (const auto& novel : novels) {
+                std::filesystem::create_directories(std::filesystem::path(Catalog::NovelDir(novelsRoot, novel.name)) / "chapters");
+            }
+
+            json j;
+            j["novels"] = novels;
+
+            std::filesystem::path catalogPath = CatalogPath(novelsRoot);
+            std::filesystem::path tempPath = catalogPath.string() + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::trunc);
+                if (!file.is_open()) {
+                    std::cerr << "Error: Could not open file for writing" << std::endl;
+                    return false;
+                }
+                file << j.dump(4);
+                if (!file) {
+                    std::cerr << "Error: Could not write " << tempPath << std::endl;
+                    return false;
+                }
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tempPath, catalogPath, ec);
+            if (ec) {
+                std::cerr << "Error: Could not replace " << catalogPath << ": " << ec.message() << std::endl;
+                return false;
+            }
+
+            std::cout << "Successfully saved " << novels.size() << " novels" << std::endl;
+            return true;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error saving novels: " << e.what() << std::endl;
+            return false;
+        }
+    }
+}
+
+bool Catalog::Load(const std::string& novelsRoot, std::vector<Novel>& novels) {
+    std::filesystem::path catalogPath = CatalogPath(novelsRoot);
+    if (!ReadCatalogFile(catalogPath, novels)) {
+        std::error_code ec;
+        if (!std::filesystem::exists(catalogPath, ec)) {
+            std::cout << "No existing novels file found" << std::endl;
+        }
+        return false;
+    }
+
+    // Update downloaded chapter counts for all novels
+    for (auto& novel : novels) {
+        novel.downloadedchapters = CountChapters(novelsRoot, novel.name);
+
+        // If downloadedchapters wasn't in the JSON, initialize it
+        if (novel.downloadedchapters == 0 && novel.totalchapters > 0) {
+            novel.downloadedchapters = novel.totalchapters; // Assume all are downloaded for existing novels
+        }
+    }
+    std::cout << "Successfully loaded " << novels.size() << " novels" << std::endl;
+    return true;
+}
+
+bool Catalog::Save(const std::string& novelsRoot, const std::vector<Novel>& novels, const std::vector<std::string>& removed,
+    std::vector<Novel>* catalogued) {
+    std::error_code ec;
+    std::filesystem::create_directories(novelsRoot, ec);
+    FileLock lock(CatalogLockPath(novelsRoot));
+
+    std::vector<Novel> merged = novels;
+    std::vector<Novel> stored;
+    ReadCatalogFile(CatalogPath(novelsRoot), stored);
+    for (Novel& novel : stored) {
+        if (Novel* listed = Find(merged, novel.name)) {
+            listed->totalchapters = std::max(listed->totalchapters, novel.totalchapters);
+            if (listed->synopsis.empty()) listed->synopsis = novel.synopsis;
+        }
+        else if (std::find(removed.begin(), removed.end(), novel.name) == removed.end()) {
+            novel.downloadedchapters = CountChapters(novelsRoot, novel.name);
+            merged.push_back(novel);
+            if (catalogued) catalogued->push_back(std::move(novel));
+        }
+    }
+    return WriteCatalogFile(novelsRoot, merged);
+}
+
+bool Catalog::Update(const std::string& novelsRoot, const std::function<void(std::vector<Novel>&)>& change) {
+    std::error_code ec;
+    std::filesystem::create_directories(novelsRoot, ec);
+    FileLock lock(CatalogLockPath(novelsRoot));
+
+    // A catalog that exists but can't be read is left alone rather than replaced by the change
+    std::vector<Novel> novels;
+    std::filesystem::path catalogPath = CatalogPath(novelsRoot);
+    if (!ReadCatalogFile(catalogPath, novels) && std::filesystem::exists(catalogPath, ec)) {
+        std::cerr << "Not updating unreadable catalog " << catalogPath << std::endl;
+        return false;
+    }
+    for (auto& novel : novels) {
+        novel.downloadedchapters = CountChapters(novelsRoot, novel.name);
+    }
+
+    change(novels);
+    return WriteCatalogFile(novelsRoot, novels);
+}
+
+bool Catalog::Add(const std::string& novelsRoot, std::vector<Novel>& novels, const Novel& novel) {
+    auto sameNovel = [&novel](const Novel& other) {
+        return other.name == novel.name && other.authorname == novel.authorname;
+    };
+
+    // Check for duplicates
+    if (std::any_of(novels.begin(), novels.end(), sameNovel)) {
+        std::cout << "Novel '" << novel.name << "' by " << novel.authorname
+            << " already exists. Skipping save." << std::endl;
+        return false;
+    }
+
+    Novel novelToSave = novel;
+    novelToSave.coverpath = CoverPath(novelsRoot, novel.name);
+    novels.push_back(novelToSave);
+
+    // Another process may have catalogued it since novels was loaded
+    return Update(novelsRoot, [&](std::vector<Novel>& catalogued) {
+        if (std::none_of(catalogued.begin(), catalogued.end(), sameNovel)) {
+            catalogued.push_back(novelToSave);
+        }
+    });
+}
+
+Catalog::Novel* Catalog::Find(std::vector<Novel>& novels, const std::string& name) {
+    for (auto& novel : novels) {
+        if (novel.name == name) return &novel;
+    }
+    return nullptr;
+}
+
+std::string Catalog::NovelDir(const std::string& novelsRoot, const std::string& name) {
+    return novelsRoot + "/" + name;
+}
+
+std::string Catalog::CoverPath(const std::string& novelsRoot, const std::string& name) {
+    return NovelDir(novelsRoot, name) + "/cover.jpg";
+}
+
+int Catalog::CountChapters(const std::string& novelsRoot, const std::string& name) {
+    std::filesystem::path chaptersDir = std::filesystem::path(NovelDir(novelsRoot, name)) / "chapters";
+    std::error_code ec;
+    if (!std::filesystem::exists(chaptersDir, ec)) {
+        return 0;
+    }
+
+    int count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(chaptersDir, ec)) {
+        if (entry.path().extension() == ".json") {
+            count++;
+        }
+    }
+    return count;
+}
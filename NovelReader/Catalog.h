@@ -0,0 +1,52 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// The library catalog, <novelsRoot>/Novels.json: the novels in the library, who wrote them and
+// how far they have been read. Shared by the app, novelreader-cli and the download daemon, which
+// may all be running: writes go through Novels.json.lock and replace the file in one rename.
+class Catalog {
+public:
+    static constexpr const char* FILE_NAME = "Novels.json";
+
+    class Novel {
+    public:
+        struct Progress {
+            int readchapters;
+            float progresspercentage;
+        };
+        std::string name;
+        std::string authorname;
+        std::string coverpath;
+        std::string synopsis;
+        int totalchapters;        // Total chapters available online
+        int downloadedchapters;   // Actually downloaded chapters
+        Progress progress;
+    };
+
+    // Replaces novels with the catalog, downloaded counts taken from disk. False if there is no
+    // catalog yet or it can't be read (novels is then empty).
+    static bool Load(const std::string& novelsRoot, std::vector<Novel>& novels);
+
+    // Writes novels as the catalog and makes sure every novel has its folder. For a process that
+    // keeps the catalog in memory (the app): novels another process catalogued since are kept,
+    // unless named in removed, and handed back in catalogued; for novels in both, a larger chapter
+    // total and a synopsis that novels lacks are kept from the file.
+    static bool Save(const std::string& novelsRoot, const std::vector<Novel>& novels,
+        const std::vector<std::string>& removed = {}, std::vector<Novel>* catalogued = nullptr);
+
+    // Reads the catalog, lets change edit it and writes it back, all under the catalog lock
+    static bool Update(const std::string& novelsRoot, const std::function<void(std::vector<Novel>&)>& change);
+
+    // Catalogs novel unless one with the same name and author is listed, and lists it in novels too
+    static bool Add(const std::string& novelsRoot, std::vector<Novel>& novels, const Novel& novel);
+
+    static Novel* Find(std::vector<Novel>& novels, const std::string& name);
+
+    static std::string NovelDir(const std::string& novelsRoot, const std::string& name);
+    static std::string CoverPath(const std::string& novelsRoot, const std::string& name);
+
+    // Chapter files in the novel's chapters folder
+    static int CountChapters(const std::string& novelsRoot, const std::string& name);
+};
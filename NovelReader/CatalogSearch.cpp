@@ -0,0 +1,119 @@
+#include "CatalogSearch.h"
+#include <algorithm>
+
+namespace {
+    // Relative weight of a full match in each field
+    constexpr float TITLE_WEIGHT = 1.0f;
+    constexpr float AUTHOR_WEIGHT = 0.8f;
+    constexpr float SYNOPSIS_WEIGHT = 0.4f;
+
+    // Added when the title holds every query gram, so "sha" ranks "Shadow" above "Marshal"
+    // ("sha" alone is just " sh" and "  s" apart from "sha", both anchored to a word start)
+    constexpr float TITLE_EXACT_BONUS = 0.5f;
+}
+
+std::string CatalogSearch::Key(std::string_view title, std::string_view author) {
+    std::string key(title);
+    key += '\x1F';
+    key += author;
+    return key;
+}
+
+void CatalogSearch::Add(const std::string& title, const std::string& author, std::string_view synopsis) {
+    std::string key = Key(title, author);
+
+    uint32_t id;
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+        id = it->second;
+    }
+    else {
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else {
+            id = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+        }
+        ids.emplace(std::move(key), id);
+    }
+
+    Entry& entry = entries[id];
+    entry.title = title;
+    entry.author = author;
+
+    titles.Add(id, title);
+    authors.Add(id, author);
+    synopses.Add(id, synopsis);
+}
+
+void CatalogSearch::Remove(const std::string& title, const std::string& author) {
+    auto it = ids.find(Key(title, author));
+    if (it == ids.end()) return;
+
+    uint32_t id = it->second;
+    ids.erase(it);
+
+    titles.Remove(id);
+    authors.Remove(id);
+    synopses.Remove(id);
+    entries[id] = Entry();
+    freeIds.push_back(id);
+}
+
+void CatalogSearch::Clear() {
+    titles.Clear();
+    authors.Clear();
+    synopses.Clear();
+    ids.clear();
+    entries.clear();
+    freeIds.clear();
+}
+
+void CatalogSearch::Search(std::string_view query, size_t maxResults, std::vector<Match>& out) const {
+    out.clear();
+
+    if (scores.size() < entries.size()) scores.resize(entries.size(), 0.0f);
+    scored.clear();
+
+    // Each field contributes its weight times the share of query grams it contains
+    auto accumulate = [&](const TrigramIndex& index, bool allowTypos, float weight, float exactBonus) {
+        size_t gramCount = index.QueryFuzzy(query, allowTypos, hits);
+        for (const TrigramIndex::FuzzyHit& hit : hits) {
+            if (scores[hit.id] == 0.0f) scored.push_back(hit.id);
+            scores[hit.id] += weight * hit.matchedGrams / static_cast<float>(gramCount);
+            if (hit.matchedGrams == gramCount) scores[hit.id] += exactBonus;
+        }
+    };
+
+    accumulate(titles, true, TITLE_WEIGHT, TITLE_EXACT_BONUS);
+    accumulate(authors, true, AUTHOR_WEIGHT, 0.0f);
+
+    // A synopsis alone scores below any title or author hit, so once those fill the results
+    // synopses could only reorder them slightly; short queries like "the" stop here.
+    // Long synopses also share a few grams with almost anything, so they need every gram.
+    if (scored.size() < maxResults) {
+        accumulate(synopses, false, SYNOPSIS_WEIGHT, 0.0f);
+    }
+
+    ranked.clear();
+    ranked.reserve(scored.size());
+    for (uint32_t id : scored) {
+        ranked.push_back({ scores[id], id });
+        scores[id] = 0.0f;
+    }
+
+    // Only the best few are ever shown, so rank those and leave the tail unsorted
+    auto better = [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    size_t keep = std::min(maxResults, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(), better);
+
+    out.reserve(keep);
+    for (size_t i = 0; i < keep; i++) {
+        const Entry& entry = entries[ranked[i].second];
+        out.push_back({ entry.title, entry.author, ranked[i].first });
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "TrigramIndex.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Typo-tolerant, ranked filtering of the library catalog as the user types.
+// Titles, authors and synopses each get their own TrigramIndex so a title hit can outrank
+// the same word buried in a synopsis. Entries are keyed by (title, author), the identity
+// AddNovel/RemoveNovel already use, and are updated one at a time as the catalog changes.
+class CatalogSearch {
+public:
+    struct Match {
+        std::string_view title;
+        std::string_view author;
+        float score = 0.0f;
+    };
+
+    // Adds the entry, or re-indexes it if (title, author) is already present
+    void Add(const std::string& title, const std::string& author, std::string_view synopsis);
+    void Remove(const std::string& title, const std::string& author);
+    void Clear();
+    size_t Size() const { return ids.size(); }
+
+    // Identity of a catalog entry, also usable by callers to map matches back to their own records
+    static std::string Key(std::string_view title, std::string_view author);
+
+    // Up to maxResults matches, best first. An empty query returns nothing; callers show the whole catalog.
+    void Search(std::string_view query, size_t maxResults, std::vector<Match>& out) const;
+
+private:
+    struct Entry {
+        std::string title;
+        std::string author;
+    };
+
+    TrigramIndex titles;
+    TrigramIndex authors;
+    TrigramIndex synopses;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<Entry> entries;          // Indexed by id
+    std::vector<uint32_t> freeIds;       // Ids of removed entries, reused so the id space stays dense
+
+    // Search scratch, indexed by id
+    mutable std::vector<float> scores;
+    mutable std::vector<uint32_t> scored;
+    mutable std::vector<TrigramIndex::FuzzyHit> hits;
+    mutable std::vector<std::pair<float, uint32_t>> ranked;
+};
@@ -0,0 +1,410 @@
+#include "ChapterCleaner.h"
+#include "BatchReader.h"
+#include "BlobStore.h"
+#include "ChapterStore.h"
+#include "ChapterText.h"
+#include "TaskScheduler.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr int RECORD_VERSION = 2;   // 2: chapters are normalized and measured (ChapterText)
+    constexpr size_t READ_BATCH = 256;
+    constexpr size_t MAX_SLOTS = 8;      // Runners on the shared scheduler, the calling thread included
+
+    // One novel at a time; rewrites of the same chapter must not share a temp file
+    std::mutex cleanMutex;
+
+    struct LineCount {
+        uint32_t chapters = 0;
+        std::string sample;   // Copied once the line repeats, so unique lines cost no text
+    };
+
+    struct Record {
+        size_t chapters = 0;
+        int64_t newest = 0;
+        ChapterCleaner::Boilerplate boilerplate;
+    };
+
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+    }
+
+    std::string_view Trim(std::string_view text) {
+        while (!text.empty() && IsSpace(text.front())) text.remove_prefix(1);
+        while (!text.empty() && IsSpace(text.back())) text.remove_suffix(1);
+        return text;
+    }
+
+    // Splits text into lines and calls visit(line) for each, without the '\n'
+    template <typename Visitor>
+    void ForEachLine(std::string_view text, Visitor visit) {
+        size_t lineStart = 0;
+        while (true) {
+            size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos) {
+                visit(text.substr(lineStart));
+                return;
+            }
+            visit(text.substr(lineStart, lineEnd - lineStart));
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    int ChapterNumberFromPath(const std::string& path) {
+        std::string stem = std::filesystem::path(path).stem().string();
+        try {
+            return std::stoi(stem.substr(7));
+        }
+        catch (...) {
+            return 0;
+        }
+    }
+
+    std::vector<std::string> ListChapters(const std::filesystem::path& chaptersDir) {
+        std::vector<std::pair<int, std::string>> numbered;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(chaptersDir, ec)) {
+            const std::filesystem::path& path = entry.path();
+            std::string stem = path.stem().string();
+            if (path.extension() != ".json" || stem.rfind("chapter", 0) != 0) continue;
+            try {
+                numbered.push_back({ std::stoi(stem.substr(7)), path.string() });
+            }
+            catch (...) {}
+        }
+        std::sort(numbered.begin(), numbered.end());
+
+        std::vector<std::string> paths;
+        for (auto& [number, path] : numbered) paths.push_back(std::move(path));
+        return paths;
+    }
+
+    // Newest modification time among the chapters; tier moves keep timestamps, so this only
+    // moves when a chapter was downloaded or rewritten
+    int64_t NewestChapter(const std::vector<std::string>& paths) {
+        int64_t newest = std::numeric_limits<int64_t>::min();   // file_time_type's epoch may be in the future
+        for (const std::string& path : paths) {
+            std::error_code ec;
+            auto modified = std::filesystem::last_write_time(path, ec);
+            if (!ec) newest = std::max<int64_t>(newest, modified.time_since_epoch().count());
+        }
+        return newest;
+    }
+
+    bool LoadRecord(const std::filesystem::path& recordPath, Record& record) {
+        std::ifstream file(recordPath);
+        if (!file.is_open()) return false;
+        try {
+            json j;
+            file >> j;
+            if (j.value("version", 0) != RECORD_VERSION) return false;
+            record.chapters = j.value("chapters", size_t(0));
+            record.newest = j.value("newest", int64_t(0));
+            for (const auto& hash : j.value("hashes", json::array())) {
+                record.boilerplate.hashes.insert(std::stoull(hash.get<std::string>(), nullptr, 16));
+            }
+            for (const auto& line : j.value("lines", json::array())) {
+                record.boilerplate.lines.push_back(line.get<std::string>());
+            }
+            return true;
+        }
+        catch (const std::exception& e) {
+            std::cout << "Ignoring unreadable " << recordPath.string() << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool SaveRecord(const std::filesystem::path& recordPath, const Record& record) {
+        json j;
+        j["version"] = RECORD_VERSION;
+        j["chapters"] = record.chapters;
+        j["newest"] = record.newest;
+
+        std::vector<uint64_t> hashes(record.boilerplate.hashes.begin(), record.boilerplate.hashes.end());
+        std::sort(hashes.begin(), hashes.end());
+        j["hashes"] = json::array();
+        for (uint64_t hash : hashes) {
+            char hex[17];
+            snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+            j["hashes"].push_back(hex);
+        }
+        j["lines"] = record.boilerplate.lines;
+
+        std::filesystem::path tempPath = recordPath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return false;
+            file << j.dump(2, ' ', false, json::error_handler_t::replace);
+            if (!file.good()) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tempPath, recordPath, ec);
+        return !ec;
+    }
+
+    // Reads the chapters in batches and runs work(slot, index, bytes) on each one that could be
+    // read, as background tasks on the shared scheduler; slot is below MAX_SLOTS
+    void ForEachChapter(const std::vector<std::string>& paths,
+        const std::function<void(size_t slot, size_t index, std::string& bytes)>& work) {
+        for (size_t begin = 0; begin < paths.size(); begin += READ_BATCH) {
+            size_t end = std::min(paths.size(), begin + READ_BATCH);
+            std::vector<std::string> bytes(end - begin);
+            std::vector<char> readOk(end - begin, 0);
+            std::vector<std::string> batchPaths(paths.begin() + begin, paths.begin() + end);
+            BatchReader::ReadBatch(BatchReader::WholeFiles(batchPaths), [&](size_t index, bool ok, std::string& data) {
+                readOk[index] = ok;
+                bytes[index] = std::move(data);
+            });
+
+            TaskScheduler::Shared().ParallelFor(bytes.size(), MAX_SLOTS, [&](size_t slot, size_t i) {
+                if (readOk[i]) work(slot, begin + i, bytes[i]);
+            });
+        }
+    }
+}
+
+uint64_t ChapterCleaner::LineHash(std::string_view line, size_t* normalizedLength) {
+    uint64_t hash = 14695981039346656037ull;
+    size_t length = 0;
+    bool pendingSpace = false;
+    for (char c : Trim(line)) {
+        if (IsSpace(c)) {
+            pendingSpace = true;
+            continue;
+        }
+        if (pendingSpace) {
+            hash = (hash ^ static_cast<uint8_t>(' ')) * 1099511628211ull;
+            length++;
+            pendingSpace = false;
+        }
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+        length++;
+    }
+    if (normalizedLength) *normalizedLength = length;
+    return hash;
+}
+
+bool ChapterCleaner::CleanContent(std::string& content, std::string_view title, const Boilerplate& boilerplate,
+    Stats* stats) {
+    std::string cleaned;
+    cleaned.reserve(content.size() + title.size() + 2);
+    bool changed = false;
+    bool firstParagraph = true;
+    size_t removed = 0;
+    bool titleSplit = false;
+
+    ForEachLine(content, [&](std::string_view line) {
+        std::string_view text = Trim(line);
+        if (!text.empty()) {
+            if (boilerplate.hashes.count(LineHash(text)) > 0) {
+                removed++;
+                changed = true;
+                cleaned += '\n';
+                return;
+            }
+
+            // The same lines glued onto a paragraph
+            std::string_view cut = text;
+            for (const std::string& known : boilerplate.lines) {
+                if (known.empty() || cut.size() <= known.size()) continue;
+                if (cut.ends_with(known)) cut = Trim(cut.substr(0, cut.size() - known.size()));
+                else if (cut.starts_with(known)) cut = Trim(cut.substr(known.size()));
+                else continue;
+                removed++;
+            }
+            if (cut.size() != text.size()) {
+                line = text = cut;
+                changed = true;
+            }
+
+            if (std::exchange(firstParagraph, false) && !title.empty() && text.size() > title.size() &&
+                text.starts_with(title) && !IsSpace(text[title.size()])) {
+                cleaned.append(title);
+                cleaned += "\n\n";
+                line = text.substr(title.size());
+                titleSplit = true;
+                changed = true;
+            }
+        }
+        cleaned.append(line);
+        cleaned += '\n';
+    });
+    if (!changed) return false;
+
+    // Removed lines leave their blank neighbours behind: keep one blank line between paragraphs
+    std::string collapsed;
+    collapsed.reserve(cleaned.size());
+    bool pendingBlank = false;
+    ForEachLine(cleaned, [&](std::string_view line) {
+        if (Trim(line).empty()) {
+            pendingBlank = !collapsed.empty();
+            return;
+        }
+        if (!collapsed.empty()) collapsed += pendingBlank ? "\n\n" : "\n";
+        collapsed.append(line);
+        pendingBlank = false;
+    });
+
+    content = std::move(collapsed);
+    if (stats) {
+        stats->linesRemoved += removed;
+        stats->titlesSplit += titleSplit;
+    }
+    return true;
+}
+
+bool ChapterCleaner::EnsureCleaned(const std::string& novelDir, Stats* stats) {
+    std::filesystem::path dir(novelDir);
+    std::vector<std::string> paths = ListChapters(dir / "chapters");
+    if (paths.empty()) return false;
+
+    Record record;
+    if (LoadRecord(dir / RECORD_FILE, record) && record.chapters == paths.size() && record.newest == NewestChapter(paths) &&
+        std::filesystem::exists(dir / ChapterText::STATS_FILE)) {
+        return true;
+    }
+    return CleanNovel(novelDir, stats);
+}
+
+bool ChapterCleaner::CleanNovel(const std::string& novelDir, Stats* stats) {
+    std::lock_guard<std::mutex> cleanLock(cleanMutex);
+
+    std::filesystem::path dir(novelDir);
+    std::filesystem::path recordPath = dir / RECORD_FILE;
+    std::vector<std::string> paths = ListChapters(dir / "chapters");
+    if (paths.empty()) return false;
+
+    Record record;
+    LoadRecord(recordPath, record);
+    Boilerplate& boilerplate = record.boilerplate;
+
+    // Pass 1: in how many chapters each line appears. Each slot counts its own chapters.
+    std::vector<std::unordered_map<uint64_t, LineCount>> counts(MAX_SLOTS);
+    ForEachChapter(paths, [&](size_t slot, size_t index, std::string& bytes) {
+        ChapterStore::MappedChapter chapter;
+        if (!ChapterStore::OpenChapterBytes(paths[index], std::move(bytes), chapter)) return;
+
+        std::vector<std::pair<uint64_t, std::string_view>> lines;
+        ForEachLine(chapter.Body(), [&](std::string_view line) {
+            size_t length = 0;
+            uint64_t hash = LineHash(line, &length);
+            if (length >= MIN_LINE_LENGTH) lines.push_back({ hash, Trim(line) });
+        });
+
+        // A line repeated within one chapter still counts once
+        std::sort(lines.begin(), lines.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        lines.erase(std::unique(lines.begin(), lines.end(),
+            [](const auto& a, const auto& b) { return a.first == b.first; }), lines.end());
+
+        for (const auto& [hash, text] : lines) {
+            LineCount& count = counts[slot][hash];
+            if (++count.chapters == 2) count.sample.assign(text);
+        }
+    });
+
+    std::unordered_map<uint64_t, LineCount> merged = std::move(counts[0]);
+    for (size_t slot = 1; slot < MAX_SLOTS; slot++) {
+        for (auto& [hash, count] : counts[slot]) {
+            LineCount& total = merged[hash];
+            total.chapters += count.chapters;
+            if (total.sample.empty()) total.sample = std::move(count.sample);
+        }
+        counts[slot].clear();
+    }
+
+    size_t threshold = std::max(MIN_CHAPTERS,
+        static_cast<size_t>(std::ceil(MIN_CHAPTER_SHARE * static_cast<double>(paths.size()))));
+    std::unordered_set<std::string> knownLines(boilerplate.lines.begin(), boilerplate.lines.end());
+    for (const auto& [hash, count] : merged) {
+        if (count.chapters < threshold) continue;
+        boilerplate.hashes.insert(hash);
+        if (!count.sample.empty() && knownLines.insert(count.sample).second) boilerplate.lines.push_back(count.sample);
+    }
+    merged.clear();
+
+    // Pass 2: clean, normalize and measure every chapter; rewrite the ones that change, each in
+    // the tier it is in
+    Stats totals;
+    totals.chapters = paths.size();
+    totals.boilerplateLines = boilerplate.hashes.size();
+    ChapterText::NovelStats novelStats;
+    std::mutex totalsMutex;
+    ForEachChapter(paths, [&](size_t, size_t index, std::string& bytes) {
+        const std::string& path = paths[index];
+        bool compressed = ChapterStore::IsCompressed(bytes);
+        ChapterStore::MappedChapter chapter;
+        if (!ChapterStore::OpenChapterBytes(path, std::move(bytes), chapter)) return;
+
+        std::string content(chapter.Body());
+        Stats chapterStats;
+        bool cleaned = CleanContent(content, chapter.Title(), boilerplate, &chapterStats);
+        bool normalized = ChapterText::Normalize(content);
+        ChapterText::Metrics metrics = ChapterText::Measure(content);
+
+        int number = chapter.Number() > 0 ? chapter.Number() : ChapterNumberFromPath(path);
+        {
+            std::lock_guard<std::mutex> lock(totalsMutex);
+            novelStats.chapters[number] = { metrics.words, static_cast<uint32_t>(metrics.paragraphs.size()) };
+            novelStats.totalWords += metrics.words;
+            totals.normalized += normalized;
+        }
+
+        bool measured = chapter.WordCount() == static_cast<int64_t>(metrics.words) &&
+            chapter.ParagraphOffsets() == metrics.paragraphs;
+        if (!cleaned && !normalized && measured) return;
+
+        // Everything but the content is kept as the downloader wrote it
+        std::string jsonText;
+        if (!ChapterStore::ReadChapterJson(path, jsonText)) return;
+        json j = json::parse(jsonText, nullptr, false);
+        if (j.is_discarded() || !j.is_object()) return;
+        j["content"] = content;
+        j["wordCount"] = metrics.words;
+        j["paragraphOffsets"] = metrics.paragraphs;
+        std::string cleanedJson = j.dump(-1, ' ', false, json::error_handler_t::replace);
+
+        bool written = compressed ? ChapterStore::WriteChapterJson(path, cleanedJson) :
+            BlobStore::ForChapterFile(path).Put(path, cleanedJson);
+        if (!written) {
+            std::cout << "Could not write cleaned chapter " << path << std::endl;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        totals.rewritten++;
+        totals.linesRemoved += chapterStats.linesRemoved;
+        totals.titlesSplit += chapterStats.titlesSplit;
+    });
+
+    if (totals.rewritten > 0) {
+        std::cout << "Cleaned " << dir.filename().string() << ": " << totals.rewritten << " of " << totals.chapters
+            << " chapters rewritten, " << totals.linesRemoved << " boilerplate lines removed, "
+            << totals.titlesSplit << " titles split, " << totals.normalized << " normalized" << std::endl;
+    }
+    if (!ChapterText::SaveNovelStats(novelDir, novelStats)) {
+        std::cout << "Could not save " << (dir / ChapterText::STATS_FILE).string() << std::endl;
+    }
+
+    // Taken after the rewrites, which are changes of our own
+    record.chapters = paths.size();
+    record.newest = NewestChapter(paths);
+    if (!SaveRecord(recordPath, record)) {
+        std::cout << "Could not save " << recordPath.string() << std::endl;
+    }
+
+    if (stats) *stats = totals;
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+#include <cstddef>
+
+// Cleans a novel's chapter text once, at ingest, so the reader, the search index and the
+// dictionary trainer never see scraped noise.
+//
+// Sites stamp their chapters with the same lines: "read at ..." watermarks, translator and
+// patron notes. Every line is normalized (trimmed, whitespace collapsed, ASCII lowercased) and
+// hashed, and a line found in enough of a novel's chapters is boilerplate: it is removed where
+// it stands alone and cut off where it is glued to the start or end of a paragraph. Scrapers
+// also glue the chapter title onto the first paragraph ("Chapter 1 Nightmare BeginsA
+// frail-looking..."), which is split into a paragraph of its own.
+//
+// What was learned is kept in <novel>/boilerplate.json, so chapters downloaded later are cleaned
+// of lines the older chapters no longer contain. The same pass brings every chapter into
+// ChapterText's canonical form and stores its word count and paragraph offsets, with the
+// novel's totals in <novel>/text_stats.json. A chapter is only rewritten when its text or
+// its stored numbers changed, and stays in its tier. ChapterTiering runs this from its sweep,
+// before the novel's dictionary is trained.
+class ChapterCleaner {
+public:
+    static constexpr const char* RECORD_FILE = "boilerplate.json";
+    static constexpr size_t MIN_CHAPTERS = 5;           // A line must repeat in at least this many chapters
+    static constexpr double MIN_CHAPTER_SHARE = 0.25;   // ... and in at least this share of them
+    static constexpr size_t MIN_LINE_LENGTH = 16;       // Shorter lines ("He nodded.") repeat on their own
+
+    struct Boilerplate {
+        std::unordered_set<uint64_t> hashes;
+        std::vector<std::string> lines;   // As they appeared, for cutting glued copies; may miss some hashes
+    };
+
+    struct Stats {
+        size_t chapters = 0;
+        size_t rewritten = 0;
+        size_t boilerplateLines = 0;
+        size_t linesRemoved = 0;
+        size_t titlesSplit = 0;
+        size_t normalized = 0;   // Chapters ChapterText::Normalize changed
+    };
+
+    // Cleans the novel if its chapter files changed since it was last cleaned.
+    // novelDir is the novel's folder, with chapters/ inside.
+    static bool EnsureCleaned(const std::string& novelDir, Stats* stats = nullptr);
+    static bool CleanNovel(const std::string& novelDir, Stats* stats = nullptr);
+
+    // Cleans one chapter's content in place; returns true if anything changed
+    static bool CleanContent(std::string& content, std::string_view title, const Boilerplate& boilerplate,
+        Stats* stats = nullptr);
+
+    // Hash of the normalized line; normalizedLength is 0 for a blank line
+    static uint64_t LineHash(std::string_view line, size_t* normalizedLength = nullptr);
+};
@@ -0,0 +1,81 @@
+#include "ChapterJournal.h"
+#include "Dependecies/json.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+using json = nlohmann::json;
+
+namespace {
+    // One line per write, so lines from the scanner and the UI thread never interleave
+    std::mutex appendMutex;
+
+    std::filesystem::path JournalPath(const std::string& contentDir) {
+        return std::filesystem::path(contentDir) / ChapterJournal::FILE_NAME;
+    }
+}
+
+bool ChapterJournal::Append(const std::string& contentDir, Entry entry) {
+    if (entry.time == 0) entry.time = std::time(nullptr);
+
+    json j;
+    j["time"] = static_cast<int64_t>(entry.time);
+    j["chapter"] = entry.chapter;
+    if (!entry.page.empty()) j["page"] = entry.page;
+    j["event"] = entry.event;
+    if (!entry.detail.empty()) j["detail"] = entry.detail;
+    std::string line = j.dump(-1, ' ', false, json::error_handler_t::replace) + "\n";
+
+    std::lock_guard<std::mutex> lock(appendMutex);
+    std::ofstream file(JournalPath(contentDir), std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        std::cout << "Could not write chapter journal in " << contentDir << std::endl;
+        return false;
+    }
+    file << line;
+    return file.good();
+}
+
+std::vector<ChapterJournal::Entry> ChapterJournal::Read(const std::string& contentDir) {
+    std::vector<Entry> entries;
+    std::ifstream file(JournalPath(contentDir), std::ios::binary);
+    if (!file.is_open()) return entries;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        try {
+            json j = json::parse(line);
+            Entry entry;
+            entry.time = static_cast<std::time_t>(j.value("time", int64_t(0)));
+            entry.chapter = j.value("chapter", 0);
+            entry.page = j.value("page", "");
+            entry.event = j.value("event", "");
+            entry.detail = j.value("detail", "");
+            entries.push_back(std::move(entry));
+        }
+        catch (...) {
+            // A torn line from an interrupted append; the rest of the journal is still good
+        }
+    }
+    return entries;
+}
+
+std::map<std::string, ChapterJournal::Entry> ChapterJournal::Damaged(const std::string& contentDir) {
+    std::map<std::string, Entry> damaged;
+    for (Entry& entry : Read(contentDir)) {
+        if (entry.event == DAMAGED) {
+            std::string key = Key(entry.chapter, entry.page);
+            damaged[key] = std::move(entry);
+        }
+        else if (entry.event == REPAIRED) {
+            damaged.erase(Key(entry.chapter, entry.page));
+        }
+    }
+    return damaged;
+}
+
+std::string ChapterJournal::Key(int chapter, const std::string& page) {
+    return page.empty() ? std::to_string(chapter) : std::to_string(chapter) + "/" + page;
+}
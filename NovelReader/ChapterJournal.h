@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+
+// What happened to the chapters of one novel or manga, kept next to them as
+// <content folder>/journal.jsonl: one JSON object per line, appended and never rewritten.
+//
+// The integrity scanner records chapters and pages it found damaged and, on a later pass,
+// repaired; the reader records chapters that failed to open; the library records re-downloads
+// it queued. A chapter's state is the last damaged/repaired event about it, so a torn last
+// line (a crash mid-append) costs at most that one event.
+class ChapterJournal {
+public:
+    static constexpr const char* FILE_NAME = "journal.jsonl";
+
+    // Events
+    static constexpr const char* DAMAGED = "damaged";
+    static constexpr const char* REPAIRED = "repaired";
+    static constexpr const char* REDOWNLOAD = "redownload";
+
+    struct Entry {
+        std::time_t time = 0;
+        int chapter = 0;
+        std::string page;     // Manga page file name; empty for a whole chapter
+        std::string event;
+        std::string detail;   // Why it is damaged, where the re-download came from, ...
+    };
+
+    // Thread-safe. time is filled in if left 0.
+    static bool Append(const std::string& contentDir, Entry entry);
+    static std::vector<Entry> Read(const std::string& contentDir);
+
+    // Chapters and pages whose latest state is damaged, by Key
+    static std::map<std::string, Entry> Damaged(const std::string& contentDir);
+    static std::string Key(int chapter, const std::string& page);
+};
@@ -1,14 +1,53 @@
 ﻿#include "ChapterManager.h"
+#include "ChapterStore.h"
+#include "ChapterJournal.h"
 #include "Library.h"
 #include "Dependecies/json.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <charconv>
 #include "ImGui/imgui.h"
 #include "Dependecies/FontAwesome.h"
 
 using json = nlohmann::json;
 
+namespace {
+    constexpr size_t MAX_FIND_HITS = 10000;
+    constexpr int MAX_FIND_LOOKAHEAD = 5;
+    constexpr ImU32 FIND_HIT_COLOR = IM_COL32(255, 210, 0, 70);
+    constexpr ImU32 FIND_CURRENT_COLOR = IM_COL32(255, 140, 0, 150);
+    constexpr float GREP_RESULTS_HEIGHT = 220.0f;
+    constexpr int CHAPTERS_KEPT_BEHIND = 1;   // Mapped chapters around the current one; ahead covers find lookahead
+
+    // A chapter file that is there but won't open is damaged; the novel's journal keeps it
+    // until the integrity scanner sees the chapter intact again
+    void JournalOpenFailure(const std::string& path) {
+        std::filesystem::path chapterPath(path);
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(chapterPath, ec)) return;
+
+        std::string stem = chapterPath.stem().string();
+        int chapter = 0;
+        if (stem.rfind("chapter", 0) != 0 ||
+            std::from_chars(stem.data() + 7, stem.data() + stem.size(), chapter).ec != std::errc()) {
+            return;
+        }
+
+        std::string novelDir = chapterPath.parent_path().parent_path().string();
+        if (ChapterJournal::Damaged(novelDir).count(ChapterJournal::Key(chapter, "")) > 0) return;   // Already known
+
+        ChapterJournal::Entry entry;
+        entry.chapter = chapter;
+        entry.event = ChapterJournal::DAMAGED;
+        entry.detail = "failed to open while reading";
+        ChapterJournal::Append(novelDir, entry);
+    }
+}
+
 ChapterManager::ChapterManager() {
     LoadSettings();
     InitializeFonts();
@@ -72,16 +111,10 @@ void to_json(json& j, const ChapterManager::Chapter& c) {
     j = json{
         {"chapterNumber", c.chapterNumber},
         {"title", c.title},
-        {"content", c.content}
+        {"content", std::string(c.Content())}
     };
 }
 
-void from_json(const json& j, ChapterManager::Chapter& c) {
-    j.at("chapterNumber").get_to(c.chapterNumber);
-    j.at("title").get_to(c.title);
-    j.at("content").get_to(c.content);
-}
-
 // Font Management
 bool ChapterManager::InitializeFonts() {
     if (fontsInitialized) return true;
@@ -445,6 +478,17 @@ void ChapterManager::RenderContentOnly() {
         return;
     }
 
+    if (ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_F)) {
+        OpenFind();
+    }
+    if (find.open) {
+        if (ImGui::IsKeyPressed(ImGuiKey_F3)) {
+            StepFindHit(ImGui::GetIO().KeyShift ? -1 : 1);
+        }
+        RenderFindBar();
+        UpdateFindResults();
+    }
+
     // Calculate font scale based on settings
     float fontScale = settings.fontSize / 18.0f;
 
@@ -551,10 +595,26 @@ void ChapterManager::RenderContentOnly() {
     // Add top padding
     ImGui::Dummy(ImVec2(0, settings.marginSize));
 
+    // Element a search hit asked us to bring into view, if any
+    size_t scrollTargetElement = SIZE_MAX;
+    if (pendingScrollParagraph >= 0 && pendingScrollParagraph < static_cast<int>(paragraphElementStart.size())) {
+        scrollTargetElement = paragraphElementStart[pendingScrollParagraph];
+    }
+    pendingScrollParagraph = -1;
+
+    if (find.scrollToCurrent && find.currentHit >= 0 && find.currentHit < static_cast<int>(find.hits.size())) {
+        scrollTargetElement = find.hits[find.currentHit].element;
+    }
+    find.scrollToCurrent = false;
+
     // Render content with font scaling (no font switching)
     for (size_t i = 0; i < parsedContent.size(); i++) {
         const auto& element = parsedContent[i];
 
+        if (i == scrollTargetElement) {
+            ImGui::SetScrollHereY(0.2f);
+        }
+
         switch (element.type) {
         case TextElement::HEADER1:
         {
@@ -562,7 +622,7 @@ void ChapterManager::RenderContentOnly() {
             ImGui::PushStyleColor(ImGuiCol_Text, settings.headerColor);
 
             ImGui::SetWindowFontScale(fontScale * settings.headerFontScale);
-            ImGui::TextWrapped("%s", element.text.c_str());
+            RenderElementText(i);
             ImGui::SetWindowFontScale(fontScale);
 
             ImGui::PopStyleColor();
@@ -576,7 +636,7 @@ void ChapterManager::RenderContentOnly() {
             ImGui::PushStyleColor(ImGuiCol_Text, settings.headerColor);
 
             ImGui::SetWindowFontScale(fontScale * settings.header2FontScale);
-            ImGui::TextWrapped("%s", element.text.c_str());
+            RenderElementText(i);
             ImGui::SetWindowFontScale(fontScale);
 
             ImGui::PopStyleColor();
@@ -590,7 +650,7 @@ void ChapterManager::RenderContentOnly() {
             ImGui::PushStyleColor(ImGuiCol_Text, settings.headerColor);
 
             ImGui::SetWindowFontScale(fontScale * settings.header3FontScale);
-            ImGui::TextWrapped("%s", element.text.c_str());
+            RenderElementText(i);
             ImGui::SetWindowFontScale(fontScale);
 
             ImGui::PopStyleColor();
@@ -601,7 +661,7 @@ void ChapterManager::RenderContentOnly() {
         case TextElement::BOLD:
         {
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
-            ImGui::TextWrapped("%s", element.text.c_str());
+            RenderElementText(i);
             ImGui::PopStyleColor();
             if (i + 1 < parsedContent.size() &&
                 parsedContent[i + 1].type != TextElement::LINE_BREAK &&
@@ -614,7 +674,7 @@ void ChapterManager::RenderContentOnly() {
         case TextElement::ITALIC:
         {
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.9f, 1.0f, 1.0f));
-            ImGui::TextWrapped("%s", element.text.c_str());
+            RenderElementText(i);
             ImGui::PopStyleColor();
             if (i + 1 < parsedContent.size() &&
                 parsedContent[i + 1].type != TextElement::LINE_BREAK &&
@@ -627,7 +687,7 @@ void ChapterManager::RenderContentOnly() {
         case TextElement::TEXT:
         {
             if (!element.text.empty()) {
-                ImGui::TextWrapped("%s", element.text.c_str());
+                RenderElementText(i);
                 if (i + 1 < parsedContent.size() &&
                     parsedContent[i + 1].type != TextElement::LINE_BREAK &&
                     parsedContent[i + 1].type != TextElement::PARAGRAPH_BREAK) {
@@ -686,29 +746,28 @@ void ChapterManager::RenderContentOnly() {
 bool ChapterManager::LoadChapter(const std::string& filePath) {
 
     try {
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
+        Chapter chapter;
+        if (!ChapterStore::OpenChapter(filePath, chapter.text)) {
             std::cout << "Failed to open chapter file: " << filePath << std::endl;
+            JournalOpenFailure(filePath);
             return false;
         }
-
-        json j;
-        file >> j;
-        file.close();
-
-        Chapter chapter = j.get<Chapter>();
+        chapter.chapterNumber = chapter.text.Number();
+        chapter.title.assign(chapter.text.Title());
+        chapter.path = filePath;
+        std::cout << "Loaded chapter: " << chapter.title << std::endl;
 
         bool found = false;
         for (auto& ch : chapters) {
             if (ch.chapterNumber == chapter.chapterNumber) {
-                ch = chapter;
+                ch = std::move(chapter);
                 found = true;
                 break;
             }
         }
 
         if (!found) {
-            chapters.push_back(chapter);
+            chapters.push_back(std::move(chapter));
         }
 
         std::sort(chapters.begin(), chapters.end(),
@@ -717,7 +776,6 @@ bool ChapterManager::LoadChapter(const std::string& filePath) {
             });
 
         contentNeedsReparsing = true;
-        std::cout << "Loaded chapter: " << chapter.title << std::endl;
         return true;
 
     }
@@ -735,15 +793,11 @@ bool ChapterManager::SaveChapter(const Chapter& chapter, const std::string& nove
         std::string filename = novelDir + "/chapter" + std::to_string(chapter.chapterNumber) + ".json";
 
         json j = chapter;
-        std::ofstream file(filename);
-        if (!file.is_open()) {
+        if (!ChapterStore::WriteChapterJson(filename, j.dump())) {
             std::cout << "Failed to create chapter file: " << filename << std::endl;
             return false;
         }
 
-        file << j.dump(4);
-        file.close();
-
         std::cout << "Saved chapter to: " << filename << std::endl;
         return true;
 
@@ -758,6 +812,8 @@ void ChapterManager::ParseMarkdownContent() {
     if (!contentNeedsReparsing) return;
 
     parsedContent.clear();
+    paragraphElementStart.clear();
+    find.textDirty = true;
 
     if (chapters.empty() || settings.currentChapter < 1 ||
         settings.currentChapter > chapters.size()) {
@@ -765,16 +821,43 @@ void ChapterManager::ParseMarkdownContent() {
         return;
     }
 
-    const Chapter& current = chapters[settings.currentChapter - 1];
-    std::string content = current.content;
+    parsedChapter.Close();
+    parsedStorage = std::make_shared<std::deque<std::string>>();
+    if (!EnsureChapterOpen(settings.currentChapter - 1)) {
+        contentNeedsReparsing = false;
+        return;
+    }
+    ReleaseDistantChapters();
 
-    std::istringstream stream(content);
-    std::string line;
+    // Elements are views into the chapter's text; nothing is copied per line
+    parsedChapter = chapters[settings.currentChapter - 1].text;
+    std::string_view content = parsedChapter.Body();
     bool lastLineWasEmpty = false;
 
-    while (std::getline(stream, line)) {
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
+    // Paragraph offsets stored at ingest (see ChapterText) jump from one paragraph straight to
+    // the next instead of scanning the blank lines in between
+    const std::vector<uint32_t>& paragraphOffsets = parsedChapter.ParagraphOffsets();
+    size_t nextParagraph = 0;
+
+    size_t lineStart = 0;
+    while (lineStart < content.size()) {
+        if (!paragraphOffsets.empty()) {
+            if (nextParagraph == paragraphOffsets.size()) break;
+            size_t paragraphStart = paragraphOffsets[nextParagraph++];
+            if (paragraphStart > lineStart && !lastLineWasEmpty) {
+                parsedContent.emplace_back(TextElement::PARAGRAPH_BREAK, "");
+            }
+            lineStart = paragraphStart;
+        }
+
+        size_t lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = content.size();
+        std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        size_t first = line.find_first_not_of(" \t\r\n");
+        line = (first == std::string_view::npos) ? std::string_view() :
+            line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
 
         if (line.empty()) {
             if (!lastLineWasEmpty) {
@@ -785,6 +868,7 @@ void ChapterManager::ParseMarkdownContent() {
         }
 
         lastLineWasEmpty = false;
+        paragraphElementStart.push_back(parsedContent.size());
 
         if (line.length() >= 4 && line.substr(0, 3) == "### ") {
             parsedContent.emplace_back(TextElement::HEADER3, line.substr(4));
@@ -796,7 +880,8 @@ void ChapterManager::ParseMarkdownContent() {
             parsedContent.emplace_back(TextElement::HEADER1, line.substr(2));
         }
         else if (line.length() >= 2 && (line.substr(0, 2) == "- " || line.substr(0, 2) == "* ")) {
-            parsedContent.emplace_back(TextElement::TEXT, "• " + line.substr(2));
+            parsedStorage->push_back("• " + std::string(line.substr(2)));
+            parsedContent.emplace_back(TextElement::TEXT, parsedStorage->back());
             parsedContent.emplace_back(TextElement::LINE_BREAK, "");
         }
         else {
@@ -808,13 +893,13 @@ void ChapterManager::ParseMarkdownContent() {
     contentNeedsReparsing = false;
 }
 
-void ChapterManager::ParseInlineFormatting(const std::string& line) {
+void ChapterManager::ParseInlineFormatting(std::string_view line) {
     if (line.empty()) {
         parsedContent.emplace_back(TextElement::PARAGRAPH_BREAK, "");
         return;
     }
 
-    std::string currentText = line;
+    std::string_view currentText = line;
     size_t pos = 0;
 
     while (pos < currentText.length()) {
@@ -822,12 +907,12 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
         size_t italicStart = currentText.find("*", pos);
 
         // Skip if italic is part of bold marker
-        if (italicStart != std::string::npos && italicStart == boldStart) {
+        if (italicStart != std::string_view::npos && italicStart == boldStart) {
             italicStart = currentText.find("*", boldStart + 2);
-            if (italicStart != std::string::npos && italicStart == boldStart + 1) {
+            if (italicStart != std::string_view::npos && italicStart == boldStart + 1) {
                 // This is still part of **, look for next single *
                 italicStart = currentText.find("*", boldStart + 2);
-                while (italicStart != std::string::npos &&
+                while (italicStart != std::string_view::npos &&
                     italicStart + 1 < currentText.length() &&
                     currentText[italicStart + 1] == '*') {
                     italicStart = currentText.find("*", italicStart + 2);
@@ -836,12 +921,12 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
         }
 
         // Process bold first if it comes before italic
-        if (boldStart != std::string::npos &&
-            (italicStart == std::string::npos || boldStart < italicStart)) {
+        if (boldStart != std::string_view::npos &&
+            (italicStart == std::string_view::npos || boldStart < italicStart)) {
 
             // Add text before bold
             if (boldStart > pos) {
-                std::string beforeText = currentText.substr(pos, boldStart - pos);
+                std::string_view beforeText = currentText.substr(pos, boldStart - pos);
                 if (!beforeText.empty()) {
                     parsedContent.emplace_back(TextElement::TEXT, beforeText);
                 }
@@ -849,8 +934,8 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
 
             // Find end of bold
             size_t boldEnd = currentText.find("**", boldStart + 2);
-            if (boldEnd != std::string::npos) {
-                std::string boldText = currentText.substr(boldStart + 2, boldEnd - boldStart - 2);
+            if (boldEnd != std::string_view::npos) {
+                std::string_view boldText = currentText.substr(boldStart + 2, boldEnd - boldStart - 2);
                 if (!boldText.empty()) {
                     parsedContent.emplace_back(TextElement::BOLD, boldText);
                 }
@@ -858,7 +943,7 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
             }
             else {
                 // No closing **, treat as regular text
-                std::string remainingText = currentText.substr(boldStart);
+                std::string_view remainingText = currentText.substr(boldStart);
                 if (!remainingText.empty()) {
                     parsedContent.emplace_back(TextElement::TEXT, remainingText);
                 }
@@ -866,10 +951,10 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
             }
         }
         // Process italic
-        else if (italicStart != std::string::npos) {
+        else if (italicStart != std::string_view::npos) {
             // Add text before italic
             if (italicStart > pos) {
-                std::string beforeText = currentText.substr(pos, italicStart - pos);
+                std::string_view beforeText = currentText.substr(pos, italicStart - pos);
                 if (!beforeText.empty()) {
                     parsedContent.emplace_back(TextElement::TEXT, beforeText);
                 }
@@ -894,7 +979,7 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
             }
 
             if (italicEnd < currentText.length() && currentText[italicEnd] == '*') {
-                std::string italicText = currentText.substr(italicStart + 1, italicEnd - italicStart - 1);
+                std::string_view italicText = currentText.substr(italicStart + 1, italicEnd - italicStart - 1);
                 if (!italicText.empty()) {
                     parsedContent.emplace_back(TextElement::ITALIC, italicText);
                 }
@@ -902,7 +987,7 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
             }
             else {
                 // No closing *, treat as regular text
-                std::string remainingText = currentText.substr(italicStart);
+                std::string_view remainingText = currentText.substr(italicStart);
                 if (!remainingText.empty()) {
                     parsedContent.emplace_back(TextElement::TEXT, remainingText);
                 }
@@ -911,7 +996,7 @@ void ChapterManager::ParseInlineFormatting(const std::string& line) {
         }
         // No more formatting, add remaining text
         else {
-            std::string remainingText = currentText.substr(pos);
+            std::string_view remainingText = currentText.substr(pos);
             if (!remainingText.empty()) {
                 parsedContent.emplace_back(TextElement::TEXT, remainingText);
             }
@@ -973,6 +1058,7 @@ void ChapterManager::OpenChapter(int chapterNumber) {
         settings.currentChapter = chapterNumber;
         settings.scrollPosition = 0.0f;
         contentNeedsReparsing = true;
+        EnsureChapterOpen(chapterNumber - 1);   // The title is shown before the next reparse
 
         // Notify Library of reading progress update
         if (libraryPtr && !novelTitle.empty()) {
@@ -1004,12 +1090,33 @@ void ChapterManager::LoadChaptersFromDirectory(const std::string& novelName) {
 
     chapters.clear();
     chaptersLoadedInCache = false;
+    ChapterText::LoadNovelStats("Novels/" + novelName, textStats);
 
+    // Only list the chapters here; each is mapped when it is first read
     for (const auto& entry : std::filesystem::directory_iterator(chaptersDir)) {
-        if (entry.path().extension() == ".json") {
+        if (entry.path().extension() != ".json") continue;
+
+        std::string stem = entry.path().stem().string();
+        int number = 0;
+        bool named = stem.rfind("chapter", 0) == 0;
+        if (named) {
+            auto [end, ec] = std::from_chars(stem.data() + 7, stem.data() + stem.size(), number);
+            named = ec == std::errc() && end == stem.data() + stem.size() && number > 0;
+        }
+
+        if (named) {
+            Chapter chapter;
+            chapter.chapterNumber = number;
+            chapter.path = entry.path().string();
+            chapters.push_back(std::move(chapter));
+        }
+        else {
+            // Not named after its number; open it to find out
             LoadChapter(entry.path().string());
         }
     }
+    std::sort(chapters.begin(), chapters.end(),
+        [](const Chapter& a, const Chapter& b) { return a.chapterNumber < b.chapterNumber; });
 
     if (!chapters.empty()) {
         settings.currentChapter = 1;
@@ -1320,8 +1427,7 @@ void ChapterManager::RenderNavigationTab() {
 
     if (!chapters.empty()) {
         ImGui::Text("Current: Chapter %d of %zu", settings.currentChapter, chapters.size());
-        ImGui::ProgressBar((float)settings.currentChapter / (float)chapters.size(),
-            ImVec2(300, 0), "");
+        ImGui::ProgressBar(NovelCompletion(), ImVec2(300, 0), "");
 
         ImGui::Spacing();
 
@@ -1360,12 +1466,447 @@ void ChapterManager::RenderNavigationTab() {
         ImGui::Text("📊 Reading Statistics");
         ImGui::Separator();
 
-        float completion = (float)settings.currentChapter / (float)chapters.size() * 100.0f;
-        ImGui::Text("Novel Completion: %.1f%%", completion);
+        ImGui::Text("Novel Completion: %.1f%%", NovelCompletion() * 100.0f);
         ImGui::Text("Chapters Read: %d", settings.currentChapter - 1);
         ImGui::Text("Chapters Remaining: %d", (int)chapters.size() - settings.currentChapter + 1);
+        if (textStats.totalWords > 0) {
+            uint64_t remaining = textStats.WordsFrom(chapters[settings.currentChapter - 1].chapterNumber);
+            ImGui::Text("Words Remaining: %llu (about %s)", static_cast<unsigned long long>(remaining),
+                ChapterText::FormatReadingTime(remaining).c_str());
+        }
     }
     else {
         ImGui::Text("No chapters loaded");
     }
-}
\ No newline at end of file
+}
+
+float ChapterManager::NovelCompletion() const {
+    if (chapters.empty() || settings.currentChapter < 1 || settings.currentChapter > (int)chapters.size()) return 0.0f;
+
+    // By words when the novel has been measured, so long and short chapters weigh what they read
+    if (textStats.totalWords > 0) {
+        uint64_t after = textStats.WordsFrom(chapters[settings.currentChapter - 1].chapterNumber + 1);
+        return 1.0f - static_cast<float>(after) / static_cast<float>(textStats.totalWords);
+    }
+    return (float)settings.currentChapter / (float)chapters.size();
+}
+
+// ============================================================================
+// In-reader find
+// ============================================================================
+
+void ChapterManager::OpenFind() {
+    if (!find.open) {
+        find.open = true;
+        find.resultsDirty = true;
+    }
+    find.focusInput = true;
+}
+
+void ChapterManager::CloseFind() {
+    find.open = false;
+    find.hits.clear();
+    find.currentHit = -1;
+    find.lookahead.clear();
+    find.lookaheadFrom = -1;
+    find.grep.reset();
+    find.grepResults.clear();
+    find.grepError.clear();
+}
+
+void ChapterManager::RenderFindBar() {
+    ImGui::PushID("FindBar");
+    ImGui::Dummy(ImVec2(0, 2.0f));
+    ImGui::Indent(8.0f);
+
+    if (find.focusInput) {
+        ImGui::SetKeyboardFocusHere();
+        find.focusInput = false;
+    }
+    ImGui::SetNextItemWidth(280.0f);
+    if (ImGui::InputTextWithHint("##FindQuery", find.wholeNovel ? "Regex across all chapters" : "Find in chapter",
+        find.query, sizeof(find.query), ImGuiInputTextFlags_EnterReturnsTrue)) {
+        if (find.wholeNovel) {
+            StartNovelGrep();
+        }
+        else {
+            StepFindHit(ImGui::GetIO().KeyShift ? -1 : 1);
+        }
+        ImGui::SetKeyboardFocusHere(-1);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Whole novel (regex)", &find.wholeNovel)) {
+        find.resultsDirty = true;
+        if (!find.wholeNovel) {
+            find.grep.reset();
+        }
+    }
+
+    if (find.wholeNovel) {
+        ImGui::SameLine();
+        ImGui::Checkbox("Match case", &find.matchCase);
+
+        ImGui::SameLine();
+        if (find.grep && find.grep->IsRunning()) {
+            ImGui::Text("Searching %zu/%zu chapters, %zu matches", find.grep->FilesDone(), find.grep->FileCount(),
+                find.grepResults.size());
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel")) {
+                find.grep->Cancel();
+            }
+        }
+        else if (!find.grepError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.45f, 0.4f, 1.0f), "%s", find.grepError.c_str());
+        }
+        else if (find.grep) {
+            ImGui::TextDisabled("%zu matches in %zu chapters (%.0f ms)%s", find.grepResults.size(),
+                find.grep->FilesDone(), find.grepMillis, find.grep->IsTruncated() ? ", stopped at limit" : "");
+        }
+        else {
+            ImGui::TextDisabled("Press Enter to search");
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_XMARK)) {
+            CloseFind();
+        }
+
+        ImGui::Unindent(8.0f);
+        RenderNovelGrepResults();
+        ImGui::PopID();
+        return;
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_CHEVRON_UP)) {
+        StepFindHit(-1);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_CHEVRON_DOWN)) {
+        StepFindHit(1);
+    }
+
+    ImGui::SameLine();
+    if (find.query[0] == '\0') {
+        ImGui::TextDisabled("Type to search");
+    }
+    else if (find.hits.empty()) {
+        ImGui::TextDisabled("No matches");
+    }
+    else {
+        ImGui::Text("%d of %zu", find.currentHit + 1, find.hits.size());
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(140.0f);
+    if (ImGui::SliderInt("##FindLookahead", &find.lookaheadChapters, 0, MAX_FIND_LOOKAHEAD,
+        find.lookaheadChapters == 0 ? "This chapter only" : "+%d chapters")) {
+        find.resultsDirty = true;
+    }
+
+    size_t laterHits = 0;
+    for (size_t count : find.lookaheadCounts) laterHits += count;
+    if (find.lookaheadChapters > 0 && find.query[0] != '\0') {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%zu more ahead", laterHits);
+    }
+
+    ImGui::SameLine();
+    ImGui::TextDisabled("%.2f ms", find.searchMillis);
+
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_XMARK)) {
+        CloseFind();
+    }
+
+    ImGui::Unindent(8.0f);
+    ImGui::PopID();
+}
+
+void ChapterManager::RebuildFindText() {
+    // One buffer for the whole chapter: element texts joined by '\n', so a match never spans elements
+    std::string text;
+    size_t totalSize = 0;
+    for (const auto& element : parsedContent) totalSize += element.text.size() + 1;
+    text.reserve(totalSize);
+
+    find.elementOffsets.clear();
+    find.elementOffsets.reserve(parsedContent.size());
+    for (const auto& element : parsedContent) {
+        find.elementOffsets.push_back(text.size());
+        text += element.text;
+        text += '\n';
+    }
+
+    find.text.SetText(std::move(text));
+    find.textDirty = false;
+    find.resultsDirty = true;
+}
+
+bool ChapterManager::EnsureChapterOpen(size_t index) {
+    if (index >= chapters.size()) return false;
+    Chapter& chapter = chapters[index];
+    if (chapter.text.IsOpen()) return true;
+    if (chapter.path.empty()) return false;
+    if (!ChapterStore::OpenChapter(chapter.path, chapter.text)) {
+        JournalOpenFailure(chapter.path);
+        return false;
+    }
+
+    chapter.title.assign(chapter.text.Title());
+    return true;
+}
+
+void ChapterManager::ReleaseDistantChapters() {
+    int first = settings.currentChapter - 1 - CHAPTERS_KEPT_BEHIND;
+    int last = settings.currentChapter - 1 + MAX_FIND_LOOKAHEAD;
+    for (int i = 0; i < static_cast<int>(chapters.size()); i++) {
+        // Chapters without a file stay as they are; there would be nothing to reopen
+        if ((i < first || i > last) && !chapters[i].path.empty()) chapters[i].text.Close();
+    }
+}
+
+void ChapterManager::RefreshFindLookahead() {
+    int wanted = find.lookaheadChapters;
+    if (find.lookaheadFrom == settings.currentChapter && static_cast<int>(find.lookahead.size()) == wanted) {
+        return;
+    }
+
+    find.lookahead.clear();
+    for (int k = 0; k < wanted; k++) {
+        size_t index = static_cast<size_t>(settings.currentChapter) + k;  // chapters after the current one
+        if (index >= chapters.size()) break;
+        find.lookahead.emplace_back();
+        if (EnsureChapterOpen(index)) find.lookahead.back().SetText(std::string(chapters[index].Content()));
+    }
+    find.lookaheadFrom = settings.currentChapter;
+    find.resultsDirty = true;
+}
+
+void ChapterManager::UpdateFindResults() {
+    PollNovelGrep();
+    if (find.wholeNovel) {
+        // Regex results are listed rather than highlighted
+        find.hits.clear();
+        find.currentHit = -1;
+        find.lookaheadCounts.clear();
+        return;
+    }
+
+    if (find.textDirty) {
+        RebuildFindText();
+    }
+    RefreshFindLookahead();
+
+    if (!find.resultsDirty && find.searchedQuery == find.query) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    find.searchedQuery = find.query;
+    find.resultsDirty = false;
+    find.hits.clear();
+    find.lookaheadCounts.clear();
+
+    std::vector<TextSearch::Match> matches;
+    find.text.FindAll(find.searchedQuery, matches, MAX_FIND_HITS);
+
+    // Matches come back in buffer order, so element lookups walk forward
+    size_t element = 0;
+    for (const auto& match : matches) {
+        while (element + 1 < find.elementOffsets.size() && find.elementOffsets[element + 1] <= match.offset) {
+            element++;
+        }
+        find.hits.push_back({ element, match.offset - find.elementOffsets[element], match.length });
+    }
+
+    for (const TextSearch& chapterText : find.lookahead) {
+        find.lookaheadCounts.push_back(find.searchedQuery.empty() ? 0 : chapterText.Count(find.searchedQuery));
+    }
+
+    find.currentHit = find.hits.empty() ? -1 : 0;
+    find.scrollToCurrent = !find.hits.empty();
+    find.searchMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ChapterManager::StepFindHit(int direction) {
+    if (find.hits.empty() && find.lookaheadCounts.empty()) return;
+
+    if (direction > 0) {
+        if (find.currentHit + 1 < static_cast<int>(find.hits.size())) {
+            find.currentHit++;
+            find.scrollToCurrent = true;
+            return;
+        }
+
+        // Past the last hit: continue in the next chapter that has one
+        for (size_t k = 0; k < find.lookaheadCounts.size(); k++) {
+            if (find.lookaheadCounts[k] > 0) {
+                OpenChapter(settings.currentChapter + 1 + static_cast<int>(k));
+                return;
+            }
+        }
+
+        if (!find.hits.empty()) {
+            find.currentHit = 0;
+            find.scrollToCurrent = true;
+        }
+    }
+    else if (!find.hits.empty()) {
+        find.currentHit = (find.currentHit > 0) ? find.currentHit - 1 : static_cast<int>(find.hits.size()) - 1;
+        find.scrollToCurrent = true;
+    }
+}
+
+void ChapterManager::StartNovelGrep() {
+    find.grepResults.clear();
+    find.grepError.clear();
+    find.grepSorted = true;
+    if (find.query[0] == '\0' || cachedNovelName.empty()) {
+        find.grep.reset();
+        return;
+    }
+
+    find.grep = std::make_shared<NovelGrep>();
+    find.grepStarted = std::chrono::steady_clock::now();
+    std::string chaptersDir = "Novels/" + cachedNovelName + "/chapters";
+    if (!find.grep->Start(chaptersDir, find.query, !find.matchCase, find.grepError)) {
+        find.grep.reset();
+    }
+}
+
+void ChapterManager::PollNovelGrep() {
+    if (!find.grep) return;
+
+    bool running = find.grep->IsRunning();
+    size_t before = find.grepResults.size();
+    find.grep->TakeResults(find.grepResults);
+    if (find.grepResults.size() != before) {
+        find.grepSorted = false;
+    }
+
+    if (running) {
+        find.grepMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - find.grepStarted).count();
+    }
+    else if (!find.grepSorted) {
+        // Workers finish chapters out of order; settle into reading order once they are done
+        std::sort(find.grepResults.begin(), find.grepResults.end(),
+            [](const NovelGrep::Result& a, const NovelGrep::Result& b) {
+                return a.chapterNumber != b.chapterNumber ? a.chapterNumber < b.chapterNumber
+                    : a.paragraphIndex < b.paragraphIndex;
+            });
+        find.grepSorted = true;
+    }
+}
+
+void ChapterManager::RenderNovelGrepResults() {
+    if (find.grepResults.empty()) return;
+
+    float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    float height = std::min(GREP_RESULTS_HEIGHT, rowHeight * find.grepResults.size() + ImGui::GetStyle().WindowPadding.y * 2);
+    ImGui::BeginChild("GrepResults", ImVec2(0, height), true);
+
+    ImVec4 matchColor = ImGui::ColorConvertU32ToFloat4(FIND_CURRENT_COLOR | IM_COL32(0, 0, 0, 255));
+    int clicked = -1;
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(find.grepResults.size()), rowHeight);
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const NovelGrep::Result& result = find.grepResults[i];
+            const char* text = result.context.c_str();
+            size_t matchEnd = result.matchOffset + result.matchLength;
+
+            ImGui::PushID(i);
+            if (ImGui::Selectable("##GrepResult", false, ImGuiSelectableFlags_AllowOverlap)) {
+                clicked = i;
+            }
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::TextDisabled("Ch. %d", result.chapterNumber);
+            ImGui::SameLine(80.0f);
+            ImGui::TextUnformatted(text, text + result.matchOffset);
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::PushStyleColor(ImGuiCol_Text, matchColor);
+            ImGui::TextUnformatted(text + result.matchOffset, text + matchEnd);
+            ImGui::PopStyleColor();
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::TextUnformatted(text + matchEnd, text + result.context.size());
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+
+    if (clicked >= 0) {
+        const NovelGrep::Result& result = find.grepResults[clicked];
+        auto chapter = std::lower_bound(chapters.begin(), chapters.end(), result.chapterNumber,
+            [](const Chapter& c, int number) { return c.chapterNumber < number; });
+        if (chapter != chapters.end() && chapter->chapterNumber == result.chapterNumber) {
+            OpenChapter(static_cast<int>(chapter - chapters.begin()) + 1);
+            // Reparse now so the paragraph index resolves against the new chapter this frame
+            ParseMarkdownContent();
+            ScrollToParagraph(result.paragraphIndex);
+        }
+    }
+}
+
+void ChapterManager::RenderElementText(size_t elementIndex) {
+    // TextWrapped wraps at the column edge measured from where the text starts
+    float wrapRight = ImGui::GetCursorScreenPos().x + ImGui::GetContentRegionAvail().x;
+    std::string_view text = parsedContent[elementIndex].text;
+    ImGui::TextWrapped("%.*s", static_cast<int>(text.size()), text.data());
+
+    if (find.open && !find.hits.empty() && ImGui::IsItemVisible()) {
+        ImVec2 textPos = ImGui::GetItemRectMin();
+        DrawFindHighlights(elementIndex, textPos, std::max(wrapRight - textPos.x, 1.0f));
+    }
+}
+
+void ChapterManager::DrawFindHighlights(size_t elementIndex, const ImVec2& textPos, float wrapWidth) {
+    auto hit = std::lower_bound(find.hits.begin(), find.hits.end(), elementIndex,
+        [](const FindHit& h, size_t element) { return h.element < element; });
+    if (hit == find.hits.end() || hit->element != elementIndex) return;
+
+    std::string_view text = parsedContent[elementIndex].text;
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+
+    ImFont* font = ImGui::GetFont();
+    float fontSize = ImGui::GetFontSize();
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    float clipTop = drawList->GetClipRectMin().y;
+    float clipBottom = drawList->GetClipRectMax().y;
+
+    // Re-run ImGui's word wrap line by line to place each hit; only lines on screen are measured
+    const char* lineStart = begin;
+    float y = textPos.y;
+    while (lineStart < end && hit != find.hits.end() && hit->element == elementIndex && y <= clipBottom) {
+        const char* lineEnd = font->CalcWordWrapPosition(fontSize, lineStart, end, wrapWidth);
+        if (lineEnd <= lineStart) lineEnd = lineStart + 1;
+        size_t lineBegin = lineStart - begin;
+        size_t lineStop = lineEnd - begin;
+
+        if (y + fontSize >= clipTop) {
+            for (auto h = hit; h != find.hits.end() && h->element == elementIndex && h->offset < lineStop; ++h) {
+                size_t from = std::max(h->offset, lineBegin);
+                size_t to = std::min(h->offset + h->length, lineStop);
+                if (to <= from) continue;
+
+                float x0 = textPos.x + font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, lineStart, begin + from).x;
+                float x1 = x0 + font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, begin + from, begin + to).x;
+                bool current = (h - find.hits.begin()) == find.currentHit;
+                drawList->AddRectFilled(ImVec2(x0, y), ImVec2(x1, y + fontSize),
+                    current ? FIND_CURRENT_COLOR : FIND_HIT_COLOR, 2.0f);
+            }
+        }
+
+        while (hit != find.hits.end() && hit->element == elementIndex && hit->offset + hit->length <= lineStop) {
+            ++hit;
+        }
+
+        // Wrapping swallows the blanks at the start of the next line
+        lineStart = lineEnd;
+        while (lineStart < end && (*lineStart == ' ' || *lineStart == '\t')) lineStart++;
+        y += fontSize;
+    }
+}
@@ -3,6 +3,14 @@
 #include <vector>
 #include <unordered_map>
 #include "ImGui/imgui.h"
+#include "TextSearch.h"
+#include "NovelGrep.h"
+#include "ChapterStore.h"
+#include "ChapterText.h"
+#include <memory>
+#include <chrono>
+#include <deque>
+#include <string_view>
 
 class Library;
 
@@ -10,8 +18,10 @@ class ChapterManager {
 public:
     struct Chapter {
         int chapterNumber;
-        std::string title;
-        std::string content;
+        std::string title;                    // Known once the chapter has been opened
+        std::string path;                     // Chapter file; opened on first use
+        ChapterStore::MappedChapter text;
+        std::string_view Content() const { return text.Body(); }
         Chapter() : chapterNumber(0) {}
     };
 
@@ -68,7 +78,7 @@ public:
     bool LoadChapter(const std::string& filePath);
     bool SaveChapter(const Chapter& chapter, const std::string& novelName);
     void ParseMarkdownContent();
-    void ParseInlineFormatting(const std::string& line);
+    void ParseInlineFormatting(std::string_view line);
     void RenderContent();
     void RenderSettingsPanel();
     void Render();
@@ -83,8 +93,14 @@ public:
     void RenderNavigationTab();
 
     void SetScrollPosition(float position) { settings.scrollPosition = position; }
+    void ScrollToParagraph(int paragraphIndex) { pendingScrollParagraph = paragraphIndex; }
     float GetScrollPosition() const { return settings.scrollPosition; }
 
+    // In-reader find (Ctrl+F)
+    void OpenFind();
+    void CloseFind();
+    bool IsFindOpen() const { return find.open; }
+
     // Font management
     bool InitializeFonts();
     void LoadFont(const std::string& name, const std::string& path, float size);
@@ -107,8 +123,8 @@ private:
     struct TextElement {
         enum Type { TEXT, BOLD, ITALIC, HEADER1, HEADER2, HEADER3, PARAGRAPH_BREAK, LINE_BREAK };
         Type type;
-        std::string text;
-        TextElement(Type t, const std::string& txt) : type(t), text(txt) {}
+        std::string_view text;   // Into parsedChapter's text, or parsedStorage for text the tokenizer made up
+        TextElement(Type t, std::string_view txt) : type(t), text(txt) {}
     };
 
     std::string cachedNovelName = "";
@@ -118,10 +134,54 @@ private:
     // Core data
     ReadingSettings settings;
     std::vector<TextElement> parsedContent;
+    ChapterStore::MappedChapter parsedChapter;                 // Keeps parsedContent's text alive
+    std::shared_ptr<std::deque<std::string>> parsedStorage;    // Bullet lines; shared so copies stay valid
     std::string novelTitle = "Novel Title";
     bool showSettings = false;
     bool contentNeedsReparsing = true;
     std::vector<Chapter> chapters;
+    ChapterText::NovelStats textStats;          // Word counts from ingest; empty if not measured yet
+    std::vector<size_t> paragraphElementStart; // parsedContent index of each non-empty line
+    int pendingScrollParagraph = -1;
+
+    // Find bar state; hits index into parsedContent so only visible ones are laid out
+    struct FindHit {
+        size_t element = 0;   // parsedContent index
+        size_t offset = 0;    // Byte range within the element's text
+        size_t length = 0;
+    };
+
+    struct FindState {
+        bool open = false;
+        bool focusInput = false;
+        char query[128] = "";
+        std::string searchedQuery;
+        bool textDirty = true;              // parsedContent changed since text was built
+        bool resultsDirty = true;
+        TextSearch text;                    // Element texts joined by '\n'
+        std::vector<size_t> elementOffsets; // Start of each element in text
+        std::vector<FindHit> hits;
+        int currentHit = -1;
+        bool scrollToCurrent = false;
+        double searchMillis = 0.0;
+
+        // Raw content of the chapters after the current one, counted but not highlighted
+        int lookaheadChapters = 0;
+        int lookaheadFrom = -1;
+        std::vector<TextSearch> lookahead;
+        std::vector<size_t> lookaheadCounts;
+
+        // Whole-novel regex mode; results list every matching line across the chapters on disk
+        bool wholeNovel = false;
+        bool matchCase = false;
+        std::shared_ptr<NovelGrep> grep;    // shared_ptr keeps ChapterManager copyable
+        std::vector<NovelGrep::Result> grepResults;
+        std::string grepError;
+        bool grepSorted = true;
+        std::chrono::steady_clock::time_point grepStarted;
+        double grepMillis = 0.0;
+    };
+    FindState find;
 
     Library* libraryPtr = nullptr; // Add this member variable
 
@@ -140,6 +200,23 @@ private:
     void RenderFontSettings();
     void ApplyTheme();
     float GetWidthMultiplier();
+    float NovelCompletion() const;   // Up to the end of the current chapter, 0..1
+
+    // Find helpers
+    void RenderFindBar();
+    void UpdateFindResults();
+    void RebuildFindText();
+    void RefreshFindLookahead();
+
+    // Chapter text is mapped lazily and released once the reader moves away
+    bool EnsureChapterOpen(size_t index);
+    void ReleaseDistantChapters();
+    void StepFindHit(int direction);
+    void StartNovelGrep();
+    void PollNovelGrep();
+    void RenderNovelGrepResults();
+    void RenderElementText(size_t elementIndex);
+    void DrawFindHighlights(size_t elementIndex, const ImVec2& textPos, float wrapWidth);
 
 public:
     ReadingSettings& getSettings() { return settings; }
@@ -0,0 +1,832 @@
+#include "ChapterStore.h"
+#include "BatchReader.h"
+#include "BlobStore.h"
+#include "Deflate.h"
+#include "JsonReader.h"
+#include "MappedFile.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr char FRAME_MAGIC[4] = { 'N', 'R', 'Z', '1' };
+    constexpr size_t FRAME_HEADER_SIZE = 12;
+    constexpr int COMPRESSION_LEVEL = 6;         // New chapters: quick to write
+    constexpr int COLD_COMPRESSION_LEVEL = 9;    // Demoted chapters: written once, rarely read
+
+    // Training candidates: whole lines (boilerplate) and three-word phrases (names, idioms)
+    constexpr size_t MIN_LINE_LENGTH = 12;
+    constexpr size_t MAX_LINE_LENGTH = 400;
+    constexpr size_t MIN_PHRASE_LENGTH = 8;
+    constexpr size_t MAX_PHRASE_LENGTH = 64;
+    constexpr int PHRASE_WORDS = 3;
+    constexpr size_t MAX_CANDIDATES = 20000;
+
+    struct FrameHeader {
+        uint32_t dictionaryId = 0;
+        uint32_t jsonSize = 0;
+    };
+
+    bool ReadHeader(std::string_view fileBytes, FrameHeader& header) {
+        if (fileBytes.size() < FRAME_HEADER_SIZE || std::memcmp(fileBytes.data(), FRAME_MAGIC, 4) != 0) return false;
+        std::memcpy(&header.dictionaryId, fileBytes.data() + 4, 4);
+        std::memcpy(&header.jsonSize, fileBytes.data() + 8, 4);
+        return true;
+    }
+
+    bool ReadWholeFile(const std::filesystem::path& path, std::string& out) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+
+        file.seekg(0, std::ios::end);
+        std::streamoff length = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (length < 0) return false;
+
+        out.resize(static_cast<size_t>(length));
+        file.read(out.data(), length);
+        return static_cast<bool>(file) || file.eof();
+    }
+
+    bool WriteFileAtomically(const std::filesystem::path& path, std::string_view bytes) {
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), bytes.size());
+            if (!file) return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, path, ec);
+        if (ec) {
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+        return true;
+    }
+
+    bool IsChapterFile(const std::filesystem::path& path) {
+        return path.extension() == ".json" && path.stem().string().rfind("chapter", 0) == 0;
+    }
+
+    // ============================================================================
+    // Dictionary cache
+    // ============================================================================
+    // A dictionary never changes once written, so each is read once and then only stat'ed:
+    // a novel deleted and downloaded again gets a new dictionary under the same path.
+    struct Dictionary {
+        uint32_t id = 0;
+        std::string bytes;
+        std::filesystem::file_time_type modified;
+    };
+
+    std::mutex dictionaryMutex;
+    std::unordered_map<std::string, std::shared_ptr<const Dictionary>> dictionaries;   // By chapters directory
+
+    std::shared_ptr<const Dictionary> LoadDictionary(const std::filesystem::path& chaptersDir) {
+        std::string key = chaptersDir.string();
+        std::filesystem::path path = chaptersDir / ChapterStore::DICTIONARY_FILE;
+        std::error_code ec;
+        std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, ec);
+        if (ec) return nullptr;
+        {
+            std::lock_guard<std::mutex> lock(dictionaryMutex);
+            auto it = dictionaries.find(key);
+            if (it != dictionaries.end() && it->second->modified == modified) return it->second;
+        }
+
+        auto dictionary = std::make_shared<Dictionary>();
+        if (!ReadWholeFile(path, dictionary->bytes) || dictionary->bytes.empty()) {
+            return nullptr;
+        }
+        dictionary->id = ChapterStore::DictionaryId(dictionary->bytes);
+        dictionary->modified = modified;
+
+        std::lock_guard<std::mutex> lock(dictionaryMutex);
+        dictionaries[key] = dictionary;
+        return dictionary;
+    }
+
+    bool DecodeFrame(std::string_view fileBytes, const std::filesystem::path& chaptersDir, std::string& jsonText) {
+        FrameHeader header;
+        if (!ReadHeader(fileBytes, header)) return false;
+
+        std::shared_ptr<const Dictionary> dictionary;
+        if (header.dictionaryId != 0) {
+            dictionary = LoadDictionary(chaptersDir);
+            if (!dictionary || dictionary->id != header.dictionaryId) {
+                std::cout << "Missing compression dictionary in " << chaptersDir << std::endl;
+                return false;
+            }
+        }
+
+        jsonText.clear();
+        std::string_view dictionaryBytes = dictionary ? std::string_view(dictionary->bytes) : std::string_view();
+        return Deflate::Inflate(fileBytes.substr(FRAME_HEADER_SIZE), dictionaryBytes, jsonText, header.jsonSize) &&
+            jsonText.size() == header.jsonSize;
+    }
+
+    std::string EncodeFrame(std::string_view jsonText, const Dictionary* dictionary, int level) {
+        std::string frame(FRAME_MAGIC, 4);
+        uint32_t dictionaryId = dictionary ? dictionary->id : 0;
+        uint32_t jsonSize = static_cast<uint32_t>(jsonText.size());
+        frame.append(reinterpret_cast<const char*>(&dictionaryId), 4);
+        frame.append(reinterpret_cast<const char*>(&jsonSize), 4);
+        Deflate::Compress(jsonText, dictionary ? std::string_view(dictionary->bytes) : std::string_view(),
+            frame, level);
+        return frame;
+    }
+}
+
+// ============================================================================
+// Reading and writing
+// ============================================================================
+bool ChapterStore::IsCompressed(std::string_view fileBytes) {
+    FrameHeader header;
+    return ReadHeader(fileBytes, header);
+}
+
+bool ChapterStore::ReadChapterJson(const std::string& path, std::string& jsonText) {
+    std::string fileBytes;
+    if (!ReadWholeFile(path, fileBytes)) return false;
+
+    if (!IsCompressed(fileBytes)) {
+        jsonText = std::move(fileBytes);
+        return true;
+    }
+    if (!DecodeFrame(fileBytes, std::filesystem::path(path).parent_path(), jsonText)) {
+        std::cout << "Corrupt compressed chapter: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ChapterStore::WriteChapterJson(const std::string& path, std::string_view jsonText) {
+    std::shared_ptr<const Dictionary> dictionary = LoadDictionary(std::filesystem::path(path).parent_path());
+    return BlobStore::ForChapterFile(path).Put(path, EncodeFrame(jsonText, dictionary.get(), COMPRESSION_LEVEL));
+}
+
+// ============================================================================
+// Mapped chapters
+// ============================================================================
+struct ChapterStore::MappedChapter::Storage {
+    MappedFile file;
+    std::string buffer;   // Inflated JSON and/or unescaped text; never resized once views point into it
+    int number = 0;
+    std::string_view title;
+    std::string_view body;
+    size_t jsonBytes = 0;
+    size_t copiedBytes = 0;
+    int64_t wordCount = -1;
+    std::vector<uint32_t> paragraphOffsets;   // Checked against body: ascending and inside it
+};
+
+int ChapterStore::MappedChapter::Number() const {
+    return storage ? storage->number : 0;
+}
+
+std::string_view ChapterStore::MappedChapter::Title() const {
+    return storage ? storage->title : std::string_view();
+}
+
+std::string_view ChapterStore::MappedChapter::Body() const {
+    return storage ? storage->body : std::string_view();
+}
+
+size_t ChapterStore::MappedChapter::JsonBytes() const {
+    return storage ? storage->jsonBytes : 0;
+}
+
+size_t ChapterStore::MappedChapter::CopiedBytes() const {
+    return storage ? storage->copiedBytes : 0;
+}
+
+int64_t ChapterStore::MappedChapter::WordCount() const {
+    return storage ? storage->wordCount : -1;
+}
+
+const std::vector<uint32_t>& ChapterStore::MappedChapter::ParagraphOffsets() const {
+    static const std::vector<uint32_t> none;
+    return storage ? storage->paragraphOffsets : none;
+}
+
+bool ChapterStore::OpenChapter(const std::string& path, MappedChapter& chapter) {
+    auto storage = std::make_shared<MappedChapter::Storage>();
+    if (!storage->file.Open(path)) return false;
+
+    std::string_view source = storage->file.View();
+    if (!IsCompressed(source)) return ParseOpenedChapter(path, std::move(storage), source, false, chapter);
+
+    if (!DecodeFrame(source, std::filesystem::path(path).parent_path(), storage->buffer)) {
+        std::cout << "Corrupt compressed chapter: " << path << std::endl;
+        return false;
+    }
+    storage->file.Close();
+    storage->copiedBytes = storage->buffer.size();
+    return ParseOpenedChapter(path, storage, storage->buffer, true, chapter);
+}
+
+bool ChapterStore::OpenChapterBytes(const std::string& path, std::string fileBytes, MappedChapter& chapter) {
+    auto storage = std::make_shared<MappedChapter::Storage>();
+    if (IsCompressed(fileBytes)) {
+        if (!DecodeFrame(fileBytes, std::filesystem::path(path).parent_path(), storage->buffer)) {
+            std::cout << "Corrupt compressed chapter: " << path << std::endl;
+            return false;
+        }
+    }
+    else {
+        storage->buffer = std::move(fileBytes);
+    }
+    storage->copiedBytes = storage->buffer.size();
+    return ParseOpenedChapter(path, storage, storage->buffer, true, chapter);
+}
+
+bool ChapterStore::ParseOpenedChapter(const std::string& path, std::shared_ptr<MappedChapter::Storage> storage,
+    std::string_view source, bool ownsSource, MappedChapter& chapter) {
+    storage->jsonBytes = source.size();
+
+    JsonReader::Object object;
+    JsonReader::Value title, content;
+    bool parsed = object.Parse(source) && object.Find("title", title) && object.Find("content", content);
+
+    if (parsed) {
+        JsonReader::Value number;
+        if (object.Find("chapterNumber", number) && !number.GetInt(storage->number)) parsed = false;
+
+        // Read before the strings are unescaped in place; a bad index is ignored, not an error
+        JsonReader::Value words;
+        std::vector<JsonReader::Value> offsets;
+        if (object.Find("wordCount", words) && words.GetInt64(storage->wordCount) &&
+            object.GetArray("paragraphOffsets", offsets)) {
+            storage->paragraphOffsets.reserve(offsets.size());
+            for (const JsonReader::Value& offset : offsets) {
+                int64_t value = 0;
+                if (!offset.GetInt64(value) || value < 0 || value > UINT32_MAX) {
+                    storage->paragraphOffsets.clear();
+                    break;
+                }
+                storage->paragraphOffsets.push_back(static_cast<uint32_t>(value));
+            }
+        }
+        else {
+            storage->wordCount = -1;
+        }
+    }
+
+    if (parsed && ownsSource) {
+        // Unescape in place: the buffer is ours and decoding only ever shrinks a string
+        auto decodeInPlace = [&](const JsonReader::Value& value, std::string_view& out) {
+            char* at = storage->buffer.data() + (value.raw.data() - storage->buffer.data()) + 1;
+            size_t length = 0;
+            if (!value.DecodeStringTo(at, length)) return false;
+            out = std::string_view(at, length);
+            return true;
+        };
+        parsed = decodeInPlace(title, storage->title) && decodeInPlace(content, storage->body);
+    }
+    else if (parsed) {
+        bool titleMapped = title.GetStringView(storage->title);
+        bool bodyMapped = content.GetStringView(storage->body);
+        if (!titleMapped || !bodyMapped) {
+            // Reserved up front so the views taken below stay put
+            storage->buffer.resize((titleMapped ? 0 : title.raw.size()) + (bodyMapped ? 0 : content.raw.size()));
+            char* at = storage->buffer.data();
+            auto decodeInto = [&](const JsonReader::Value& value, std::string_view& out) {
+                size_t length = 0;
+                if (!value.DecodeStringTo(at, length)) return false;
+                out = std::string_view(at, length);
+                at += length;
+                storage->copiedBytes += length;
+                return true;
+            };
+            parsed = (titleMapped || decodeInto(title, storage->title)) && (bodyMapped || decodeInto(content, storage->body));
+            if (parsed && !titleMapped && !bodyMapped) storage->file.Close();
+        }
+    }
+
+    if (!parsed) {
+        // Anything the reader doesn't expect goes through the DOM, as ReadChapterJson callers did
+        try {
+            json j = json::parse(source);
+            storage->number = j.value("chapterNumber", 0);
+            std::string titleText = j.value("title", "");
+            std::string bodyText = j.value("content", "");
+
+            std::string decoded = titleText + bodyText;
+            storage->file.Close();
+            storage->buffer = std::move(decoded);
+            storage->title = std::string_view(storage->buffer).substr(0, titleText.size());
+            storage->body = std::string_view(storage->buffer).substr(titleText.size());
+            storage->copiedBytes += storage->buffer.size();
+        }
+        catch (const std::exception& e) {
+            std::cout << "Unreadable chapter " << path << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    if (!storage->paragraphOffsets.empty()) {
+        const std::vector<uint32_t>& offsets = storage->paragraphOffsets;
+        bool valid = offsets.back() < storage->body.size();
+        for (size_t i = 1; valid && i < offsets.size(); i++) valid = offsets[i - 1] < offsets[i];
+        if (!valid) {
+            storage->wordCount = -1;
+            storage->paragraphOffsets.clear();
+        }
+    }
+
+    chapter.storage = std::move(storage);
+    return true;
+}
+
+uint32_t ChapterStore::DictionaryId(std::string_view dictionary) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : dictionary) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash == 0 ? 1 : hash;   // 0 is reserved for "no dictionary"
+}
+
+// ============================================================================
+// Dictionary training
+// ============================================================================
+std::string ChapterStore::TrainDictionary(const std::vector<std::string>& samples, size_t maxSize) {
+    struct Candidate {
+        uint32_t documents = 0;
+        uint32_t lastDocument = 0;
+    };
+    std::unordered_map<std::string_view, Candidate> candidates;
+
+    auto count = [&](std::string_view text, uint32_t document) {
+        Candidate& candidate = candidates[text];
+        if (candidate.lastDocument != document) {
+            candidate.documents++;
+            candidate.lastDocument = document;
+        }
+    };
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        std::string_view text(samples[i]);
+        uint32_t document = static_cast<uint32_t>(i + 1);
+
+        // Lines, as escaped inside the JSON string ("\n") and as real newlines
+        size_t lineStart = 0;
+        for (size_t p = 0; p <= text.size(); p++) {
+            bool lineEnd = p == text.size() || text[p] == '\n' || (text[p] == '\\' && p + 1 < text.size() && text[p + 1] == 'n');
+            if (!lineEnd) continue;
+
+            std::string_view line = text.substr(lineStart, p - lineStart);
+            if (line.size() >= MIN_LINE_LENGTH && line.size() <= MAX_LINE_LENGTH) count(line, document);
+            if (p < text.size() && text[p] == '\\') p++;
+            lineStart = p + 1;
+        }
+
+        // Three-word phrases, with the trailing space so they chain into the next word
+        std::vector<size_t> wordStarts;
+        for (size_t p = 0; p < text.size(); p++) {
+            if (text[p] != ' ' && (p == 0 || text[p - 1] == ' ')) wordStarts.push_back(p);
+        }
+        for (size_t w = 0; w + PHRASE_WORDS < wordStarts.size(); w++) {
+            std::string_view phrase = text.substr(wordStarts[w], wordStarts[w + PHRASE_WORDS] - wordStarts[w]);
+            if (phrase.size() >= MIN_PHRASE_LENGTH && phrase.size() <= MAX_PHRASE_LENGTH) count(phrase, document);
+        }
+    }
+
+    // Only the first use in each chapter gains from the dictionary; later ones match within the chapter
+    uint32_t minDocuments = std::max<uint32_t>(2, static_cast<uint32_t>(samples.size() / 8));
+    std::vector<std::pair<uint64_t, std::string_view>> ranked;
+    for (const auto& [text, candidate] : candidates) {
+        if (candidate.documents >= minDocuments) {
+            ranked.push_back({ static_cast<uint64_t>(candidate.documents) * text.size(), text });
+        }
+    }
+    size_t keep = std::min(ranked.size(), MAX_CANDIDATES);
+    std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(),
+        [](const auto& a, const auto& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+    ranked.resize(keep);
+
+    std::vector<std::string_view> chosen;
+    std::string joined;
+    size_t total = 0;
+    for (const auto& [score, text] : ranked) {
+        if (total + text.size() > maxSize) continue;
+        if (joined.find(text) != std::string::npos) continue;
+        chosen.push_back(text);
+        joined.append(text);
+        total += text.size();
+    }
+
+    // Closest to the data is cheapest to reference, so the best phrases go last
+    std::string dictionary;
+    dictionary.reserve(total);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+        dictionary.append(*it);
+    }
+    return dictionary;
+}
+
+// ============================================================================
+// Tiers and compaction
+// ============================================================================
+namespace {
+    // Re-encodes one chapter in place when it isn't stored as tier asks. Frames made with an
+    // older (or no) dictionary count as out of place for the cold tier. The timestamp is kept:
+    // it is the same chapter, and the search index uses timestamps to spot changed ones.
+    bool Recode(const std::filesystem::path& path, ChapterStore::Tier tier, const Dictionary* dictionary,
+        uint64_t* bytesAfter, bool* rewritten) {
+        std::string fileBytes, jsonText;
+        if (!ReadWholeFile(path, fileBytes)) return false;
+        if (bytesAfter) *bytesAfter = fileBytes.size();
+        if (rewritten) *rewritten = false;
+
+        FrameHeader header;
+        bool compressed = ReadHeader(fileBytes, header);
+        uint32_t dictionaryId = dictionary ? dictionary->id : 0;
+        if (tier == ChapterStore::Tier::Cold && compressed && header.dictionaryId == dictionaryId) return true;
+        if (tier == ChapterStore::Tier::Hot && !compressed) return true;
+
+        try {
+            if (compressed) {
+                if (!DecodeFrame(fileBytes, path.parent_path(), jsonText)) throw std::runtime_error("corrupt frame");
+            }
+            else {
+                // Drops the pretty-printing older downloads were saved with
+                jsonText = json::parse(fileBytes).dump();
+            }
+        }
+        catch (const std::exception& e) {
+            std::cout << "Skipping " << path << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        std::string encoded = tier == ChapterStore::Tier::Hot ? std::move(jsonText)
+            : EncodeFrame(jsonText, dictionary, COLD_COMPRESSION_LEVEL);
+
+        // A chapter that shares its blob with another novel's shares the timestamp too; at worst
+        // the other chapter looks changed and is indexed again
+        std::error_code ec;
+        std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, ec);
+        if (!BlobStore::ForChapterFile(path.string()).Put(path.string(), encoded)) {
+            // Open elsewhere (Windows won't replace it); the next pass retries
+            return false;
+        }
+        if (!ec) std::filesystem::last_write_time(path, modified, ec);
+
+        if (bytesAfter) *bytesAfter = encoded.size();
+        if (rewritten) *rewritten = true;
+        return true;
+    }
+}
+
+bool ChapterStore::Inspect(const std::string& path, StoredChapter& info) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char headerBytes[FRAME_HEADER_SIZE];
+    file.read(headerBytes, sizeof(headerBytes));
+    FrameHeader header;
+    info.compressed = ReadHeader(std::string_view(headerBytes, static_cast<size_t>(file.gcount())), header);
+
+    std::error_code ec;
+    info.fileBytes = std::filesystem::file_size(path, ec);
+    info.jsonBytes = info.compressed ? header.jsonSize : info.fileBytes;
+    return !ec;
+}
+
+bool ChapterStore::MoveToTier(const std::string& path, Tier tier, uint64_t* bytesAfter) {
+    std::shared_ptr<const Dictionary> dictionary;
+    if (tier == Tier::Cold) {
+        dictionary = LoadDictionary(std::filesystem::path(path).parent_path());
+    }
+    return Recode(path, tier, dictionary.get(), bytesAfter, nullptr);
+}
+
+bool ChapterStore::EnsureDictionary(const std::string& chaptersDir) {
+    std::filesystem::path dir(chaptersDir);
+    if (LoadDictionary(dir)) return true;
+
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (IsChapterFile(entry.path())) files.push_back(entry.path());
+    }
+    if (ec || files.size() < MIN_TRAINING_CHAPTERS) return false;
+    std::sort(files.begin(), files.end());
+
+    // Sample evenly so early chapters don't dominate the vocabulary
+    size_t sampleCount = std::min(files.size(), MAX_TRAINING_CHAPTERS);
+    std::vector<std::string> samplePaths;
+    for (size_t i = 0; i < sampleCount; i++) {
+        samplePaths.push_back(files[i * files.size() / sampleCount].string());
+    }
+
+    // Kept in chapter order, whatever order the reads complete in, so training is repeatable
+    std::vector<std::string> samples(sampleCount);
+    BatchReader::ReadBatch(BatchReader::WholeFiles(samplePaths), [&](size_t index, bool ok, std::string& fileBytes) {
+        if (!ok) return;
+        std::string jsonText;
+        if (!IsCompressed(fileBytes)) jsonText = std::move(fileBytes);
+        else if (!DecodeFrame(fileBytes, dir, jsonText)) return;
+        try {
+            samples[index] = json::parse(jsonText).dump();
+        }
+        catch (const std::exception&) {}
+    });
+    samples.erase(std::remove(samples.begin(), samples.end(), std::string()), samples.end());
+
+    std::string trained = TrainDictionary(samples, MAX_DICTIONARY_SIZE);
+    if (trained.empty() || !WriteFileAtomically(dir / DICTIONARY_FILE, trained)) return false;
+
+    std::cout << "Trained " << trained.size() << " byte dictionary for " << chaptersDir << std::endl;
+    return true;
+}
+
+bool ChapterStore::CompactNovel(const std::string& chaptersDir, CompactStats* stats) {
+    std::filesystem::path dir(chaptersDir);
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (IsChapterFile(entry.path())) files.push_back(entry.path());
+    }
+    if (ec) {
+        std::cout << "Cannot read " << chaptersDir << std::endl;
+        return false;
+    }
+
+    EnsureDictionary(chaptersDir);
+    std::shared_ptr<const Dictionary> dictionary = LoadDictionary(dir);
+
+    CompactStats localStats;
+    for (const std::filesystem::path& path : files) {
+        uint64_t before = std::filesystem::file_size(path, ec);
+        if (ec) continue;
+        localStats.chapters++;
+        localStats.bytesBefore += before;
+
+        uint64_t after = before;
+        bool rewritten = false;
+        Recode(path, Tier::Cold, dictionary.get(), &after, &rewritten);
+        localStats.bytesAfter += after;
+        localStats.rewritten += rewritten;
+    }
+
+    if (stats) *stats = localStats;
+    return true;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+void ChapterStore::RunBenchmark(const std::string& workDir, uint64_t targetBytes) {
+    std::filesystem::path root(workDir);
+    std::filesystem::path plainDir = root / "chapters_plain";
+    std::filesystem::path packedDir = root / "chapters_packed";
+
+    constexpr int CHAPTERS_PER_NOVEL = 200;
+    constexpr size_t CHAPTER_BYTES = 12000;
+    constexpr int VOCABULARY_SIZE = 20000;
+    constexpr int OPEN_SAMPLES = 500;
+
+    std::mt19937 rng(4321);
+    const char* syllables[] = { "ka", "ri", "to", "shen", "mo", "ra", "lin", "vel", "dor", "an",
+        "sa", "ul", "thi", "gor", "ne", "qi", "xu", "ya", "zen", "bo" };
+    auto makeWord = [&](int v) {
+        std::string word;
+        do {
+            word += syllables[v % 20];
+            v /= 20;
+        } while (v > 0);
+        return word;
+    };
+
+    // Zipf-distributed prose with per-novel names and boilerplate, which is what a trained
+    // dictionary can exploit in real web novels
+    std::vector<std::string> vocabulary;
+    for (int i = 0; i < VOCABULARY_SIZE; i++) vocabulary.push_back(makeWord(i));
+    std::vector<double> weights(VOCABULARY_SIZE);
+    for (int i = 0; i < VOCABULARY_SIZE; i++) weights[i] = 1.0 / (i + 1);
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+
+    std::filesystem::remove_all(root);
+    uint64_t plainBytes = 0, compactBytes = 0, noDictionaryBytes = 0;
+    std::vector<std::filesystem::path> novelDirs;
+    for (int novel = 0; plainBytes < targetBytes; novel++) {
+        std::string novelName = "Bench Novel " + std::to_string(novel);
+        std::filesystem::path chapterDir = plainDir / novelName / "chapters";
+        std::filesystem::create_directories(chapterDir);
+        novelDirs.push_back(std::filesystem::path(novelName) / "chapters");
+
+        std::vector<std::string> names;
+        for (int i = 0; i < 12; i++) {
+            std::string name = makeWord(static_cast<int>(rng() % 8000) + 400);
+            name[0] = static_cast<char>(toupper(name[0]));
+            names.push_back(name);
+        }
+        std::string site = makeWord(static_cast<int>(rng() % 1000) + 50) + "novels.com";
+        std::string header = "Translator: " + names[10] + " | Editor: " + names[11];
+        std::string footer = "If you enjoy this novel, read the latest chapters at " + site +
+            " and consider supporting the translator on Patreon for advance chapters!";
+
+        for (int chapter = 1; chapter <= CHAPTERS_PER_NOVEL && plainBytes < targetBytes; chapter++) {
+            std::string content = header + "\n\n";
+            while (content.size() < CHAPTER_BYTES) {
+                int words = 20 + static_cast<int>(rng() % 60);
+                if (rng() % 3 == 0) content += "\"";
+                for (int w = 0; w < words; w++) {
+                    if (w > 0) content += ' ';
+                    content += (rng() % 12 == 0) ? names[rng() % 10] : vocabulary[zipf(rng)];
+                }
+                content += ".\n\n";
+            }
+            content += footer;
+
+            json j;
+            j["chapterNumber"] = chapter;
+            j["title"] = "Chapter " + std::to_string(chapter) + " - " + vocabulary[zipf(rng)];
+            j["content"] = content;
+
+            std::string pretty = j.dump(2);
+            std::string compact = j.dump();
+            std::string deflated;
+            Deflate::Compress(compact, "", deflated, COMPRESSION_LEVEL);
+
+            std::ofstream(chapterDir / ("chapter" + std::to_string(chapter) + ".json"), std::ios::binary) << pretty;
+            plainBytes += pretty.size();
+            compactBytes += compact.size();
+            noDictionaryBytes += deflated.size() + FRAME_HEADER_SIZE;
+        }
+    }
+
+    std::filesystem::copy(plainDir, packedDir, std::filesystem::copy_options::recursive);
+
+    auto compactBegin = std::chrono::steady_clock::now();
+    uint64_t packedBytes = 0, dictionaryBytes = 0;
+    for (const std::filesystem::path& novelDir : novelDirs) {
+        CompactStats stats;
+        CompactNovel((packedDir / novelDir).string(), &stats);
+        packedBytes += stats.bytesAfter;
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(packedDir / novelDir / DICTIONARY_FILE, ec);
+        if (!ec) dictionaryBytes += size;
+    }
+    double compactSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - compactBegin).count();
+
+    const double MB = 1024.0 * 1024.0;
+    std::cout << "Corpus: " << novelDirs.size() << " novels, " << plainBytes / MB << " MB pretty-printed JSON" << std::endl;
+    std::cout << "Compact JSON:          " << compactBytes / MB << " MB (" << 100.0 * compactBytes / plainBytes << "%)" << std::endl;
+    std::cout << "DEFLATE, no dictionary: " << noDictionaryBytes / MB << " MB (" << 100.0 * noDictionaryBytes / plainBytes << "%)" << std::endl;
+    std::cout << "DEFLATE + dictionary:  " << (packedBytes + dictionaryBytes) / MB << " MB (" <<
+        100.0 * (packedBytes + dictionaryBytes) / plainBytes << "%, dictionaries " << dictionaryBytes / 1024.0 << " KB)" << std::endl;
+    std::cout << "Compaction: " << plainBytes / MB / compactSeconds << " MB/s" << std::endl;
+
+    // Open = read the file, decompress if needed, parse the JSON and pull out the content
+    auto measureOpen = [&](const char* label, const std::filesystem::path& base) {
+        std::mt19937 pick(99);
+        std::vector<double> latencies;
+        for (int i = 0; i < OPEN_SAMPLES; i++) {
+            const std::filesystem::path& novelDir = novelDirs[pick() % novelDirs.size()];
+            std::filesystem::path path = base / novelDir / ("chapter" + std::to_string(1 + pick() % 20) + ".json");
+            if (!std::filesystem::exists(path)) continue;
+
+            auto begin = std::chrono::steady_clock::now();
+            std::string jsonText;
+            if (!ReadChapterJson(path.string(), jsonText)) continue;
+            std::string content = json::parse(jsonText).value("content", "");
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+        }
+        if (latencies.empty()) return;
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << label << ": p50 " << latencies[latencies.size() / 2] << " ms, p95 "
+            << latencies[latencies.size() * 95 / 100] << " ms" << std::endl;
+    };
+    measureOpen("Open plain", plainDir);
+    measureOpen("Open compressed", packedDir);
+}
+
+namespace {
+    uint64_t PeakResidentBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+
+    // Non-empty trimmed lines, the reader's paragraphs
+    template <typename Visit>
+    void ForEachParagraph(std::string_view text, Visit&& visit) {
+        size_t lineStart = 0;
+        while (lineStart < text.size()) {
+            size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos) lineEnd = text.size();
+            std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string_view::npos) continue;
+            visit(line.substr(first, line.find_last_not_of(" \t\r") - first + 1));
+        }
+    }
+}
+
+void ChapterStore::RunOpenBenchmark(const std::string& novelsRoot, int passes) {
+    std::vector<std::string> paths;
+    uint64_t fileBytes = 0;
+    std::error_code ec;
+    for (const auto& novel : std::filesystem::directory_iterator(novelsRoot, ec)) {
+        for (const auto& entry : std::filesystem::directory_iterator(novel.path() / "chapters", ec)) {
+            if (!IsChapterFile(entry.path())) continue;
+            paths.push_back(entry.path().string());
+            fileBytes += entry.file_size(ec);
+        }
+    }
+    if (paths.empty()) {
+        std::cout << "No chapters under " << novelsRoot << std::endl;
+        return;
+    }
+    std::cout << paths.size() << " chapters, " << fileBytes / 1024 << " KB on disk, " << passes << " passes" << std::endl;
+
+    // Each pass keeps every chapter it opened alive, as the reader keeps a novel's chapters.
+    // Peak RSS never goes down, so the lighter path runs first.
+    const uint64_t baseline = PeakResidentBytes();
+    const double MB = 1024.0 * 1024.0;
+    auto report = [&](const char* label, double seconds, uint64_t copied, uint64_t opens) {
+        std::cout << label << ": " << seconds * 1000.0 / opens << " ms per open, "
+            << static_cast<double>(copied) / opens / 1024.0 << " KB copied per open, peak RSS "
+            << PeakResidentBytes() / MB << " MB (+" << (PeakResidentBytes() - baseline) / MB << " MB)" << std::endl;
+    };
+
+    {
+        uint64_t copied = 0, paragraphs = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            std::vector<MappedChapter> chapters(paths.size());
+            std::vector<std::vector<std::string_view>> elements(paths.size());
+            for (size_t i = 0; i < paths.size(); i++) {
+                if (!OpenChapter(paths[i], chapters[i])) continue;
+                copied += chapters[i].CopiedBytes();
+                ForEachParagraph(chapters[i].Body(), [&](std::string_view line) { elements[i].push_back(line); });
+                paragraphs += elements[i].size();
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        report("Mapped, views", seconds, copied, paths.size() * passes);
+    }
+
+    {
+        // What the reader did before: read, DOM, get<>, copy for the tokenizer, istringstream, lines
+        uint64_t copied = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            std::vector<std::string> contents(paths.size());
+            std::vector<std::vector<std::string>> elements(paths.size());
+            for (size_t i = 0; i < paths.size(); i++) {
+                std::string jsonText;
+                if (!ReadChapterJson(paths[i], jsonText)) continue;
+                json j = json::parse(jsonText);
+                contents[i] = j.at("content").get<std::string>();
+                std::string content = contents[i];
+                copied += jsonText.size() + 3 * content.size();   // File read, DOM node, get<>, tokenizer copy
+
+                std::istringstream stream(content);
+                copied += content.size();
+                std::string line;
+                while (std::getline(stream, line)) {
+                    copied += line.size();
+                    line.erase(0, line.find_first_not_of(" \t\r\n"));
+                    line.erase(line.find_last_not_of(" \t\r\n") + 1);
+                    if (line.empty()) continue;
+                    elements[i].push_back(line);
+                    copied += line.size();
+                }
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        report("Read + DOM + copies", seconds, copied, paths.size() * passes);
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Chapter files on disk. A chapter is either plain JSON (older downloads) or a compressed
+// frame under the same "chapterN.json" name, so directory scans and chapter numbering
+// don't care which one they see:
+//
+//     "NRZ1" | u32 dictionary id | u32 JSON size | raw DEFLATE of the compact JSON
+//
+// Each chapter is its own frame, so opening one never touches its neighbours. Chapters of
+// the same novel share names, phrasing and translator boilerplate, so every novel gets a
+// dictionary trained on its own chapters (chapters/dictionary.bin). The dictionary is written
+// once and never replaced; frames name it by id (FNV-1a 32 of its bytes, 0 meaning none).
+// download_manager.py writes the same frames with zlib.
+//
+// Chapters live in one of two tiers (see ChapterTiering for the policy): hot chapters are
+// plain compact JSON and open without decoding, cold ones are frames at the highest level.
+// Every write goes through the library's BlobStore, so identical chapter files share storage.
+class ChapterStore {
+public:
+    enum class Tier {
+        Hot,
+        Cold
+    };
+
+    struct StoredChapter {
+        bool compressed = false;
+        uint64_t fileBytes = 0;
+        uint64_t jsonBytes = 0;   // Size once decoded; from the frame header, without decoding
+    };
+
+    // A chapter opened for reading. Title and Body point into the file's memory mapping when
+    // the stored text has nothing to unescape, otherwise into one buffer decoded from it
+    // (a compressed chapter is inflated into that buffer and unescaped in place). Copies
+    // share the storage, which stays alive until the last copy is gone.
+    class MappedChapter {
+    public:
+        bool IsOpen() const { return storage != nullptr; }
+        void Close() { storage.reset(); }
+
+        int Number() const;                 // 0 if the file doesn't say
+        std::string_view Title() const;
+        std::string_view Body() const;
+        size_t JsonBytes() const;           // Size of the JSON it was read from
+        size_t CopiedBytes() const;         // Bytes written to get Title and Body; 0 if fully mapped
+
+        // Stored at ingest by ChapterCleaner (see ChapterText); -1 and empty for chapters it
+        // hasn't measured yet
+        int64_t WordCount() const;
+        const std::vector<uint32_t>& ParagraphOffsets() const;
+
+    private:
+        friend class ChapterStore;
+        struct Storage;
+        std::shared_ptr<const Storage> storage;
+    };
+
+    struct CompactStats {
+        size_t chapters = 0;
+        size_t rewritten = 0;
+        uint64_t bytesBefore = 0;
+        uint64_t bytesAfter = 0;
+    };
+
+    static constexpr const char* DICTIONARY_FILE = "dictionary.bin";
+    static constexpr size_t MAX_DICTIONARY_SIZE = 32 * 1024;    // All of it stays inside the DEFLATE window
+    static constexpr size_t MIN_TRAINING_CHAPTERS = 8;
+    static constexpr size_t MAX_TRAINING_CHAPTERS = 64;
+
+    // Reads a chapter file of either kind and returns its JSON text
+    static bool ReadChapterJson(const std::string& path, std::string& jsonText);
+
+    // Opens a chapter file of either kind for reading without a JSON DOM
+    static bool OpenChapter(const std::string& path, MappedChapter& chapter);
+
+    // The same for a chapter already read into memory (see BatchReader). The chapter takes the
+    // bytes over and unescapes in place. path locates the novel's dictionary.
+    static bool OpenChapterBytes(const std::string& path, std::string fileBytes, MappedChapter& chapter);
+
+    // Compresses jsonText into path, using the novel's dictionary if it has one.
+    // Written through a temp file so readers never see a partial chapter.
+    static bool WriteChapterJson(const std::string& path, std::string_view jsonText);
+
+    static bool IsCompressed(std::string_view fileBytes);
+
+    // Reads only a chapter's header
+    static bool Inspect(const std::string& path, StoredChapter& info);
+
+    // Rewrites a chapter into tier, keeping its timestamp. A chapter already there is left alone.
+    static bool MoveToTier(const std::string& path, Tier tier, uint64_t* bytesAfter = nullptr);
+
+    // Trains the novel's dictionary if it has none yet and enough chapters to learn from.
+    // Returns true if the novel has a dictionary afterwards.
+    static bool EnsureDictionary(const std::string& chaptersDir);
+
+    // EnsureDictionary, then moves every chapter to the cold tier. Used to migrate a whole
+    // library at once; in the app, ChapterTiering decides per chapter.
+    static bool CompactNovel(const std::string& chaptersDir, CompactStats* stats = nullptr);
+
+    // Builds a dictionary of at most maxSize bytes from sample chapter JSON. Phrases shared by
+    // many chapters are kept, the most valuable ones last where matches are cheapest.
+    static std::string TrainDictionary(const std::vector<std::string>& samples, size_t maxSize);
+
+    static uint32_t DictionaryId(std::string_view dictionary);
+
+    // Headless benchmark: disk usage and chapter open latency, plain vs compressed
+    static void RunBenchmark(const std::string& workDir, uint64_t targetBytes);
+
+    // Headless benchmark: bytes copied and peak memory per chapter open, read-and-parse vs mapped
+    static void RunOpenBenchmark(const std::string& novelsRoot, int passes);
+
+private:
+    // Finds title and body in source, the mapping or (ownsSource) storage's own buffer
+    static bool ParseOpenedChapter(const std::string& path, std::shared_ptr<MappedChapter::Storage> storage,
+        std::string_view source, bool ownsSource, MappedChapter& chapter);
+};
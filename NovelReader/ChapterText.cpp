@@ -0,0 +1,250 @@
+#include "ChapterText.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CHAPTER_TEXT_SSE2 1
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr int STATS_VERSION = 1;
+
+    constexpr const char* EN_DASH = "\xE2\x80\x93";
+    constexpr const char* EM_DASH = "\xE2\x80\x94";
+
+    struct Replacement {
+        std::string_view from;   // UTF-8
+        const char* to;
+    };
+
+    // Everything Normalize folds; "" drops the character
+    const Replacement REPLACEMENTS[] = {
+        { "\xC2\xA0", " " },        // No-break space
+        { "\xC2\xAD", "" },         // Soft hyphen
+        { "\xE2\x80\x80", " " }, { "\xE2\x80\x81", " " }, { "\xE2\x80\x82", " " }, { "\xE2\x80\x83", " " },
+        { "\xE2\x80\x84", " " }, { "\xE2\x80\x85", " " }, { "\xE2\x80\x86", " " }, { "\xE2\x80\x87", " " },
+        { "\xE2\x80\x88", " " }, { "\xE2\x80\x89", " " }, { "\xE2\x80\x8A", " " },   // En quad .. hair space
+        { "\xE2\x80\x8B", "" },     // Zero-width space
+        { "\xE2\x80\x90", "-" },    // Hyphen
+        { "\xE2\x80\x91", "-" },    // Non-breaking hyphen
+        { "\xE2\x80\x92", EN_DASH },   // Figure dash
+        { "\xE2\x80\x95", EM_DASH },   // Horizontal bar
+        { "\xE2\x80\x98", "'" }, { "\xE2\x80\x99", "'" }, { "\xE2\x80\x9A", "'" }, { "\xE2\x80\x9B", "'" },
+        { "\xE2\x80\x9C", "\"" }, { "\xE2\x80\x9D", "\"" }, { "\xE2\x80\x9E", "\"" }, { "\xE2\x80\x9F", "\"" },
+        { "\xE2\x80\xAF", " " },    // Narrow no-break space
+        { "\xE2\x81\x9F", " " },    // Medium mathematical space
+        { "\xE2\x81\xA0", "" },     // Word joiner
+        { "\xE2\xB8\xBA", EM_DASH }, { "\xE2\xB8\xBB", EM_DASH },   // Two- and three-em dash
+        { "\xE3\x80\x80", " " },    // Ideographic space
+        { "\xEF\xBB\xBF", "" },     // Byte order mark
+    };
+
+    inline bool MayStartReplacement(unsigned char c) {
+        return c == 0xC2 || c == 0xE2 || c == 0xE3 || c == 0xEF;
+    }
+
+    inline bool IsLineSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\f' || c == '\v';
+    }
+
+    // Line endings, characters and dashes; spacing is left to the second pass
+    std::string FoldCharacters(std::string_view text) {
+        std::string out;
+        out.reserve(text.size());
+        for (size_t i = 0; i < text.size(); i++) {
+            char c = text[i];
+            if (c == '\r') {
+                out += '\n';
+                if (i + 1 < text.size() && text[i + 1] == '\n') i++;
+                continue;
+            }
+            if (c == '-' && i + 1 < text.size() && text[i + 1] == '-' &&
+                (i + 2 == text.size() || text[i + 2] != '-') && (i == 0 || text[i - 1] != '-')) {
+                out += EM_DASH;   // A typed em dash; longer runs are rules and stay
+                i++;
+                continue;
+            }
+            if (MayStartReplacement(static_cast<unsigned char>(c))) {
+                std::string_view rest = text.substr(i);
+                const Replacement* found = nullptr;
+                for (const Replacement& replacement : REPLACEMENTS) {
+                    if (rest.starts_with(replacement.from)) {
+                        found = &replacement;
+                        break;
+                    }
+                }
+                if (found) {
+                    out += found->to;
+                    i += found->from.size() - 1;
+                    continue;
+                }
+            }
+            out += IsLineSpace(c) ? ' ' : c;
+        }
+        return out;
+    }
+}
+
+bool ChapterText::Normalize(std::string& content) {
+    std::string folded = FoldCharacters(content);
+
+    // Trim lines, collapse spaces, keep one blank line between paragraphs
+    std::string out;
+    out.reserve(folded.size());
+    bool pendingBlank = false;
+    size_t lineStart = 0;
+    while (lineStart <= folded.size()) {
+        size_t lineEnd = folded.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = folded.size();
+
+        size_t lineBegin = out.size();
+        bool pendingSpace = false;
+        bool lineEmpty = true;
+        for (size_t i = lineStart; i < lineEnd; i++) {
+            char c = folded[i];
+            if (c == ' ') {
+                pendingSpace = !lineEmpty;
+                continue;
+            }
+            if (lineEmpty) {
+                if (lineBegin > 0) out += pendingBlank ? "\n\n" : "\n";
+                lineEmpty = false;
+            }
+            else if (pendingSpace) {
+                out += ' ';
+            }
+            pendingSpace = false;
+            out += c;
+        }
+        if (lineEmpty) pendingBlank = !out.empty();
+        else pendingBlank = false;
+
+        lineStart = lineEnd + 1;
+    }
+
+    if (out == content) return false;
+    content = std::move(out);
+    return true;
+}
+
+size_t ChapterText::CountWords(std::string_view text) {
+    // A word starts at every non-space byte that follows a space byte (or the start)
+    size_t words = 0;
+    bool previousSpace = true;
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+#ifdef CHAPTER_TEXT_SSE2
+    const __m128i spaceMax = _mm_set1_epi8(0x20);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i space = _mm_cmpeq_epi8(_mm_min_epu8(v, spaceMax), v);   // v <= 0x20
+        uint32_t spaces = static_cast<uint32_t>(_mm_movemask_epi8(space));
+        uint32_t before = ((spaces << 1) | (previousSpace ? 1u : 0u)) & 0xFFFF;
+        words += std::popcount(~spaces & before & 0xFFFF);
+        previousSpace = (spaces & 0x8000) != 0;
+        p += 16;
+    }
+#endif
+    for (; p < end; p++) {
+        bool space = static_cast<unsigned char>(*p) <= 0x20;
+        if (!space && previousSpace) words++;
+        previousSpace = space;
+    }
+    return words;
+}
+
+ChapterText::Metrics ChapterText::Measure(std::string_view content) {
+    Metrics metrics;
+    metrics.words = static_cast<uint32_t>(CountWords(content));
+
+    size_t lineStart = 0;
+    while (lineStart < content.size()) {
+        size_t lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = content.size();
+        std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+        if (line.find_first_not_of(" \t\r") != std::string_view::npos) {
+            metrics.paragraphs.push_back(static_cast<uint32_t>(lineStart));
+        }
+        lineStart = lineEnd + 1;
+    }
+    return metrics;
+}
+
+uint64_t ChapterText::ReadingMinutes(uint64_t words) {
+    return (words + WORDS_PER_MINUTE - 1) / WORDS_PER_MINUTE;
+}
+
+std::string ChapterText::FormatReadingTime(uint64_t words) {
+    uint64_t minutes = ReadingMinutes(words);
+    if (minutes < 60) return std::to_string(minutes) + " min";
+    std::string text = std::to_string(minutes / 60) + " h";
+    if (minutes % 60 != 0) text += " " + std::to_string(minutes % 60) + " min";
+    return text;
+}
+
+uint64_t ChapterText::NovelStats::WordsFrom(int chapter) const {
+    uint64_t words = 0;
+    for (auto it = chapters.lower_bound(chapter); it != chapters.end(); ++it) {
+        words += it->second.words;
+    }
+    return words;
+}
+
+// ============================================================================
+// Per-novel totals
+// ============================================================================
+bool ChapterText::LoadNovelStats(const std::string& novelDir, NovelStats& stats) {
+    stats = NovelStats();
+    std::filesystem::path statsPath = std::filesystem::path(novelDir) / STATS_FILE;
+    std::ifstream file(statsPath);
+    if (!file.is_open()) return false;
+    try {
+        json j;
+        file >> j;
+        if (j.value("version", 0) != STATS_VERSION) return false;
+        for (const auto& chapter : j.value("chapters", json::array())) {
+            ChapterStats chapterStats;
+            chapterStats.words = chapter.value("words", 0u);
+            chapterStats.paragraphs = chapter.value("paragraphs", 0u);
+            stats.chapters[chapter.value("chapter", 0)] = chapterStats;
+            stats.totalWords += chapterStats.words;
+        }
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cout << "Ignoring unreadable " << statsPath.string() << ": " << e.what() << std::endl;
+        stats = NovelStats();
+        return false;
+    }
+}
+
+bool ChapterText::SaveNovelStats(const std::string& novelDir, const NovelStats& stats) {
+    json j;
+    j["version"] = STATS_VERSION;
+    j["totalWords"] = stats.totalWords;
+    j["chapters"] = json::array();
+    for (const auto& [number, chapter] : stats.chapters) {
+        j["chapters"].push_back({ {"chapter", number}, {"words", chapter.words}, {"paragraphs", chapter.paragraphs} });
+    }
+
+    std::filesystem::path statsPath = std::filesystem::path(novelDir) / STATS_FILE;
+    std::filesystem::path tempPath = statsPath;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << j.dump(-1);
+        if (!file.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, statsPath, ec);
+    return !ec;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+// The canonical form of chapter text and the numbers the app keeps about it, so the reader
+// and the library panels never read a chapter body just to count it.
+//
+// Normalize runs when ChapterCleaner persists a chapter: line endings become '\n', odd spaces
+// (no-break, ideographic, tabs) become plain spaces, invisible characters (zero-width space,
+// soft hyphen, BOM) go, runs of spaces collapse and lines are trimmed, and paragraphs are kept
+// one blank line apart. Curly and low quotes become ASCII quotes, so a find typed on a
+// keyboard matches them, and the dash family folds into '-', en dash and em dash ("--" too).
+//
+// Measure finds each paragraph's byte offset (non-empty lines, the rule the reader and the
+// search index use) and counts words. Both are stored in the chapter file as "wordCount" and
+// "paragraphOffsets", and each novel's totals in <novel>/text_stats.json.
+class ChapterText {
+public:
+    static constexpr const char* STATS_FILE = "text_stats.json";
+    static constexpr uint32_t WORDS_PER_MINUTE = 238;   // Average silent reading speed for fiction
+
+    struct Metrics {
+        uint32_t words = 0;
+        std::vector<uint32_t> paragraphs;   // Byte offset of each non-empty line in the content
+    };
+
+    struct ChapterStats {
+        uint32_t words = 0;
+        uint32_t paragraphs = 0;
+    };
+
+    struct NovelStats {
+        std::map<int, ChapterStats> chapters;   // By chapter number
+        uint64_t totalWords = 0;
+
+        // Words in chapters numbered from `chapter` on; what is left to read when about to start it
+        uint64_t WordsFrom(int chapter) const;
+    };
+
+    // Rewrites content into the canonical form; returns true if anything changed
+    static bool Normalize(std::string& content);
+
+    static Metrics Measure(std::string_view content);
+
+    // Runs of bytes between ASCII whitespace, 16 bytes at a time with SSE2
+    static size_t CountWords(std::string_view text);
+
+    static uint64_t ReadingMinutes(uint64_t words);
+    static std::string FormatReadingTime(uint64_t words);   // "3 h 20 min", "12 min"
+
+    // novelDir is the novel's folder, with chapters/ inside
+    static bool LoadNovelStats(const std::string& novelDir, NovelStats& stats);
+    static bool SaveNovelStats(const std::string& novelDir, const NovelStats& stats);
+};
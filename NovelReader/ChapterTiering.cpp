@@ -0,0 +1,251 @@
+#include "ChapterTiering.h"
+#include "ChapterCleaner.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+    constexpr auto SWEEP_INTERVAL = std::chrono::minutes(5);
+
+    std::filesystem::path ChapterPath(const std::string& novelsRoot, const std::string& novelDirName, int chapter) {
+        return std::filesystem::path(novelsRoot) / novelDirName / "chapters" / ("chapter" + std::to_string(chapter) + ".json");
+    }
+}
+
+ChapterTiering::ChapterTiering(std::string novelsRoot)
+    : novelsRoot(novelsRoot),
+      blobStore((std::filesystem::path(novelsRoot) / BlobStore::DIRECTORY_NAME).string()),
+      job([this]() { RunPass(); }) {
+}
+
+ChapterTiering::~ChapterTiering() {
+    Stop();
+}
+
+void ChapterTiering::Start() {
+    stopping = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = false;
+    }
+    job.Start();
+    job.Request();
+}
+
+void ChapterTiering::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    stopping = true;
+    job.Stop();
+}
+
+void ChapterTiering::SetBudget(const Budget& newBudget) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        budget = newBudget;
+        budget.chaptersBehind = std::max(0, budget.chaptersBehind);
+        budget.chaptersAhead = std::max(0, budget.chaptersAhead);
+        budget.hotNovels = std::max(0, budget.hotNovels);
+        budget.maxHotMegabytes = std::max(0, budget.maxHotMegabytes);
+        sweepRequested = true;   // A smaller budget only takes effect through demotion
+    }
+    job.Request();
+}
+
+ChapterTiering::Budget ChapterTiering::GetBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+void ChapterTiering::UpdatePosition(const std::string& novelDirName, int chapter, std::time_t lastRead) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Position& position = positions[novelDirName];
+        if (position.chapter == chapter && position.lastRead == lastRead) return;
+        position.chapter = chapter;
+        position.lastRead = lastRead;
+        promoteRequested = true;
+    }
+    job.Request();
+}
+
+BlobStore::Stats ChapterTiering::StoreStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return storeStats;
+}
+
+void ChapterTiering::RequestSweep() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sweepRequested = true;
+    }
+    job.Request();
+}
+
+// ============================================================================
+// Policy
+// ============================================================================
+std::vector<std::string> ChapterTiering::SelectHotChapters(const std::unordered_map<std::string, Position>& positions,
+    const Budget& budget) const {
+    std::vector<std::pair<std::string, Position>> recent(positions.begin(), positions.end());
+    std::sort(recent.begin(), recent.end(),
+        [](const auto& a, const auto& b) { return a.second.lastRead > b.second.lastRead; });
+    if (recent.size() > static_cast<size_t>(budget.hotNovels)) recent.resize(budget.hotNovels);
+
+    // Walk outward from every position at once, so when the budget runs out each novel still
+    // has its nearest chapters hot. The chapter being read comes first, then the next ones.
+    std::vector<int> offsets = { 0 };
+    for (int step = 1; step <= std::max(budget.chaptersAhead, budget.chaptersBehind); step++) {
+        if (step <= budget.chaptersAhead) offsets.push_back(step);
+        if (step <= budget.chaptersBehind) offsets.push_back(-step);
+    }
+
+    uint64_t maxBytes = static_cast<uint64_t>(budget.maxHotMegabytes) * 1024 * 1024;
+    uint64_t usedBytes = 0;
+    std::vector<std::string> hotPaths;
+    for (int offset : offsets) {
+        for (const auto& [novelDirName, position] : recent) {
+            int chapter = position.chapter + offset;
+            if (chapter < 1) continue;
+
+            std::string path = ChapterPath(novelsRoot, novelDirName, chapter).string();
+            ChapterStore::StoredChapter info;
+            if (!ChapterStore::Inspect(path, info)) continue;   // Not downloaded (yet)
+            if (usedBytes + info.jsonBytes > maxBytes) return hotPaths;
+
+            usedBytes += info.jsonBytes;
+            hotPaths.push_back(std::move(path));
+        }
+    }
+    return hotPaths;
+}
+
+// ============================================================================
+// Passes
+// ============================================================================
+void ChapterTiering::SweepNovel(const std::filesystem::path& novelDir, const std::unordered_set<std::string>& hot) {
+    std::error_code ec;
+    std::filesystem::path chaptersDir = novelDir / "chapters";
+    if (!std::filesystem::is_directory(chaptersDir, ec)) return;
+
+    // Cleaned first, so the dictionary learns from the text the reader will see
+    ChapterCleaner::EnsureCleaned(novelDir.string());
+    ChapterStore::EnsureDictionary(chaptersDir.string());
+
+    for (const auto& entry : std::filesystem::directory_iterator(chaptersDir, ec)) {
+        if (stopping) return;
+
+        const std::filesystem::path& path = entry.path();
+        if (path.extension() != ".json" || path.stem().string().rfind("chapter", 0) != 0) continue;
+
+        bool isHot = hot.count(path.lexically_normal().string()) > 0;
+        uint64_t bytes = 0;
+        if (!ChapterStore::MoveToTier(path.string(), isHot ? ChapterStore::Tier::Hot : ChapterStore::Tier::Cold, &bytes)) {
+            continue;
+        }
+
+        // Chapters saved before the store existed (and already in their tier) are still private;
+        // one that is open right now is left for the next sweep
+        std::error_code linkError;
+        if (adoptChapters && std::filesystem::hard_link_count(path, linkError) == 1) {
+            blobStore.Adopt(path.string());
+        }
+        if (isHot) {
+            sweep.hotBytes += bytes;
+            sweep.hotChapters++;
+        }
+        else {
+            sweep.coldBytes += bytes;
+            sweep.coldChapters++;
+        }
+    }
+}
+
+void ChapterTiering::FinishSweep() {
+    hotBytes = sweep.hotBytes;
+    coldBytes = sweep.coldBytes;
+    hotChapters = sweep.hotChapters;
+    coldChapters = sweep.coldChapters;
+    sweep = SweepState();
+    nextSweep = std::chrono::steady_clock::now() + SWEEP_INTERVAL;
+
+    // Entries of removed novels are gone by now, so their blobs have no links left
+    BlobStore::Stats stats = blobStore.CollectGarbage();
+    std::lock_guard<std::mutex> lock(mutex);
+    storeStats = stats;
+}
+
+// Tiering is housekeeping: the job runs on the background lane so it never competes with reading
+void ChapterTiering::RunPass() {
+    if (!linksChecked) {
+        linksChecked = true;
+        nextSweep = std::chrono::steady_clock::now() + SWEEP_INTERVAL;
+        adoptChapters = blobStore.SupportsLinks();
+        if (!adoptChapters) {
+            std::cout << "No hard links in " << blobStore.Root() << "; chapter files won't be deduplicated" << std::endl;
+        }
+    }
+
+    std::unordered_map<std::string, Position> positionsCopy;
+    Budget budgetCopy;
+    bool startSweep = false;
+    bool promote = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopRequested) return;
+
+        startSweep = std::exchange(sweepRequested, false) ||
+            (!sweep.running && std::chrono::steady_clock::now() >= nextSweep);
+        promote = std::exchange(promoteRequested, false);
+        positionsCopy = positions;
+        budgetCopy = budget;
+    }
+
+    std::vector<std::string> hotPaths = SelectHotChapters(positionsCopy, budgetCopy);
+
+    // A sweep requested while one runs starts over, so every novel sees the latest budget
+    if (startSweep) {
+        sweep = SweepState();
+        sweep.running = true;
+        std::error_code ec;
+        for (const auto& novelEntry : std::filesystem::directory_iterator(novelsRoot, ec)) {
+            if (novelEntry.is_directory()) sweep.novelsLeft.push_back(novelEntry.path());
+        }
+    }
+
+    // Between sweeps, and for positions that moved during one, only promote; chapters that fell
+    // out of the window wait for the sweep
+    if (!sweep.running || promote) {
+        for (const std::string& path : hotPaths) {
+            if (stopping) break;
+            ChapterStore::MoveToTier(path, ChapterStore::Tier::Hot);
+        }
+    }
+
+    if (sweep.running) {
+        if (!sweep.novelsLeft.empty()) {
+            std::unordered_set<std::string> hot;
+            for (const std::string& path : hotPaths) {
+                hot.insert(std::filesystem::path(path).lexically_normal().string());
+            }
+            SweepNovel(sweep.novelsLeft.back(), hot);
+            sweep.novelsLeft.pop_back();
+        }
+        if (stopping) {
+            sweep = SweepState();   // Abandoned; the next one starts over
+            return;
+        }
+        if (!sweep.novelsLeft.empty()) {
+            job.Request();
+            return;
+        }
+        FinishSweep();
+    }
+
+    job.RequestAt(nextSweep);
+}
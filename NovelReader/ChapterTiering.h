@@ -0,0 +1,102 @@
+#pragma once
+#include "ChapterStore.h"
+#include "BlobStore.h"
+#include "TaskScheduler.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+
+// Decides which tier each chapter belongs in, in background TaskScheduler passes that never
+// overlap.
+//
+// The chapters around each recently read novel's position (a few behind, more ahead) are kept
+// hot so the next chapter opens without decoding. Everything else is demoted to the cold tier.
+// A position update promotes its window right away. Demotion is a full sweep of the library
+// that runs periodically, or when the budget changes, a download finishes or a novel is removed.
+// The sweep also cleans newly downloaded chapters (ChapterCleaner), moves older chapter files
+// into the library's BlobStore and ends by collecting blobs nothing links to anymore. It takes
+// one novel per pass, so a large library never holds a worker for long.
+class ChapterTiering {
+public:
+    struct Budget {
+        int chaptersBehind = 2;
+        int chaptersAhead = 10;
+        int hotNovels = 5;              // Most recently read novels that get a hot window
+        int maxHotMegabytes = 256;      // Across all hot windows, nearest chapters first
+    };
+
+    explicit ChapterTiering(std::string novelsRoot);
+    ~ChapterTiering();
+
+    ChapterTiering(const ChapterTiering&) = delete;
+    ChapterTiering& operator=(const ChapterTiering&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Thread-safe
+    void SetBudget(const Budget& budget);
+    Budget GetBudget() const;
+    void UpdatePosition(const std::string& novelDirName, int chapter, std::time_t lastRead);
+    void RequestSweep();
+
+    // As of the last sweep
+    uint64_t HotBytes() const { return hotBytes.load(); }
+    uint64_t ColdBytes() const { return coldBytes.load(); }
+    size_t HotChapters() const { return hotChapters.load(); }
+    size_t ColdChapters() const { return coldChapters.load(); }
+    BlobStore::Stats StoreStats() const;
+
+private:
+    struct Position {
+        int chapter = 1;
+        std::time_t lastRead = 0;
+    };
+
+    void RunPass();
+    std::vector<std::string> SelectHotChapters(const std::unordered_map<std::string, Position>& positions,
+        const Budget& budget) const;
+    void SweepNovel(const std::filesystem::path& novelDir, const std::unordered_set<std::string>& hot);
+    void FinishSweep();
+
+    std::string novelsRoot;
+    BlobStore blobStore;
+    bool adoptChapters = true;   // Passes only; off when the volume can't link
+    bool linksChecked = false;   // Passes only
+    std::chrono::steady_clock::time_point nextSweep;   // Passes only
+
+    // The sweep in progress; passes only
+    struct SweepState {
+        bool running = false;
+        std::vector<std::filesystem::path> novelsLeft;
+        uint64_t hotBytes = 0;
+        uint64_t coldBytes = 0;
+        size_t hotChapters = 0;
+        size_t coldChapters = 0;
+    };
+    SweepState sweep;
+
+    mutable std::mutex mutex;
+
+    // Guarded by mutex
+    std::unordered_map<std::string, Position> positions;   // By novel folder name
+    Budget budget;
+    bool stopRequested = false;
+    bool promoteRequested = false;
+    bool sweepRequested = true;   // The first pass migrates anything stored before tiering existed
+    BlobStore::Stats storeStats;
+
+    std::atomic<bool> stopping{ false };
+    std::atomic<uint64_t> hotBytes{ 0 };
+    std::atomic<uint64_t> coldBytes{ 0 };
+    std::atomic<size_t> hotChapters{ 0 };
+    std::atomic<size_t> coldChapters{ 0 };
+
+    TaskScheduler::Job job;   // Last, so it stops before the state its passes use goes away
+};
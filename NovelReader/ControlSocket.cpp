@@ -0,0 +1,366 @@
+#include "ControlSocket.h"
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t READ_CHUNK = 4096;
+    constexpr size_t MAX_LINE = 1 << 20;        // Anything longer is a broken peer, not a message
+
+#ifdef _WIN32
+    constexpr DWORD PIPE_BUFFER = 64 * 1024;
+    constexpr int CONNECT_ATTEMPTS = 5;
+    constexpr DWORD BUSY_WAIT_MS = 2000;
+
+    // Overlapped I/O, so a read blocked on one thread doesn't hold up a send on another the way
+    // synchronous I/O on one handle would. Gives up when shutdownEvent is set.
+    bool Transfer(HANDLE pipe, HANDLE shutdownEvent, bool write, void* data, DWORD size, DWORD& transferred) {
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        if (!overlapped.hEvent) return false;
+
+        BOOL started = write ? WriteFile(pipe, data, size, nullptr, &overlapped)
+            : ReadFile(pipe, data, size, nullptr, &overlapped);
+        if (!started && GetLastError() != ERROR_IO_PENDING) {
+            CloseHandle(overlapped.hEvent);
+            return false;
+        }
+
+        HANDLE events[2] = { overlapped.hEvent, shutdownEvent };
+        DWORD woken = WaitForMultipleObjects(2, events, FALSE, INFINITE);
+        if (woken != WAIT_OBJECT_0) {
+            CancelIoEx(pipe, &overlapped);
+        }
+        BOOL completed = GetOverlappedResult(pipe, &overlapped, &transferred, TRUE);
+        CloseHandle(overlapped.hEvent);
+        return completed && woken == WAIT_OBJECT_0;
+    }
+#else
+    bool MakeAddress(const std::string& endpoint, sockaddr_un& address) {
+        address = {};
+        address.sun_family = AF_UNIX;
+        if (endpoint.size() >= sizeof(address.sun_path)) {
+            std::cout << "Control socket path too long: " << endpoint << std::endl;
+            return false;
+        }
+        std::memcpy(address.sun_path, endpoint.c_str(), endpoint.size() + 1);
+        return true;
+    }
+
+    int ConnectTo(const std::string& endpoint) {
+        sockaddr_un address;
+        if (!MakeAddress(endpoint, address)) return -1;
+        int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (descriptor < 0) return -1;
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(descriptor, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(descriptor);
+            return -1;
+        }
+        return descriptor;
+    }
+#endif
+}
+
+// ============================================================================
+// ControlSocket
+// ============================================================================
+ControlSocket::~ControlSocket() {
+#ifdef _WIN32
+    if (pipeHandle) CloseHandle(pipeHandle);
+    if (shutdownEvent) CloseHandle(shutdownEvent);
+#else
+    if (socketDescriptor >= 0) close(socketDescriptor);
+#endif
+}
+
+std::string ControlSocket::DefaultEndpoint() {
+#ifdef _WIN32
+    return "\\\\.\\pipe\\NovelReaderDaemon";
+#else
+    return "downloads/daemon.sock";
+#endif
+}
+
+bool ControlSocket::Connect(const std::string& endpoint) {
+    if (IsOpen()) return false;
+#ifdef _WIN32
+    for (int attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++) {
+        HANDLE pipe = CreateFileA(endpoint.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+            OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+        if (pipe != INVALID_HANDLE_VALUE) {
+            pipeHandle = pipe;
+            shutdownEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            return shutdownEvent != nullptr;
+        }
+        // Every instance is taken until the server creates the next one
+        if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeA(endpoint.c_str(), BUSY_WAIT_MS)) {
+            return false;
+        }
+    }
+    return false;
+#else
+    socketDescriptor = ConnectTo(endpoint);
+    return socketDescriptor >= 0;
+#endif
+}
+
+bool ControlSocket::IsOpen() const {
+#ifdef _WIN32
+    return pipeHandle != nullptr;
+#else
+    return socketDescriptor >= 0;
+#endif
+}
+
+bool ControlSocket::SendLine(const std::string& line) {
+    std::string message = line;
+    message += '\n';
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return Write(message.data(), message.size());
+}
+
+bool ControlSocket::ReadLine(std::string& line) {
+    while (true) {
+        size_t newline = readBuffer.find('\n');
+        if (newline != std::string::npos) {
+            line.assign(readBuffer, 0, newline);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            readBuffer.erase(0, newline + 1);
+            return true;
+        }
+        if (readBuffer.size() > MAX_LINE) {
+            std::cout << "Control message too long, dropping the connection" << std::endl;
+            return false;
+        }
+
+        char chunk[READ_CHUNK];
+        size_t received = 0;
+        if (!Read(chunk, sizeof(chunk), received)) return false;
+        readBuffer.append(chunk, received);
+    }
+}
+
+void ControlSocket::Shutdown() {
+    if (shutDown.exchange(true)) return;
+#ifdef _WIN32
+    if (shutdownEvent) SetEvent(shutdownEvent);
+#else
+    if (socketDescriptor >= 0) shutdown(socketDescriptor, SHUT_RDWR);
+#endif
+}
+
+bool ControlSocket::Write(const char* data, size_t size) {
+    if (!IsOpen() || shutDown) return false;
+    while (size > 0) {
+#ifdef _WIN32
+        DWORD written = 0;
+        if (!Transfer(pipeHandle, shutdownEvent, true, const_cast<char*>(data), static_cast<DWORD>(size), written)) {
+            return false;
+        }
+#else
+#ifdef MSG_NOSIGNAL
+        ssize_t written = send(socketDescriptor, data, size, MSG_NOSIGNAL);
+#else
+        ssize_t written = send(socketDescriptor, data, size, 0);
+#endif
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+#endif
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool ControlSocket::Read(char* buffer, size_t capacity, size_t& received) {
+    if (!IsOpen() || shutDown) return false;
+#ifdef _WIN32
+    DWORD read = 0;
+    if (!Transfer(pipeHandle, shutdownEvent, false, buffer, static_cast<DWORD>(capacity), read) || read == 0) {
+        return false;
+    }
+    received = read;
+    return true;
+#else
+    while (true) {
+        ssize_t read = recv(socketDescriptor, buffer, capacity, 0);
+        if (read < 0 && errno == EINTR) continue;
+        if (read <= 0) return false;
+        received = static_cast<size_t>(read);
+        return true;
+    }
+#endif
+}
+
+// ============================================================================
+// ControlListener
+// ============================================================================
+ControlListener::~ControlListener() {
+    Close();
+#ifdef _WIN32
+    if (pendingPipe) CloseHandle(pendingPipe);
+    if (closeEvent) CloseHandle(closeEvent);
+#else
+    if (listenDescriptor >= 0) {
+        close(listenDescriptor);
+        std::error_code ec;
+        std::filesystem::remove(endpoint, ec);
+    }
+#endif
+}
+
+#ifdef _WIN32
+bool ControlListener::CreateInstance(bool first) {
+    DWORD openMode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+    HANDLE pipe = CreateNamedPipeA(endpoint.c_str(), openMode,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        PIPE_UNLIMITED_INSTANCES, PIPE_BUFFER, PIPE_BUFFER, 0, nullptr);
+    if (pipe == INVALID_HANDLE_VALUE) return false;
+    std::lock_guard<std::mutex> lock(instanceMutex);
+    pendingPipe = pipe;
+    return true;
+}
+#endif
+
+bool ControlListener::Listen(const std::string& listenEndpoint) {
+    endpoint = listenEndpoint;
+    closing = false;
+#ifdef _WIN32
+    closeEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (!closeEvent) return false;
+    if (!CreateInstance(true)) {
+        if (GetLastError() == ERROR_ACCESS_DENIED) {
+            std::cout << "Another process is already serving " << endpoint << std::endl;
+        }
+        else {
+            std::cout << "Could not create pipe " << endpoint << " (error " << GetLastError() << ")" << std::endl;
+        }
+        return false;
+    }
+    return true;
+#else
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(endpoint).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+
+    // A socket file nobody answers on was left by a process that died
+    int existing = ConnectTo(endpoint);
+    if (existing >= 0) {
+        close(existing);
+        std::cout << "Another process is already serving " << endpoint << std::endl;
+        return false;
+    }
+    std::filesystem::remove(endpoint, ec);
+
+    sockaddr_un address;
+    if (!MakeAddress(endpoint, address)) return false;
+    listenDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenDescriptor < 0) return false;
+    if (bind(listenDescriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenDescriptor, SOMAXCONN) != 0) {
+        std::cout << "Could not listen on " << endpoint << ": " << std::strerror(errno) << std::endl;
+        close(listenDescriptor);
+        listenDescriptor = -1;
+        return false;
+    }
+    return true;
+#endif
+}
+
+std::unique_ptr<ControlSocket> ControlListener::Accept() {
+#ifdef _WIN32
+    while (!closing) {
+        HANDLE pipe;
+        {
+            std::lock_guard<std::mutex> lock(instanceMutex);
+            pipe = pendingPipe;
+        }
+        if (!pipe) return nullptr;
+
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        if (!overlapped.hEvent) return nullptr;
+
+        bool connected = ConnectNamedPipe(pipe, &overlapped) != FALSE;
+        DWORD error = connected ? ERROR_SUCCESS : GetLastError();
+        if (error == ERROR_IO_PENDING) {
+            HANDLE events[2] = { overlapped.hEvent, closeEvent };
+            DWORD woken = WaitForMultipleObjects(2, events, FALSE, INFINITE);
+            if (woken != WAIT_OBJECT_0) CancelIoEx(pipe, &overlapped);
+            DWORD unused = 0;
+            connected = GetOverlappedResult(pipe, &overlapped, &unused, TRUE) != FALSE && woken == WAIT_OBJECT_0;
+        }
+        else if (error == ERROR_PIPE_CONNECTED) {
+            connected = true;
+        }
+        CloseHandle(overlapped.hEvent);
+
+        if (!connected || closing) {
+            if (closing) return nullptr;
+            DisconnectNamedPipe(pipe);      // The client gave up before we got to it
+            continue;
+        }
+
+        auto socket = std::make_unique<ControlSocket>();
+        socket->pipeHandle = pipe;
+        socket->shutdownEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        {
+            std::lock_guard<std::mutex> lock(instanceMutex);
+            pendingPipe = nullptr;
+        }
+        if (!CreateInstance(false)) {
+            std::cout << "Could not create the next pipe instance (error " << GetLastError() << ")" << std::endl;
+        }
+        return socket;
+    }
+    return nullptr;
+#else
+    while (!closing && listenDescriptor >= 0) {
+        int descriptor = accept(listenDescriptor, nullptr, nullptr);
+        if (descriptor < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return nullptr;
+        }
+        if (closing) {
+            close(descriptor);
+            return nullptr;
+        }
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(descriptor, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        auto socket = std::make_unique<ControlSocket>();
+        socket->socketDescriptor = descriptor;
+        return socket;
+    }
+    return nullptr;
+#endif
+}
+
+void ControlListener::Close() {
+    if (closing.exchange(true)) return;
+#ifdef _WIN32
+    if (closeEvent) SetEvent(closeEvent);
+#else
+    if (listenDescriptor >= 0) {
+        // Wakes accept(): shutdown() does on Linux, a connection of our own does everywhere
+        shutdown(listenDescriptor, SHUT_RDWR);
+        int wake = ConnectTo(endpoint);
+        if (wake >= 0) close(wake);
+    }
+#endif
+}
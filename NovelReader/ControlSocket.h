@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+// Local stream connection carrying newline-delimited messages: a Unix domain socket, or a
+// named pipe on Windows. Used by the download daemon and the processes that talk to it.
+//
+// One thread may read while others send; Shutdown() from any thread wakes a blocked reader,
+// and the connection is closed when the object is destroyed.
+class ControlSocket {
+public:
+    ControlSocket() = default;
+    ~ControlSocket();
+
+    ControlSocket(const ControlSocket&) = delete;
+    ControlSocket& operator=(const ControlSocket&) = delete;
+
+    // downloads/daemon.sock under the library root, or \\.\pipe\NovelReaderDaemon
+    static std::string DefaultEndpoint();
+
+    bool Connect(const std::string& endpoint);
+
+    // Writes line and a newline; false once the other end has gone
+    bool SendLine(const std::string& line);
+
+    // Blocks for the next line, without its newline; false on close or Shutdown()
+    bool ReadLine(std::string& line);
+
+    void Shutdown();
+    bool IsOpen() const;
+
+private:
+    friend class ControlListener;
+
+    bool Write(const char* data, size_t size);
+    bool Read(char* buffer, size_t capacity, size_t& received);
+
+#ifdef _WIN32
+    void* pipeHandle = nullptr;
+    void* shutdownEvent = nullptr;
+#else
+    int socketDescriptor = -1;
+#endif
+    std::atomic<bool> shutDown{ false };
+    std::mutex writeMutex;
+    std::string readBuffer;            // Reader thread only
+};
+
+// Accepts ControlSocket connections on an endpoint. Only one listener can hold an endpoint:
+// Listen() fails while another process is serving it, and takes over a stale socket file
+// left behind by one that crashed.
+class ControlListener {
+public:
+    ControlListener() = default;
+    ~ControlListener();
+
+    ControlListener(const ControlListener&) = delete;
+    ControlListener& operator=(const ControlListener&) = delete;
+
+    bool Listen(const std::string& endpoint);
+
+    // Blocks for the next connection; nullptr once Close() is called
+    std::unique_ptr<ControlSocket> Accept();
+
+    // Stops listening and wakes a blocked Accept()
+    void Close();
+
+private:
+    std::string endpoint;
+    std::atomic<bool> closing{ false };
+#ifdef _WIN32
+    bool CreateInstance(bool first);
+
+    std::mutex instanceMutex;
+    void* pendingPipe = nullptr;       // Instance waiting for the next client
+    void* closeEvent = nullptr;
+#else
+    int listenDescriptor = -1;
+#endif
+};
@@ -0,0 +1,650 @@
+#include "Deflate.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    constexpr uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    constexpr uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    constexpr uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    constexpr uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    constexpr int MAX_BITS = 15;
+    constexpr int MAX_CODE_LENGTH_BITS = 7;
+    constexpr int LITLEN_SYMBOLS = 286;
+    constexpr int DIST_SYMBOLS = 30;
+    constexpr int MIN_MATCH = 3;
+    constexpr int MAX_MATCH = 258;
+    constexpr size_t BLOCK_SYMBOLS = 32768;    // Symbols per dynamic block before a new header
+
+    uint32_t ReverseBits(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; i++) {
+            reversed = (reversed << 1) | (code & 1);
+            code >>= 1;
+        }
+        return reversed;
+    }
+
+    // ============================================================================
+    // Inflate
+    // ============================================================================
+    class BitReader {
+    public:
+        BitReader(std::string_view input)
+            : data(reinterpret_cast<const uint8_t*>(input.data())), size(input.size()) {
+        }
+
+        // Past the end the stream reads as zeros; Overrun() reports it once decoding stops
+        void Refill() {
+            while (count <= 56) {
+                uint64_t byte = position < size ? data[position] : 0;
+                position++;
+                bits |= byte << count;
+                count += 8;
+            }
+        }
+
+        uint32_t Peek(int n) {
+            if (count < n) Refill();
+            return static_cast<uint32_t>(bits & ((1ull << n) - 1));
+        }
+
+        void Drop(int n) {
+            bits >>= n;
+            count -= n;
+        }
+
+        uint32_t Bits(int n) {
+            if (n == 0) return 0;
+            uint32_t value = Peek(n);
+            Drop(n);
+            return value;
+        }
+
+        void AlignToByte() {
+            Drop(count % 8);
+        }
+
+        bool Overrun() const {
+            return position * 8 - count > size * 8;
+        }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t position = 0;
+        uint64_t bits = 0;
+        int count = 0;
+    };
+
+    // Canonical Huffman decoder: a lookup table for short codes, a bit-at-a-time walk for the rest
+    class HuffmanDecoder {
+    public:
+        static constexpr int FAST_BITS = 10;
+
+        bool Build(const uint8_t* lengths, int symbolCount) {
+            std::memset(counts, 0, sizeof(counts));
+            std::memset(fast, 0, sizeof(fast));
+            for (int i = 0; i < symbolCount; i++) counts[lengths[i]]++;
+            counts[0] = 0;
+
+            // Reject over-subscribed codes; incomplete ones are legal (e.g. a single distance code)
+            int left = 1;
+            for (int length = 1; length <= MAX_BITS; length++) {
+                left <<= 1;
+                left -= counts[length];
+                if (left < 0) return false;
+            }
+
+            uint16_t offsets[MAX_BITS + 2];
+            uint32_t nextCode[MAX_BITS + 2];
+            offsets[1] = 0;
+            nextCode[1] = 0;
+            for (int length = 1; length <= MAX_BITS; length++) {
+                offsets[length + 1] = offsets[length] + counts[length];
+                nextCode[length + 1] = (nextCode[length] + counts[length]) << 1;
+            }
+
+            for (int symbol = 0; symbol < symbolCount; symbol++) {
+                int length = lengths[symbol];
+                if (length == 0) continue;
+                symbols[offsets[length]++] = static_cast<uint16_t>(symbol);
+
+                uint32_t code = nextCode[length]++;
+                if (length <= FAST_BITS) {
+                    uint32_t reversed = ReverseBits(code, length);
+                    for (uint32_t fill = reversed; fill < (1u << FAST_BITS); fill += 1u << length) {
+                        fast[fill] = static_cast<uint16_t>((symbol << 4) | length);
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Returns the next symbol, or -1 for a code that isn't in the table
+        int Decode(BitReader& reader) const {
+            uint32_t peek = reader.Peek(MAX_BITS);
+            uint16_t entry = fast[peek & ((1u << FAST_BITS) - 1)];
+            if (entry != 0) {
+                reader.Drop(entry & 15);
+                return entry >> 4;
+            }
+
+            int code = 0, first = 0, index = 0;
+            for (int length = 1; length <= MAX_BITS; length++) {
+                code |= (peek >> (length - 1)) & 1;
+                int count = counts[length];
+                if (code - count < first) {
+                    reader.Drop(length);
+                    return symbols[index + (code - first)];
+                }
+                index += count;
+                first += count;
+                first <<= 1;
+                code <<= 1;
+            }
+            return -1;
+        }
+
+    private:
+        uint16_t fast[1 << FAST_BITS];   // (symbol << 4) | length; 0 means take the slow path
+        uint16_t counts[MAX_BITS + 1];
+        uint16_t symbols[288];
+    };
+
+    bool ReadDynamicTables(BitReader& reader, HuffmanDecoder& litlen, HuffmanDecoder& dist) {
+        int litlenCount = static_cast<int>(reader.Bits(5)) + 257;
+        int distCount = static_cast<int>(reader.Bits(5)) + 1;
+        int codeLengthCount = static_cast<int>(reader.Bits(4)) + 4;
+        if (litlenCount > LITLEN_SYMBOLS || distCount > DIST_SYMBOLS) return false;
+
+        uint8_t codeLengthLengths[19] = {};
+        for (int i = 0; i < codeLengthCount; i++) {
+            codeLengthLengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(reader.Bits(3));
+        }
+        HuffmanDecoder codeLengths;
+        if (!codeLengths.Build(codeLengthLengths, 19)) return false;
+
+        uint8_t lengths[LITLEN_SYMBOLS + DIST_SYMBOLS] = {};
+        int total = litlenCount + distCount;
+        for (int i = 0; i < total;) {
+            int symbol = codeLengths.Decode(reader);
+            if (symbol < 0) return false;
+            if (symbol < 16) {
+                lengths[i++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t value = 0;
+            int repeat;
+            if (symbol == 16) {
+                if (i == 0) return false;
+                value = lengths[i - 1];
+                repeat = 3 + static_cast<int>(reader.Bits(2));
+            }
+            else if (symbol == 17) {
+                repeat = 3 + static_cast<int>(reader.Bits(3));
+            }
+            else {
+                repeat = 11 + static_cast<int>(reader.Bits(7));
+            }
+            if (i + repeat > total) return false;
+            while (repeat-- > 0) lengths[i++] = value;
+        }
+
+        if (lengths[256] == 0) return false;
+        return litlen.Build(lengths, litlenCount) && dist.Build(lengths + litlenCount, distCount);
+    }
+
+    void BuildFixedTables(HuffmanDecoder& litlen, HuffmanDecoder& dist) {
+        uint8_t lengths[288];
+        std::fill(lengths, lengths + 144, 8);
+        std::fill(lengths + 144, lengths + 256, 9);
+        std::fill(lengths + 256, lengths + 280, 7);
+        std::fill(lengths + 280, lengths + 288, 8);
+        litlen.Build(lengths, 288);
+
+        uint8_t distLengths[DIST_SYMBOLS];
+        std::fill(distLengths, distLengths + DIST_SYMBOLS, 5);
+        dist.Build(distLengths, DIST_SYMBOLS);
+    }
+
+    // ============================================================================
+    // Compress
+    // ============================================================================
+    class BitWriter {
+    public:
+        explicit BitWriter(std::string& out) : out(out) {}
+
+        void Put(uint32_t value, int n) {
+            bits |= static_cast<uint64_t>(value) << count;
+            count += n;
+            while (count >= 8) {
+                out.push_back(static_cast<char>(bits & 0xFF));
+                bits >>= 8;
+                count -= 8;
+            }
+        }
+
+        void Flush() {
+            if (count > 0) out.push_back(static_cast<char>(bits & 0xFF));
+            bits = 0;
+            count = 0;
+        }
+
+    private:
+        std::string& out;
+        uint64_t bits = 0;
+        int count = 0;
+    };
+
+    struct Symbol {
+        uint16_t value;      // Literal byte, or match length
+        uint16_t distance;   // 0 for a literal
+    };
+
+    int LengthCode(int length) {
+        return static_cast<int>(std::upper_bound(LENGTH_BASE, LENGTH_BASE + 29, length) - LENGTH_BASE) - 1;
+    }
+
+    int DistanceCode(int distance) {
+        return static_cast<int>(std::upper_bound(DIST_BASE, DIST_BASE + 30, distance) - DIST_BASE) - 1;
+    }
+
+    // Huffman code lengths no longer than maxLength. Frequencies are halved until the tree fits,
+    // which costs a fraction of a percent against an optimal length-limited code.
+    void BuildCodeLengths(std::vector<uint32_t> freqs, int maxLength, uint8_t* lengths) {
+        int symbolCount = static_cast<int>(freqs.size());
+
+        // A decoder needs a complete code, so always give it at least two symbols
+        int used = 0;
+        for (uint32_t f : freqs) used += f > 0;
+        for (int i = 0; used < 2 && i < symbolCount; i++) {
+            if (freqs[i] == 0) {
+                freqs[i] = 1;
+                used++;
+            }
+        }
+
+        while (true) {
+            struct Node {
+                uint64_t weight;
+                int parent;
+            };
+            std::vector<Node> nodes;
+            std::vector<int> leafSymbols;
+            for (int i = 0; i < symbolCount; i++) {
+                if (freqs[i] > 0) leafSymbols.push_back(i);
+            }
+            std::sort(leafSymbols.begin(), leafSymbols.end(),
+                [&](int a, int b) { return freqs[a] != freqs[b] ? freqs[a] < freqs[b] : a < b; });
+            for (int symbol : leafSymbols) nodes.push_back({ freqs[symbol], -1 });
+
+            // Two-queue merge: leaves in weight order, internal nodes are created in weight order
+            size_t leafCount = nodes.size();
+            size_t nextLeaf = 0, nextInternal = leafCount;
+            auto takeSmallest = [&]() {
+                if (nextLeaf < leafCount && (nextInternal >= nodes.size() || nodes[nextLeaf].weight <= nodes[nextInternal].weight)) {
+                    return static_cast<int>(nextLeaf++);
+                }
+                return static_cast<int>(nextInternal++);
+            };
+            while (nodes.size() - nextInternal + (leafCount - nextLeaf) > 1) {
+                int a = takeSmallest();
+                int b = takeSmallest();
+                nodes.push_back({ nodes[a].weight + nodes[b].weight, -1 });
+                nodes[a].parent = nodes[b].parent = static_cast<int>(nodes.size() - 1);
+            }
+
+            std::vector<int> depth(nodes.size(), 0);
+            for (int i = static_cast<int>(nodes.size()) - 2; i >= 0; i--) {
+                depth[i] = depth[nodes[i].parent] + 1;
+            }
+
+            int deepest = 0;
+            std::fill(lengths, lengths + symbolCount, 0);
+            for (size_t i = 0; i < leafCount; i++) {
+                lengths[leafSymbols[i]] = static_cast<uint8_t>(depth[i]);
+                deepest = std::max(deepest, depth[i]);
+            }
+            if (deepest <= maxLength) return;
+
+            for (uint32_t& f : freqs) {
+                if (f > 0) f = (f + 1) / 2;
+            }
+        }
+    }
+
+    // Canonical codes, bit-reversed so they can go straight into the LSB-first bit writer
+    void AssignCodes(const uint8_t* lengths, int symbolCount, uint16_t* codes) {
+        uint16_t lengthCounts[MAX_BITS + 1] = {};
+        for (int i = 0; i < symbolCount; i++) lengthCounts[lengths[i]]++;
+        lengthCounts[0] = 0;
+
+        uint32_t nextCode[MAX_BITS + 2] = {};
+        for (int length = 1; length <= MAX_BITS; length++) {
+            nextCode[length + 1] = (nextCode[length] + lengthCounts[length]) << 1;
+        }
+        for (int i = 0; i < symbolCount; i++) {
+            if (lengths[i] > 0) {
+                codes[i] = static_cast<uint16_t>(ReverseBits(nextCode[lengths[i]]++, lengths[i]));
+            }
+        }
+    }
+
+    void WriteBlock(BitWriter& writer, const std::vector<Symbol>& symbols, bool finalBlock) {
+        std::vector<uint32_t> litlenFreqs(LITLEN_SYMBOLS, 0), distFreqs(DIST_SYMBOLS, 0);
+        for (const Symbol& symbol : symbols) {
+            if (symbol.distance == 0) {
+                litlenFreqs[symbol.value]++;
+            }
+            else {
+                litlenFreqs[257 + LengthCode(symbol.value)]++;
+                distFreqs[DistanceCode(symbol.distance)]++;
+            }
+        }
+        litlenFreqs[256] = 1;
+
+        uint8_t lengths[LITLEN_SYMBOLS + DIST_SYMBOLS] = {};
+        BuildCodeLengths(litlenFreqs, MAX_BITS, lengths);
+        BuildCodeLengths(distFreqs, MAX_BITS, lengths + LITLEN_SYMBOLS);
+
+        int litlenCount = LITLEN_SYMBOLS;
+        while (litlenCount > 257 && lengths[litlenCount - 1] == 0) litlenCount--;
+        int distCount = DIST_SYMBOLS;
+        while (distCount > 1 && lengths[LITLEN_SYMBOLS + distCount - 1] == 0) distCount--;
+
+        // Run-length code the two length tables as one sequence (runs may cross between them)
+        std::vector<uint8_t> sequence(lengths, lengths + litlenCount);
+        sequence.insert(sequence.end(), lengths + LITLEN_SYMBOLS, lengths + LITLEN_SYMBOLS + distCount);
+
+        struct RunSymbol {
+            uint8_t symbol;
+            uint8_t extra;
+        };
+        std::vector<RunSymbol> runs;
+        std::vector<uint32_t> codeLengthFreqs(19, 0);
+        auto emitRun = [&](uint8_t symbol, uint8_t extra) {
+            runs.push_back({ symbol, extra });
+            codeLengthFreqs[symbol]++;
+        };
+        for (size_t i = 0; i < sequence.size();) {
+            uint8_t value = sequence[i];
+            size_t run = 1;
+            while (i + run < sequence.size() && sequence[i + run] == value) run++;
+            i += run;
+
+            if (value == 0) {
+                while (run >= 11) {
+                    size_t take = std::min<size_t>(run, 138);
+                    emitRun(18, static_cast<uint8_t>(take - 11));
+                    run -= take;
+                }
+                if (run >= 3) {
+                    emitRun(17, static_cast<uint8_t>(run - 3));
+                    run = 0;
+                }
+            }
+            else {
+                emitRun(value, 0);
+                run--;
+                while (run >= 3) {
+                    size_t take = std::min<size_t>(run, 6);
+                    emitRun(16, static_cast<uint8_t>(take - 3));
+                    run -= take;
+                }
+            }
+            while (run-- > 0) emitRun(value, 0);
+        }
+
+        uint8_t codeLengthLengths[19] = {};
+        BuildCodeLengths(codeLengthFreqs, MAX_CODE_LENGTH_BITS, codeLengthLengths);
+        uint16_t codeLengthCodes[19] = {};
+        AssignCodes(codeLengthLengths, 19, codeLengthCodes);
+        int codeLengthCount = 19;
+        while (codeLengthCount > 4 && codeLengthLengths[CODE_LENGTH_ORDER[codeLengthCount - 1]] == 0) codeLengthCount--;
+
+        uint16_t litlenCodes[LITLEN_SYMBOLS] = {}, distCodes[DIST_SYMBOLS] = {};
+        AssignCodes(lengths, LITLEN_SYMBOLS, litlenCodes);
+        AssignCodes(lengths + LITLEN_SYMBOLS, DIST_SYMBOLS, distCodes);
+        const uint8_t* distLengths = lengths + LITLEN_SYMBOLS;
+
+        writer.Put(finalBlock ? 1 : 0, 1);
+        writer.Put(2, 2);
+        writer.Put(litlenCount - 257, 5);
+        writer.Put(distCount - 1, 5);
+        writer.Put(codeLengthCount - 4, 4);
+        for (int i = 0; i < codeLengthCount; i++) {
+            writer.Put(codeLengthLengths[CODE_LENGTH_ORDER[i]], 3);
+        }
+        for (const RunSymbol& run : runs) {
+            writer.Put(codeLengthCodes[run.symbol], codeLengthLengths[run.symbol]);
+            if (run.symbol == 16) writer.Put(run.extra, 2);
+            else if (run.symbol == 17) writer.Put(run.extra, 3);
+            else if (run.symbol == 18) writer.Put(run.extra, 7);
+        }
+
+        for (const Symbol& symbol : symbols) {
+            if (symbol.distance == 0) {
+                writer.Put(litlenCodes[symbol.value], lengths[symbol.value]);
+                continue;
+            }
+            int lengthCode = LengthCode(symbol.value);
+            writer.Put(litlenCodes[257 + lengthCode], lengths[257 + lengthCode]);
+            writer.Put(symbol.value - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+
+            int distanceCode = DistanceCode(symbol.distance);
+            writer.Put(distCodes[distanceCode], distLengths[distanceCode]);
+            writer.Put(symbol.distance - DIST_BASE[distanceCode], DIST_EXTRA[distanceCode]);
+        }
+        writer.Put(litlenCodes[256], lengths[256]);
+    }
+}
+
+// ============================================================================
+// Deflate
+// ============================================================================
+void Deflate::Compress(std::string_view input, std::string_view dictionary, std::string& out, int level) {
+    BitWriter writer(out);
+    if (input.empty()) {
+        // One fixed-Huffman block holding only the end-of-block code
+        writer.Put(1, 1);
+        writer.Put(1, 2);
+        writer.Put(0, 7);
+        writer.Flush();
+        return;
+    }
+
+    if (dictionary.size() > WINDOW_SIZE) {
+        dictionary = dictionary.substr(dictionary.size() - WINDOW_SIZE);
+    }
+
+    // History and input in one buffer so matches can run from the dictionary into the data
+    std::string buffer;
+    buffer.reserve(dictionary.size() + input.size());
+    buffer.append(dictionary);
+    buffer.append(input);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.data());
+    const int size = static_cast<int>(buffer.size());
+
+    level = std::clamp(level, 1, 9);
+    const int maxChain = level <= 1 ? 4 : level <= 3 ? 16 : level <= 6 ? 128 : 1024;
+    const int niceLength = level >= 8 ? MAX_MATCH : 128;
+    const bool lazy = level >= 4;
+
+    constexpr int HASH_BITS = 15;
+    std::vector<int32_t> head(1 << HASH_BITS, -1);
+    std::vector<int32_t> previous(size, -1);
+    auto hash = [data](int position) {
+        uint32_t value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16);
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    };
+
+    int insertedUpTo = 0;
+    auto insertUpTo = [&](int limit) {
+        for (; insertedUpTo < limit; insertedUpTo++) {
+            if (insertedUpTo + MIN_MATCH > size) continue;
+            uint32_t h = hash(insertedUpTo);
+            previous[insertedUpTo] = head[h];
+            head[h] = insertedUpTo;
+        }
+    };
+
+    auto findMatch = [&](int position, int& distance) {
+        int limit = std::min(MAX_MATCH, size - position);
+        if (limit < MIN_MATCH) return 0;
+
+        int best = MIN_MATCH - 1;
+        int chain = maxChain;
+        for (int candidate = head[hash(position)]; candidate >= 0 && chain-- > 0; candidate = previous[candidate]) {
+            if (position - candidate > static_cast<int>(WINDOW_SIZE)) break;
+            if (data[candidate + best] != data[position + best] || data[candidate] != data[position]) continue;
+
+            int length = 0;
+            while (length < limit && data[candidate + length] == data[position + length]) length++;
+            if (length > best) {
+                best = length;
+                distance = position - candidate;
+                if (length >= niceLength || length == limit) break;
+            }
+        }
+        return best >= MIN_MATCH ? best : 0;
+    };
+
+    std::vector<Symbol> symbols;
+    symbols.reserve(BLOCK_SYMBOLS);
+    auto flushBlock = [&](bool finalBlock) {
+        WriteBlock(writer, symbols, finalBlock);
+        symbols.clear();
+    };
+
+    insertUpTo(static_cast<int>(dictionary.size()));
+    for (int position = static_cast<int>(dictionary.size()); position < size;) {
+        insertUpTo(position);
+        int distance = 0;
+        int length = findMatch(position, distance);
+
+        if (length > 0 && lazy && length < niceLength && position + 1 < size) {
+            insertUpTo(position + 1);
+            int nextDistance = 0;
+            int nextLength = findMatch(position + 1, nextDistance);
+            if (nextLength > length) {
+                symbols.push_back({ data[position], 0 });
+                position++;
+                length = nextLength;
+                distance = nextDistance;
+            }
+        }
+
+        if (length > 0) {
+            symbols.push_back({ static_cast<uint16_t>(length), static_cast<uint16_t>(distance) });
+            position += length;
+        }
+        else {
+            symbols.push_back({ data[position], 0 });
+            position++;
+        }
+
+        if (symbols.size() >= BLOCK_SYMBOLS && position < size) {
+            flushBlock(false);
+        }
+    }
+    flushBlock(true);
+    writer.Flush();
+}
+
+bool Deflate::Inflate(std::string_view input, std::string_view dictionary, std::string& out, size_t sizeHint) {
+    if (dictionary.size() > WINDOW_SIZE) {
+        dictionary = dictionary.substr(dictionary.size() - WINDOW_SIZE);
+    }
+
+    // The dictionary sits in front of the output as history and is cut off at the end
+    BitReader reader(input);
+    const size_t start = out.size();
+    out.append(dictionary);
+    const size_t dataStart = out.size();
+    size_t written = dataStart;
+    out.resize(dataStart + std::max<size_t>(sizeHint, 4096));
+
+    // Growing is also when a corrupt stream gets caught: past the end it reads as zeros,
+    // which can decode as literals forever
+    auto ensure = [&](size_t extra) {
+        if (written + extra > out.size()) {
+            if (reader.Overrun()) return false;
+            out.resize(std::max(out.size() * 2, written + extra));
+        }
+        return true;
+    };
+    auto finish = [&](bool ok) {
+        out.resize(written);
+        out.erase(start, dataStart - start);
+        return ok;
+    };
+
+    HuffmanDecoder litlen, dist;
+    bool finalBlock = false;
+    while (!finalBlock) {
+        finalBlock = reader.Bits(1) != 0;
+        uint32_t type = reader.Bits(2);
+
+        if (type == 0) {
+            reader.AlignToByte();
+            uint32_t length = reader.Bits(16);
+            uint32_t complement = reader.Bits(16);
+            if ((length ^ 0xFFFF) != complement) return finish(false);
+            if (!ensure(length)) return finish(false);
+            for (uint32_t i = 0; i < length; i++) {
+                out[written++] = static_cast<char>(reader.Bits(8));
+            }
+            if (reader.Overrun()) return finish(false);
+            continue;
+        }
+
+        if (type == 1) {
+            BuildFixedTables(litlen, dist);
+        }
+        else if (type == 2) {
+            if (!ReadDynamicTables(reader, litlen, dist)) return finish(false);
+        }
+        else {
+            return finish(false);
+        }
+
+        while (true) {
+            int symbol = litlen.Decode(reader);
+            if (symbol < 0) return finish(false);
+            if (symbol < 256) {
+                if (!ensure(1)) return finish(false);
+                out[written++] = static_cast<char>(symbol);
+                continue;
+            }
+            if (symbol == 256) break;
+
+            int lengthCode = symbol - 257;
+            if (lengthCode >= 29) return finish(false);
+            size_t length = LENGTH_BASE[lengthCode] + reader.Bits(LENGTH_EXTRA[lengthCode]);
+
+            int distanceCode = dist.Decode(reader);
+            if (distanceCode < 0 || distanceCode >= DIST_SYMBOLS) return finish(false);
+            size_t distance = DIST_BASE[distanceCode] + reader.Bits(DIST_EXTRA[distanceCode]);
+            if (distance > written - start) return finish(false);
+
+            // Byte by byte: overlapping copies (distance < length) repeat the pattern
+            if (!ensure(length)) return finish(false);
+            char* target = out.data() + written;
+            const char* source = target - distance;
+            for (size_t i = 0; i < length; i++) target[i] = source[i];
+            written += length;
+        }
+        if (reader.Overrun()) return finish(false);
+    }
+
+    return finish(!reader.Overrun());
+}
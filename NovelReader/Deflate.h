@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Raw DEFLATE (RFC 1951) with an optional preset dictionary, compatible with Python's
+// zlib.compressobj(wbits=-15, zdict=...) / zlib.decompressobj(wbits=-15, zdict=...).
+//
+// The dictionary acts as history in front of the data: matches may reach back into it,
+// so text that shares phrases with the dictionary compresses well even when it is short.
+// Only the last 32 KB of a dictionary can be referenced.
+class Deflate {
+public:
+    static constexpr size_t WINDOW_SIZE = 32768;
+
+    // Appends the compressed stream to out. Higher levels search longer match chains (1-9).
+    static void Compress(std::string_view input, std::string_view dictionary, std::string& out, int level = 6);
+
+    // Appends the decompressed data to out. sizeHint, when known, avoids regrowing out.
+    // Returns false on a malformed stream; out is left with whatever was decoded.
+    static bool Inflate(std::string_view input, std::string_view dictionary, std::string& out, size_t sizeHint = 0);
+};
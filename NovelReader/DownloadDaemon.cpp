@@ -0,0 +1,694 @@
+#include "DownloadDaemon.h"
+#include "Catalog.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr size_t MAX_FINISHED_KEPT = 50;        // Finished jobs listed before the oldest go
+    constexpr auto SCHEDULER_TICK = std::chrono::seconds(1);
+
+    bool IsFinished(DownloadDaemon::Status status) {
+        return status == DownloadDaemon::Status::Complete || status == DownloadDaemon::Status::Failed ||
+            status == DownloadDaemon::Status::Cancelled;
+    }
+
+    bool ParseStatus(const std::string& name, DownloadDaemon::Status& status) {
+        static const DownloadDaemon::Status all[] = {
+            DownloadDaemon::Status::Queued, DownloadDaemon::Status::Downloading, DownloadDaemon::Status::Paused,
+            DownloadDaemon::Status::Complete, DownloadDaemon::Status::Failed, DownloadDaemon::Status::Cancelled
+        };
+        for (DownloadDaemon::Status candidate : all) {
+            if (name == DownloadDaemon::StatusName(candidate)) {
+                status = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    json JobToJson(const DownloadDaemon::Job& job) {
+        return json{
+            {"id", job.id},
+            {"source", job.request.source},
+            {"url", job.request.url},
+            {"name", job.request.name},
+            {"output", job.request.outputDir},
+            {"start", job.request.startChapter},
+            {"end", job.request.endChapter},
+            {"status", DownloadDaemon::StatusName(job.status)},
+            {"currentChapter", job.currentChapter},
+            {"totalChapters", job.totalChapters},
+            {"progress", job.progress},
+            {"lastSavedChapter", job.lastSavedChapter},
+            {"lastError", job.lastError}
+        };
+    }
+
+    bool JobFromJson(const json& j, DownloadDaemon::Job& job) {
+        if (!j.is_object() || !ParseStatus(j.value("status", ""), job.status)) return false;
+        job.id = j.value("id", "");
+        job.request.source = j.value("source", "");
+        job.request.url = j.value("url", "");
+        job.request.name = j.value("name", "");
+        job.request.outputDir = j.value("output", "Novels");
+        job.request.startChapter = j.value("start", 1);
+        job.request.endChapter = j.value("end", -1);
+        job.request.downloadId = job.id;
+        job.currentChapter = j.value("currentChapter", 0);
+        job.totalChapters = j.value("totalChapters", 0);
+        job.progress = j.value("progress", 0.0f);
+        job.lastSavedChapter = j.value("lastSavedChapter", 0);
+        job.lastError = j.value("lastError", "");
+        return !job.id.empty();
+    }
+
+    std::string Reply(bool ok, const std::string& error = "") {
+        json reply = { {"ok", ok} };
+        if (!ok) reply["error"] = error;
+        return reply.dump();
+    }
+
+    std::string MakeJobId(const std::string& name) {
+        static std::atomic<unsigned> counter{ 0 };
+        std::string sanitized;
+        for (char c : name) {
+            bool alphanumeric = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+            sanitized += alphanumeric ? c : '_';
+        }
+        return "novel_" + sanitized + "_" + std::to_string(std::time(nullptr)) + "_" + std::to_string(counter++);
+    }
+}
+
+const char* DownloadDaemon::StatusName(Status status) {
+    switch (status) {
+    case Status::Queued: return "queued";
+    case Status::Downloading: return "downloading";
+    case Status::Paused: return "paused";
+    case Status::Complete: return "complete";
+    case Status::Failed: return "failed";
+    case Status::Cancelled: return "cancelled";
+    }
+    return "queued";
+}
+
+DownloadDaemon::DownloadDaemon(std::string novelsRoot, ChaptersAdded onChaptersAdded)
+    : novelsRoot(std::move(novelsRoot)), onChaptersAdded(std::move(onChaptersAdded)) {
+}
+
+DownloadDaemon::~DownloadDaemon() {
+    Stop();
+}
+
+// ============================================================================
+// Lifetime
+// ============================================================================
+bool DownloadDaemon::Start(const std::string& endpoint) {
+    if (!listener.Listen(endpoint)) return false;
+    LoadJobs();
+
+    stopping = false;
+    schedulerThread = std::make_unique<std::thread>(&DownloadDaemon::SchedulerLoop, this);
+    acceptThread = std::make_unique<std::thread>(&DownloadDaemon::AcceptLoop, this);
+    std::cout << "Download daemon listening on " << endpoint << std::endl;
+    return true;
+}
+
+void DownloadDaemon::Wait() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    stopped.wait(lock, [this]() { return shutdownRequested; });
+}
+
+void DownloadDaemon::Stop() {
+    if (stopping.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        shutdownRequested = true;
+    }
+    stopped.notify_all();
+
+    listener.Close();
+    if (acceptThread && acceptThread->joinable()) acceptThread->join();
+
+    schedulerWake.notify_all();
+    if (schedulerThread && schedulerThread->joinable()) schedulerThread->join();
+
+    // Paused scripts stop too; the others stop once the request they are on returns
+    std::vector<std::unique_ptr<Running>> stillRunning;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stillRunning = std::move(running);
+        running.clear();
+    }
+    for (auto& entry : stillRunning) {
+        entry->control.Send(DownloadJob::Command::Stop);
+    }
+    for (auto& entry : stillRunning) {
+        if (entry->thread && entry->thread->joinable()) entry->thread->join();
+    }
+
+    std::vector<std::unique_ptr<Connection>> open;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        open = std::move(connections);
+        connections.clear();
+    }
+    for (auto& connection : open) connection->socket->Shutdown();
+    for (auto& connection : open) {
+        if (connection->thread && connection->thread->joinable()) connection->thread->join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        SaveJobs();
+    }
+    std::cout << "Download daemon stopped" << std::endl;
+}
+
+// ============================================================================
+// Clients
+// ============================================================================
+void DownloadDaemon::AcceptLoop() {
+    while (std::unique_ptr<ControlSocket> socket = listener.Accept()) {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        for (auto it = connections.begin(); it != connections.end();) {
+            if ((*it)->finished) {
+                if ((*it)->thread->joinable()) (*it)->thread->join();
+                it = connections.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        auto connection = std::make_unique<Connection>();
+        connection->socket = std::shared_ptr<ControlSocket>(std::move(socket));
+        Connection* raw = connection.get();
+        connection->thread = std::make_unique<std::thread>([this, raw]() { ServeClient(*raw); });
+        connections.push_back(std::move(connection));
+    }
+}
+
+void DownloadDaemon::ServeClient(Connection& connection) {
+    std::string line;
+    while (connection.socket->ReadLine(line)) {
+        bool watch = false;
+        std::string reply = HandleRequest(line, watch);
+        if (!connection.socket->SendLine(reply)) break;
+        if (watch) SendSnapshot(connection.socket);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(watchersMutex);
+        watchers.erase(std::remove(watchers.begin(), watchers.end(), connection.socket), watchers.end());
+    }
+    connection.finished = true;
+}
+
+std::string DownloadDaemon::HandleRequest(const std::string& line, bool& watch) {
+    json request = json::parse(line, nullptr, false);
+    if (!request.is_object()) return Reply(false, "Not a JSON object");
+
+    std::string command = request.value("cmd", "");
+    std::string id = request.value("id", "");
+    std::string error;
+
+    if (command == "enqueue") {
+        Enqueue enqueue;
+        enqueue.request.source = request.value("source", "");
+        enqueue.request.url = request.value("url", "");
+        enqueue.request.name = request.value("name", "");
+        enqueue.request.startChapter = request.value("start", 1);
+        enqueue.request.endChapter = request.value("end", -1);
+        enqueue.author = request.value("author", "");
+        enqueue.synopsis = request.value("synopsis", "");
+        enqueue.totalChapters = request.value("total", 0);
+        if (enqueue.request.source.empty() || (enqueue.request.url.empty() && enqueue.request.name.empty())) {
+            return Reply(false, "enqueue needs a source and a url or name");
+        }
+        json reply = { {"ok", true}, {"id", AddJob(enqueue)} };
+        return reply.dump();
+    }
+    if (command == "pause") return PauseJob(id, error) ? Reply(true) : Reply(false, error);
+    if (command == "resume") return ResumeJob(id, error) ? Reply(true) : Reply(false, error);
+    if (command == "cancel") return CancelJob(id, error) ? Reply(true) : Reply(false, error);
+    if (command == "status") {
+        json list = json::array();
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            for (const Job& job : jobs) list.push_back(JobToJson(job));
+        }
+        json reply = { {"ok", true}, {"jobs", list} };
+        return reply.dump();
+    }
+    if (command == "watch") {
+        watch = true;
+        return Reply(true);
+    }
+    if (command == "shutdown") {
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            shutdownRequested = true;
+        }
+        stopped.notify_all();
+        return Reply(true);
+    }
+    return Reply(false, "Unknown command: " + command);
+}
+
+void DownloadDaemon::SendSnapshot(const std::shared_ptr<ControlSocket>& socket) {
+    // Under watchersMutex, so no change is published between the snapshot and the registration
+    std::lock_guard<std::mutex> watchersLock(watchersMutex);
+    std::vector<std::string> lines;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        for (const Job& job : jobs) {
+            json event = JobToJson(job);
+            event["event"] = "job";
+            lines.push_back(event.dump());
+        }
+    }
+    for (const std::string& line : lines) {
+        if (!socket->SendLine(line)) return;
+    }
+    watchers.push_back(socket);
+}
+
+void DownloadDaemon::Publish(const std::string& id) {
+    std::lock_guard<std::mutex> watchersLock(watchersMutex);
+    if (watchers.empty()) return;
+
+    std::string line;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; });
+        if (it == jobs.end()) return;
+        json event = JobToJson(*it);
+        event["event"] = "job";
+        line = event.dump();
+    }
+
+    // A watcher that can't keep up is dropped; it reconnects and gets a fresh snapshot
+    for (auto it = watchers.begin(); it != watchers.end();) {
+        if ((*it)->SendLine(line)) {
+            ++it;
+        }
+        else {
+            (*it)->Shutdown();
+            it = watchers.erase(it);
+        }
+    }
+}
+
+// ============================================================================
+// Jobs
+// ============================================================================
+std::string DownloadDaemon::AddJob(const Enqueue& enqueue) {
+    AddToCatalog(enqueue);
+
+    Job job;
+    job.id = MakeJobId(enqueue.request.name.empty() ? enqueue.request.url : enqueue.request.name);
+    job.request = enqueue.request;
+    job.request.outputDir = novelsRoot;
+    job.request.downloadId = job.id;
+    job.totalChapters = enqueue.totalChapters;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        size_t finished = std::count_if(jobs.begin(), jobs.end(), [](const Job& existing) { return IsFinished(existing.status); });
+        for (auto it = jobs.begin(); it != jobs.end() && finished >= MAX_FINISHED_KEPT;) {
+            if (IsFinished(it->status)) {
+                it = jobs.erase(it);
+                finished--;
+            }
+            else {
+                ++it;
+            }
+        }
+        jobs.push_back(job);
+        SaveJobs();
+    }
+    std::cout << "Queued " << job.id << std::endl;
+    Publish(job.id);
+    schedulerWake.notify_all();
+    return job.id;
+}
+
+void DownloadDaemon::AddToCatalog(const Enqueue& enqueue) {
+    const std::string& title = enqueue.request.name;
+    if (title.empty()) return;
+
+    // Read-modify-write under the catalog lock, so novels and progress the app saved meanwhile stay
+    std::lock_guard<std::mutex> lock(catalogMutex);
+    Catalog::Update(novelsRoot, [&](std::vector<Catalog::Novel>& novels) {
+        if (Catalog::Novel* existing = Catalog::Find(novels, title)) {
+            if (enqueue.totalChapters > 0) existing->totalchapters = enqueue.totalChapters;
+            if (!enqueue.synopsis.empty()) existing->synopsis = enqueue.synopsis;
+            return;
+        }
+
+        Catalog::Novel novel;
+        novel.name = title;
+        novel.authorname = enqueue.author;
+        novel.coverpath = Catalog::CoverPath(novelsRoot, title);
+        novel.synopsis = enqueue.synopsis;
+        novel.totalchapters = enqueue.totalChapters;
+        novel.downloadedchapters = 0;
+        novel.progress.readchapters = 0;
+        novel.progress.progresspercentage = 0.0f;
+        novels.push_back(novel);
+    });
+}
+
+bool DownloadDaemon::PauseJob(const std::string& id, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; });
+        if (it == jobs.end() || IsFinished(it->status) || it->status == Status::Paused) {
+            error = it == jobs.end() ? "No such job" : "Job is not queued or downloading";
+            return false;
+        }
+        if (it->status == Status::Downloading) SendToRunning(id, DownloadJob::Command::Pause);
+        it->status = Status::Paused;
+        SaveJobs();
+    }
+    Publish(id);
+    return true;
+}
+
+bool DownloadDaemon::ResumeJob(const std::string& id, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; });
+        if (it == jobs.end() || (it->status != Status::Paused && it->status != Status::Failed)) {
+            error = it == jobs.end() ? "No such job" : "Job is not paused or failed";
+            return false;
+        }
+
+        // A paused script is still waiting for us; a job paused before it started, or left
+        // paused by the last daemon, is started again
+        if (SendToRunning(id, DownloadJob::Command::Resume)) {
+            it->status = Status::Downloading;
+        }
+        else {
+            it->status = Status::Queued;
+            it->lastError.clear();
+        }
+        SaveJobs();
+    }
+    Publish(id);
+    schedulerWake.notify_all();
+    return true;
+}
+
+bool DownloadDaemon::CancelJob(const std::string& id, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; });
+        if (it == jobs.end() || IsFinished(it->status)) {
+            error = it == jobs.end() ? "No such job" : "Job has already finished";
+            return false;
+        }
+
+        SendToRunning(id, DownloadJob::Command::Cancel);
+        it->status = Status::Cancelled;
+        it->lastError = "Cancelled by user";
+        SaveJobs();
+    }
+    Publish(id);
+    return true;
+}
+
+void DownloadDaemon::SchedulerLoop() {
+    std::unique_lock<std::mutex> lock(jobsMutex);
+    while (!stopping) {
+        for (auto it = running.begin(); it != running.end();) {
+            if ((*it)->finished) {
+                if ((*it)->thread->joinable()) (*it)->thread->join();
+                it = running.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        for (Job& job : jobs) {
+            if (running.size() >= MAX_PARALLEL) break;
+            if (job.status != Status::Queued) continue;
+
+            DownloadJob::Request request = job.request;
+            if (job.lastSavedChapter >= request.startChapter) {
+                request.startChapter = job.lastSavedChapter + 1;
+            }
+            job.status = Status::Downloading;
+            job.lastError.clear();
+
+            auto entry = std::make_unique<Running>();
+            entry->id = job.id;
+            Running* raw = entry.get();
+            entry->thread = std::make_unique<std::thread>([this, raw, request]() { RunJob(*raw, request); });
+            running.push_back(std::move(entry));
+            SaveJobs();
+        }
+
+        schedulerWake.wait_for(lock, SCHEDULER_TICK);
+    }
+}
+
+void DownloadDaemon::RunJob(Running& entry, DownloadJob::Request request) {
+    const std::string& id = entry.id;
+    Publish(id);
+    std::cout << "Downloading " << id << " from chapter " << request.startChapter << std::endl;
+
+    std::vector<std::string> novelDirNames;
+    int exitCode = DownloadJob::Run(DownloadJob::BuildArgs(request), [&](const std::string& line) {
+        ApplyOutputLine(id, line, novelDirNames);
+    }, &entry.control);
+
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; });
+        if (it != jobs.end() && it->status != Status::Cancelled) {
+            if (stopping) {
+                it->status = Status::Queued;         // Picked up again on the next start
+            }
+            else if (exitCode == 0) {
+                it->status = Status::Complete;
+                it->progress = 100.0f;
+            }
+            else {
+                it->status = Status::Failed;
+                if (it->lastError.empty()) it->lastError = "download_manager.py exited with " + std::to_string(exitCode);
+            }
+        }
+        SaveJobs();
+    }
+    Publish(id);
+    std::cout << "Finished " << id << " (exit code " << exitCode << ")" << std::endl;
+
+    if (!novelDirNames.empty() && onChaptersAdded) {
+        std::lock_guard<std::mutex> lock(chaptersAddedMutex);
+        onChaptersAdded(novelDirNames);
+    }
+
+    entry.finished = true;
+    schedulerWake.notify_all();
+}
+
+void DownloadDaemon::ApplyOutputLine(const std::string& id, const std::string& line, std::vector<std::string>& novelDirNames) {
+    DownloadJob::ChapterSaved saved;
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; });
+        if (it == jobs.end()) return;
+
+        size_t progressAt = line.find("Progress:");
+        if (DownloadJob::ParseChapterSaved(line, saved)) {
+            if (std::find(novelDirNames.begin(), novelDirNames.end(), saved.novelDirName) == novelDirNames.end()) {
+                novelDirNames.push_back(saved.novelDirName);
+            }
+            it->lastSavedChapter = std::max(it->lastSavedChapter, saved.chapter);
+            SaveJobs();
+            changed = true;
+        }
+        else if (progressAt != std::string::npos) {
+            // "Progress: X/Y (Z%) - Chapter Title"
+            int current = 0, total = 0;
+            float percent = 0.0f;
+            if (std::sscanf(line.c_str() + progressAt, "Progress: %d/%d (%f%%)", &current, &total, &percent) == 3) {
+                it->currentChapter = current;
+                if (total > 0) it->totalChapters = total;
+                it->progress = percent;
+                changed = true;
+            }
+        }
+        else if (line.find("Error") != std::string::npos && line.find("Error loading sources") == std::string::npos) {
+            it->lastError = line;
+            while (!it->lastError.empty() && (it->lastError.back() == '\n' || it->lastError.back() == '\r')) {
+                it->lastError.pop_back();
+            }
+            changed = true;
+        }
+    }
+    if (changed) Publish(id);
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+void DownloadDaemon::LoadJobs() {
+    std::ifstream file(JOBS_FILE);
+    if (!file.is_open()) return;
+
+    json j = json::parse(file, nullptr, false);
+    if (!j.is_object() || !j.contains("jobs") || !j["jobs"].is_array()) {
+        std::cout << "Ignoring unreadable " << JOBS_FILE << std::endl;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    jobs.clear();
+    for (const json& entry : j["jobs"]) {
+        Job job;
+        if (!JobFromJson(entry, job)) continue;
+        // Whatever was downloading died with the last daemon
+        if (job.status == Status::Downloading) job.status = Status::Queued;
+        job.request.outputDir = novelsRoot;
+        jobs.push_back(std::move(job));
+    }
+    std::cout << "Loaded " << jobs.size() << " download jobs" << std::endl;
+}
+
+void DownloadDaemon::SaveJobs() {
+    json list = json::array();
+    for (const Job& job : jobs) list.push_back(JobToJson(job));
+    json j = { {"jobs", list} };
+
+    // Written aside and renamed, so a crash mid-write leaves the previous list
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(JOBS_FILE).parent_path(), ec);
+    std::string temporaryPath = std::string(JOBS_FILE) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cout << "Could not save " << JOBS_FILE << std::endl;
+            return;
+        }
+        file << j.dump(2);
+    }
+    std::filesystem::rename(temporaryPath, JOBS_FILE, ec);
+    if (ec) std::cout << "Could not save " << JOBS_FILE << ": " << ec.message() << std::endl;
+}
+
+bool DownloadDaemon::SendToRunning(const std::string& id, DownloadJob::Command command) {
+    for (const auto& entry : running) {
+        if (entry->id == id && !entry->finished) {
+            return entry->control.Send(command);
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Client
+// ============================================================================
+bool DownloadDaemon::Client::Connect(const std::string& endpoint) {
+    if (!socket.Connect(endpoint)) {
+        lastError = "No download daemon on " + endpoint;
+        return false;
+    }
+    return true;
+}
+
+bool DownloadDaemon::Client::Call(const std::string& request, std::string& reply) {
+    if (!socket.SendLine(request) || !socket.ReadLine(reply)) {
+        lastError = "Lost the connection to the download daemon";
+        return false;
+    }
+
+    json parsed = json::parse(reply, nullptr, false);
+    if (!parsed.is_object() || !parsed.value("ok", false)) {
+        lastError = parsed.is_object() ? parsed.value("error", "Request failed") : "Unreadable reply";
+        return false;
+    }
+    return true;
+}
+
+bool DownloadDaemon::Client::Command(const char* command, const std::string& id) {
+    json request = { {"cmd", command} };
+    if (!id.empty()) request["id"] = id;
+    std::string reply;
+    return Call(request.dump(), reply);
+}
+
+bool DownloadDaemon::Client::Add(const Enqueue& enqueue, std::string& id) {
+    json request = {
+        {"cmd", "enqueue"},
+        {"source", enqueue.request.source},
+        {"url", enqueue.request.url},
+        {"name", enqueue.request.name},
+        {"start", enqueue.request.startChapter},
+        {"end", enqueue.request.endChapter},
+        {"author", enqueue.author},
+        {"synopsis", enqueue.synopsis},
+        {"total", enqueue.totalChapters}
+    };
+    std::string reply;
+    if (!Call(request.dump(), reply)) return false;
+    id = json::parse(reply).value("id", "");
+    return true;
+}
+
+bool DownloadDaemon::Client::Pause(const std::string& id) {
+    return Command("pause", id);
+}
+
+bool DownloadDaemon::Client::Resume(const std::string& id) {
+    return Command("resume", id);
+}
+
+bool DownloadDaemon::Client::Cancel(const std::string& id) {
+    return Command("cancel", id);
+}
+
+bool DownloadDaemon::Client::Shutdown() {
+    return Command("shutdown", "");
+}
+
+bool DownloadDaemon::Client::Status(std::vector<Job>& jobs) {
+    std::string reply;
+    if (!Call(json{ {"cmd", "status"} }.dump(), reply)) return false;
+
+    jobs.clear();
+    json parsed = json::parse(reply);
+    for (const json& entry : parsed.value("jobs", json::array())) {
+        Job job;
+        if (JobFromJson(entry, job)) jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+bool DownloadDaemon::Client::Watch(const std::function<void(const Job&)>& onJob) {
+    if (!Command("watch", "")) return false;
+
+    std::string line;
+    while (socket.ReadLine(line)) {
+        json event = json::parse(line, nullptr, false);
+        Job job;
+        if (event.is_object() && event.value("event", "") == "job" && JobFromJson(event, job)) {
+            onJob(job);
+        }
+    }
+    return true;
+}
+
+void DownloadDaemon::Client::Close() {
+    socket.Shutdown();
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include "ControlSocket.h"
+#include "DownloadJob.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+// Headless download scheduler, run by `novelreader-cli daemon`. It owns the download queue,
+// the job states in downloads/daemon_jobs.json and the catalog entries of what it downloads,
+// so downloads carry on while no window is open and the app attaches and detaches as it likes.
+//
+// Clients talk to it over a ControlSocket, one JSON object per line:
+//   {"cmd":"enqueue","source":..,"url":..,"name":..,"start":N,"end":N,"author":..,"synopsis":..,"total":N}
+//   {"cmd":"pause"|"resume"|"cancel","id":..}    {"cmd":"status"}    {"cmd":"shutdown"}
+//   {"cmd":"watch"}   every job now, then each job again whenever it changes
+// Replies are {"ok":true,...} or {"ok":false,"error":..}; watch events are {"event":"job",...}.
+class DownloadDaemon {
+public:
+    static constexpr size_t MAX_PARALLEL = 3;
+    static constexpr const char* JOBS_FILE = "downloads/daemon_jobs.json";
+
+    enum class Status {
+        Queued,
+        Downloading,
+        Paused,
+        Complete,
+        Failed,
+        Cancelled
+    };
+
+    struct Job {
+        std::string id;
+        DownloadJob::Request request;
+        Status status = Status::Queued;
+        int currentChapter = 0;       // From the script's "Progress: X/Y" lines
+        int totalChapters = 0;
+        float progress = 0.0f;
+        int lastSavedChapter = 0;     // Where a resumed job picks up
+        std::string lastError;
+    };
+
+    // A download and the catalog entry to create for it
+    struct Enqueue {
+        DownloadJob::Request request;
+        std::string author;
+        std::string synopsis;
+        int totalChapters = 0;
+    };
+
+    // Called once per finished job with the novel folders that gained chapters, one call at a
+    // time; the CLI cleans them and updates the search index here
+    using ChaptersAdded = std::function<void(const std::vector<std::string>& novelDirNames)>;
+
+    // Connection to a running daemon. Each call is one request and its reply, except Watch(),
+    // which keeps the connection to itself until it returns.
+    class Client {
+    public:
+        bool Connect(const std::string& endpoint = ControlSocket::DefaultEndpoint());
+
+        bool Add(const Enqueue& enqueue, std::string& id);
+        bool Pause(const std::string& id);
+        bool Resume(const std::string& id);
+        bool Cancel(const std::string& id);
+        bool Status(std::vector<Job>& jobs);
+        bool Shutdown();
+
+        // Hands onJob every job, then every change, until the daemon goes away or Close()
+        bool Watch(const std::function<void(const Job&)>& onJob);
+
+        // Safe from another thread; ends a Watch()
+        void Close();
+
+        const std::string& LastError() const { return lastError; }
+
+    private:
+        bool Call(const std::string& request, std::string& reply);
+        bool Command(const char* command, const std::string& id);
+
+        ControlSocket socket;
+        std::string lastError;
+    };
+
+    DownloadDaemon(std::string novelsRoot, ChaptersAdded onChaptersAdded);
+    ~DownloadDaemon();
+
+    DownloadDaemon(const DownloadDaemon&) = delete;
+    DownloadDaemon& operator=(const DownloadDaemon&) = delete;
+
+    // Loads the saved jobs and starts serving; false if another daemon holds the endpoint
+    bool Start(const std::string& endpoint = ControlSocket::DefaultEndpoint());
+
+    // Blocks until a client asks for shutdown or Stop() is called
+    void Wait();
+
+    // Stops the running downloads, which resume from their last chapter on the next start
+    void Stop();
+
+    static const char* StatusName(Status status);
+
+private:
+    struct Connection {
+        std::shared_ptr<ControlSocket> socket;
+        std::unique_ptr<std::thread> thread;
+        std::atomic<bool> finished{ false };
+    };
+
+    struct Running {
+        std::string id;
+        DownloadJob::Control control;
+        std::unique_ptr<std::thread> thread;
+        std::atomic<bool> finished{ false };
+    };
+
+    void AcceptLoop();
+    void SchedulerLoop();
+    void ServeClient(Connection& connection);
+    std::string HandleRequest(const std::string& line, bool& watch);
+    void RunJob(Running& running, DownloadJob::Request request);
+    void ApplyOutputLine(const std::string& id, const std::string& line, std::vector<std::string>& novelDirNames);
+
+    std::string AddJob(const Enqueue& enqueue);
+    bool PauseJob(const std::string& id, std::string& error);
+    bool ResumeJob(const std::string& id, std::string& error);
+    bool CancelJob(const std::string& id, std::string& error);
+    void AddToCatalog(const Enqueue& enqueue);
+
+    void Publish(const std::string& id);
+    void SendSnapshot(const std::shared_ptr<ControlSocket>& socket);
+    void LoadJobs();
+    void SaveJobs();              // Caller holds jobsMutex
+    bool SendToRunning(const std::string& id, DownloadJob::Command command);   // Caller holds jobsMutex
+
+    std::string novelsRoot;
+    ChaptersAdded onChaptersAdded;
+    ControlListener listener;
+
+    std::mutex jobsMutex;
+    std::condition_variable schedulerWake;
+    std::vector<Job> jobs;                                     // Guarded by jobsMutex
+    std::vector<std::unique_ptr<Running>> running;             // Guarded by jobsMutex
+    std::mutex catalogMutex;
+    std::mutex chaptersAddedMutex;
+
+    std::mutex watchersMutex;
+    std::vector<std::shared_ptr<ControlSocket>> watchers;      // Guarded by watchersMutex
+
+    std::mutex connectionsMutex;
+    std::vector<std::unique_ptr<Connection>> connections;      // Guarded by connectionsMutex
+
+    std::unique_ptr<std::thread> acceptThread;
+    std::unique_ptr<std::thread> schedulerThread;
+    std::atomic<bool> stopping{ false };
+    std::mutex stopMutex;
+    std::condition_variable stopped;
+    bool shutdownRequested = false;                            // Guarded by stopMutex
+};
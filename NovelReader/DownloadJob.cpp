@@ -0,0 +1,367 @@
+#include "DownloadJob.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace {
+    const char* const PYTHON_VARIABLE = "NOVELREADER_PYTHON";
+    const char* const CONTROL_FLAG = "--control-stdin";
+
+    // Our own ends are never inheritable, so no child (ours, or a popen from elsewhere in the
+    // app) can keep them open. The child's ends are inheritable on Windows until the script has
+    // started; this lock keeps another script from picking them up in that window.
+    std::mutex spawnMutex;
+
+    const char* CommandName(DownloadJob::Command command) {
+        switch (command) {
+        case DownloadJob::Command::Pause: return "pause";
+        case DownloadJob::Command::Resume: return "resume";
+        case DownloadJob::Command::Cancel: return "cancel";
+        case DownloadJob::Command::Stop: return "stop";
+        }
+        return "stop";
+    }
+
+#ifndef _WIN32
+    // Both ends close on exec from the start; posix_spawn's dup2 clears the flag on the
+    // child's stdio copies only. A fork elsewhere between pipe() and fcntl() would otherwise
+    // inherit our write end to the script's stdin, and the script would never see it close.
+    bool OpenPipe(int descriptors[2]) {
+#ifdef __APPLE__
+        if (pipe(descriptors) != 0) return false;
+        fcntl(descriptors[0], F_SETFD, FD_CLOEXEC);
+        fcntl(descriptors[1], F_SETFD, FD_CLOEXEC);
+        return true;
+#else
+        return pipe2(descriptors, O_CLOEXEC) == 0;
+#endif
+    }
+#endif
+}
+
+const std::string& DownloadJob::Python() {
+    static const std::string python = []() -> std::string {
+        const char* configured = std::getenv(PYTHON_VARIABLE);
+        if (configured && *configured) return configured;
+#ifndef _WIN32
+        if (const char* path = std::getenv("PATH")) {
+            std::string directories = path;
+            size_t start = 0;
+            while (start <= directories.size()) {
+                size_t end = directories.find(':', start);
+                if (end == std::string::npos) end = directories.size();
+                std::string directory = directories.substr(start, end - start);
+                std::string candidate = (directory.empty() ? std::string(".") : directory) + "/python3";
+                if (access(candidate.c_str(), X_OK) == 0) return "python3";
+                start = end + 1;
+            }
+        }
+#endif
+        return "python";
+    }();
+    return python;
+}
+
+std::vector<std::string> DownloadJob::BuildArgs(const Request& request) {
+    std::vector<std::string> args = {
+        "download",
+        "--source", request.source,
+        "--output", request.outputDir,
+        "--start", std::to_string(request.startChapter)
+    };
+
+    // Check if the url is actually a URL or just a name
+    if (request.url.find("http") == 0) {
+        args.push_back("--url");
+        args.push_back(request.url);
+    }
+    else {
+        args.push_back("--name");
+        args.push_back(request.name);
+    }
+
+    // Add end chapter if specified
+    if (request.endChapter > 0) {
+        args.push_back("--end");
+        args.push_back(std::to_string(request.endChapter));
+    }
+
+    if (!request.downloadId.empty()) {
+        args.push_back("--download-id");
+        args.push_back(request.downloadId);
+    }
+
+    return args;
+}
+
+std::string DownloadJob::BuildCommand(const std::string& scriptName, const std::vector<std::string>& args) {
+    std::string command = Python() + " \"" + scriptName + "\"";
+    for (const auto& arg : args) {
+        command += " \"" + arg + "\"";
+    }
+    return command;
+}
+
+bool DownloadJob::ParseChapterSaved(const std::string& line, ChapterSaved& saved) {
+    if (line.rfind("ChapterSaved:", 0) != 0) return false;
+    const size_t prefixLength = sizeof("ChapterSaved:") - 1;
+    size_t numberStart = line.find_first_not_of(' ', prefixLength);
+    if (numberStart == std::string::npos) return false;
+
+    size_t numberEnd = line.find(' ', numberStart);
+    if (numberEnd == std::string::npos) return false;
+
+    saved.novelDirName = line.substr(numberEnd + 1);
+    while (!saved.novelDirName.empty() && (saved.novelDirName.back() == '\n' || saved.novelDirName.back() == '\r')) {
+        saved.novelDirName.pop_back();
+    }
+
+    try {
+        saved.chapter = std::stoi(line.substr(numberStart, numberEnd - numberStart));
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    return saved.chapter > 0 && !saved.novelDirName.empty();
+}
+
+bool DownloadJob::Control::Send(Command command) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == State::Running) return Write(command);
+    if (state == State::Exited) return false;
+
+    // Only the latest matters: a resume undoes a pause, and a stop or cancel overrides both
+    if (!hasPending || (pending != Command::Cancel && pending != Command::Stop)) {
+        pending = command;
+        hasPending = true;
+    }
+    return true;
+}
+
+bool DownloadJob::Control::IsRunning() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state == State::Running;
+}
+
+bool DownloadJob::Control::Write(Command command) {
+    std::string line = std::string(CommandName(command)) + "\n";
+#ifdef _WIN32
+    DWORD written = 0;
+    return WriteFile(input, line.data(), static_cast<DWORD>(line.size()), &written, nullptr) && written == line.size();
+#else
+    const char* data = line.data();
+    size_t remaining = line.size();
+    while (remaining > 0) {
+        ssize_t written = write(input, data, remaining);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    return true;
+#endif
+}
+
+int DownloadJob::Run(const std::vector<std::string>& args, const std::function<void(const std::string&)>& onLine,
+    Control* control) {
+    int exitCode = Spawn(args, onLine, control);
+    if (control) {
+        std::lock_guard<std::mutex> lock(control->mutex);
+        control->state = Control::State::Exited;
+    }
+    return exitCode;
+}
+
+int DownloadJob::Spawn(const std::vector<std::string>& args, const std::function<void(const std::string&)>& onLine,
+    Control* control) {
+    if (!std::filesystem::exists(SCRIPT)) {
+        std::cout << "Error: Python script not found: " << SCRIPT << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> fullArgs = args;
+    fullArgs.push_back(CONTROL_FLAG);
+
+    // The child gets the read end of a pipe as stdin and the write end of another as both
+    // stdout and stderr; we keep the other two ends
+#ifdef _WIN32
+    HANDLE outputRead = nullptr, outputWrite = nullptr, inputRead = nullptr, inputWrite = nullptr;
+    PROCESS_INFORMATION process = {};
+    {
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        // Nothing is inheritable to begin with; only the child's two ends become so, and they
+        // are passed in an explicit handle list, so the script gets those two and nothing else
+        if (!CreatePipe(&outputRead, &outputWrite, nullptr, 0)) {
+            std::cout << "Failed to start Python process" << std::endl;
+            return -1;
+        }
+        if (!CreatePipe(&inputRead, &inputWrite, nullptr, 0)) {
+            CloseHandle(outputRead);
+            CloseHandle(outputWrite);
+            std::cout << "Failed to start Python process" << std::endl;
+            return -1;
+        }
+        SetHandleInformation(inputRead, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+        SetHandleInformation(outputWrite, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+
+        HANDLE inherited[2] = { inputRead, outputWrite };
+        SIZE_T attributeSize = 0;
+        InitializeProcThreadAttributeList(nullptr, 1, 0, &attributeSize);
+        std::vector<char> attributeBuffer(attributeSize);
+        auto attributes = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeBuffer.data());
+        bool attributesReady = InitializeProcThreadAttributeList(attributes, 1, 0, &attributeSize) != FALSE;
+        bool listed = attributesReady && UpdateProcThreadAttribute(attributes, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+            inherited, sizeof(inherited), nullptr, nullptr) != FALSE;
+
+        STARTUPINFOEXA startup = {};
+        startup.StartupInfo.cb = sizeof(startup);
+        startup.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+        startup.StartupInfo.hStdInput = inputRead;
+        startup.StartupInfo.hStdOutput = outputWrite;
+        startup.StartupInfo.hStdError = outputWrite;
+        startup.lpAttributeList = attributes;
+
+        std::string command = BuildCommand(SCRIPT, fullArgs);
+        BOOL started = listed && CreateProcessA(nullptr, command.data(), nullptr, nullptr, TRUE,
+            CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT, nullptr, nullptr, &startup.StartupInfo, &process);
+        DWORD error = GetLastError();
+        if (attributesReady) DeleteProcThreadAttributeList(attributes);
+        CloseHandle(inputRead);
+        CloseHandle(outputWrite);
+        if (!started) {
+            CloseHandle(outputRead);
+            CloseHandle(inputWrite);
+            std::cout << "Failed to start Python process (error " << error << ")" << std::endl;
+            return -1;
+        }
+        CloseHandle(process.hThread);
+    }
+    auto readOutput = [&](char* buffer, size_t capacity) -> long {
+        DWORD read = 0;
+        if (!ReadFile(outputRead, buffer, static_cast<DWORD>(capacity), &read, nullptr)) return 0;
+        return static_cast<long>(read);
+    };
+#else
+    // A command sent just as the script exits must fail, not kill us
+    static std::once_flag ignoreBrokenPipes;
+    std::call_once(ignoreBrokenPipes, []() { std::signal(SIGPIPE, SIG_IGN); });
+
+    int outputPipe[2] = { -1, -1 };
+    int inputPipe[2] = { -1, -1 };
+    pid_t pid = -1;
+    {
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        if (!OpenPipe(outputPipe) || !OpenPipe(inputPipe)) {
+            for (int descriptor : { outputPipe[0], outputPipe[1], inputPipe[0], inputPipe[1] }) {
+                if (descriptor >= 0) close(descriptor);
+            }
+            std::cout << "Failed to start Python process" << std::endl;
+            return -1;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, inputPipe[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, outputPipe[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, outputPipe[1], STDERR_FILENO);
+        posix_spawn_file_actions_addclose(&actions, inputPipe[0]);
+        posix_spawn_file_actions_addclose(&actions, outputPipe[1]);
+
+        std::vector<char*> argv;
+        std::string python = Python();
+        std::string script = SCRIPT;
+        argv.push_back(python.data());
+        argv.push_back(script.data());
+        for (std::string& arg : fullArgs) argv.push_back(arg.data());
+        argv.push_back(nullptr);
+
+        int spawned = posix_spawnp(&pid, python.c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(inputPipe[0]);
+        close(outputPipe[1]);
+        if (spawned != 0) {
+            close(outputPipe[0]);
+            close(inputPipe[1]);
+            std::cout << "Failed to start Python process: " << std::strerror(spawned) << std::endl;
+            return -1;
+        }
+    }
+    auto readOutput = [&](char* buffer, size_t capacity) -> long {
+        while (true) {
+            ssize_t received = read(outputPipe[0], buffer, capacity);
+            if (received < 0 && errno == EINTR) continue;
+            return received < 0 ? 0 : static_cast<long>(received);
+        }
+    };
+#endif
+
+    if (control) {
+        std::lock_guard<std::mutex> lock(control->mutex);
+#ifdef _WIN32
+        control->input = inputWrite;
+#else
+        control->input = inputPipe[1];
+#endif
+        control->state = Control::State::Running;
+        if (control->hasPending) {
+            control->Write(control->pending);
+            control->hasPending = false;
+        }
+    }
+
+    // Lines longer than the buffer arrive in pieces; they are put back together here
+    char buffer[1024];
+    std::string line;
+    long received;
+    while ((received = readOutput(buffer, sizeof(buffer))) > 0) {
+        line.append(buffer, static_cast<size_t>(received));
+        size_t start = 0;
+        size_t newline;
+        while ((newline = line.find('\n', start)) != std::string::npos) {
+            if (onLine) onLine(line.substr(start, newline + 1 - start));
+            start = newline + 1;
+        }
+        line.erase(0, start);
+    }
+    if (!line.empty() && onLine) onLine(line);
+
+    // Closing stdin also tells a script that is somehow still running to stop
+    if (control) {
+        std::lock_guard<std::mutex> lock(control->mutex);
+        control->state = Control::State::Exited;
+    }
+
+#ifdef _WIN32
+    CloseHandle(inputWrite);
+    CloseHandle(outputRead);
+    WaitForSingleObject(process.hProcess, INFINITE);
+    DWORD exitCode = 0;
+    bool exited = GetExitCodeProcess(process.hProcess, &exitCode) != FALSE;
+    CloseHandle(process.hProcess);
+    return exited ? static_cast<int>(exitCode) : -1;
+#else
+    close(inputPipe[1]);
+    close(outputPipe[0]);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
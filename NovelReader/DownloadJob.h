@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+
+// One run of download_manager.py: the arguments for a download, the command line, the output
+// it prints and the commands it takes. Shared by the app's download threads, online search,
+// the download daemon and novelreader-cli; the app keeps its own progress bookkeeping on top.
+//
+// The script reads commands from its stdin, one per line, on a thread of its own, and acts on
+// them between network requests; a rate-limit wait or a pause ends as soon as one arrives.
+// Its stdin closing (the parent exiting) counts as Stop.
+class DownloadJob {
+public:
+    static constexpr const char* SCRIPT = "download_manager.py";
+
+    struct Request {
+        std::string source;
+        std::string url;              // A full URL, or anything else to download by name
+        std::string name;
+        std::string outputDir = "Novels";
+        int startChapter = 1;
+        int endChapter = -1;          // -1 for all available
+        std::string downloadId;       // The script names its state file after it; optional
+    };
+
+    // "ChapterSaved: <number> <novel folder name>", printed as each chapter lands on disk
+    struct ChapterSaved {
+        int chapter = 0;
+        std::string novelDirName;
+    };
+
+    enum class Command {
+        Pause,
+        Resume,
+        Cancel,       // Stop and report the download as cancelled
+        Stop          // Stop; the download resumes from where it got to
+    };
+
+    // The script's stdin, for one Run. Send works from any thread; a command sent before the
+    // script has started is delivered as it starts, and Send fails once it has exited.
+    class Control {
+    public:
+        bool Send(Command command);
+        bool IsRunning();
+
+    private:
+        friend class DownloadJob;
+        bool Write(Command command);        // Caller holds mutex
+
+        enum class State { NotStarted, Running, Exited };
+
+        std::mutex mutex;
+        State state = State::NotStarted;
+        bool hasPending = false;
+        Command pending = Command::Resume;
+#ifdef _WIN32
+        void* input = nullptr;
+#else
+        int input = -1;
+#endif
+    };
+
+    // The interpreter the script runs under: $NOVELREADER_PYTHON if set; otherwise "python3"
+    // when it is on the PATH (many Linux servers ship no "python"), else "python"
+    static const std::string& Python();
+
+    static std::vector<std::string> BuildArgs(const Request& request);
+    static std::string BuildCommand(const std::string& scriptName, const std::vector<std::string>& args);
+    static bool ParseChapterSaved(const std::string& line, ChapterSaved& saved);
+
+    // Runs the script with stderr merged into stdout and hands onLine every line it prints;
+    // control, if given, can steer it meanwhile. Returns the exit code, or -1 if the script is
+    // missing, could not be started or was killed.
+    static int Run(const std::vector<std::string>& args, const std::function<void(const std::string&)>& onLine,
+        Control* control = nullptr);
+
+private:
+    static int Spawn(const std::vector<std::string>& args, const std::function<void(const std::string&)>& onLine,
+        Control* control);
+};
@@ -0,0 +1,62 @@
+#include "FileLock.h"
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+FileLock::FileLock(const std::string& path) {
+    HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cout << "Failed to open lock file: " << path << std::endl;
+        return;
+    }
+    fileHandle = file;
+
+    OVERLAPPED overlapped = {};
+    locked = LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped) != 0;
+    if (!locked) std::cout << "Failed to lock " << path << ": error " << GetLastError() << std::endl;
+}
+
+FileLock::~FileLock() {
+    if (!fileHandle) return;
+    if (locked) {
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(static_cast<HANDLE>(fileHandle), 0, 1, 0, &overlapped);
+    }
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+}
+
+#else
+
+FileLock::FileLock(const std::string& path) {
+    fileDescriptor = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0) {
+        std::cout << "Failed to open lock file: " << path << std::endl;
+        return;
+    }
+
+    int result;
+    do {
+        result = flock(fileDescriptor, LOCK_EX);
+    } while (result != 0 && errno == EINTR);
+    locked = result == 0;
+    if (!locked) std::cout << "Failed to lock " << path << ": errno " << errno << std::endl;
+}
+
+FileLock::~FileLock() {
+    // Closing the descriptor releases the lock
+    if (fileDescriptor >= 0) close(fileDescriptor);
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+// Exclusive lock on a lock file, shared by every process working on the same library (the app,
+// novelreader-cli and the download daemon). Blocks until the lock is free; the OS drops it when
+// the holder exits, so a crashed process never leaves it stuck. Not reentrant within a process.
+class FileLock {
+public:
+    explicit FileLock(const std::string& path);   // Creates the file if needed
+    ~FileLock();                                   // Unlocks
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    // False if the file could not be opened or locked; the caller then goes ahead unlocked
+    bool IsLocked() const { return locked; }
+
+private:
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+    bool locked = false;
+};
@@ -0,0 +1,207 @@
+#include "IndexingPipeline.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace {
+    // Downloads arrive in bursts; waiting briefly turns a burst into one segment
+    constexpr auto BATCH_DELAY = std::chrono::seconds(1);
+    constexpr auto SCAN_INTERVAL = std::chrono::seconds(60);
+    constexpr size_t MAX_BATCH_CHAPTERS = 500;
+}
+
+IndexingPipeline::IndexingPipeline(std::string novelsRoot, std::string indexDir)
+    : novelsRoot(std::move(novelsRoot)), indexDir(std::move(indexDir)),
+      job([this]() { RunPass(); }) {
+}
+
+IndexingPipeline::~IndexingPipeline() {
+    Stop();
+}
+
+void IndexingPipeline::Start() {
+    stopping = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopRequested = false;
+    }
+    job.Start();
+    job.Request();
+}
+
+void IndexingPipeline::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopRequested = true;
+    }
+    stopping = true;
+    rebuildCancel = true;
+    job.Stop();
+}
+
+void IndexingPipeline::EnqueueChapter(const std::string& novelDirName, int chapterNumber) {
+    std::chrono::steady_clock::time_point batchDue;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (pendingChapters.empty()) {
+            firstPendingAt = std::chrono::steady_clock::now();
+        }
+        pendingChapters.push_back({ novelDirName, chapterNumber });
+        batchDue = firstPendingAt + BATCH_DELAY;
+    }
+    job.RequestAt(batchDue);
+}
+
+void IndexingPipeline::EnqueueRemoveNovel(const std::string& novelDirName) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        pendingRemovals.push_back(novelDirName);
+    }
+    job.Request();
+}
+
+void IndexingPipeline::RequestRebuild() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        rebuildRequested = true;
+    }
+    rebuildCancel = false;
+    rebuildProgress = 0.0f;
+    rebuilding = true;
+    job.Request();
+}
+
+void IndexingPipeline::CancelRebuild() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    rebuildCancel = true;
+
+    // Not picked up by a pass yet
+    if (std::exchange(rebuildRequested, false)) {
+        rebuilding = false;
+    }
+}
+
+void IndexingPipeline::RequestScan() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        scanRequested = true;
+    }
+    job.Request();
+}
+
+size_t IndexingPipeline::PendingChapters() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return pendingChapters.size();
+}
+
+void IndexingPipeline::RunPass() {
+    std::vector<std::string> removals;
+    bool rebuild = false;
+    bool scan = false;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (stopRequested) return;
+
+        auto now = std::chrono::steady_clock::now();
+        rebuild = std::exchange(rebuildRequested, false);
+        scan = std::exchange(scanRequested, false) || now >= nextScan;
+        removals.swap(pendingRemovals);
+        if (!pendingChapters.empty() && now >= firstPendingAt + BATCH_DELAY) {
+            backlog.insert(backlog.begin(), pendingChapters.begin(), pendingChapters.end());
+            pendingChapters.clear();
+        }
+    }
+
+    bool changed = false;
+
+    if (rebuild) {
+        // Every chapter is added again over the live index, which keeps answering searches, and
+        // whatever predates the rebuild is dropped once the last slice is in
+        rebuildCancel = false;
+        rebuildRunning = SearchIndex::BeginRebuild(novelsRoot, indexDir, rebuildFirstSeq);
+        rebuildBacklog = rebuildRunning ? SearchIndex::ListChapters(novelsRoot) : std::vector<SearchIndex::ChapterRef>();
+        std::reverse(rebuildBacklog.begin(), rebuildBacklog.end());   // Sliced from the back
+        rebuildTotal = rebuildBacklog.size();
+        rebuilding = rebuildRunning;
+    }
+    if (rebuildRunning && (rebuildCancel || stopping)) {
+        // What was added so far only shadows identical copies
+        rebuildRunning = false;
+        rebuildBacklog.clear();
+        rebuilding = false;
+    }
+
+    // Removals go first so chapters of a re-added novel land after the tombstone
+    for (const std::string& novelName : removals) {
+        changed = SearchIndex::RemoveNovel(indexDir, novelName) || changed;
+        rebuildBacklog.erase(std::remove_if(rebuildBacklog.begin(), rebuildBacklog.end(),
+            [&](const SearchIndex::ChapterRef& chapter) { return chapter.novelName == novelName; }), rebuildBacklog.end());
+    }
+
+    if (scan && !rebuildRunning) {
+        std::vector<std::string> vanished;
+        std::vector<SearchIndex::ChapterRef> stale = SearchIndex::FindStaleChapters(novelsRoot, indexDir, &vanished);
+        for (const std::string& novelName : vanished) {
+            changed = SearchIndex::RemoveNovel(indexDir, novelName) || changed;
+        }
+        backlog.insert(backlog.begin(), stale.begin(), stale.end());
+        nextScan = std::chrono::steady_clock::now() + SCAN_INTERVAL;
+    }
+
+    // One slice per pass; fresh downloads before the rebuild
+    if (!backlog.empty()) {
+        changed = IndexSlice(backlog) || changed;
+    }
+    else if (rebuildRunning) {
+        changed = IndexSlice(rebuildBacklog) || changed;
+        rebuildProgress = 1.0f - static_cast<float>(rebuildBacklog.size()) / std::max<size_t>(rebuildTotal, 1);
+        if (rebuildBacklog.empty()) {
+            changed = SearchIndex::FinishRebuild(indexDir, rebuildFirstSeq) || changed;
+            rebuildRunning = false;
+            rebuilding = false;
+        }
+    }
+    if (changed) {
+        compactPending = true;
+        indexChanged = true;
+    }
+    else if (compactPending && backlog.empty() && !rebuildRunning && !stopping) {
+        // One merge per pass, once the chapters are in; old and rebuilt segments are never merged
+        if (SearchIndex::Compact(indexDir, &stopping, 1)) {
+            indexChanged = true;
+        }
+        else {
+            compactPending = false;
+            SearchIndex::CollectGarbage(indexDir);
+        }
+    }
+
+    if (stopping) return;
+    if (!backlog.empty() || rebuildRunning || compactPending) {
+        job.Request();
+        return;
+    }
+
+    // The next pass: the periodic scan, or sooner for a batch that is still settling
+    auto wakeAt = nextScan;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!pendingChapters.empty()) wakeAt = std::min(wakeAt, firstPendingAt + BATCH_DELAY);
+    }
+    job.RequestAt(wakeAt);
+}
+
+bool IndexingPipeline::IndexSlice(std::vector<SearchIndex::ChapterRef>& chapters) {
+    // Large backlogs (first launch, a finished bulk download) are published in slices
+    // so searches pick up new chapters while the rest is still being indexed
+    size_t count = std::min(chapters.size(), MAX_BATCH_CHAPTERS);
+    std::vector<SearchIndex::ChapterRef> batch(chapters.end() - count, chapters.end());
+    chapters.resize(chapters.size() - count);
+
+    if (!SearchIndex::AddChapters(novelsRoot, indexDir, batch)) {
+        std::cout << "Failed to index " << batch.size() << " chapters" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "SearchIndex.h"
+#include "TaskScheduler.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+// Keeps the search index in step with the Novels folder through a background TaskScheduler
+// job, one pass at a time. Saved chapters are batched into small delta segments, removed
+// novels are tombstoned and segments are merged in the background. Each pass does one slice
+// of work (a batch of chapters, a merge) and requests the next, so a backlog or a rebuild
+// never holds a worker for long. The UI thread only polls ConsumeIndexChanged() and reopens
+// its SearchIndex, which maps just the segments it hasn't seen yet.
+class IndexingPipeline {
+public:
+    IndexingPipeline(std::string novelsRoot, std::string indexDir);
+    ~IndexingPipeline();
+
+    IndexingPipeline(const IndexingPipeline&) = delete;
+    IndexingPipeline& operator=(const IndexingPipeline&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Thread-safe; called from download threads as chapters land on disk
+    void EnqueueChapter(const std::string& novelDirName, int chapterNumber);
+    void EnqueueRemoveNovel(const std::string& novelDirName);
+
+    void RequestRebuild();
+    void CancelRebuild();
+    void RequestScan();
+
+    // True once per published change; the caller should reopen its SearchIndex
+    bool ConsumeIndexChanged() { return indexChanged.exchange(false); }
+
+    bool IsRebuilding() const { return rebuilding.load(); }
+    float RebuildProgress() const { return rebuildProgress.load(); }
+    size_t PendingChapters() const;
+
+private:
+    void RunPass();
+    bool IndexSlice(std::vector<SearchIndex::ChapterRef>& chapters);   // From the back; true if published
+
+    std::string novelsRoot;
+    std::string indexDir;
+
+    mutable std::mutex queueMutex;
+
+    // Guarded by queueMutex
+    std::vector<SearchIndex::ChapterRef> pendingChapters;
+    std::vector<std::string> pendingRemovals;
+    std::chrono::steady_clock::time_point firstPendingAt;
+    bool stopRequested = false;
+    bool rebuildRequested = false;
+    bool scanRequested = true;   // The first pass picks up anything downloaded while the app was closed
+
+    // Passes only
+    std::chrono::steady_clock::time_point nextScan;
+    std::vector<SearchIndex::ChapterRef> backlog;          // Due for indexing
+    std::vector<SearchIndex::ChapterRef> rebuildBacklog;   // Left for the rebuild in progress
+    size_t rebuildTotal = 0;
+    uint64_t rebuildFirstSeq = 0;
+    bool rebuildRunning = false;
+    bool compactPending = false;                           // Merges and garbage collection still to do
+
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> rebuilding{ false };
+    std::atomic<bool> rebuildCancel{ false };
+    std::atomic<float> rebuildProgress{ 0.0f };
+    std::atomic<bool> indexChanged{ false };
+
+    TaskScheduler::Job job;   // Last, so it stops before the state its passes use goes away
+};
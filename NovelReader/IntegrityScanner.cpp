@@ -0,0 +1,435 @@
+#include "IntegrityScanner.h"
+#include "BatchReader.h"
+#include "ChapterJournal.h"
+#include "ChapterStore.h"
+#include "Dependecies/json.h"
+#include "Dependecies/stb_image.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr auto FIRST_SCAN_DELAY = std::chrono::minutes(2);   // Let startup and the first tiering sweep go first
+    constexpr auto SCAN_INTERVAL = std::chrono::hours(6);
+    constexpr auto READER_IDLE_AFTER = std::chrono::seconds(15);
+    constexpr auto ACTIVE_PAUSE = std::chrono::seconds(2);
+    constexpr size_t IDLE_BATCH = 128;
+    constexpr size_t ACTIVE_BATCH = 8;
+    constexpr size_t IDLE_QUEUE_DEPTH = 16;
+    constexpr size_t ACTIVE_QUEUE_DEPTH = 2;
+    constexpr const char* METADATA_FILE = "metadata.json";
+    constexpr const char* RECORDED_MISMATCH = "does not match its recorded checksum";
+    constexpr const char* STORED_MISMATCH = "does not match its stored checksum";
+
+    // The number after prefix in names like "chapter12" or "Chapter_012"; 0 if there is none
+    int NumberAfter(const std::string& name, const std::string& prefix) {
+        if (name.rfind(prefix, 0) != 0 || name.size() == prefix.size()) return 0;
+        int number = 0;
+        for (size_t i = prefix.size(); i < name.size(); i++) {
+            if (name[i] < '0' || name[i] > '9' || number > 100000000) return 0;
+            number = number * 10 + (name[i] - '0');
+        }
+        return number;
+    }
+
+    bool IsPageFile(const std::string& fileName) {
+        return fileName.starts_with("page_") && (fileName.ends_with(".jpg") || fileName.ends_with(".png") ||
+            fileName.ends_with(".gif") || fileName.ends_with(".webp"));
+    }
+
+    size_t CountPageFiles(const std::filesystem::path& chapterDir) {
+        size_t count = 0;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(chapterDir, ec)) {
+            if (IsPageFile(entry.path().filename().string())) count++;
+        }
+        return count;
+    }
+
+    // A download cut short keeps a valid header, so the end of the file is what gives it away
+    bool HasIntactEnd(std::string_view bytes) {
+        auto startsWith = [&](const char* magic, size_t length) {
+            return bytes.size() >= length && std::memcmp(bytes.data(), magic, length) == 0;
+        };
+        if (startsWith("\x89PNG", 4)) {
+            return bytes.size() >= 12 && bytes.substr(bytes.size() - 8, 4) == "IEND";
+        }
+        if (startsWith("\xFF\xD8", 2)) {
+            // Some encoders pad after the end-of-image marker
+            std::string_view tail = bytes.substr(bytes.size() - std::min<size_t>(bytes.size(), 64));
+            return tail.find("\xFF\xD9") != std::string_view::npos;
+        }
+        if (startsWith("GIF8", 4)) {
+            return bytes.back() == 0x3B;
+        }
+        if (startsWith("RIFF", 4) && bytes.size() >= 12) {
+            uint32_t riffSize = 0;
+            for (int i = 3; i >= 0; i--) riffSize = (riffSize << 8) | static_cast<uint8_t>(bytes[4 + i]);
+            return static_cast<uint64_t>(riffSize) + 8 <= bytes.size();
+        }
+        return true;   // A format we can't check further
+    }
+
+    std::string CheckImage(std::string_view bytes, const std::string& extension) {
+        if (bytes.empty()) return "empty file";
+
+        // stb_image has no WebP; its RIFF header is checked by HasIntactEnd instead
+        int width = 0, height = 0, components = 0;
+        if (extension != ".webp" && !stbi_info_from_memory(reinterpret_cast<const stbi_uc*>(bytes.data()),
+            static_cast<int>(std::min<size_t>(bytes.size(), INT32_MAX)), &width, &height, &components)) {
+            return "not a readable image";
+        }
+        if (!HasIntactEnd(bytes)) return "truncated image";
+        return {};
+    }
+
+    std::string DamageKey(const IntegrityScanner::Damage& damage) {
+        return (damage.manga ? "Manga/" : "Novels/") + damage.contentName + "/" +
+            ChapterJournal::Key(damage.chapter, damage.page);
+    }
+
+    bool ReadWholeFile(const std::string& path, std::string& bytes) {
+        std::ifstream file(std::filesystem::path(path), std::ios::binary);
+        if (!file.is_open()) return false;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        bytes = buffer.str();
+        return true;
+    }
+}
+
+IntegrityScanner::IntegrityScanner(std::string novelsRoot, std::string mangaRoot)
+    : novelsRoot(novelsRoot),
+      mangaRoot(std::move(mangaRoot)),
+      blobStore((std::filesystem::path(novelsRoot) / BlobStore::DIRECTORY_NAME).string()) {
+}
+
+IntegrityScanner::~IntegrityScanner() {
+    Stop();
+}
+
+void IntegrityScanner::Start() {
+    if (worker) return;
+
+    stopping = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = false;
+    }
+    worker = std::make_unique<std::thread>(&IntegrityScanner::WorkerLoop, this);
+}
+
+void IntegrityScanner::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    stopping = true;
+    wake.notify_all();
+
+    if (worker && worker->joinable()) {
+        worker->join();
+    }
+    worker.reset();
+}
+
+void IntegrityScanner::RequestScan() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scanRequested = true;
+    }
+    wake.notify_one();
+}
+
+void IntegrityScanner::NotifyReaderActivity() {
+    lastReaderActivity = std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+std::vector<IntegrityScanner::Damage> IntegrityScanner::TakeNewDamage() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::exchange(newDamage, {});
+}
+
+std::vector<IntegrityScanner::Damage> IntegrityScanner::CurrentDamage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentDamage;
+}
+
+bool IntegrityScanner::ReaderActive() const {
+    std::chrono::steady_clock::duration sinceActivity = std::chrono::steady_clock::now().time_since_epoch() -
+        std::chrono::steady_clock::duration(lastReaderActivity.load());
+    return sinceActivity < READER_IDLE_AFTER;
+}
+
+void IntegrityScanner::Throttle() {
+    if (!ReaderActive()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.wait_for(lock, ACTIVE_PAUSE, [&]() { return stopRequested; });
+}
+
+// ============================================================================
+// Checks
+// ============================================================================
+std::string IntegrityScanner::CheckItem(const Item& item, std::string& bytes) const {
+    std::filesystem::path path(item.path);
+    std::string fileName = path.filename().string();
+
+    std::error_code ec;
+    if (!item.expectedBlob.empty()) {
+        if (BlobStore::Hash(bytes).Hex() != item.expectedBlob) return RECORDED_MISMATCH;
+    }
+    else if (std::filesystem::hard_link_count(path, ec) > 1 && !ec) {
+        // A store entry must still be a link of the blob its bytes hash to
+        std::string blobPath = blobStore.BlobPath(BlobStore::Hash(bytes));
+        if (!std::filesystem::equivalent(path, blobPath, ec)) return STORED_MISMATCH;
+    }
+
+    if (!item.damage.manga) {
+        ChapterStore::MappedChapter chapter;
+        if (!ChapterStore::OpenChapterBytes(item.path, std::move(bytes), chapter)) return "does not decode or parse";
+        return {};
+    }
+
+    if (fileName == METADATA_FILE) {
+        json metadata = json::parse(bytes, nullptr, false);
+        if (metadata.is_discarded() || !metadata.is_object()) return "chapter metadata does not parse";
+
+        auto pageCount = metadata.find("page_count");
+        if (pageCount == metadata.end() || !pageCount->is_number_integer()) return {};
+        size_t expected = static_cast<size_t>(std::max<int64_t>(0, pageCount->get<int64_t>()));
+        size_t present = CountPageFiles(path.parent_path());
+        if (present < expected) {
+            return "only " + std::to_string(present) + " of " + std::to_string(expected) + " pages present";
+        }
+        return {};
+    }
+    return CheckImage(bytes, path.extension().string());
+}
+
+void IntegrityScanner::CheckBatch(std::vector<Item>& items, size_t begin, size_t end) {
+    std::vector<BatchReader::Request> requests;
+    requests.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        BatchReader::Request request;
+        request.path = items[i].path;
+        requests.push_back(std::move(request));
+    }
+
+    size_t queueDepth = ReaderActive() ? ACTIVE_QUEUE_DEPTH : IDLE_QUEUE_DEPTH;
+    BatchReader::ReadBatch(requests, [&](size_t index, bool ok, std::string& data) {
+        Item& item = items[begin + index];
+        item.damage.reason = ok ? CheckItem(item, data) : "missing or unreadable";
+    }, queueDepth, BatchReader::Priority::Background);
+
+    // A file replaced between the read and the link check (a tier move, a download landing)
+    // looks damaged for a moment, so failures are confirmed with a second read
+    for (size_t i = begin; i < end; i++) {
+        Item& item = items[i];
+        if (item.damage.reason.empty()) continue;
+
+        std::string bytes;
+        if (!ReadWholeFile(item.path, bytes)) {
+            item.damage.reason = "missing or unreadable";
+            continue;
+        }
+        item.damage.reason = CheckItem(item, bytes);
+
+        // Bytes that changed under a store entry changed in its blob too
+        std::error_code ec;
+        if ((item.damage.reason == RECORDED_MISMATCH || item.damage.reason == STORED_MISMATCH) &&
+            std::filesystem::hard_link_count(item.path, ec) > 1 && !ec) {
+            blobStore.Evict(item.path);
+        }
+    }
+}
+
+// ============================================================================
+// Worker
+// ============================================================================
+bool IntegrityScanner::ScanContent(const std::string& contentDir, std::vector<Item> items, std::vector<Damage>& found) {
+    std::map<std::string, ChapterJournal::Entry> journaled = ChapterJournal::Damaged(contentDir);
+
+    for (size_t begin = 0; begin < items.size();) {
+        if (stopping) return false;
+
+        size_t end = std::min(items.size(), begin + (ReaderActive() ? ACTIVE_BATCH : IDLE_BATCH));
+        CheckBatch(items, begin, end);
+        checkedItems += end - begin;
+        begin = end;
+        Throttle();
+    }
+
+    // Only changes are journaled, so a chapter that stays damaged is recorded once
+    for (Item& item : items) {
+        std::string key = ChapterJournal::Key(item.damage.chapter, item.damage.page);
+        bool wasDamaged = journaled.count(key) > 0;
+
+        if (item.damage.reason.empty()) {
+            if (!wasDamaged) continue;
+            ChapterJournal::Entry entry;
+            entry.chapter = item.damage.chapter;
+            entry.page = item.damage.page;
+            entry.event = ChapterJournal::REPAIRED;
+            entry.detail = "passed integrity check";
+            ChapterJournal::Append(contentDir, entry);
+            continue;
+        }
+
+        found.push_back(item.damage);
+        if (!wasDamaged) {
+            std::cout << "Integrity check: " << item.path << " " << item.damage.reason << std::endl;
+            ChapterJournal::Entry entry;
+            entry.chapter = item.damage.chapter;
+            entry.page = item.damage.page;
+            entry.event = ChapterJournal::DAMAGED;
+            entry.detail = item.damage.reason;
+            ChapterJournal::Append(contentDir, entry);
+        }
+
+        // Damage the reader journaled, or that was there before a restart, is still news to the library
+        if (previouslyFound.count(DamageKey(item.damage)) == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            newDamage.push_back(item.damage);
+        }
+    }
+    return true;
+}
+
+void IntegrityScanner::ScanLibrary() {
+    scanning = true;
+    checkedItems = 0;
+    std::vector<Damage> found;
+    bool finished = true;
+
+    std::error_code ec;
+    for (const auto& novelEntry : std::filesystem::directory_iterator(novelsRoot, ec)) {
+        std::string name = novelEntry.path().filename().string();
+        std::filesystem::path chaptersDir = novelEntry.path() / "chapters";
+        if (name.starts_with(".") || !std::filesystem::is_directory(chaptersDir, ec)) continue;   // .store
+
+        std::vector<Item> items;
+        for (const auto& entry : std::filesystem::directory_iterator(chaptersDir, ec)) {
+            const std::filesystem::path& path = entry.path();
+            int chapter = NumberAfter(path.stem().string(), "chapter");
+            if (path.extension() != ".json" || chapter == 0) continue;
+
+            Item item;
+            item.path = path.string();
+            item.damage.contentName = name;
+            item.damage.chapter = chapter;
+            items.push_back(std::move(item));
+        }
+        std::sort(items.begin(), items.end(),
+            [](const Item& a, const Item& b) { return a.damage.chapter < b.damage.chapter; });
+
+        if (!ScanContent(novelEntry.path().string(), std::move(items), found)) {
+            finished = false;
+            break;
+        }
+    }
+
+    for (const auto& mangaEntry : std::filesystem::directory_iterator(mangaRoot, ec)) {
+        if (!finished) break;
+        if (!mangaEntry.is_directory()) continue;
+        std::string name = mangaEntry.path().filename().string();
+
+        std::vector<Item> items;
+        for (const auto& chapterEntry : std::filesystem::directory_iterator(mangaEntry.path(), ec)) {
+            int chapter = NumberAfter(chapterEntry.path().filename().string(), "Chapter_");
+            if (!chapterEntry.is_directory() || chapter == 0) continue;
+
+            Item base;
+            base.damage.contentName = name;
+            base.damage.manga = true;
+            base.damage.chapter = chapter;
+
+            // Pages downloaded since the store existed are listed with the blob they hashed to
+            std::unordered_map<std::string, std::string> recordedBlobs;
+            std::filesystem::path metadataPath = chapterEntry.path() / METADATA_FILE;
+            std::string metadataText;
+            if (ReadWholeFile(metadataPath.string(), metadataText)) {
+                Item item = base;
+                item.path = metadataPath.string();
+                items.push_back(std::move(item));
+
+                json metadata = json::parse(metadataText, nullptr, false);
+                if (metadata.is_object() && metadata.contains("pages") && metadata["pages"].is_array()) {
+                    for (const json& page : metadata["pages"]) {
+                        if (!page.is_object()) continue;
+                        std::string file = page.value("file", "");
+                        if (!file.empty()) recordedBlobs[file] = page.value("blob", "");
+                    }
+                }
+            }
+
+            // A page listed in the metadata but gone from the folder fails its read
+            std::set<std::string> pageFiles;
+            for (const auto& pageEntry : std::filesystem::directory_iterator(chapterEntry.path(), ec)) {
+                std::string fileName = pageEntry.path().filename().string();
+                if (IsPageFile(fileName)) pageFiles.insert(fileName);
+            }
+            for (const auto& [file, blob] : recordedBlobs) {
+                if (file.find_first_of("/\\") == std::string::npos) pageFiles.insert(file);
+            }
+
+            for (const std::string& fileName : pageFiles) {
+                Item item = base;
+                item.path = (chapterEntry.path() / fileName).string();
+                item.damage.page = fileName;
+                auto recorded = recordedBlobs.find(fileName);
+                if (recorded != recordedBlobs.end()) item.expectedBlob = recorded->second;
+                items.push_back(std::move(item));
+            }
+        }
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+            return std::tie(a.damage.chapter, a.damage.page) < std::tie(b.damage.chapter, b.damage.page);
+        });
+
+        if (!ScanContent(mangaEntry.path().string(), std::move(items), found)) {
+            finished = false;
+        }
+    }
+
+    if (finished) {
+        previouslyFound.clear();
+        for (const Damage& damage : found) previouslyFound.insert(DamageKey(damage));
+        damagedItems = found.size();
+        lastScanTime = std::time(nullptr);
+        std::lock_guard<std::mutex> lock(mutex);
+        currentDamage = std::move(found);
+    }
+    scanning = false;
+}
+
+void IntegrityScanner::WorkerLoop() {
+    // Verification is housekeeping: idle I/O class, and on Windows background CPU and memory priority
+    BatchReader::EnterBackgroundMode();
+
+    auto nextScan = std::chrono::steady_clock::now() + FIRST_SCAN_DELAY;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto hasWork = [&]() {
+                return stopRequested || scanRequested || std::chrono::steady_clock::now() >= nextScan;
+            };
+            while (!hasWork()) {
+                wake.wait_until(lock, nextScan);
+            }
+            if (stopRequested) break;
+            scanRequested = false;
+        }
+
+        ScanLibrary();
+        nextScan = std::chrono::steady_clock::now() + SCAN_INTERVAL;
+    }
+}
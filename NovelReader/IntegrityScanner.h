@@ -0,0 +1,91 @@
+#pragma once
+#include "BlobStore.h"
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+
+// Walks the library from a single idle-priority worker and checks every chapter file and
+// manga page, so damage shows up before the reader opens a chapter that fails to load.
+//
+// Chapter files and pages that are BlobStore entries must still hash to their blob; pages
+// listed in a chapter's metadata must hash to the blob recorded there. Everything else gets a
+// parse check: chapters must decode and parse, pages need an image header and an intact end.
+// Damage and repairs are recorded in each content folder's ChapterJournal, and newly damaged
+// items are handed to the library, which can queue them for re-download.
+//
+// Reads go through BatchReader at background priority. While the reader has been active
+// recently the scanner checks a few files at a time and pauses in between.
+class IntegrityScanner {
+public:
+    struct Damage {
+        std::string contentName;   // Folder name under the library root
+        bool manga = false;
+        int chapter = 0;
+        std::string page;          // Empty for a whole chapter
+        std::string reason;
+    };
+
+    IntegrityScanner(std::string novelsRoot, std::string mangaRoot);
+    ~IntegrityScanner();
+
+    IntegrityScanner(const IntegrityScanner&) = delete;
+    IntegrityScanner& operator=(const IntegrityScanner&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Thread-safe
+    void RequestScan();
+    void NotifyReaderActivity();
+    std::vector<Damage> TakeNewDamage();   // Not found by the previous pass, oldest first
+    std::vector<Damage> CurrentDamage() const;   // As of the last full pass
+
+    bool IsScanning() const { return scanning.load(); }
+    size_t CheckedItems() const { return checkedItems.load(); }   // In the current or last pass
+    size_t DamagedItems() const { return damagedItems.load(); }   // Found by the last full pass
+    std::time_t LastScanTime() const { return lastScanTime.load(); }
+
+private:
+    struct Item {
+        std::string path;
+        Damage damage;               // Identifies the item; reason filled in when a check fails
+        std::string expectedBlob;    // Hex BLAKE2b-128 from manga metadata, if recorded
+    };
+
+    void WorkerLoop();
+    void ScanLibrary();
+    bool ScanContent(const std::string& contentDir, std::vector<Item> items, std::vector<Damage>& found);
+    void CheckBatch(std::vector<Item>& items, size_t begin, size_t end);
+    std::string CheckItem(const Item& item, std::string& bytes) const;
+    void Throttle();
+    bool ReaderActive() const;
+
+    std::string novelsRoot;
+    std::string mangaRoot;
+    BlobStore blobStore;
+    std::set<std::string> previouslyFound;   // Worker only; damage found by the last full pass
+
+    std::unique_ptr<std::thread> worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+
+    // Guarded by mutex
+    bool stopRequested = false;
+    bool scanRequested = false;
+    std::vector<Damage> newDamage;
+    std::vector<Damage> currentDamage;
+
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> scanning{ false };
+    std::atomic<int64_t> lastReaderActivity{ 0 };   // steady_clock ticks
+    std::atomic<size_t> checkedItems{ 0 };
+    std::atomic<size_t> damagedItems{ 0 };
+    std::atomic<std::time_t> lastScanTime{ 0 };
+};
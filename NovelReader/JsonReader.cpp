@@ -0,0 +1,771 @@
+#include "JsonReader.h"
+#include "ChapterStore.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_READER_SSE2 1
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr int MAX_DEPTH = 256;   // Deeper documents go to the DOM parser
+
+    inline bool IsWhitespace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    inline const char* SkipWhitespace(const char* p, const char* end) {
+        while (p < end && IsWhitespace(*p)) p++;
+        return p;
+    }
+
+    // First byte in [p, end) that ends a run of plain string characters: a quote, a backslash
+    // or a control character (not allowed unescaped). Returns end if there is none.
+    inline const char* FindStringSpecial(const char* p, const char* end) {
+#ifdef JSON_READER_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i controlMax = _mm_set1_epi8(0x1F);
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i special = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+            special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_min_epu8(v, controlMax), v));   // v <= 0x1F
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+            if (mask) return p + std::countr_zero(mask);
+            p += 16;
+        }
+#endif
+        while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) p++;
+        return p;
+    }
+
+    // First backslash or non-ASCII byte; the decoder copies everything before it in one go
+    inline const char* FindEscapeOrUtf8(const char* p, const char* end) {
+#ifdef JSON_READER_SSE2
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(v) | _mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)));
+            if (mask) return p + std::countr_zero(mask);
+            p += 16;
+        }
+#endif
+        while (p < end && *p != '\\' && static_cast<unsigned char>(*p) < 0x80) p++;
+        return p;
+    }
+
+    // p is just past an opening quote; returns just past the closing one, or nullptr
+    const char* ScanString(const char* p, const char* end) {
+        while (true) {
+            p = FindStringSpecial(p, end);
+            if (p == end) return nullptr;
+            if (*p == '"') return p + 1;
+            if (*p != '\\' || end - p < 2) return nullptr;   // Raw control character, or a dangling escape
+            p += 2;
+        }
+    }
+
+    bool IsNumber(std::string_view text) {
+        size_t i = 0;
+        if (i < text.size() && text[i] == '-') i++;
+        if (i >= text.size()) return false;
+        if (text[i] == '0') {
+            i++;
+        }
+        else if (text[i] >= '1' && text[i] <= '9') {
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') i++;
+        }
+        else {
+            return false;
+        }
+        if (i < text.size() && text[i] == '.') {
+            size_t digits = ++i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') i++;
+            if (i == digits) return false;
+        }
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+            i++;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-')) i++;
+            size_t digits = i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') i++;
+            if (i == digits) return false;
+        }
+        return i == text.size();
+    }
+
+    bool IsInteger(std::string_view text) {
+        return IsNumber(text) && text.find_first_of(".eE") == std::string_view::npos;
+    }
+
+    // p is at the first byte of a value; returns just past it, or nullptr. Containers are only
+    // checked for balanced brackets and well-formed strings; their scalars are left for later.
+    const char* SkipValue(const char* p, const char* end) {
+        if (p >= end) return nullptr;
+
+        if (*p == '"') return ScanString(p + 1, end);
+
+        if (*p == '{' || *p == '[') {
+            char closers[MAX_DEPTH];
+            int depth = 0;
+            while (p < end) {
+                char c = *p;
+                if (c == '"') {
+                    p = ScanString(p + 1, end);
+                    if (!p) return nullptr;
+                    continue;
+                }
+                if (c == '{' || c == '[') {
+                    if (depth == MAX_DEPTH) return nullptr;
+                    closers[depth++] = (c == '{') ? '}' : ']';
+                }
+                else if (c == '}' || c == ']') {
+                    if (depth == 0 || closers[depth - 1] != c) return nullptr;
+                    if (--depth == 0) return p + 1;
+                }
+                p++;
+            }
+            return nullptr;
+        }
+
+        const char* start = p;
+        while (p < end && !IsWhitespace(*p) && *p != ',' && *p != '}' && *p != ']') p++;
+        std::string_view literal(start, p - start);
+        if (literal == "true" || literal == "false" || literal == "null" || IsNumber(literal)) return p;
+        return nullptr;
+    }
+
+    // Length of the well-formed UTF-8 sequence at p (lead byte >= 0x80), or 0
+    size_t Utf8SequenceLength(const unsigned char* p, const unsigned char* end) {
+        unsigned char c = p[0];
+        size_t length;
+        unsigned char low = 0x80, high = 0xBF;   // Allowed range of the second byte
+        if (c >= 0xC2 && c <= 0xDF) length = 2;
+        else if (c == 0xE0) { length = 3; low = 0xA0; }
+        else if (c == 0xED) { length = 3; high = 0x9F; }   // No UTF-16 surrogates
+        else if (c >= 0xE1 && c <= 0xEF) length = 3;
+        else if (c == 0xF0) { length = 4; low = 0x90; }
+        else if (c >= 0xF1 && c <= 0xF3) length = 4;
+        else if (c == 0xF4) { length = 4; high = 0x8F; }
+        else return 0;
+
+        if (static_cast<size_t>(end - p) < length) return 0;
+        if (p[1] < low || p[1] > high) return 0;
+        for (size_t i = 2; i < length; i++) {
+            if ((p[i] & 0xC0) != 0x80) return 0;
+        }
+        return length;
+    }
+
+    bool ReadHex4(const char* p, const char* end, uint32_t& value) {
+        if (end - p < 4) return false;
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = p[i];
+            uint32_t digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else return false;
+            value = (value << 4) | digit;
+        }
+        return true;
+    }
+
+    void EncodeUtf8(char*& out, uint32_t cp) {
+        if (cp < 0x80) {
+            *out++ = static_cast<char>(cp);
+        }
+        else if (cp < 0x800) {
+            *out++ = static_cast<char>(0xC0 | (cp >> 6));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            *out++ = static_cast<char>(0xE0 | (cp >> 12));
+            *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else {
+            *out++ = static_cast<char>(0xF0 | (cp >> 18));
+            *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // body is a string's contents without the quotes. out needs body.size() bytes and may be
+    // body itself: every escape is longer than what it decodes to, so writes never pass reads.
+    bool DecodeString(std::string_view body, char* out, size_t& length) {
+        char* o = out;
+        const char* p = body.data();
+        const char* end = p + body.size();
+        while (p < end) {
+            const char* run = FindEscapeOrUtf8(p, end);
+            if (o != p) std::memmove(o, p, run - p);
+            o += run - p;
+            p = run;
+            if (p == end) break;
+
+            if (*p != '\\') {
+                size_t sequence = Utf8SequenceLength(reinterpret_cast<const unsigned char*>(p),
+                    reinterpret_cast<const unsigned char*>(end));
+                if (sequence == 0) return false;
+                std::memmove(o, p, sequence);
+                o += sequence;
+                p += sequence;
+                continue;
+            }
+
+            if (end - p < 2) return false;
+            char escape = p[1];
+            p += 2;
+            switch (escape) {
+            case '"': *o++ = '"'; break;
+            case '\\': *o++ = '\\'; break;
+            case '/': *o++ = '/'; break;
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'n': *o++ = '\n'; break;
+            case 'r': *o++ = '\r'; break;
+            case 't': *o++ = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!ReadHex4(p, end, cp)) return false;
+                p += 4;
+                if (cp >= 0xDC00 && cp <= 0xDFFF) return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !ReadHex4(p + 2, end, low)) return false;
+                    if (low < 0xDC00 || low > 0xDFFF) return false;
+                    p += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                EncodeUtf8(o, cp);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        length = o - out;
+        return true;
+    }
+
+    bool DecodeString(std::string_view body, std::string& out) {
+        out.resize(body.size());
+        size_t length = 0;
+        if (!DecodeString(body, out.data(), length)) return false;
+        out.resize(length);
+        return true;
+    }
+
+    // True if body decodes to itself: no escapes, and well-formed UTF-8
+    bool IsPlainString(std::string_view body) {
+        const char* p = body.data();
+        const char* end = p + body.size();
+        while ((p = FindEscapeOrUtf8(p, end)) < end) {
+            if (*p == '\\') return false;
+            size_t sequence = Utf8SequenceLength(reinterpret_cast<const unsigned char*>(p),
+                reinterpret_cast<const unsigned char*>(end));
+            if (sequence == 0) return false;
+            p += sequence;
+        }
+        return true;
+    }
+
+    bool KeyEquals(std::string_view rawKey, std::string_view key) {
+        if (rawKey.find('\\') == std::string_view::npos) return rawKey == key;
+        std::string decoded;
+        return DecodeString(rawKey, decoded) && decoded == key;
+    }
+}
+
+// ============================================================================
+// Values
+// ============================================================================
+bool JsonReader::Value::GetString(std::string& out) const {
+    if (raw.size() < 2 || raw.front() != '"') return false;
+    return DecodeString(raw.substr(1, raw.size() - 2), out);
+}
+
+bool JsonReader::Value::GetStringView(std::string_view& out) const {
+    if (raw.size() < 2 || raw.front() != '"') return false;
+    std::string_view body = raw.substr(1, raw.size() - 2);
+    if (!IsPlainString(body)) return false;
+    out = body;
+    return true;
+}
+
+bool JsonReader::Value::DecodeStringTo(char* destination, size_t& length) const {
+    if (raw.size() < 2 || raw.front() != '"') return false;
+    return DecodeString(raw.substr(1, raw.size() - 2), destination, length);
+}
+
+bool JsonReader::Value::GetInt64(int64_t& out) const {
+    if (!IsInteger(raw)) return false;
+    auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), out);
+    return ec == std::errc() && end == raw.data() + raw.size();
+}
+
+bool JsonReader::Value::GetInt(int& out) const {
+    int64_t value;
+    if (!GetInt64(value)) return false;
+    if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+bool JsonReader::Value::GetDouble(double& out) const {
+    if (!IsNumber(raw)) return false;
+    auto [end, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), out);
+    return ec == std::errc() && end == raw.data() + raw.size();
+}
+
+bool JsonReader::Value::GetFloat(float& out) const {
+    // Through double, as the DOM stores numbers
+    double value;
+    if (!GetDouble(value)) return false;
+    out = static_cast<float>(value);
+    return true;
+}
+
+bool JsonReader::Value::GetBool(bool& out) const {
+    if (raw == "true") out = true;
+    else if (raw == "false") out = false;
+    else return false;
+    return true;
+}
+
+// ============================================================================
+// Objects and arrays
+// ============================================================================
+bool JsonReader::Object::Parse(std::string_view text) {
+    members.clear();
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    p = SkipWhitespace(p, end);
+    if (p == end || *p != '{') return false;
+    p = SkipWhitespace(p + 1, end);
+
+    if (p < end && *p == '}') {
+        p++;
+    }
+    else {
+        while (true) {
+            if (p == end || *p != '"') return false;
+            const char* keyEnd = ScanString(p + 1, end);
+            if (!keyEnd) return false;
+            std::string_view key(p + 1, keyEnd - p - 2);
+
+            p = SkipWhitespace(keyEnd, end);
+            if (p == end || *p != ':') return false;
+            p = SkipWhitespace(p + 1, end);
+
+            const char* valueEnd = SkipValue(p, end);
+            if (!valueEnd) return false;
+            members.push_back({ key, { std::string_view(p, valueEnd - p) } });
+
+            p = SkipWhitespace(valueEnd, end);
+            if (p == end) return false;
+            if (*p == '}') {
+                p++;
+                break;
+            }
+            if (*p != ',') return false;
+            p = SkipWhitespace(p + 1, end);
+        }
+    }
+
+    return SkipWhitespace(p, end) == end;
+}
+
+bool JsonReader::ParseArray(std::string_view text, std::vector<Value>& elements) {
+    elements.clear();
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    p = SkipWhitespace(p, end);
+    if (p == end || *p != '[') return false;
+    p = SkipWhitespace(p + 1, end);
+
+    if (p < end && *p == ']') {
+        p++;
+    }
+    else {
+        while (true) {
+            const char* valueEnd = SkipValue(p, end);
+            if (!valueEnd) return false;
+            elements.push_back({ std::string_view(p, valueEnd - p) });
+
+            p = SkipWhitespace(valueEnd, end);
+            if (p == end) return false;
+            if (*p == ']') {
+                p++;
+                break;
+            }
+            if (*p != ',') return false;
+            p = SkipWhitespace(p + 1, end);
+        }
+    }
+
+    return SkipWhitespace(p, end) == end;
+}
+
+bool JsonReader::Object::Find(std::string_view key, Value& value) const {
+    // Last one wins on duplicate keys, as in the DOM
+    for (auto it = members.rbegin(); it != members.rend(); ++it) {
+        if (KeyEquals(it->key, key)) {
+            value = it->value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JsonReader::Object::Has(std::string_view key) const {
+    Value value;
+    return Find(key, value);
+}
+
+bool JsonReader::Object::GetString(std::string_view key, std::string& out) const {
+    Value value;
+    return Find(key, value) && value.GetString(out);
+}
+
+bool JsonReader::Object::GetInt(std::string_view key, int& out) const {
+    Value value;
+    return Find(key, value) && value.GetInt(out);
+}
+
+bool JsonReader::Object::GetInt64(std::string_view key, int64_t& out) const {
+    Value value;
+    return Find(key, value) && value.GetInt64(out);
+}
+
+bool JsonReader::Object::GetFloat(std::string_view key, float& out) const {
+    Value value;
+    return Find(key, value) && value.GetFloat(out);
+}
+
+bool JsonReader::Object::GetBool(std::string_view key, bool& out) const {
+    Value value;
+    return Find(key, value) && value.GetBool(out);
+}
+
+bool JsonReader::Object::GetObject(std::string_view key, Object& out) const {
+    Value value;
+    return Find(key, value) && out.Parse(value.raw);
+}
+
+bool JsonReader::Object::GetArray(std::string_view key, std::vector<Value>& elements) const {
+    Value value;
+    return Find(key, value) && ParseArray(value.raw, elements);
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+void JsonReader::RunBenchmark(const std::string& novelsRoot, uint64_t targetBytes) {
+    std::vector<std::string> documents;
+    uint64_t corpusBytes = 0;
+    std::error_code ec;
+    for (const auto& novel : std::filesystem::directory_iterator(novelsRoot, ec)) {
+        for (const auto& entry : std::filesystem::directory_iterator(novel.path() / "chapters", ec)) {
+            if (entry.path().extension() != ".json") continue;
+            std::string jsonText;
+            if (ChapterStore::ReadChapterJson(entry.path().string(), jsonText)) {
+                corpusBytes += jsonText.size();
+                documents.push_back(std::move(jsonText));
+            }
+        }
+    }
+    if (documents.empty()) {
+        std::cout << "No chapters under " << novelsRoot << std::endl;
+        return;
+    }
+
+    uint64_t passes = std::max<uint64_t>(1, targetBytes / corpusBytes);
+    std::cout << documents.size() << " chapters, " << corpusBytes / 1024 << " KB of JSON, "
+        << passes << " passes" << std::endl;
+
+    // Mirrors ChapterManager's chapter schema: number, title, content
+    struct Fields {
+        int chapterNumber = 0;
+        std::string title;
+        std::string content;
+    };
+
+    auto timePath = [&](const char* name, auto&& parse) {
+        Fields fields;
+        uint64_t checksum = 0;
+        size_t failures = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t pass = 0; pass < passes; pass++) {
+            for (const std::string& document : documents) {
+                if (!parse(document, fields)) {
+                    failures++;
+                    continue;
+                }
+                checksum += fields.chapterNumber + fields.title.size() + fields.content.size();
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double megabytes = static_cast<double>(corpusBytes) * passes / (1024.0 * 1024.0);
+        std::cout << name << ": " << megabytes / seconds << " MB/s (" << seconds * 1000.0 / (passes * documents.size())
+            << " ms per chapter, " << failures << " failed, checksum " << checksum << ")" << std::endl;
+        return seconds;
+    };
+
+    double domSeconds = timePath("nlohmann DOM", [](const std::string& document, Fields& fields) {
+        try {
+            json j = json::parse(document);
+            j.at("chapterNumber").get_to(fields.chapterNumber);
+            j.at("title").get_to(fields.title);
+            j.at("content").get_to(fields.content);
+            return true;
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    });
+
+    Object object;
+    double readerSeconds = timePath("JsonReader", [&object](const std::string& document, Fields& fields) {
+        return object.Parse(document) && object.GetInt("chapterNumber", fields.chapterNumber) &&
+            object.GetString("title", fields.title) && object.GetString("content", fields.content);
+    });
+
+    std::cout << "Speedup: " << domSeconds / readerSeconds << "x" << std::endl;
+}
+
+// ============================================================================
+// Self-test
+// ============================================================================
+bool JsonReader::RunTests() {
+    int failures = 0;
+    auto check = [&failures](bool condition, const std::string& what) {
+        if (!condition) {
+            std::cout << "FAILED: " << what << std::endl;
+            failures++;
+        }
+    };
+    auto decodes = [](std::string_view raw, std::string& out) { return Value{ raw }.GetString(out); };
+
+    // String bodies: every escape, and a special byte at each offset around the 16-byte scan
+    struct StringCase {
+        const char* raw;
+        const char* decoded;   // nullptr: must be rejected
+    };
+    static const StringCase strings[] = {
+        { "\"\"", "" },
+        { "\"plain\"", "plain" },
+        { "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"", "\"\\/\b\f\n\r\t" },
+        { "\"\\u0041\\u00e9\\u4FEE\"", "A\xC3\xA9\xE4\xBF\xAE" },
+        { "\"\\ud83d\\ude00\"", "\xF0\x9F\x98\x80" },
+        { "\"caf\xC3\xA9 \xE7\xAC\xAC \xF0\x9F\x98\x80\"", "caf\xC3\xA9 \xE7\xAC\xAC \xF0\x9F\x98\x80" },
+        { "\"\\q\"", nullptr },
+        { "\"\\u12\"", nullptr },
+        { "\"\\u12G4\"", nullptr },
+        { "\"\\udc00\"", nullptr },
+        { "\"\\ud83d\"", nullptr },
+        { "\"\\ud83dx\"", nullptr },
+        { "\"\\ud83d\\u0041\"", nullptr },
+        { "\"\xC0\x80\"", nullptr },        // Overlong
+        { "\"\xE0\x80\x80\"", nullptr },    // Overlong
+        { "\"\xED\xA0\x80\"", nullptr },    // Encoded surrogate
+        { "\"\xF4\x90\x80\x80\"", nullptr },// Past U+10FFFF
+        { "\"\xE4\xBF\"", nullptr },        // Truncated
+        { "\"\x80\"", nullptr },            // Stray continuation byte
+        { "\"\xFF\"", nullptr },
+    };
+    for (const StringCase& test : strings) {
+        std::string out;
+        bool ok = decodes(test.raw, out);
+        check(ok == (test.decoded != nullptr) && (!ok || out == test.decoded),
+            std::string("string ") + test.raw + (test.decoded ? " decodes" : " is rejected"));
+    }
+
+    {
+        std::string out;
+        check(decodes("\"\\u0000x\"", out) && out == std::string("\0x", 2), "string \\u0000 decodes to a NUL byte");
+    }
+
+    for (size_t length = 0; length <= 40; length++) {
+        for (size_t at = 0; at < length; at++) {
+            const char* specials[] = { "\\n", "\\\"", "\xC3\xA9", "\\u4fee" };
+            const char* decodedSpecials[] = { "\n", "\"", "\xC3\xA9", "\xE4\xBF\xAE" };
+            for (size_t s = 0; s < std::size(specials); s++) {
+                std::string raw = "\"" + std::string(at, 'a') + specials[s] + std::string(length - at, 'b') + "\"";
+                std::string expected = std::string(at, 'a') + decodedSpecials[s] + std::string(length - at, 'b');
+                std::string out;
+                check(decodes(raw, out) && out == expected, "special at offset " + std::to_string(at) + " of " + raw);
+            }
+        }
+
+        // An unterminated or control-character string must be found at any offset, not just in the tail
+        std::string text = "{\"k\": \"" + std::string(length, 'x');
+        Object object;
+        check(!object.Parse(text), "unterminated string of " + std::to_string(length) + " bytes is rejected");
+        check(!object.Parse(text + "\n\"}"), "raw newline after " + std::to_string(length) + " bytes is rejected");
+        check(object.Parse(text + "\\n\"}"), "escaped newline after " + std::to_string(length) + " bytes is accepted");
+    }
+
+    // Views are only handed out when there is nothing to decode; in-place decoding
+    {
+        std::string_view view;
+        check(Value{ "\"caf\xC3\xA9\"" }.GetStringView(view) && view == "caf\xC3\xA9", "string view of a plain string");
+        check(!Value{ "\"a\\nb\"" }.GetStringView(view), "no string view when there are escapes");
+        check(!Value{ "\"\xC0\x80\"" }.GetStringView(view), "no string view of malformed UTF-8");
+        check(!Value{ "12" }.GetStringView(view), "no string view of a number");
+
+        std::string buffer = "\"x\\u00e9\\ud83d\\ude00\\t\"";
+        Value value{ buffer };
+        size_t length = 0;
+        char* destination = buffer.data() + 1;
+        check(value.DecodeStringTo(destination, length) && std::string_view(destination, length) == "x\xC3\xA9\xF0\x9F\x98\x80\t",
+            "decoding in place over the escaped bytes");
+    }
+
+    // Scalars
+    {
+        int i = 0;
+        int64_t i64 = 0;
+        double d = 0;
+        float f = 0;
+        bool b = false;
+        check(Value{ "42" }.GetInt(i) && i == 42, "int");
+        check(Value{ "-0" }.GetInt(i) && i == 0, "negative zero int");
+        check(Value{ "-2147483648" }.GetInt(i) && i == INT32_MIN, "smallest int");
+        check(!Value{ "2147483648" }.GetInt(i), "int overflow is refused");
+        check(Value{ "2147483648" }.GetInt64(i64) && i64 == 2147483648ll, "int64 past int");
+        check(Value{ "9223372036854775807" }.GetInt64(i64) && i64 == INT64_MAX, "largest int64");
+        check(Value{ "-9223372036854775808" }.GetInt64(i64) && i64 == INT64_MIN, "smallest int64");
+        check(!Value{ "9223372036854775808" }.GetInt64(i64), "int64 overflow is refused");
+        check(!Value{ "1.0" }.GetInt(i) && !Value{ "1e3" }.GetInt64(i64), "fractions and exponents are not ints");
+        check(!Value{ "\"7\"" }.GetInt(i) && !Value{ "true" }.GetInt(i) && !Value{ "null" }.GetInt(i), "non-numbers are not ints");
+        const char* malformed[] = { "01", "-", "+1", "1.", ".5", "1e", "1e+", "0x10", "1 ", "" };
+        for (const char* text : malformed) check(!Value{ text }.GetDouble(d), std::string("number \"") + text + "\" is refused");
+        check(Value{ "-12.5e-1" }.GetDouble(d) && d == -1.25, "double with exponent");
+        check(Value{ "0.1" }.GetFloat(f) && f == static_cast<float>(0.1), "float through double");
+        check(Value{ "1E2" }.GetDouble(d) && d == 100.0, "capital exponent");
+        check(Value{ "true" }.GetBool(b) && b && Value{ "false" }.GetBool(b) && !b, "bools");
+        check(!Value{ "1" }.GetBool(b) && !Value{ "\"true\"" }.GetBool(b), "non-bools are not bools");
+        check(Value{ "null" }.IsNull() && !Value{ "\"null\"" }.IsNull(), "null");
+    }
+
+    // Objects
+    {
+        Object object;
+        check(object.Parse(" \r\n\t{ } \n") && !object.Has("a"), "empty object with whitespace");
+        check(object.Parse(R"({"n":1,"s":"x","o":{"a":[1,{"b":"}]"}]},"l":[],"t":true,"z":null})"), "nested object");
+        int n = 0;
+        std::string s;
+        bool t = false;
+        Object inner;
+        std::vector<Value> elements;
+        check(object.GetInt("n", n) && n == 1 && object.GetString("s", s) && s == "x" && object.GetBool("t", t) && t,
+            "members of a nested object");
+        check(object.GetObject("o", inner) && inner.GetArray("a", elements) && elements.size() == 2 &&
+            elements[1].raw == R"({"b":"}]"})", "brackets inside strings don't end containers");
+        check(object.GetArray("l", elements) && elements.empty(), "empty array member");
+        check(!object.GetString("n", s) && !object.GetInt("s", n) && !object.GetObject("l", inner) && !object.GetArray("o", elements),
+            "a member of the wrong type fails");
+        check(!object.GetInt("missing", n), "missing member fails");
+        check(object.GetOr("missing", n, 7, &Value::GetInt) && n == 7, "GetOr falls back on a missing member");
+        check(!object.GetOr("s", n, 7, &Value::GetInt), "GetOr still fails on the wrong type");
+        Value z;
+        check(object.Find("z", z) && z.IsNull(), "null member");
+
+        check(object.Parse(R"({"k":1,"k":2})") && object.GetInt("k", n) && n == 2, "the last duplicate key wins");
+        check(object.Parse(R"({"a\u0062":3,"\n":4})") && object.GetInt("ab", n) && n == 3 && object.GetInt("\n", n) && n == 4,
+            "escaped keys match their decoded form");
+
+        const char* invalid[] = {
+            "", "[]", "{", "}", "{\"a\":1", "{\"a\":1,}", "{,}", "{\"a\" 1}", "{a:1}", "{\"a\":}", "{\"a\":1}}",
+            "{\"a\":1} x", "{\"a\":[1,2}", "{\"a\":{]}", "{\"a\":tru}", "{\"a\":nul}", "{\"a\":01}", "{\"a\":1 2}",
+            "{\"a\":'x'}", "{'a':1}", "{\"a\":1}{}",
+        };
+        for (const char* text : invalid) check(!object.Parse(text), std::string("object ") + text + " is rejected");
+
+        std::string deep = "{\"a\":" + std::string(255, '[') + std::string(255, ']') + "}";
+        check(object.Parse(deep), "255 nested arrays are read");
+        deep = "{\"a\":" + std::string(300, '[') + std::string(300, ']') + "}";
+        check(!object.Parse(deep), "too deep nesting is left to the DOM parser");
+    }
+
+    // Arrays
+    {
+        std::vector<Value> elements;
+        check(JsonReader::ParseArray(" [ 1 , \"a,b\" , [2,3] , {\"c\":[]} , null ] ", elements) && elements.size() == 5 &&
+            elements[1].raw == "\"a,b\"" && elements[2].raw == "[2,3]" && elements[3].raw == "{\"c\":[]}" && elements[4].IsNull(),
+            "array elements");
+        check(JsonReader::ParseArray("[]", elements) && elements.empty(), "empty array");
+        const char* invalid[] = { "", "{}", "[", "[1,]", "[,1]", "[1 2]", "[1]]", "[1],", "[\"a]" };
+        for (const char* text : invalid) check(!JsonReader::ParseArray(text, elements), std::string("array ") + text + " is rejected");
+    }
+
+    // Against the DOM: random chapters written by nlohmann, escaped both ways, read back field by field
+    {
+        uint32_t seed = 12345;
+        auto next = [&seed]() {
+            seed = seed * 1103515245 + 12345;
+            return seed >> 8;
+        };
+        Object object;
+        for (int document = 0; document < 500; document++) {
+            std::string content;
+            int length = static_cast<int>(next() % 300);
+            for (int i = 0; i < length; i++) {
+                uint32_t kind = next() % 10;
+                uint32_t cp;
+                if (kind < 5) cp = 0x20 + next() % 0x5F;
+                else if (kind == 5) cp = next() % 0x20;
+                else if (kind == 6) cp = "\"\\/"[next() % 3];
+                else if (kind == 7) cp = 0x80 + next() % 0x780;
+                else if (kind == 8) cp = 0x800 + next() % 0xD000;   // Stays below the surrogates
+                else cp = 0x10000 + next() % 0x100000;
+                char bytes[4];
+                char* out = bytes;
+                EncodeUtf8(out, cp);
+                content.append(bytes, out);
+            }
+
+            json j;
+            j["chapterNumber"] = static_cast<int>(next()) - 8000000;
+            j["title"] = "Chapter \xE2\x80\x94 " + std::to_string(document);
+            j["content"] = content;
+            j["wordCount"] = static_cast<int64_t>(next()) * 4096;
+            j["ratio"] = (next() % 100000) / 997.0;
+            bool ascii = document % 2 == 1;
+            std::string text = j.dump(document % 3 == 0 ? -1 : 2, ' ', ascii);
+
+            int chapterNumber = 0;
+            int64_t wordCount = 0;
+            double ratio = 0;
+            std::string title, decoded;
+            Value value;
+            bool ok = object.Parse(text) && object.GetInt("chapterNumber", chapterNumber) && object.GetString("title", title) &&
+                object.GetString("content", decoded) && object.GetInt64("wordCount", wordCount) && object.Find("ratio", value) &&
+                value.GetDouble(ratio);
+            if (!ok || chapterNumber != j["chapterNumber"].get<int>() || title != j["title"].get<std::string>() ||
+                decoded != content || wordCount != j["wordCount"].get<int64_t>() || ratio != j["ratio"].get<double>()) {
+                check(false, "document " + std::to_string(document) + " differs from the DOM");
+                break;
+            }
+        }
+    }
+
+    std::cout << (failures == 0 ? "JSON reader tests passed" : "JSON reader tests FAILED (" +
+        std::to_string(failures) + ")") << std::endl;
+    return failures == 0;
+}
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <sstream>
 #include <regex>
+#include <bit>
 #include "ImGui/imgui_impl_vulkan.h"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -27,6 +28,24 @@ namespace {
     constexpr float COVER_AREA_HEIGHT = 180.0f;
     constexpr float INFO_PANEL_COVER_WIDTH = 200.0f;
     constexpr int CHAPTER_GRID_COLUMNS = 3;
+    constexpr int GRID_PREFETCH_ROWS = 1;
+    constexpr size_t MAX_FILTER_RESULTS = 2000;
+
+    // Online search starts once typing pauses, and only for queries long enough to be useful
+    constexpr auto ONLINE_SEARCH_DEBOUNCE = std::chrono::milliseconds(500);
+    constexpr size_t ONLINE_SEARCH_MIN_LENGTH = 3;
+    constexpr float SEARCH_THUMB_WIDTH = 60.0f;
+    constexpr float SEARCH_THUMB_HEIGHT = 80.0f;
+
+    // List view column ids, stable across column reordering
+    enum ListColumn : ImGuiID {
+        LIST_COLUMN_COVER = 0,
+        LIST_COLUMN_TITLE,
+        LIST_COLUMN_AUTHOR,
+        LIST_COLUMN_PROGRESS,
+        LIST_COLUMN_LAST_READ,
+        LIST_COLUMN_CHAPTERS
+    };
 
     // Helper function to truncate text
     std::string TruncateText(const std::string& text, size_t maxLength) {
@@ -35,37 +54,83 @@ namespace {
     }
 }
 
-// JSON serialization for Novel structures
-void to_json(json& j, const Library::Novel::Progress& p) {
-    j = json{
-        {"readchapters", p.readchapters},
-        {"progresspercentage", p.progresspercentage}
-    };
-}
+// ============================================================================
+// Fast JSON readers
+// ============================================================================
+// On-demand readers for the files the app writes itself. Each returns false on anything it
+// doesn't expect, and the caller then goes through nlohmann::json exactly as before.
+namespace {
+    bool ReadTextFile(const std::string& path, std::string& out) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
 
-void from_json(const json& j, Library::Novel::Progress& p) {
-    j.at("readchapters").get_to(p.readchapters);
-    j.at("progresspercentage").get_to(p.progresspercentage);
-}
+    bool ReadReadingPositionFields(std::string_view jsonText, Library::ReadingPosition& pos) {
+        JsonReader::Object object;
+        int type = 0;
+        int64_t lastRead = 0;
+        if (!object.Parse(jsonText) ||
+            !object.GetOr("contentName", pos.contentName, std::string(), &JsonReader::Value::GetString) ||
+            !object.GetOr("type", type, 0, &JsonReader::Value::GetInt) ||
+            !object.GetOr("currentChapter", pos.currentChapter, 1, &JsonReader::Value::GetInt) ||
+            !object.GetOr("scrollPosition", pos.scrollPosition, 0.0f, &JsonReader::Value::GetFloat) ||
+            !object.GetOr("currentPage", pos.currentPage, 0, &JsonReader::Value::GetInt) ||
+            !object.GetOr("lastRead", lastRead, int64_t{ 0 }, &JsonReader::Value::GetInt64)) {
+            return false;
+        }
+        pos.type = static_cast<Library::ContentType>(type);
+        pos.lastRead = static_cast<std::time_t>(lastRead);
+        return true;
+    }
 
-void to_json(json& j, const Library::Novel& n) {
-    j = json{
-        {"name", n.name},
-        {"authorname", n.authorname},
-        {"coverpath", n.coverpath},
-        {"synopsis", n.synopsis},
-        {"totalchapters", n.totalchapters},
-        {"progress", n.progress}
-    };
-}
+    Library::ReadingPosition ParseReadingPosition(const std::string& jsonText) {
+        Library::ReadingPosition pos;
+        if (ReadReadingPositionFields(jsonText, pos)) return pos;
+
+        json j = json::parse(jsonText);
+        pos.contentName = j.value("contentName", "");
+        pos.type = static_cast<Library::ContentType>(j.value("type", 0));
+        pos.currentChapter = j.value("currentChapter", 1);
+        pos.scrollPosition = j.value("scrollPosition", 0.0f);
+        pos.currentPage = j.value("currentPage", 0);
+        pos.lastRead = j.value("lastRead", std::time_t{ 0 });
+        return pos;
+    }
 
-void from_json(const json& j, Library::Novel& n) {
-    j.at("name").get_to(n.name);
-    j.at("authorname").get_to(n.authorname);
-    j.at("coverpath").get_to(n.coverpath);
-    j.at("synopsis").get_to(n.synopsis);
-    j.at("totalchapters").get_to(n.totalchapters);
-    j.at("progress").get_to(n.progress);
+    bool ReadDownloadStateList(std::string_view jsonText, std::vector<Library::DownloadState>& states) {
+        JsonReader::Object root;
+        std::vector<JsonReader::Value> elements;
+        if (!root.Parse(jsonText)) return false;
+        states.clear();
+        if (!root.Has("downloads")) return true;
+        if (!root.GetArray("downloads", elements)) return false;
+
+        for (const JsonReader::Value& element : elements) {
+            JsonReader::Object object;
+            Library::DownloadState state;
+            int type = 0;
+            int64_t lastUpdate = 0;
+            if (!object.Parse(element.raw) ||
+                !object.GetOr("id", state.id, std::string(), &JsonReader::Value::GetString) ||
+                !object.GetOr("contentName", state.contentName, std::string(), &JsonReader::Value::GetString) ||
+                !object.GetOr("type", type, 0, &JsonReader::Value::GetInt) ||
+                !object.GetOr("currentChapter", state.currentChapter, 0, &JsonReader::Value::GetInt) ||
+                !object.GetOr("totalChapters", state.totalChapters, 0, &JsonReader::Value::GetInt) ||
+                !object.GetOr("isPaused", state.isPaused, false, &JsonReader::Value::GetBool) ||
+                !object.GetOr("isComplete", state.isComplete, false, &JsonReader::Value::GetBool) ||
+                !object.GetOr("progress", state.progress, 0.0f, &JsonReader::Value::GetFloat) ||
+                !object.GetOr("lastError", state.lastError, std::string(), &JsonReader::Value::GetString) ||
+                !object.GetOr("lastUpdate", lastUpdate, int64_t{ 0 }, &JsonReader::Value::GetInt64)) {
+                return false;
+            }
+            state.type = static_cast<Library::ContentType>(type);
+            state.lastUpdate = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(lastUpdate));
+            states.push_back(std::move(state));
+        }
+        return true;
+    }
 }
 
 // Constructor and Destructor
@@ -73,6 +138,16 @@ Library::Library(ImGuiApp::Application* application) : app(application) {
     chaptermanager = ChapterManager();
     InitializeUIFonts();
     InitializeDownloadSources();
+    searchIndex.Open("index");
+    indexingPipeline = std::make_unique<IndexingPipeline>("Novels", "index");
+    chapterTiering = std::make_unique<ChapterTiering>("Novels");
+    integrityScanner = std::make_unique<IntegrityScanner>("Novels", "Manga");
+    // Configures the shared TaskScheduler, so it comes before anything submits to it
+    LoadStorageSettings();
+    indexingPipeline->Start();
+    chapterTiering->Start();
+    integrityScanner->Start();
+    AttachToDaemon();
 }
 
 Library::~Library() {
@@ -80,29 +155,47 @@ Library::~Library() {
 
     shouldTerminateDownloads = true;
 
+    // The daemon's downloads carry on without us
+    if (daemonWatch) {
+        daemonWatch->Close();
+    }
+    if (daemonWatcher && daemonWatcher->joinable()) {
+        daemonWatcher->join();
+    }
+
     // Save all persistent data before cleanup
     SaveDownloadStates();
     SaveAllReadingPositions();
-    SaveNovels(novellist);
+    SaveNovels();
 
-    // Signal all active processes to stop
-    {
-        std::lock_guard<std::mutex> lock(downloadStateMutex);
-        for (auto& [id, processInfo] : activeProcesses) {
-            processInfo.shouldTerminate.store(true);
+    // Downloads stop after the request they are on and resume from there next time
+    StopDownloadManager();
 
-            // Create stop signal
-            std::string stopSignalFile = "downloads/.stop_" + id;
-            std::filesystem::create_directories("downloads");
-            std::ofstream stopFile(stopSignalFile);
-            if (stopFile.is_open()) {
-                stopFile << "TERMINATE" << std::endl;
-                stopFile.close();
-            }
-        }
+    // Abandon any indexing in progress; the last published manifest stays valid
+    if (indexingPipeline) {
+        indexingPipeline->Stop();
+    }
+    if (searchIndexRefreshTask.IsValid()) {
+        searchIndexRefreshTask.Wait();
+    }
+    if (chapterTiering) {
+        chapterTiering->Stop();
+    }
+    if (integrityScanner) {
+        integrityScanner->Stop();
     }
 
-    StopDownloadManager();
+    // The import in progress finishes; queued ones are dropped
+    {
+        std::lock_guard<std::mutex> lock(importMutex);
+        importQueue.clear();
+    }
+    if (importWorker && importWorker->joinable()) {
+        importWorker->join();
+    }
+    if (exportWorker && exportWorker->joinable()) {
+        exportWorker->join();
+    }
 
     // Wait for all threads to finish properly
     {
@@ -117,10 +210,6 @@ Library::~Library() {
         activeProcesses.clear();
     }
 
-    // Clean up stop signals
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    CleanupStopSignals();
-
     std::cout << "Library destructor: Cleanup completed" << std::endl;
 
     CleanupTextures();
@@ -653,12 +742,15 @@ void Library::LoadMangaChapter(const std::string& mangaName, int chapter) {
     std::string metadataPath = chapterDir + "/metadata.json";
     if (std::filesystem::exists(metadataPath)) {
         try {
-            std::ifstream file(metadataPath);
-            json j;
-            file >> j;
-            file.close();
-
-            mangaViewer.totalPages = j.value("page_count", 0);
+            std::string jsonText;
+            ReadTextFile(metadataPath, jsonText);
+
+            JsonReader::Object object;
+            if (!object.Parse(jsonText) ||
+                !object.GetOr("page_count", mangaViewer.totalPages, 0, &JsonReader::Value::GetInt)) {
+                json j = json::parse(jsonText);
+                mangaViewer.totalPages = j.value("page_count", 0);
+            }
         }
         catch (...) {
             mangaViewer.totalPages = 0;
@@ -826,6 +918,15 @@ void Library::RenderSearchFilters() {
     ImGui::SameLine();
     ImGui::Checkbox("Show Adult Content", &currentSearchFilter.showAdult);
 
+    ImGui::SameLine();
+    ImGui::Text("Cache (min):");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    ImGui::SliderInt("##CacheTtl", &currentSearchFilter.cacheTtlMinutes, 0, 24 * 60);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("How long a source's answer to the same query is reused. 0 always asks the source.");
+    }
+
     // Language filter
     ImGui::Text("Language:");
     ImGui::SameLine();
@@ -852,6 +953,10 @@ void Library::SaveReadingPosition(const std::string& contentName, ContentType ty
         pos.lastRead = std::time(nullptr);
 
         readingPositions[contentName] = pos;
+        catalogVersion++;
+        if (type == ContentType::NOVEL && chapterTiering) {
+            chapterTiering->UpdatePosition(contentName, chapter, pos.lastRead);
+        }
 
         // Save to file
         json j;
@@ -881,23 +986,12 @@ Library::ReadingPosition Library::LoadReadingPosition(const std::string& content
         std::string filename = "reading_positions/" +
             std::regex_replace(contentName, std::regex("[^a-zA-Z0-9]"), "_") + ".json";
 
-        std::ifstream file(filename);
-        if (!file.is_open()) {
+        std::string jsonText;
+        if (!ReadTextFile(filename, jsonText)) {
             return ReadingPosition();
         }
 
-        json j;
-        file >> j;
-        file.close();
-
-        ReadingPosition pos;
-        pos.contentName = j.value("contentName", "");
-        pos.type = static_cast<ContentType>(j.value("type", 0));
-        pos.currentChapter = j.value("currentChapter", 1);
-        pos.scrollPosition = j.value("scrollPosition", 0.0f);
-        pos.currentPage = j.value("currentPage", 0);
-        pos.lastRead = j.value("lastRead", std::time_t{ 0 });
-
+        ReadingPosition pos = ParseReadingPosition(jsonText);
         readingPositions[contentName] = pos;
         return pos;
     }
@@ -916,23 +1010,16 @@ void Library::LoadAllReadingPositions() {
 
         for (const auto& entry : std::filesystem::directory_iterator(posDir)) {
             if (entry.path().extension() == ".json") {
-                std::ifstream file(entry.path());
-                if (file.is_open()) {
-                    json j;
-                    file >> j;
-                    file.close();
-
-                    std::string contentName = j.value("contentName", "");
+                std::string jsonText;
+                if (ReadTextFile(entry.path().string(), jsonText)) {
+                    ReadingPosition pos = ParseReadingPosition(jsonText);
+                    const std::string& contentName = pos.contentName;
                     if (!contentName.empty()) {
-                        ReadingPosition pos;
-                        pos.contentName = contentName;
-                        pos.type = static_cast<ContentType>(j.value("type", 0));
-                        pos.currentChapter = j.value("currentChapter", 1);
-                        pos.scrollPosition = j.value("scrollPosition", 0.0f);
-                        pos.currentPage = j.value("currentPage", 0);
-                        pos.lastRead = j.value("lastRead", std::time_t{ 0 });
-
                         readingPositions[contentName] = pos;
+                        catalogVersion++;
+                        if (pos.type == ContentType::NOVEL && chapterTiering) {
+                            chapterTiering->UpdatePosition(contentName, pos.currentChapter, pos.lastRead);
+                        }
                     }
                 }
             }
@@ -1006,18 +1093,7 @@ void Library::CheckNovelFolderStructure(const std::string& novelName) {
 }
 
 int Library::CountChaptersInDirectory(const std::string& novelName) {
-    std::string chaptersDir = "Novels/" + novelName + "/chapters";
-    if (!std::filesystem::exists(chaptersDir)) {
-        return 0;
-    }
-
-    int count = 0;
-    for (const auto& entry : std::filesystem::directory_iterator(chaptersDir)) {
-        if (entry.path().extension() == ".json") {
-            count++;
-        }
-    }
-    return count;
+    return Catalog::CountChapters("Novels", novelName);
 }
 
 // ============================================================================
@@ -1052,41 +1128,17 @@ void Library::RefreshNovelChapterCounts() {
             std::cout << "Updated " << novel.name << " chapter count to " << chapterCount << std::endl;
         }
     }
-    SaveNovels(novellist);
+    SaveNovels();
 }
 
 void Library::LoadAllNovelsFromFile() {
-    try {
-        std::ifstream file("Novels/Novels.json");
-        if (!file.is_open()) {
-            std::cout << "No existing novels file found" << std::endl;
-            return;
-        }
-
-        json j;
-        file >> j;
-        file.close();
-
-        if (j.contains("novels")) {
-            novellist = j["novels"].get<std::vector<Novel>>();
+    std::vector<Novel> novels;
+    if (!Catalog::Load("Novels", novels)) return;
 
-            // Update downloaded chapter counts for all novels
-            for (auto& novel : novellist) {
-                novel.downloadedchapters = CountChaptersInDirectory(novel.name);
-
-                // If downloadedchapters wasn't in the JSON, initialize it
-                if (novel.downloadedchapters == 0 && novel.totalchapters > 0) {
-                    novel.downloadedchapters = novel.totalchapters; // Assume all are downloaded for existing novels
-                }
-            }
-
-            std::cout << "Successfully loaded " << novellist.size() << " novels" << std::endl;
-        }
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error loading novels: " << e.what() << std::endl;
-        novellist.clear();
-    }
+    novellist = std::move(novels);
+    catalogVersion++;
+    catalogSearch.Clear();
+    catalogSearchBuilt = false;
 }
 
 void Library::UpdateReadingProgress(const std::string& novelName, int chapterNumber) {
@@ -1097,8 +1149,15 @@ void Library::UpdateReadingProgress(const std::string& novelName, int chapterNum
                 novel.progress.readchapters = chapterNumber;
             }
 
-            // Calculate percentage based on downloaded chapters
-            if (novel.downloadedchapters > 0) {
+            // By words once the novel has been measured at ingest, otherwise by downloaded chapters
+            RefreshTextStats(novel);
+            const ChapterText::NovelStats& textStats = textStatsView.stats;
+            if (textStats.totalWords > 0) {
+                uint64_t unread = textStats.WordsFrom(novel.progress.readchapters + 1);
+                novel.progress.progresspercentage =
+                    (1.0f - static_cast<float>(unread) / static_cast<float>(textStats.totalWords)) * 100.0f;
+            }
+            else if (novel.downloadedchapters > 0) {
                 novel.progress.progresspercentage =
                     (static_cast<float>(novel.progress.readchapters) / static_cast<float>(novel.downloadedchapters)) * 100.0f;
             }
@@ -1108,7 +1167,7 @@ void Library::UpdateReadingProgress(const std::string& novelName, int chapterNum
                 novel.progress.progresspercentage = 100.0f;
             }
 
-            SaveNovels(novellist);
+            SaveNovels();
             std::cout << "Updated reading progress for " << novelName << " to chapter " << chapterNumber
                 << " (" << novel.progress.progresspercentage << "%)" << std::endl;
             break;
@@ -1116,57 +1175,28 @@ void Library::UpdateReadingProgress(const std::string& novelName, int chapterNum
     }
 }
 
-bool Library::SaveNovels(const std::vector<Novel>& novels) {
-    try {
-        CheckNovelsDirectory();
-
-        for (const auto& novel : novels) {
-            CheckNovelFolderStructure(novel.name);
-        }
-
-        json j;
-        j["novels"] = novels;
-
-        std::ofstream file("Novels/Novels.json");
-        if (!file.is_open()) {
-            std::cerr << "Error: Could not open file for writing" << std::endl;
-            return false;
-        }
-
-        file << j.dump(4);
-        file.close();
-
-        std::cout << "Successfully saved " << novels.size() << " novels" << std::endl;
-        return true;
-    }
-    catch (const std::exception& e) {
-        std::cerr << "Error saving novels: " << e.what() << std::endl;
-        return false;
-    }
+bool Library::SaveNovels() {
+    // Callers may hold references into novellist, so novels found in the file are listed later
+    std::vector<Novel> catalogued;
+    if (!Catalog::Save("Novels", novellist, removedNovelNames, &catalogued)) return false;
+    removedNovelNames.clear();
+    pendingCatalogued.insert(pendingCatalogued.end(), catalogued.begin(), catalogued.end());
+    catalogVersion++;
+    return true;
 }
 
 bool Library::AddNovel(const Novel& novel) {
     try {
-        CheckNovelFolderStructure(novel.name);
-
-        // Check for duplicates
-        for (const auto& existingNovel : novellist) {
-            if (existingNovel.name == novel.name && existingNovel.authorname == novel.authorname) {
-                std::cout << "Novel '" << novel.name << "' by " << novel.authorname
-                    << " already exists. Skipping save." << std::endl;
-                return false;
+        size_t listed = novellist.size();
+        bool saved = Catalog::Add("Novels", novellist, novel);
+        if (novellist.size() > listed) {
+            catalogVersion++;
+            if (catalogSearchBuilt) {
+                const Novel& added = novellist.back();
+                catalogSearch.Add(added.name, added.authorname, added.synopsis);
             }
         }
-
-        Novel novelToSave = novel;
-        std::string expectedCoverPath = "Novels/" + novel.name + "/cover.jpg";
-        if (novelToSave.coverpath != expectedCoverPath) {
-            novelToSave.coverpath = expectedCoverPath;
-        }
-
-        novellist.push_back(novelToSave);
-        return SaveNovels(novellist);
-
+        return saved;
     }
     catch (const std::exception& e) {
         std::cerr << "Error saving single novel: " << e.what() << std::endl;
@@ -1183,8 +1213,10 @@ bool Library::RemoveNovel(const std::string& novelName, const std::string& autho
 
         if (it != novellist.end()) {
             novellist.erase(it, novellist.end());
+            catalogSearch.Remove(novelName, authorName);
+            removedNovelNames.push_back(novelName);
 
-            if (SaveNovels(novellist)) {
+            if (SaveNovels()) {
                 std::cout << "Successfully removed novel '" << novelName
                     << "' by " << authorName << std::endl;
 
@@ -1194,6 +1226,13 @@ bool Library::RemoveNovel(const std::string& novelName, const std::string& autho
                     std::filesystem::remove_all(novelDir);
                     std::cout << "Removed novel folder: " << novelDir << std::endl;
                 }
+                if (indexingPipeline) {
+                    indexingPipeline->EnqueueRemoveNovel(novelName);
+                }
+                if (chapterTiering) {
+                    // Collects the blobs only this novel linked to
+                    chapterTiering->RequestSweep();
+                }
                 return true;
             }
         }
@@ -1218,11 +1257,22 @@ void Library::Render() {
         InitializeUIFonts();
     }
 
+    PollSearchIndex();
+    PollOnlineSearch();
+    PollIntegrityScanner();
+    PollImports();
+    PollDaemon();
+
     switch (currentState) {
     case UIState::LIBRARY:
         RenderLibraryInterface();
         break;
     case UIState::READING:
+        // The scanner backs off while someone is reading
+        if (integrityScanner) {
+            integrityScanner->NotifyReaderActivity();
+        }
+
         // Check content type
         if (readingPositions.count(currentNovelName) > 0) {
             auto& pos = readingPositions[currentNovelName];
@@ -1272,6 +1322,14 @@ void Library::RenderMainTabs() {
             ImGui::EndTabItem();
         }
 
+        if (ImGui::BeginTabItem(ICON_FA_MAGNIFYING_GLASS " Search")) {
+            currentLibraryTab = 2;
+            RestoreUIState();
+            RenderLibrarySearch();
+            PrepareUIState();
+            ImGui::EndTabItem();
+        }
+
         ImGui::EndTabBar();
     }
 
@@ -1321,6 +1379,8 @@ void Library::RenderSplitView(const ImVec2& windowSize) {
 void Library::RenderNovelGrid() {
     RenderGridHeader();
     ImGui::Spacing();
+    RenderLibraryFilterInput();
+    ApplyLibraryFilter();
     ImGui::Separator();
     ImGui::Spacing();
 
@@ -1349,9 +1409,17 @@ void Library::RenderGridHeader() {
 
         ImGui::SameLine();
 
-        float toggleStart = availableSize.x - 200;
+        float toggleStart = availableSize.x - 290;
         ImGui::SetCursorPosX(toggleStart);
 
+        std::string importText = std::string(ICON_FA_FILE_IMPORT) + " Import";
+        if (ImGui::Button(importText.c_str(), ImVec2(80, 0))) {
+            ImGui::OpenPopup("ImportBooks");
+        }
+        RenderImportPopup();
+
+        ImGui::SameLine();
+
         const char* viewIcon = showGrid ? ICON_FA_LIST : ICON_FA_THERMOMETER;
         const char* viewText = showGrid ? " List View" : " Grid View";
         std::string buttonText = std::string(viewIcon) + viewText;
@@ -1375,58 +1443,97 @@ void Library::RenderNovelGridView() {
     int columns = CalculateGridColumns(availableSize.x);
 
     ImGui::BeginChild("NovelGrid", ImVec2(0, 0), false);
+    ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(CARD_SPACING, CARD_SPACING));
 
-    // Use traditional ImGui layout instead of SetCursorPos
-    for (size_t i = 0; i < novellist.size(); i++) {
-        // Start new row if needed
-        if (i > 0 && i % columns == 0) {
-            ImGui::Spacing();
-        }
+    // Every row has the same pitch, so the visible rows follow directly from the scroll offset
+    const float rowHeight = CARD_HEIGHT + CARD_SPACING;
+    const int novelCount = FilteredNovelCount();
+    const int totalRows = (novelCount + columns - 1) / columns;
 
-        // Use SameLine for columns (except first in row)
-        if (i % columns != 0) {
-            ImGui::SameLine(0, CARD_SPACING);
-        }
+    float scrollY = ImGui::GetScrollY();
+    float viewHeight = ImGui::GetWindowHeight();
+    int firstRow = std::clamp(static_cast<int>(scrollY / rowHeight), 0, totalRows);
+    int lastRow = std::clamp(static_cast<int>((scrollY + viewHeight) / rowHeight) + 1, firstRow, totalRows);
+
+    // Spacer standing in for the rows scrolled off the top
+    if (firstRow > 0) {
+        ImGui::Dummy(ImVec2(1.0f, firstRow * rowHeight - CARD_SPACING));
+    }
 
-        // Create a child window for consistent card sizing
-        ImGui::PushID(static_cast<int>(i));
+    for (int row = firstRow; row < lastRow; row++) {
+        for (int col = 0; col < columns; col++) {
+            int position = row * columns + col;
+            if (position >= novelCount) break;
+            int i = FilteredNovelAt(position);
 
-        // Begin child with exact card dimensions
-        if (ImGui::BeginChild("NovelCard", ImVec2(CARD_WIDTH, CARD_HEIGHT), false,
-            ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoBackground)) {
+            // Use SameLine for columns (except first in row)
+            if (col != 0) {
+                ImGui::SameLine(0, CARD_SPACING);
+            }
 
-            // Get the screen position for this child window
-            ImVec2 cardStart = ImGui::GetCursorScreenPos();
-            ImVec2 cardEnd = ImVec2(cardStart.x + CARD_WIDTH, cardStart.y + CARD_HEIGHT);
+            // Create a child window for consistent card sizing
+            ImGui::PushID(i);
 
-            bool isSelected = (selectedNovelIndex == static_cast<int>(i));
+            // Begin child with exact card dimensions
+            if (ImGui::BeginChild("NovelCard", ImVec2(CARD_WIDTH, CARD_HEIGHT), false,
+                ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoBackground)) {
 
-            // Render card background
-            RenderCardBackground(cardStart, cardEnd, isSelected);
+                // Get the screen position for this child window
+                ImVec2 cardStart = ImGui::GetCursorScreenPos();
+                ImVec2 cardEnd = ImVec2(cardStart.x + CARD_WIDTH, cardStart.y + CARD_HEIGHT);
 
-            // Create invisible button for interaction
-            ImGui::InvisibleButton("CardInteraction", ImVec2(CARD_WIDTH, CARD_HEIGHT));
-            if (ImGui::IsItemClicked()) {
-                selectedNovelIndex = static_cast<int>(i);
-                showInfoPanel = true;
-            }
+                bool isSelected = (selectedNovelIndex == i);
 
-            // Render card content
-            RenderCardContent(novellist[i], cardStart, isSelected);
+                // Render card background
+                RenderCardBackground(cardStart, cardEnd, isSelected);
 
-            // Add hover effect
-            if (ImGui::IsItemHovered()) {
-                ImDrawList* drawList = ImGui::GetWindowDrawList();
-                drawList->AddRect(cardStart, cardEnd, IM_COL32(150, 170, 200, 200), 8.0f, 0, 2.0f);
+                // Create invisible button for interaction
+                ImGui::InvisibleButton("CardInteraction", ImVec2(CARD_WIDTH, CARD_HEIGHT));
+                if (ImGui::IsItemClicked()) {
+                    selectedNovelIndex = i;
+                    showInfoPanel = true;
+                }
+
+                // Render card content
+                RenderCardContent(novellist[i], cardStart, isSelected);
+
+                // Add hover effect
+                if (ImGui::IsItemHovered()) {
+                    ImDrawList* drawList = ImGui::GetWindowDrawList();
+                    drawList->AddRect(cardStart, cardEnd, IM_COL32(150, 170, 200, 200), 8.0f, 0, 2.0f);
+                }
             }
+            ImGui::EndChild();
+            ImGui::PopID();
         }
-        ImGui::EndChild();
-        ImGui::PopID();
     }
 
+    // Spacer for the rows below the viewport keeps the scrollbar range intact
+    if (lastRow < totalRows) {
+        ImGui::Dummy(ImVec2(1.0f, (totalRows - lastRow) * rowHeight - CARD_SPACING));
+    }
+
+    // Warm covers one row beyond each edge so scrolling doesn't hitch on a full row of loads
+    int prefetchStart = std::max(0, firstRow - GRID_PREFETCH_ROWS) * columns;
+    int prefetchEnd = std::min(totalRows, lastRow + GRID_PREFETCH_ROWS) * columns;
+    PrefetchCoverTextures(prefetchStart, std::min(prefetchEnd, novelCount));
+
+    ImGui::PopStyleVar();
     ImGui::EndChild();
 }
 
+void Library::PrefetchCoverTextures(int startIndex, int endIndex) {
+    // Visible cards load their own covers; this only picks up near-visible ones,
+    // one per frame, so a fast scroll never stalls on a burst of decodes
+    for (int i = startIndex; i < endIndex; i++) {
+        const std::string& coverPath = novellist[FilteredNovelAt(i)].coverpath;
+        if (coverTextures.find(coverPath) == coverTextures.end()) {
+            LoadCoverTexture(coverPath);
+            return;
+        }
+    }
+}
+
 int Library::CalculateGridColumns(float availableWidth) {
     int columns = static_cast<int>((availableWidth + CARD_SPACING) / (CARD_WIDTH + CARD_SPACING));
     return std::max(1, columns);
@@ -1522,8 +1629,9 @@ void Library::RenderCardContent(const Novel& novel, const ImVec2& cardStart, boo
     drawList->AddText(ImVec2(infoStart.x, infoStart.y + 18), IM_COL32(204, 204, 153, 255), authorText.c_str());
 
     // Chapters
-    std::string chapterText = std::to_string(novel.downloadedchapters) + "/" + std::to_string(novel.totalchapters) + " chapters";
-    drawList->AddText(ImVec2(infoStart.x, infoStart.y + 36), IM_COL32(180, 180, 180, 255), chapterText.c_str());
+    char chapterText[64];
+    snprintf(chapterText, sizeof(chapterText), "%d/%d chapters", novel.downloadedchapters, novel.totalchapters);
+    drawList->AddText(ImVec2(infoStart.x, infoStart.y + 36), IM_COL32(180, 180, 180, 255), chapterText);
 
     // Progress bar
     ImVec2 progressStart = ImVec2(infoStart.x, infoStart.y + 54);
@@ -1540,8 +1648,9 @@ void Library::RenderCardContent(const Novel& novel, const ImVec2& cardStart, boo
     }
 
     // Progress text
-    std::string progressText = std::to_string(static_cast<int>(novel.progress.progresspercentage)) + "% complete";
-    drawList->AddText(ImVec2(infoStart.x, infoStart.y + 72), IM_COL32(180, 180, 180, 255), progressText.c_str());
+    char progressText[32];
+    snprintf(progressText, sizeof(progressText), "%d%% complete", static_cast<int>(novel.progress.progresspercentage));
+    drawList->AddText(ImVec2(infoStart.x, infoStart.y + 72), IM_COL32(180, 180, 180, 255), progressText);
 }
 
 void Library::RenderCardCover(const Novel& novel, const ImVec2& cardStart) {
@@ -1671,16 +1780,38 @@ void Library::RenderCardInfo(const Novel& novel, const ImVec2& cardStart) {
 void Library::RenderNovelListView() {
     ImGui::BeginChild("NovelList", ImVec2(0, 0), true);
 
-    if (ImGui::BeginTable("NovelsTable", 5,
+    if (ImGui::BeginTable("NovelsTable", 6,
         ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg |
         ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable)) {
 
         SetupTableColumns();
+        ImGui::TableSetupScrollFreeze(0, 1);
         ImGui::TableHeadersRow();
 
-        for (int i = 0; i < static_cast<int>(novellist.size()); i++) {
-            RenderTableRow(novellist[i], i);
+        RebuildListSortKeys();
+
+        if (ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs()) {
+            if (sortSpecs->SpecsDirty && sortSpecs->SpecsCount > 0) {
+                listView.sortColumn = sortSpecs->Specs[0].ColumnUserID;
+                listView.sortAscending = sortSpecs->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+                listView.sortValid = false;
+                listView.rankByRelevance = false;
+            }
+            sortSpecs->SpecsDirty = false;
+        }
+
+        SortListRows();
+
+        // Rows have a fixed height (cover thumbnail), so the clipper can skip everything off screen
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(listView.rows.size()));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                int index = listView.rows[row];
+                RenderTableRow(novellist[index], index);
+            }
         }
+        clipper.End();
 
         ImGui::EndTable();
     }
@@ -1688,12 +1819,190 @@ void Library::RenderNovelListView() {
     ImGui::EndChild();
 }
 
+// ============================================================================
+// Library filter
+// ============================================================================
+
+void Library::RenderLibraryFilterInput() {
+    ImGui::SetNextItemWidth(-120.0f);
+    if (ImGui::InputTextWithHint("##LibraryFilter", ICON_FA_MAGNIFYING_GLASS " Filter by title, author or synopsis...",
+        libraryFilter.buffer, sizeof(libraryFilter.buffer))) {
+        listView.rankByRelevance = true;
+    }
+
+    if (libraryFilter.active) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%zu found, %.2f ms", libraryFilter.ranked.size(), libraryFilter.millis);
+    }
+    ImGui::Spacing();
+}
+
+void Library::EnsureCatalogSearch() {
+    if (catalogSearchBuilt) return;
+
+    catalogSearch.Clear();
+    for (const Novel& novel : novellist) {
+        catalogSearch.Add(novel.name, novel.authorname, novel.synopsis);
+    }
+    catalogSearchBuilt = true;
+}
+
+void Library::ApplyLibraryFilter() {
+    if (libraryFilter.appliedQuery == libraryFilter.buffer && libraryFilter.appliedVersion == catalogVersion) {
+        return;
+    }
+    libraryFilter.appliedQuery = libraryFilter.buffer;
+    libraryFilter.appliedVersion = catalogVersion;
+    listView.rowsValid = false;
+
+    libraryFilter.ranked.clear();
+    libraryFilter.active = !TrigramIndex::SplitWords(TrigramIndex::FoldCase(libraryFilter.appliedQuery)).empty();
+    if (!libraryFilter.active) {
+        return;
+    }
+
+    EnsureCatalogSearch();
+
+    if (libraryFilter.indexVersion != catalogVersion) {
+        libraryFilter.indexByKey.clear();
+        libraryFilter.indexByKey.reserve(novellist.size());
+        for (int i = 0; i < static_cast<int>(novellist.size()); i++) {
+            libraryFilter.indexByKey.emplace(CatalogSearch::Key(novellist[i].name, novellist[i].authorname), i);
+        }
+        libraryFilter.indexVersion = catalogVersion;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<CatalogSearch::Match> matches;
+    catalogSearch.Search(libraryFilter.appliedQuery, MAX_FILTER_RESULTS, matches);
+    libraryFilter.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    libraryFilter.mask.assign(novellist.size(), 0);
+    for (const CatalogSearch::Match& match : matches) {
+        auto it = libraryFilter.indexByKey.find(CatalogSearch::Key(match.title, match.author));
+        if (it != libraryFilter.indexByKey.end()) {
+            libraryFilter.ranked.push_back(it->second);
+            libraryFilter.mask[it->second] = 1;
+        }
+    }
+}
+
+int Library::FilteredNovelCount() const {
+    return libraryFilter.active ? static_cast<int>(libraryFilter.ranked.size()) : static_cast<int>(novellist.size());
+}
+
+int Library::FilteredNovelAt(int position) const {
+    return libraryFilter.active ? libraryFilter.ranked[position] : position;
+}
+
 void Library::SetupTableColumns() {
-    ImGui::TableSetupColumn("Cover", ImGuiTableColumnFlags_WidthFixed, 60.0f);
-    ImGui::TableSetupColumn("Title", ImGuiTableColumnFlags_WidthFixed, 250.0f);
-    ImGui::TableSetupColumn("Author", ImGuiTableColumnFlags_WidthFixed, 180.0f);
-    ImGui::TableSetupColumn("Progress", ImGuiTableColumnFlags_WidthFixed, 120.0f);
-    ImGui::TableSetupColumn("Chapters", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+    ImGui::TableSetupColumn("Cover", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_NoSort, 60.0f, LIST_COLUMN_COVER);
+    ImGui::TableSetupColumn("Title", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_DefaultSort, 250.0f, LIST_COLUMN_TITLE);
+    ImGui::TableSetupColumn("Author", ImGuiTableColumnFlags_WidthFixed, 180.0f, LIST_COLUMN_AUTHOR);
+    ImGui::TableSetupColumn("Progress", ImGuiTableColumnFlags_WidthFixed, 120.0f, LIST_COLUMN_PROGRESS);
+    ImGui::TableSetupColumn("Last Read", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_PreferSortDescending, 110.0f, LIST_COLUMN_LAST_READ);
+    ImGui::TableSetupColumn("Chapters", ImGuiTableColumnFlags_WidthFixed, 100.0f, LIST_COLUMN_CHAPTERS);
+}
+
+void Library::RebuildListSortKeys() {
+    if (listView.keysVersion == catalogVersion && listView.keys.size() == novellist.size()) {
+        return;
+    }
+
+    const int count = static_cast<int>(novellist.size());
+    listView.keys.assign(count, ListSortKey());
+
+    for (int i = 0; i < count; i++) {
+        const Novel& novel = novellist[i];
+        ListSortKey& key = listView.keys[i];
+
+        key.foldedTitle = TrigramIndex::FoldCase(novel.name);
+        key.foldedAuthor = TrigramIndex::FoldCase(novel.authorname);
+        key.progress = novel.progress.progresspercentage;
+        key.chapters = novel.downloadedchapters;
+
+        auto posIt = readingPositions.find(novel.name);
+        key.lastRead = (posIt != readingPositions.end()) ? posIt->second.lastRead : 0;
+    }
+
+    // Rank strings once so every later sort compares integers only
+    std::vector<int> order(count);
+    for (int i = 0; i < count; i++) order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return listView.keys[a].foldedTitle < listView.keys[b].foldedTitle;
+    });
+    for (int rank = 0; rank < count; rank++) listView.keys[order[rank]].titleRank = rank;
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return listView.keys[a].foldedAuthor < listView.keys[b].foldedAuthor;
+    });
+    for (int rank = 0; rank < count; rank++) listView.keys[order[rank]].authorRank = rank;
+
+    listView.keysVersion = catalogVersion;
+    listView.sortValid = false;
+}
+
+void Library::SortListRows() {
+    const int count = static_cast<int>(novellist.size());
+
+    if (!listView.sortValid || listView.sortedOrder.size() != static_cast<size_t>(count)) {
+        listView.sortedOrder.resize(count);
+        for (int i = 0; i < count; i++) listView.sortedOrder[i] = i;
+
+        const std::vector<ListSortKey>& keys = listView.keys;
+        const ImGuiID column = listView.sortColumn;
+
+        // Compare precomputed keys only; ties fall back to title order so the result is stable
+        auto less = [&keys, column](int a, int b) {
+            const ListSortKey& ka = keys[a];
+            const ListSortKey& kb = keys[b];
+            switch (column) {
+            case LIST_COLUMN_AUTHOR:
+                if (ka.authorRank != kb.authorRank) return ka.authorRank < kb.authorRank;
+                break;
+            case LIST_COLUMN_PROGRESS:
+                if (ka.progress != kb.progress) return ka.progress < kb.progress;
+                break;
+            case LIST_COLUMN_LAST_READ:
+                if (ka.lastRead != kb.lastRead) return ka.lastRead < kb.lastRead;
+                break;
+            case LIST_COLUMN_CHAPTERS:
+                if (ka.chapters != kb.chapters) return ka.chapters < kb.chapters;
+                break;
+            default:
+                break;
+            }
+            return ka.titleRank < kb.titleRank;
+        };
+
+        if (listView.sortAscending) {
+            std::sort(listView.sortedOrder.begin(), listView.sortedOrder.end(), less);
+        }
+        else {
+            std::sort(listView.sortedOrder.begin(), listView.sortedOrder.end(),
+                [&less](int a, int b) { return less(b, a); });
+        }
+
+        listView.sortValid = true;
+        listView.rowsValid = false;
+    }
+
+    if (!listView.rowsValid) {
+        listView.rows.clear();
+        if (libraryFilter.active && listView.rankByRelevance) {
+            listView.rows = libraryFilter.ranked;
+        }
+        else {
+            for (int index : listView.sortedOrder) {
+                if (!libraryFilter.active ||
+                    (index < static_cast<int>(libraryFilter.mask.size()) && libraryFilter.mask[index])) {
+                    listView.rows.push_back(index);
+                }
+            }
+        }
+        listView.rowsValid = true;
+    }
 }
 
 void Library::RenderTableRow(const Novel& novel, int index) {
@@ -1732,8 +2041,24 @@ void Library::RenderTableRow(const Novel& novel, int index) {
     ImGui::TableSetColumnIndex(3);
     RenderProgressBar(novel.progress.progresspercentage);
 
-    // Chapters column
+    // Last read column
     ImGui::TableSetColumnIndex(4);
+    if (uiFonts.smallFont) ImGui::PushFont(uiFonts.smallFont);
+    std::time_t lastRead = (index < static_cast<int>(listView.keys.size())) ? listView.keys[index].lastRead : 0;
+    if (lastRead > 0) {
+        char dateText[32];
+        std::tm localTime{};
+        localtime_s(&localTime, &lastRead);
+        std::strftime(dateText, sizeof(dateText), "%Y-%m-%d", &localTime);
+        ImGui::TextUnformatted(dateText);
+    }
+    else {
+        ImGui::TextDisabled("Never");
+    }
+    if (uiFonts.smallFont) ImGui::PopFont();
+
+    // Chapters column
+    ImGui::TableSetColumnIndex(5);
     if (uiFonts.normalFont) ImGui::PushFont(uiFonts.normalFont);
     ImGui::Text("%d/%d", novel.progress.readchapters, novel.downloadedchapters);
     if (uiFonts.normalFont) ImGui::PopFont();
@@ -1907,7 +2232,27 @@ void Library::RenderInfoPanelDetails(const Novel& novel, float detailsWidth) {
     ImGui::EndGroup();
 }
 
+void Library::RefreshTextStats(const Novel& novel) {
+    // The sweep may rewrite the file while the novel is selected; look again every few seconds
+    auto now = std::chrono::steady_clock::now();
+    if (textStatsView.novelName == novel.name && now - textStatsView.checked < std::chrono::seconds(5)) return;
+    textStatsView.checked = now;
+
+    std::string novelDir = "Novels/" + novel.name;
+    std::error_code ec;
+    auto written = std::filesystem::last_write_time(std::filesystem::path(novelDir) / ChapterText::STATS_FILE, ec);
+    if (ec) written = std::filesystem::file_time_type();
+    if (textStatsView.novelName == novel.name && textStatsView.written == written) return;
+
+    textStatsView.novelName = novel.name;
+    textStatsView.written = written;
+    ChapterText::LoadNovelStats(novelDir, textStatsView.stats);
+}
+
 void Library::RenderStatsArea(const Novel& novel, float detailsWidth) {
+    RefreshTextStats(novel);
+    const ChapterText::NovelStats& textStats = textStatsView.stats;
+
     ImGui::BeginChild("StatsArea", ImVec2(detailsWidth, 120), true, ImGuiWindowFlags_NoScrollbar);
 
     // Downloaded Chapters
@@ -1933,6 +2278,27 @@ void Library::RenderStatsArea(const Novel& novel, float detailsWidth) {
     if (uiFonts.largeFont) ImGui::PopFont();
     ImGui::EndGroup();
 
+    // Time left, from word counts taken at ingest; nothing is read to show it
+    if (textStats.totalWords > 0) {
+        ImGui::SameLine();
+        ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 20);
+
+        uint64_t remaining = textStats.WordsFrom(novel.progress.readchapters + 1);
+        ImGui::BeginGroup();
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.8f, 1.0f, 1.0f));
+        ImGui::Text("%s Time Left", ICON_FA_CLOCK);
+        ImGui::PopStyleColor();
+        if (uiFonts.largeFont) ImGui::PushFont(uiFonts.largeFont);
+        ImGui::Text("%s", ChapterText::FormatReadingTime(remaining).c_str());
+        if (uiFonts.largeFont) ImGui::PopFont();
+        ImGui::EndGroup();
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("%llu of %llu words left, at %u words a minute",
+                static_cast<unsigned long long>(remaining), static_cast<unsigned long long>(textStats.totalWords),
+                ChapterText::WORDS_PER_MINUTE);
+        }
+    }
+
     ImGui::Spacing();
 
     // Progress Bar
@@ -1993,6 +2359,14 @@ void Library::RenderActionButtons(const Novel& novel, float detailsWidth) {
     float smallButtonWidth = (detailsWidth - 20) / 3.0f;
     RenderSmallActionButtons(novel, smallButtonWidth);
 
+    std::string exportText = std::string(ICON_FA_FILE_EXPORT) + " Export";
+    if (ImGui::Button(exportText.c_str(), ImVec2(detailsWidth, 35))) {
+        exportFirstChapter = 1;
+        exportLastChapter = novel.downloadedchapters;
+        ImGui::OpenPopup("ExportBook");
+    }
+    RenderExportPopup(novel);
+
     ImGui::PopStyleVar(); // ItemSpacing
 }
 
@@ -2037,7 +2411,7 @@ void Library::MarkNovelAsRead(const std::string& novelName) {
         if (novel.name == novelName) {
             novel.progress.readchapters = novel.downloadedchapters;
             novel.progress.progresspercentage = 100.0f;
-            SaveNovels(novellist);
+            SaveNovels();
             std::cout << "Marked " << novelName << " as read" << std::endl;
             break;
         }
@@ -2093,30 +2467,179 @@ void Library::RenderChapterOverview(const Novel& novel) {
     if (uiFonts.normalFont) ImGui::PopFont();
     ImGui::PopStyleColor();
 
+    RebuildChapterReadBits(novel);
+    RenderChapterJumpBar(novel);
+    RenderChapterMinimap(novel);
+
     ImGui::BeginChild("ChapterGrid", ImVec2(0, 0), true, ImGuiWindowFlags_AlwaysVerticalScrollbar);
 
     float chapterButtonWidth = (ImGui::GetContentRegionAvail().x - 25.0f) / CHAPTER_GRID_COLUMNS;
     float chapterButtonHeight = 40.0f;
-
-    // Only show downloaded chapters
-    for (int i = 1; i <= novel.downloadedchapters; i++) {
-        RenderChapterButton(novel, i, chapterButtonWidth, chapterButtonHeight);
-
-        // Create 3-column layout
-        if (i % CHAPTER_GRID_COLUMNS != 0 && i < novel.downloadedchapters) {
-            ImGui::SameLine();
+    float rowHeight = chapterButtonHeight + ImGui::GetStyle().ItemSpacing.y;
+    int totalRows = (novel.downloadedchapters + CHAPTER_GRID_COLUMNS - 1) / CHAPTER_GRID_COLUMNS;
+
+    // Apply a pending jump from the jump bar or minimap
+    if (chapterOverview.scrollToChapter > 0) {
+        int targetRow = (chapterOverview.scrollToChapter - 1) / CHAPTER_GRID_COLUMNS;
+        ImGui::SetScrollY(targetRow * rowHeight);
+        chapterOverview.scrollToChapter = 0;
+    }
+
+    // Only show downloaded chapters, and only build the rows in view
+    ImGuiListClipper clipper;
+    clipper.Begin(totalRows, rowHeight);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            for (int col = 0; col < CHAPTER_GRID_COLUMNS; col++) {
+                int chapterNum = row * CHAPTER_GRID_COLUMNS + col + 1;
+                if (chapterNum > novel.downloadedchapters) break;
+
+                // Create 3-column layout
+                if (col != 0) {
+                    ImGui::SameLine();
+                }
+                RenderChapterButton(novel, chapterNum, chapterButtonWidth, chapterButtonHeight);
+            }
         }
     }
+    clipper.End();
 
     ImGui::EndChild();
 }
 
-void Library::RenderChapterButton(const Novel& novel, int chapterNum,
-    float buttonWidth, float buttonHeight) {
-    bool isRead = (chapterNum <= novel.progress.readchapters);
-    bool isCurrentChapter = (chapterNum == novel.progress.readchapters + 1);
+void Library::RebuildChapterReadBits(const Novel& novel) {
+    // Only rebuild when the selection or its progress actually changed
+    if (chapterOverview.novelName == novel.name &&
+        chapterOverview.readChapters == novel.progress.readchapters &&
+        chapterOverview.downloadedChapters == novel.downloadedchapters) {
+        return;
+    }
 
-    auto [buttonColor, buttonHovered, buttonActive, textColor] = GetChapterButtonColors(isRead, isCurrentChapter);
+    if (chapterOverview.novelName != novel.name) {
+        chapterOverview.jumpTarget = std::max(1, novel.progress.readchapters + 1);
+    }
+
+    chapterOverview.novelName = novel.name;
+    chapterOverview.readChapters = novel.progress.readchapters;
+    chapterOverview.downloadedChapters = novel.downloadedchapters;
+
+    int chapterCount = std::max(0, novel.downloadedchapters);
+    chapterOverview.readBits.assign((chapterCount + 63) / 64, 0);
+
+    // Bit (n - 1) is set when chapter n has been read
+    int readCount = std::clamp(novel.progress.readchapters, 0, chapterCount);
+    for (int word = 0; word < readCount / 64; word++) {
+        chapterOverview.readBits[word] = ~0ULL;
+    }
+    if (readCount % 64 != 0) {
+        chapterOverview.readBits[readCount / 64] = (1ULL << (readCount % 64)) - 1;
+    }
+}
+
+bool Library::IsChapterRead(int chapterNum) const {
+    int bit = chapterNum - 1;
+    if (bit < 0 || bit / 64 >= static_cast<int>(chapterOverview.readBits.size())) return false;
+    return (chapterOverview.readBits[bit / 64] >> (bit % 64)) & 1ULL;
+}
+
+int Library::CountReadChapters(int firstChapter, int lastChapter) const {
+    // Popcount over the half-open bit range [firstChapter - 1, lastChapter)
+    int begin = std::max(0, firstChapter - 1);
+    int end = std::min(lastChapter, static_cast<int>(chapterOverview.readBits.size()) * 64);
+    int count = 0;
+
+    while (begin < end) {
+        int word = begin / 64;
+        int offset = begin % 64;
+        int span = std::min(64 - offset, end - begin);
+        uint64_t mask = (span == 64) ? ~0ULL : (((1ULL << span) - 1) << offset);
+        count += std::popcount(chapterOverview.readBits[word] & mask);
+        begin += span;
+    }
+    return count;
+}
+
+void Library::RenderChapterJumpBar(const Novel& novel) {
+    if (novel.downloadedchapters <= 0) return;
+
+    ImGui::SetNextItemWidth(120.0f);
+    bool submitted = ImGui::InputInt("##JumpToChapter", &chapterOverview.jumpTarget, 1, 100,
+        ImGuiInputTextFlags_EnterReturnsTrue);
+    chapterOverview.jumpTarget = std::clamp(chapterOverview.jumpTarget, 1, novel.downloadedchapters);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Go") || submitted) {
+        chapterOverview.scrollToChapter = chapterOverview.jumpTarget;
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Continue")) {
+        chapterOverview.scrollToChapter = std::clamp(novel.progress.readchapters + 1, 1, novel.downloadedchapters);
+    }
+
+    ImGui::SameLine();
+    ImGui::TextDisabled("%d / %d read", CountReadChapters(1, novel.downloadedchapters), novel.downloadedchapters);
+}
+
+void Library::RenderChapterMinimap(const Novel& novel) {
+    int chapterCount = novel.downloadedchapters;
+    if (chapterCount <= 0) return;
+
+    ImVec2 mapStart = ImGui::GetCursorScreenPos();
+    float mapWidth = ImGui::GetContentRegionAvail().x;
+    float mapHeight = 10.0f;
+    if (mapWidth < 1.0f) return;
+
+    ImGui::InvisibleButton("ChapterMinimap", ImVec2(mapWidth, mapHeight));
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(mapStart, ImVec2(mapStart.x + mapWidth, mapStart.y + mapHeight),
+        IM_COL32(50, 50, 50, 255), 2.0f);
+
+    // One bucket per pixel at most; each bucket is shaded by the share of read chapters in it
+    int buckets = std::min(chapterCount, std::max(1, static_cast<int>(mapWidth)));
+    float bucketWidth = mapWidth / buckets;
+    for (int b = 0; b < buckets; b++) {
+        int first = static_cast<int>(static_cast<long long>(b) * chapterCount / buckets) + 1;
+        int last = static_cast<int>(static_cast<long long>(b + 1) * chapterCount / buckets);
+        int read = CountReadChapters(first, last);
+        if (read == 0) continue;
+
+        float ratio = static_cast<float>(read) / static_cast<float>(last - first + 1);
+        ImU32 color = IM_COL32(51, static_cast<int>(80 + 99 * ratio), 76, 255);
+        float x = mapStart.x + b * bucketWidth;
+        drawList->AddRectFilled(ImVec2(x, mapStart.y), ImVec2(x + bucketWidth, mapStart.y + mapHeight), color);
+    }
+
+    // Marker for the next chapter to read
+    int nextChapter = novel.progress.readchapters + 1;
+    if (nextChapter <= chapterCount) {
+        float x = mapStart.x + (nextChapter - 1) * mapWidth / chapterCount;
+        drawList->AddLine(ImVec2(x, mapStart.y), ImVec2(x, mapStart.y + mapHeight), IM_COL32(80, 140, 230, 255), 2.0f);
+    }
+
+    if (ImGui::IsItemHovered() || ImGui::IsItemActive()) {
+        float t = std::clamp((ImGui::GetIO().MousePos.x - mapStart.x) / mapWidth, 0.0f, 1.0f);
+        int hoveredChapter = std::clamp(static_cast<int>(t * chapterCount) + 1, 1, chapterCount);
+
+        if (ImGui::IsItemActive()) {
+            chapterOverview.jumpTarget = hoveredChapter;
+            chapterOverview.scrollToChapter = hoveredChapter;
+        }
+
+        ImGui::BeginTooltip();
+        ImGui::Text("Chapter %d - %s", hoveredChapter, IsChapterRead(hoveredChapter) ? "Read" : "Unread");
+        ImGui::EndTooltip();
+    }
+
+    ImGui::Spacing();
+}
+
+void Library::RenderChapterButton(const Novel& novel, int chapterNum,
+    float buttonWidth, float buttonHeight) {
+    bool isRead = IsChapterRead(chapterNum);
+    bool isCurrentChapter = (chapterNum == novel.progress.readchapters + 1);
+
+    auto [buttonColor, buttonHovered, buttonActive, textColor] = GetChapterButtonColors(isRead, isCurrentChapter);
 
     ImGui::PushStyleColor(ImGuiCol_Button, buttonColor);
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, buttonHovered);
@@ -2124,15 +2647,18 @@ void Library::RenderChapterButton(const Novel& novel, int chapterNum,
     ImGui::PushStyleColor(ImGuiCol_Text, textColor);
 
     // Fix: Use proper chapter text without FontAwesome icons that might not render
-    std::string chapterText = std::to_string(chapterNum);
+    char chapterText[32];
     if (isRead) {
-        chapterText += " " + std::string(ICON_FA_CHECK);
+        snprintf(chapterText, sizeof(chapterText), "%d %s", chapterNum, ICON_FA_CHECK);
     }
     else if (isCurrentChapter) {
-        chapterText += " " + std::string(ICON_FA_PLAY);
+        snprintf(chapterText, sizeof(chapterText), "%d %s", chapterNum, ICON_FA_PLAY);
+    }
+    else {
+        snprintf(chapterText, sizeof(chapterText), "%d", chapterNum);
     }
 
-    if (ImGui::Button(chapterText.c_str(), ImVec2(buttonWidth, buttonHeight))) {
+    if (ImGui::Button(chapterText, ImVec2(buttonWidth, buttonHeight))) {
         SwitchToReading(novel.name, chapterNum);
     }
 
@@ -2187,6 +2713,154 @@ void Library::RenderChapterTooltip(int chapterNum, bool isRead, bool isCurrentCh
     }
 }
 
+// ============================================================================
+// Library Full-Text Search
+// ============================================================================
+
+void Library::RenderLibrarySearch() {
+    if (uiFonts.normalFont) ImGui::PushFont(uiFonts.normalFont);
+    ImGui::Spacing();
+
+    // Query row
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x * 0.5f);
+    bool submitted = ImGui::InputTextWithHint("##LibrarySearch", "Search chapter text (use \"quotes\" for phrases)",
+        librarySearchBuffer, sizeof(librarySearchBuffer), ImGuiInputTextFlags_EnterReturnsTrue);
+
+    ImGui::SameLine();
+    const char* scopeLabel = (librarySearchScope >= 0 && librarySearchScope < static_cast<int>(novellist.size()))
+        ? novellist[librarySearchScope].name.c_str() : "Whole library";
+    ImGui::SetNextItemWidth(220.0f);
+    if (ImGui::BeginCombo("##SearchScope", scopeLabel)) {
+        if (ImGui::Selectable("Whole library", librarySearchScope < 0)) {
+            librarySearchScope = -1;
+        }
+        for (int i = 0; i < static_cast<int>(novellist.size()); i++) {
+            ImGui::PushID(i);
+            if (ImGui::Selectable(novellist[i].name.c_str(), librarySearchScope == i)) {
+                librarySearchScope = i;
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!searchIndex.IsOpen());
+    if (ImGui::Button(ICON_FA_MAGNIFYING_GLASS " Search") || submitted) {
+        RunLibrarySearch();
+    }
+    ImGui::EndDisabled();
+
+    // Index status row
+    if (indexingPipeline->IsRebuilding()) {
+        ImGui::ProgressBar(indexingPipeline->RebuildProgress(), ImVec2(300, 0), "Indexing...");
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_XMARK " Cancel")) {
+            indexingPipeline->CancelRebuild();
+        }
+    }
+    else {
+        size_t pending = indexingPipeline->PendingChapters();
+        if (searchIndex.IsOpen() && pending > 0) {
+            ImGui::TextDisabled("%zu chapters indexed, %zu pending", searchIndex.DocumentCount(), pending);
+        }
+        else if (searchIndex.IsOpen()) {
+            ImGui::TextDisabled("%zu chapters indexed", searchIndex.DocumentCount());
+        }
+        else {
+            ImGui::TextDisabled("No search index yet");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button(ICON_FA_ROTATE " Rebuild Index")) {
+            indexingPipeline->RequestRebuild();
+        }
+    }
+
+    ImGui::Separator();
+    if (uiFonts.normalFont) ImGui::PopFont();
+
+    RenderLibrarySearchResults();
+}
+
+void Library::RenderLibrarySearchResults() {
+    if (!librarySearchRan) return;
+
+    ImGui::Text("%zu results (%.1f ms)", librarySearchHits.size(), librarySearchMillis);
+    ImGui::BeginChild("LibrarySearchResults", ImVec2(0, 0), true);
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(librarySearchHits.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const SearchIndex::Hit& hit = librarySearchHits[i];
+            ImGui::PushID(i);
+
+            char header[256];
+            snprintf(header, sizeof(header), "%s - Chapter %d", hit.novelName.c_str(), hit.chapterNumber);
+            if (ImGui::Selectable(header, false, ImGuiSelectableFlags_AllowDoubleClick)) {
+                OpenSearchHit(hit);
+            }
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
+            ImGui::TextWrapped("%s", hit.snippet.c_str());
+            ImGui::PopStyleColor();
+            ImGui::Separator();
+
+            ImGui::PopID();
+        }
+    }
+    clipper.End();
+
+    ImGui::EndChild();
+}
+
+void Library::RunLibrarySearch() {
+    std::string scope;
+    if (librarySearchScope >= 0 && librarySearchScope < static_cast<int>(novellist.size())) {
+        scope = novellist[librarySearchScope].name;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    librarySearchHits = searchIndex.Search(librarySearchBuffer, scope, 200);
+    librarySearchMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    librarySearchRan = true;
+}
+
+void Library::PollSearchIndex() {
+    if (indexingPipeline && indexingPipeline->ConsumeIndexChanged()) {
+        RefreshSearchIndex();
+    }
+
+    // If the reopen failed the old view stays
+    if (searchIndexRefreshTask.IsValid() && searchIndexRefreshTask.IsDone()) {
+        searchIndexRefreshTask = {};
+        if (preparedSearchIndex) {
+            searchIndex.ApplyRefresh(*preparedSearchIndex);
+            preparedSearchIndex.reset();
+        }
+        if (searchIndexRefreshAgain) {
+            searchIndexRefreshAgain = false;
+            RefreshSearchIndex();
+        }
+    }
+}
+
+void Library::RefreshSearchIndex() {
+    // Reopening maps only segments published since the last refresh, on a worker, while searches
+    // keep using the segments already open; PollSearchIndex swaps the result in
+    if (searchIndexRefreshTask.IsValid()) {
+        searchIndexRefreshAgain = true;
+        return;
+    }
+    searchIndexRefreshTask = TaskScheduler::Shared().Submit([this] {
+        preparedSearchIndex = searchIndex.PrepareRefresh("index");
+    }, TaskScheduler::Priority::Prefetch);
+}
+
+void Library::OpenSearchHit(const SearchIndex::Hit& hit) {
+    SwitchToReading(hit.novelName, hit.chapterNumber);
+    chaptermanager.ScrollToParagraph(hit.paragraphIndex);
+}
+
 // ============================================================================
 // Reading View
 // ============================================================================
@@ -2215,9 +2889,14 @@ void Library::RenderFullScreenReading() {
     // Render settings panel if open (outside the main window)
     chaptermanager.RenderSettingsPanel();
 
-    // Handle ESC key
+    // Handle ESC key; the find bar closes first
     if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
-        SwitchToLibrary();
+        if (chaptermanager.IsFindOpen()) {
+            chaptermanager.CloseFind();
+        }
+        else {
+            SwitchToLibrary();
+        }
     }
 }
 
@@ -2408,11 +3087,7 @@ bool Library::CallPythonScript(const std::string& scriptName, const std::vector<
         return false;
     }
 
-    std::string command = "python \"" + scriptName + "\"";
-    for (const auto& arg : args) {
-        command += " \"" + arg + "\"";
-    }
-
+    std::string command = DownloadJob::BuildCommand(scriptName, args);
     std::cout << "Executing: " << command << std::endl;
 
 #ifdef _WIN32
@@ -2467,10 +3142,7 @@ bool Library::CallPythonScriptAsync(const std::string& scriptName, const std::ve
     }
 
     // Build command with stderr redirection to capture progress
-    std::string command = "python \"" + scriptName + "\"";
-    for (const auto& arg : args) {
-        command += " \"" + arg + "\"";
-    }
+    std::string command = DownloadJob::BuildCommand(scriptName, args);
 
     // Redirect stderr to stdout so we can capture both streams
     command += " 2>&1";
@@ -2502,6 +3174,7 @@ bool Library::CallPythonScriptAsync(const std::string& scriptName, const std::ve
     download.thread = std::make_shared<std::thread>([this, command, novelName, progressCallback, completionCallback]() {
         std::string output;
         std::string line;
+        std::string savedNovelDir;
 
         try {
 #ifdef _WIN32
@@ -2531,8 +3204,13 @@ bool Library::CallPythonScriptAsync(const std::string& scriptName, const std::ve
                 // Debug output
                 std::cout << "Python: " << line;
 
+                // Saved chapters go straight to the search indexer
+                if (line.rfind("ChapterSaved:", 0) == 0) {
+                    std::string novelDirName = ParseChapterSavedLine(line);
+                    if (!novelDirName.empty()) savedNovelDir = novelDirName;
+                }
                 // Parse progress lines
-                if (line.find("Progress:") != std::string::npos) {
+                else if (line.find("Progress:") != std::string::npos) {
                     if (progressCallback) {
                         progressCallback(line);
                     }
@@ -2550,6 +3228,7 @@ bool Library::CallPythonScriptAsync(const std::string& scriptName, const std::ve
 #else
             int result = pclose(pipe);
 #endif
+            CompactDownloadedNovel(savedNovelDir);
 
             // Remove from active downloads
             {
@@ -2590,25 +3269,75 @@ bool Library::CallPythonScriptAsync(const std::string& scriptName, const std::ve
 bool Library::SearchNovels(const std::string& query) {
     if (query.empty()) return false;
 
-    isSearching = true;
-    searchResults.clear();
-    searchQuery = query;
-
     std::vector<std::string> args = {
         "search",
         "--query", query,
         "--config", "sources.json"
     };
+    return StartOnlineSearch(query, args);
+}
+
+bool Library::StartOnlineSearch(const std::string& query, const std::vector<std::string>& args) {
+    if (!std::filesystem::exists("download_manager.py")) {
+        std::cout << "Error: Python script not found: download_manager.py" << std::endl;
+        return false;
+    }
+
+    // Replaces any search still in flight; its late results are dropped
+    searchResults.clear();
+    onlineSearchErrors.clear();
+    searchQuery = query;
+
+    std::vector<std::string> streamArgs = args;
+    streamArgs.push_back("--stream");
+    streamArgs.push_back("--prefetch-covers");
+    streamArgs.push_back("--cache-ttl");
+    streamArgs.push_back(std::to_string(currentSearchFilter.cacheTtlMinutes * 60));
+    onlineSearch.Start(streamArgs);
+    isSearching = true;
+    return true;
+}
+
+void Library::PollOnlineSearch() {
+    if (onlineSearchEditPending && std::chrono::steady_clock::now() - onlineSearchEditedAt >= ONLINE_SEARCH_DEBOUNCE) {
+        onlineSearchEditPending = false;
+        if (strlen(onlineSearchBuffer) >= ONLINE_SEARCH_MIN_LENGTH && searchQuery != onlineSearchBuffer) {
+            SearchContentWithFilters(onlineSearchBuffer, currentSearchFilter);
+        }
+    }
 
-    std::string output;
-    bool success = CallPythonScript("download_manager.py", args, output);
+    std::vector<OnlineSearch::SourceBatch> batches;
+    std::vector<OnlineSearch::CoverFile> covers;
+    onlineSearch.Poll(batches, covers);
+    for (const OnlineSearch::SourceBatch& batch : batches) {
+        if (!batch.error.empty()) {
+            onlineSearchErrors.push_back(batch.sourceName + ": " + batch.error);
+        }
+        size_t firstNew = searchResults.size();
+        ParseSearchResults(batch.resultsJson);
 
-    if (success && !output.empty()) {
-        success = ParseSearchResults(output);
+        // Covers seen in an earlier search are already thumbnailed on disk
+        for (size_t i = firstNew; i < searchResults.size(); i++) {
+            coverThumbnails.Request(searchResults[i].coverUrl);
+        }
     }
+    for (const OnlineSearch::CoverFile& cover : covers) {
+        coverThumbnails.Request(cover.url);
+    }
+    UploadReadyThumbnails();
+
+    // Covers may still be downloading; the results themselves are complete
+    isSearching = !onlineSearch.IsSearchComplete();
+}
 
-    isSearching = false;
-    return success;
+void Library::UploadReadyThumbnails() {
+    std::vector<ThumbnailCache::Thumbnail> thumbnails;
+    coverThumbnails.TakeReady(thumbnails);
+    for (ThumbnailCache::Thumbnail& thumbnail : thumbnails) {
+        std::string textureKey = "thumb:" + thumbnail.key;
+        if (coverTextures.find(textureKey) != coverTextures.end()) continue;
+        CreateTextureFromPixels(thumbnail.rgba.data(), thumbnail.width, thumbnail.height, textureKey);
+    }
 }
 
 bool Library::ParseSearchResults(const std::string& output) {
@@ -2640,6 +3369,10 @@ bool Library::ParseSearchResults(const std::string& output) {
 }
 
 void Library::StartDownload(const SearchResult& result, int startChapter, int endChapter) {
+    if (daemonAttached && EnqueueWithDaemon(result, startChapter, endChapter)) {
+        return;
+    }
+
     // Create the novel entry immediately when download starts
     Novel newNovel;
     newNovel.name = result.title;
@@ -2670,9 +3403,12 @@ void Library::StartDownload(const SearchResult& result, int startChapter, int en
         novellist.push_back(newNovel);
         std::cout << "Added novel to library: " << result.title << std::endl;
     }
+    if (catalogSearchBuilt) {
+        catalogSearch.Add(result.title, result.author, result.description);
+    }
 
     // Save the updated novel list immediately
-    SaveNovels(novellist);
+    SaveNovels();
 
     // Create and queue the download task
     DownloadTask task = CreateDownloadTask(result, startChapter, endChapter);
@@ -2755,38 +3491,43 @@ void Library::SaveDownloadStates() {
 
 void Library::LoadDownloadStates() {
     try {
-        std::ifstream file("downloads/download_states.json");
-        if (!file.is_open()) return;
-
-        json j;
-        file >> j;
-        file.close();
+        std::string jsonText;
+        if (!ReadTextFile("downloads/download_states.json", jsonText)) return;
+
+        std::vector<DownloadState> states;
+        if (!ReadDownloadStateList(jsonText, states)) {
+            json j = json::parse(jsonText);
+            states.clear();
+            if (j.contains("downloads")) {
+                for (const auto& stateJson : j["downloads"]) {
+                    DownloadState state;
+                    state.id = stateJson.value("id", "");
+                    state.contentName = stateJson.value("contentName", "");
+                    state.type = static_cast<ContentType>(stateJson.value("type", 0));
+                    state.currentChapter = stateJson.value("currentChapter", 0);
+                    state.totalChapters = stateJson.value("totalChapters", 0);
+                    state.isPaused = stateJson.value("isPaused", false);
+                    state.isComplete = stateJson.value("isComplete", false);
+                    state.progress = stateJson.value("progress", 0.0f);
+                    state.lastError = stateJson.value("lastError", "");
+
+                    auto time_t = stateJson.value("lastUpdate", std::time_t{ 0 });
+                    state.lastUpdate = std::chrono::system_clock::from_time_t(time_t);
+
+                    states.push_back(state);
+                }
+            }
+        }
 
         std::lock_guard<std::mutex> lock(downloadStateMutex);
         persistentDownloadStates.clear();
 
-        if (j.contains("downloads")) {
-            for (const auto& stateJson : j["downloads"]) {
-                DownloadState state;
-                state.id = stateJson.value("id", "");
-                state.contentName = stateJson.value("contentName", "");
-                state.type = static_cast<ContentType>(stateJson.value("type", 0));
-                state.currentChapter = stateJson.value("currentChapter", 0);
-                state.totalChapters = stateJson.value("totalChapters", 0);
-                state.isPaused = stateJson.value("isPaused", false);
-                state.isComplete = stateJson.value("isComplete", false);
-                state.progress = stateJson.value("progress", 0.0f);
-                state.lastError = stateJson.value("lastError", "");
-
-                auto time_t = stateJson.value("lastUpdate", std::time_t{ 0 });
-                state.lastUpdate = std::chrono::system_clock::from_time_t(time_t);
-
-                persistentDownloadStates.push_back(state);
-
-                // Auto-resume incomplete downloads
-                if (!state.isComplete && !state.isPaused) {
-                    ResumeDownload(state.id);
-                }
+        for (const DownloadState& state : states) {
+            persistentDownloadStates.push_back(state);
+
+            // Auto-resume incomplete downloads, unless the daemon is doing the downloading
+            if (!daemonAttached && !state.isComplete && !state.isPaused) {
+                ResumeDownload(state.id);
             }
         }
     }
@@ -2856,10 +3597,6 @@ void Library::CleanupPartialDownload(const std::string& downloadId, const std::s
 bool Library::SearchContentWithFilters(const std::string& query, const SearchFilter& filter) {
     if (query.empty()) return false;
 
-    isSearching = true;
-    searchResults.clear();
-    searchQuery = query;
-
     std::vector<std::string> args = {
         "search",
         "--query", query,
@@ -2877,15 +3614,7 @@ bool Library::SearchContentWithFilters(const std::string& query, const SearchFil
         args.push_back(filter.language);
     }
 
-    std::string output;
-    bool success = CallPythonScript("download_manager.py", args, output);
-
-    if (success && !output.empty()) {
-        success = ParseSearchResults(output);
-    }
-
-    isSearching = false;
-    return success;
+    return StartOnlineSearch(query, args);
 }
 
 void Library::RenderContentTypeFilter(SearchFilter& filter) {
@@ -2947,18 +3676,13 @@ void Library::StopDownloadManager() {
     shouldTerminateDownloads = true;
     downloadManagerRunning = false;
 
-    // Create stop signals for all active downloads
+    // Tell every running script to stop; paused ones wake up to do so
     {
-        std::lock_guard<std::mutex> lock(activeDownloadsMutex);
-        for (const auto& download : activeDownloads) {
-            if (download.isActive) {
-                std::string stopSignalFile = "Novels/.stop_" + download.novelName;
-                std::replace(stopSignalFile.begin(), stopSignalFile.end(), ' ', '_');
-                std::ofstream stopFile(stopSignalFile);
-                if (stopFile.is_open()) {
-                    stopFile << "SHUTDOWN" << std::endl;
-                    stopFile.close();
-                }
+        std::lock_guard<std::mutex> lock(downloadStateMutex);
+        for (auto& [id, processInfo] : activeProcesses) {
+            processInfo.shouldTerminate.store(true);
+            if (processInfo.control) {
+                processInfo.control->Send(DownloadJob::Command::Stop);
             }
         }
     }
@@ -3035,6 +3759,29 @@ bool Library::ProcessNextDownload() {
     return false;
 }
 
+std::string Library::ParseChapterSavedLine(const std::string& line) {
+    DownloadJob::ChapterSaved saved;
+    if (!DownloadJob::ParseChapterSaved(line, saved)) {
+        std::cout << "Malformed chapter notification: " << line;
+        return "";
+    }
+    if (indexingPipeline) {
+        indexingPipeline->EnqueueChapter(saved.novelDirName, saved.chapter);
+    }
+    return saved.novelDirName;
+}
+
+void Library::CompactDownloadedNovel(const std::string& novelDirName) {
+    if (novelDirName.empty()) return;
+
+    // Runs on the download thread once the script has exited. The sweep cleans the new chapters
+    // and trains the dictionary on the clean text, on the tiering worker where no tier move can
+    // race the rewrites; hot chapters stay as they are.
+    if (chapterTiering) {
+        chapterTiering->RequestSweep();
+    }
+}
+
 void Library::ParseProgressLine(const std::string& line, DownloadTask& task) {
     // Debug output
     std::cout << "Parsing progress line: " << line << std::endl;
@@ -3122,12 +3869,6 @@ bool Library::ExecuteDownloadTask(DownloadTask& task) {
     args.push_back("--download-id");
     args.push_back(task.downloadId);
 
-    // Clean up any existing stop signals
-    std::string stopSignalFile = "downloads/.stop_" + task.downloadId;
-    if (std::filesystem::exists(stopSignalFile)) {
-        std::filesystem::remove(stopSignalFile);
-    }
-
     std::cout << "Starting download: " << task.novelName << " (ID: " << task.downloadId << ")" << std::endl;
 
     // Create a copy of task data for the lambda
@@ -3144,43 +3885,26 @@ bool Library::ExecuteDownloadTask(DownloadTask& task) {
     processInfo.contentType = taskType;
     processInfo.shouldStop.store(false);
     processInfo.shouldTerminate.store(false);
+    processInfo.control = std::make_shared<DownloadJob::Control>();
+    std::shared_ptr<DownloadJob::Control> control = processInfo.control;
 
     // Create thread directly
-    auto downloadThread = std::make_shared<std::thread>([this, args, taskId, taskName, taskType, &task]() {
+    auto downloadThread = std::make_shared<std::thread>([this, args, taskId, taskName, taskType, control, &task]() {
         try {
-            std::string command = "python \"download_manager.py\"";
-            for (const auto& arg : args) {
-                command += " \"" + arg + "\"";
-            }
-
-            // Redirect stderr to stdout to capture progress
-            command += " 2>&1";
-
-            std::cout << "Executing command: " << command << std::endl;
-
-#ifdef _WIN32
-            FILE* pipe = _popen(command.c_str(), "r");
-#else
-            FILE* pipe = popen(command.c_str(), "r");
-#endif
-
-            if (!pipe) {
-                std::cout << "Failed to open pipe!" << std::endl;
-                task.isActive = false;
-                task.status = "Failed";
-                task.lastError = "Failed to start Python process";
-                return;
-            }
-
-            char buffer[256];
-            while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                std::string line(buffer);
+            std::cout << "Executing command: " << DownloadJob::BuildCommand(DownloadJob::SCRIPT, args) << std::endl;
+            std::string savedNovelDir;
 
+            int result = DownloadJob::Run(args, [&](const std::string& line) {
                 // Debug output
                 std::cout << "Python output: " << line;
 
+                // Saved chapters go straight to the search indexer
+                if (line.rfind("ChapterSaved:", 0) == 0) {
+                    std::string novelDirName = ParseChapterSavedLine(line);
+                    if (!novelDirName.empty()) savedNovelDir = novelDirName;
+                }
                 // Parse progress lines
-                if (line.find("Progress:") != std::string::npos) {
+                else if (line.find("Progress:") != std::string::npos) {
                     ParseProgressLine(line, task);
                 }
                 // Check for completion
@@ -3195,13 +3919,12 @@ bool Library::ExecuteDownloadTask(DownloadTask& task) {
                     line.find("Error loading sources") == std::string::npos) {
                     task.lastError = line;
                 }
-            }
+            }, control.get());
 
-#ifdef _WIN32
-            int result = _pclose(pipe);
-#else
-            int result = pclose(pipe);
-#endif
+            if (result == -1 && task.lastError.empty()) {
+                task.lastError = "Failed to start Python process";
+            }
+            CompactDownloadedNovel(savedNovelDir);
 
             task.isActive = false;
 
@@ -3254,31 +3977,13 @@ bool Library::ExecuteDownloadTask(DownloadTask& task) {
 
 
 std::vector<std::string> Library::BuildDownloadArgs(const DownloadTask& task) {
-    std::vector<std::string> args = {
-        "download",
-        "--source", task.sourceName,
-        "--output", "Novels",
-        "--start", std::to_string(task.startChapter)
-    };
-
-    // Check if sourceUrl is actually a URL or just a name
-    if (task.sourceUrl.find("http") == 0) {
-        args.push_back("--url");
-        args.push_back(task.sourceUrl);
-    }
-    else {
-        // It's likely just a novel name
-        args.push_back("--name");
-        args.push_back(task.novelName);
-    }
-
-    // Add end chapter if specified
-    if (task.endChapter > 0) {
-        args.push_back("--end");
-        args.push_back(std::to_string(task.endChapter));
-    }
-
-    return args;
+    DownloadJob::Request request;
+    request.source = task.sourceName;
+    request.url = task.sourceUrl;
+    request.name = task.novelName;
+    request.startChapter = task.startChapter;
+    request.endChapter = task.endChapter;
+    return DownloadJob::BuildArgs(request);
 }
 
 bool Library::IsFullUrl(const std::string& input) {
@@ -3304,19 +4009,13 @@ void Library::PauseDownload(const std::string& downloadId) {
         it->isPaused = true;
         SaveDownloadStates();
 
-        // Send signal to python process
+        // The script holds on after the request it is on until it hears resume
         auto processIt = activeProcesses.find(downloadId);
         if (processIt != activeProcesses.end()) {
             processIt->second.shouldStop.store(true);
-        }
-
-        // Create pause signal file
-        std::filesystem::create_directories("downloads");
-        std::string pauseFile = "downloads/.pause_" + downloadId;
-        std::ofstream file(pauseFile);
-        if (file.is_open()) {
-            file << "PAUSE" << std::endl;
-            file.close();
+            if (processIt->second.control) {
+                processIt->second.control->Send(DownloadJob::Command::Pause);
+            }
         }
 
         std::cout << "Paused download: " << downloadId << std::endl;
@@ -3334,14 +4033,17 @@ void Library::ResumeDownload(const std::string& downloadId) {
         it->lastError.clear();
         SaveDownloadStates();
 
-        // Remove pause signal
-        std::string pauseFile = "downloads/.pause_" + downloadId;
-        if (std::filesystem::exists(pauseFile)) {
-            std::filesystem::remove(pauseFile);
+        // A script still waiting in its pause carries on; otherwise the download starts again
+        auto processIt = activeProcesses.find(downloadId);
+        bool resumed = false;
+        if (processIt != activeProcesses.end() && processIt->second.control &&
+            processIt->second.control->IsRunning()) {
+            processIt->second.shouldStop.store(false);
+            resumed = processIt->second.control->Send(DownloadJob::Command::Resume);
+        }
+        if (!resumed) {
+            QueueDownloadResume(*it);
         }
-
-        // Queue for resumption
-        QueueDownloadResume(*it);
 
         std::cout << "Resumed download: " << downloadId << std::endl;
     }
@@ -3434,15 +4136,9 @@ void Library::CancelDownload(const std::string& downloadId) {
         auto processIt = activeProcesses.find(downloadId);
         if (processIt != activeProcesses.end()) {
             processIt->second.shouldTerminate.store(true);
-        }
-
-        // Create cancel signal file
-        std::filesystem::create_directories("downloads");
-        std::string cancelFile = "downloads/.cancel_" + downloadId;
-        std::ofstream file(cancelFile);
-        if (file.is_open()) {
-            file << "CANCEL" << std::endl;
-            file.close();
+            if (processIt->second.control) {
+                processIt->second.control->Send(DownloadJob::Command::Cancel);
+            }
         }
 
         // Clean up partial downloads
@@ -3456,23 +4152,220 @@ bool Library::IsValidTaskIndex(int taskIndex) {
     return taskIndex >= 0 && taskIndex < static_cast<int>(downloadQueue.size());
 }
 
-void Library::CleanupStopSignals() {
-    try {
-        std::filesystem::path novelsDir = "Novels";
-        if (std::filesystem::exists(novelsDir)) {
-            for (const auto& entry : std::filesystem::directory_iterator(novelsDir)) {
-                if (entry.is_regular_file()) {
-                    std::string filename = entry.path().filename().string();
-                    if (filename.starts_with(".stop_")) {
-                        std::filesystem::remove(entry.path());
-                        std::cout << "Cleaned up stop signal: " << filename << std::endl;
-                    }
-                }
+// ============================================================================
+// Download Daemon
+// ============================================================================
+
+void Library::AttachToDaemon() {
+    auto client = std::make_unique<DownloadDaemon::Client>();
+    if (!client->Connect()) {
+        return;     // No daemon: downloads run in the app
+    }
+
+    std::cout << "Attached to the download daemon" << std::endl;
+    daemonWatch = std::move(client);
+    daemonAttached = true;
+    daemonWatcher = std::make_unique<std::thread>([this]() {
+        daemonWatch->Watch([this](const DownloadDaemon::Job& job) {
+            std::lock_guard<std::mutex> lock(daemonJobsMutex);
+            auto it = std::find_if(daemonJobs.begin(), daemonJobs.end(),
+                [&job](const DownloadDaemon::Job& known) { return known.id == job.id; });
+            int knownChapter = it != daemonJobs.end() ? it->lastSavedChapter : 0;
+            if (job.lastSavedChapter > knownChapter) {
+                daemonChaptersChanged = true;
             }
+            if (it != daemonJobs.end()) {
+                *it = job;
+            }
+            else {
+                daemonJobs.push_back(job);
+            }
+        });
+
+        // From here on new downloads run in the app again
+        daemonAttached = false;
+        std::cout << "Detached from the download daemon" << std::endl;
+    });
+}
+
+void Library::PollDaemon() {
+    if (!pendingCatalogued.empty()) {
+        std::vector<Novel> catalogued = std::move(pendingCatalogued);
+        pendingCatalogued.clear();
+        ListCataloguedNovels(catalogued);
+    }
+    if (!daemonChaptersChanged.exchange(false)) return;
+
+    // The daemon has cleaned and indexed the new chapters and may have catalogued novels
+    // enqueued from elsewhere; pick both up without losing what only the app knows
+    std::vector<Novel> catalogued;
+    Catalog::Load("Novels", catalogued);
+    ListCataloguedNovels(catalogued);
+    for (auto& novel : novellist) {
+        novel.downloadedchapters = CountChaptersInDirectory(novel.name);
+    }
+    RefreshSearchIndex();
+}
+
+void Library::ListCataloguedNovels(std::vector<Novel>& catalogued) {
+    for (Novel& novel : catalogued) {
+        if (Catalog::Find(novellist, novel.name)) continue;
+        if (std::find(removedNovelNames.begin(), removedNovelNames.end(), novel.name) != removedNovelNames.end()) continue;
+
+        if (catalogSearchBuilt) {
+            catalogSearch.Add(novel.name, novel.authorname, novel.synopsis);
         }
+        novellist.push_back(std::move(novel));
+        catalogVersion++;
+    }
+}
+
+bool Library::EnqueueWithDaemon(const SearchResult& result, int startChapter, int endChapter) {
+    DownloadDaemon::Enqueue enqueue;
+    enqueue.request.source = result.sourceName;
+    enqueue.request.url = result.url;
+    enqueue.request.name = result.title;
+    enqueue.request.startChapter = startChapter;
+    enqueue.request.endChapter = endChapter;
+    enqueue.author = result.author;
+    enqueue.synopsis = result.description;
+    enqueue.totalChapters = result.totalChapters;
+
+    DownloadDaemon::Client client;
+    std::string id;
+    if (!client.Connect() || !client.Add(enqueue, id)) {
+        std::cout << client.LastError() << "; downloading in the app instead" << std::endl;
+        return false;
     }
-    catch (const std::exception& e) {
-        std::cout << "Error cleaning up stop signals: " << e.what() << std::endl;
+
+    // The daemon writes the catalog entry; the app lists it too so its own saves keep it
+    if (!Catalog::Find(novellist, result.title)) {
+        Novel novel;
+        novel.name = result.title;
+        novel.authorname = result.author;
+        novel.synopsis = result.description;
+        novel.coverpath = Catalog::CoverPath("Novels", result.title);
+        novel.totalchapters = result.totalChapters;
+        novel.downloadedchapters = 0;
+        novel.progress.readchapters = 0;
+        novel.progress.progresspercentage = 0.0f;
+        novellist.push_back(novel);
+        catalogVersion++;
+        if (catalogSearchBuilt) {
+            catalogSearch.Add(novel.name, novel.authorname, novel.synopsis);
+        }
+    }
+
+    std::cout << "Queued with the download daemon: " << result.title << " (" << id << ")" << std::endl;
+    return true;
+}
+
+void Library::RenderDaemonJobs() {
+    std::vector<DownloadDaemon::Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(daemonJobsMutex);
+        jobs = daemonJobs;
+    }
+
+    ImGui::TextDisabled("Downloads run in the background daemon and continue after the app is closed");
+    if (!daemonMessage.empty()) {
+        ImGui::TextColored(ImVec4(0.9f, 0.4f, 0.4f, 1.0f), "%s", daemonMessage.c_str());
+    }
+
+    if (jobs.empty()) {
+        ImGui::Text("No downloads in queue");
+        return;
+    }
+
+    if (ImGui::BeginTable("DaemonJobsTable", 6,
+        ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+
+        SetupDownloadTableColumns();
+        ImGui::TableHeadersRow();
+
+        for (const DownloadDaemon::Job& job : jobs) {
+            ImGui::PushID(job.id.c_str());
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::Text("%s", job.request.name.c_str());
+
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%s", job.request.source.c_str());
+
+            ImGui::TableSetColumnIndex(2);
+            ImGui::ProgressBar(job.progress / 100.0f, ImVec2(-1, 0));
+            if (job.totalChapters > 0) {
+                ImGui::Text("%d/%d chapters", job.currentChapter, job.totalChapters);
+            }
+
+            ImGui::TableSetColumnIndex(3);
+            ImVec4 statusColor = job.status == DownloadDaemon::Status::Failed ? ImVec4(0.9f, 0.3f, 0.3f, 1.0f)
+                : job.status == DownloadDaemon::Status::Paused ? ImVec4(0.8f, 0.8f, 0.2f, 1.0f)
+                : job.status == DownloadDaemon::Status::Downloading || job.status == DownloadDaemon::Status::Complete
+                ? ImVec4(0.2f, 0.8f, 0.2f, 1.0f) : ImVec4(0.6f, 0.6f, 0.6f, 1.0f);
+            ImGui::TextColored(statusColor, "%s", DownloadDaemon::StatusName(job.status));
+            if (!job.lastError.empty() && ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("%s", job.lastError.c_str());
+            }
+
+            ImGui::TableSetColumnIndex(4);
+            if (job.request.endChapter > 0) {
+                ImGui::Text("%d-%d", job.request.startChapter, job.request.endChapter);
+            }
+            else {
+                ImGui::Text("%d-All", job.request.startChapter);
+            }
+
+            ImGui::TableSetColumnIndex(5);
+            RenderDaemonJobActions(job);
+            ImGui::PopID();
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+void Library::RenderDaemonJobActions(const DownloadDaemon::Job& job) {
+    using Status = DownloadDaemon::Status;
+    bool finished = job.status == Status::Complete || job.status == Status::Cancelled;
+    if (finished) return;
+
+    // Each action is its own short request; the change comes back through the watch stream
+    DownloadDaemon::Client client;
+    auto send = [&](bool (DownloadDaemon::Client::*action)(const std::string&)) {
+        if (!client.Connect() || !(client.*action)(job.id)) {
+            daemonMessage = client.LastError();
+        }
+        else {
+            daemonMessage.clear();
+        }
+    };
+
+    if (job.status == Status::Paused || job.status == Status::Failed) {
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.2f, 0.7f, 0.2f, 1.0f));
+        ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.3f, 0.8f, 0.3f, 1.0f));
+        if (ImGui::SmallButton(job.status == Status::Failed ? "Retry" : "Resume")) {
+            send(&DownloadDaemon::Client::Resume);
+        }
+        ImGui::PopStyleColor(2);
+    }
+    else {
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.6f, 0.2f, 1.0f));
+        ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.9f, 0.7f, 0.3f, 1.0f));
+        if (ImGui::SmallButton("Pause")) {
+            send(&DownloadDaemon::Client::Pause);
+        }
+        ImGui::PopStyleColor(2);
+    }
+
+    if (job.status != Status::Failed) {
+        ImGui::SameLine();
+        ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.2f, 0.2f, 1.0f));
+        ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.9f, 0.3f, 0.3f, 1.0f));
+        if (ImGui::SmallButton("Cancel")) {
+            send(&DownloadDaemon::Client::Cancel);
+        }
+        ImGui::PopStyleColor(2);
     }
 }
 
@@ -3514,26 +4407,42 @@ void Library::RenderSearchTab() {
 }
 
 void Library::RenderSearchInput() {
-    static char searchBuffer[256] = "";
-
     ImGui::BeginGroup();
 
-    // Search input line
+    // Search input line; typing searches once the input settles, Enter or the button searches now
     ImGui::Text("Search Query:");
     ImGui::SetNextItemWidth(300);
-    ImGui::InputText("##SearchQuery", searchBuffer, sizeof(searchBuffer));
+    bool submitted = ImGui::InputText("##SearchQuery", onlineSearchBuffer, sizeof(onlineSearchBuffer),
+        ImGuiInputTextFlags_EnterReturnsTrue);
+    if (ImGui::IsItemEdited()) {
+        onlineSearchEditedAt = std::chrono::steady_clock::now();
+        onlineSearchEditPending = true;
+    }
 
     ImGui::SameLine();
-    if (ImGui::Button("Search", ImVec2(80, 0)) && strlen(searchBuffer) > 0) {
-        searchQuery = std::string(searchBuffer);
-        std::thread([this]() {
-            SearchContentWithFilters(searchQuery, currentSearchFilter);
-            }).detach();
+    if ((ImGui::Button("Search", ImVec2(80, 0)) || submitted) && strlen(onlineSearchBuffer) > 0) {
+        onlineSearchEditPending = false;
+        SearchContentWithFilters(onlineSearchBuffer, currentSearchFilter);
     }
 
     ImGui::SameLine();
     if (isSearching) {
-        ImGui::Text("Searching...");
+        ImGui::Text("Searching... (%d sources answered)", onlineSearch.SourcesAnswered());
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Cancel")) {
+            onlineSearch.Cancel();
+            isSearching = false;
+        }
+    }
+    else if (!onlineSearchErrors.empty()) {
+        ImGui::TextDisabled("%zu source(s) failed", onlineSearchErrors.size());
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            for (const std::string& error : onlineSearchErrors) {
+                ImGui::TextUnformatted(error.c_str());
+            }
+            ImGui::EndTooltip();
+        }
     }
 
     ImGui::Spacing();
@@ -3583,6 +4492,16 @@ void Library::RenderSearchResultCard(const SearchResult& result, size_t index) {
 }
 
 void Library::RenderResultCardContent(const SearchResult& result) {
+    auto thumbIt = result.coverUrl.empty() ? coverTextures.end()
+        : coverTextures.find("thumb:" + ThumbnailCache::Key(result.coverUrl));
+    if (thumbIt != coverTextures.end() && thumbIt->second.loaded) {
+        const CoverTexture& thumb = thumbIt->second;
+        float scale = std::min(SEARCH_THUMB_WIDTH / thumb.width, SEARCH_THUMB_HEIGHT / thumb.height);
+        ImGui::Image(reinterpret_cast<ImTextureID>(thumb.descriptorSet), ImVec2(thumb.width * scale, thumb.height * scale));
+        ImGui::SameLine();
+    }
+    ImGui::BeginGroup();
+
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.95f, 1.0f, 1.0f));
     ImGui::Text("%s", result.title.c_str());
     ImGui::PopStyleColor();
@@ -3597,6 +4516,8 @@ void Library::RenderResultCardContent(const SearchResult& result) {
     if (!result.description.empty()) {
         ImGui::TextWrapped("%s", result.description.c_str());
     }
+
+    ImGui::EndGroup();
 }
 
 int Library::FindAvailableDownloadSlot() {
@@ -3781,6 +4702,10 @@ void Library::RenderDownloadOptions(const SearchResult& result, size_t index) {
 }
 
 void Library::RenderDownloadQueue() {
+    if (daemonAttached) {
+        RenderDaemonJobs();
+        return;
+    }
 
     if (downloadQueue.empty()) {
         ImGui::Text("No downloads in queue");
@@ -4012,6 +4937,7 @@ void Library::RenderSourcesTab() {
 
     RenderSourcesTable();
     RenderSourcesManagement();
+    RenderStorageSettings();
 }
 
 void Library::RenderSourcesTable() {
@@ -4096,6 +5022,419 @@ void Library::RenderSourcesManagement() {
     }
 }
 
+void Library::RenderStorageSettings() {
+    if (!chapterTiering) return;
+
+    ImGui::Spacing();
+    ImGui::Separator();
+
+    ImGui::Text(ICON_FA_GEAR "Chapter Storage");
+    ImGui::TextWrapped("Chapters near where you are reading stay uncompressed so they open instantly. "
+        "The rest are compressed in the background.");
+    ImGui::Spacing();
+
+    ChapterTiering::Budget budget = chapterTiering->GetBudget();
+    bool changed = false;
+    ImGui::SetNextItemWidth(200);
+    changed |= ImGui::SliderInt("Chapters ahead", &budget.chaptersAhead, 0, 50);
+    ImGui::SetNextItemWidth(200);
+    changed |= ImGui::SliderInt("Chapters behind", &budget.chaptersBehind, 0, 20);
+    ImGui::SetNextItemWidth(200);
+    changed |= ImGui::SliderInt("Recent novels", &budget.hotNovels, 0, 20);
+    ImGui::SetNextItemWidth(200);
+    changed |= ImGui::SliderInt("Uncompressed limit (MB)", &budget.maxHotMegabytes, 16, 2048);
+    if (changed) {
+        chapterTiering->SetBudget(budget);
+    }
+
+    ImGui::Text("Uncompressed: %zu chapters, %.1f MB", chapterTiering->HotChapters(),
+        chapterTiering->HotBytes() / (1024.0 * 1024.0));
+    ImGui::Text("Compressed: %zu chapters, %.1f MB", chapterTiering->ColdChapters(),
+        chapterTiering->ColdBytes() / (1024.0 * 1024.0));
+
+    BlobStore::Stats store = chapterTiering->StoreStats();
+    ImGui::Text("Shared storage: %zu files in %zu blobs, %.1f MB saved by deduplication", store.references, store.blobs,
+        (store.referencedBytes - store.storedBytes) / (1024.0 * 1024.0));
+
+    if (integrityScanner) {
+        ImGui::Spacing();
+        ImGui::Checkbox("Re-download damaged chapters automatically", &redownloadDamaged);
+
+        std::time_t lastScan = integrityScanner->LastScanTime();
+        if (integrityScanner->IsScanning()) {
+            ImGui::Text("Verifying library: %zu files checked", integrityScanner->CheckedItems());
+        }
+        else if (lastScan > 0) {
+            char dateText[32];
+            std::tm localTime{};
+            localtime_s(&localTime, &lastScan);
+            std::strftime(dateText, sizeof(dateText), "%Y-%m-%d %H:%M", &localTime);
+            ImGui::Text("Last verified %s: %zu files checked, %zu damaged", dateText, integrityScanner->CheckedItems(),
+                integrityScanner->DamagedItems());
+        }
+        else {
+            ImGui::TextDisabled("Library not verified yet");
+        }
+
+        if (ImGui::Button("Verify Library Now", ImVec2(180, 30))) {
+            integrityScanner->RequestScan();
+        }
+        if (integrityScanner->DamagedItems() > 0) {
+            ImGui::SameLine();
+            if (ImGui::Button("Re-download Damaged", ImVec2(180, 30))) {
+                RedownloadDamaged(integrityScanner->CurrentDamage());
+            }
+        }
+    }
+
+    ImGui::Spacing();
+    ImGui::SetNextItemWidth(200);
+    ImGui::SliderInt("Background workers (0 = all cores)", &schedulerWorkers, 0,
+        static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)));
+    ImGui::Checkbox("Pin background workers to cores", &pinSchedulerWorkers);
+    ImGui::TextDisabled("Worker changes apply after a restart (%zu running)", TaskScheduler::Shared().WorkerCount());
+
+    if (ImGui::Button("💾 Save Storage Settings", ImVec2(180, 30))) {
+        SaveStorageSettings();
+    }
+}
+
+void Library::SaveStorageSettings() {
+    try {
+        std::filesystem::create_directories("settings");
+
+        ChapterTiering::Budget budget = chapterTiering->GetBudget();
+        json j;
+        j["chaptersAhead"] = budget.chaptersAhead;
+        j["chaptersBehind"] = budget.chaptersBehind;
+        j["hotNovels"] = budget.hotNovels;
+        j["maxHotMegabytes"] = budget.maxHotMegabytes;
+        j["redownloadDamaged"] = redownloadDamaged;
+        j["schedulerWorkers"] = schedulerWorkers;
+        j["pinSchedulerWorkers"] = pinSchedulerWorkers;
+
+        std::ofstream file("settings/storage_settings.json");
+        if (file.is_open()) {
+            file << j.dump(4);
+            file.close();
+            std::cout << "Storage settings saved" << std::endl;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error saving storage settings: " << e.what() << std::endl;
+    }
+}
+
+void Library::LoadStorageSettings() {
+    try {
+        std::ifstream file("settings/storage_settings.json");
+        if (file.is_open()) {
+            json j;
+            file >> j;
+            file.close();
+
+            ChapterTiering::Budget budget;
+            budget.chaptersAhead = j.value("chaptersAhead", budget.chaptersAhead);
+            budget.chaptersBehind = j.value("chaptersBehind", budget.chaptersBehind);
+            budget.hotNovels = j.value("hotNovels", budget.hotNovels);
+            budget.maxHotMegabytes = j.value("maxHotMegabytes", budget.maxHotMegabytes);
+            chapterTiering->SetBudget(budget);
+            redownloadDamaged = j.value("redownloadDamaged", redownloadDamaged);
+            schedulerWorkers = j.value("schedulerWorkers", schedulerWorkers);
+            pinSchedulerWorkers = j.value("pinSchedulerWorkers", pinSchedulerWorkers);
+        }
+
+        TaskScheduler::Options options;
+        options.workers = static_cast<size_t>(std::max(schedulerWorkers, 0));
+        options.pinWorkers = pinSchedulerWorkers;
+        TaskScheduler::Configure(options);
+    }
+    catch (const std::exception& e) {
+        std::cout << "Could not load storage settings, using defaults: " << e.what() << std::endl;
+    }
+}
+
+void Library::PollIntegrityScanner() {
+    if (!integrityScanner) return;
+
+    std::vector<IntegrityScanner::Damage> damage = integrityScanner->TakeNewDamage();
+    if (!damage.empty() && redownloadDamaged) {
+        RedownloadDamaged(damage);
+    }
+}
+
+// ============================================================================
+// Book import
+// ============================================================================
+
+void Library::QueueImport(const std::string& path) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+            if (entry.is_regular_file(ec) && BookImporter::IsSupported(entry.path().string())) {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+    else if (BookImporter::IsSupported(path)) {
+        files.push_back(path);
+    }
+    if (files.empty()) {
+        std::cout << "Nothing to import in " << path << std::endl;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(importMutex);
+    importQueue.insert(importQueue.end(), files.begin(), files.end());
+    if (importRunning) return;
+
+    // The last worker has emptied the queue and is exiting or gone
+    if (importWorker && importWorker->joinable()) {
+        importWorker->join();
+    }
+    importRunning = true;
+    importWorker = std::make_unique<std::thread>(&Library::ImportWorkerLoop, this);
+}
+
+void Library::ImportWorkerLoop() {
+    while (true) {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(importMutex);
+            if (importQueue.empty()) {
+                importRunning = false;
+                return;
+            }
+            path = importQueue.front();
+            importQueue.erase(importQueue.begin());
+        }
+
+        BookImporter::Result result;
+        BookImporter::Import(path, "Novels", result);
+
+        std::lock_guard<std::mutex> lock(importMutex);
+        importResults.push_back(std::move(result));
+    }
+}
+
+void Library::PollImports() {
+    std::vector<BookImporter::Result> results;
+    {
+        std::lock_guard<std::mutex> lock(importMutex);
+        results.swap(importResults);
+    }
+    if (results.empty()) return;
+
+    bool imported = false;
+    for (const BookImporter::Result& result : results) {
+        if (!result.error.empty()) {
+            importLog.push_back("Failed: " + result.error);
+            continue;
+        }
+
+        // The catalog entry is made here, on the thread that owns novellist
+        Novel novel;
+        novel.name = result.title;
+        novel.authorname = result.author.empty() ? "Unknown" : result.author;
+        novel.synopsis = result.synopsis;
+        novel.totalchapters = static_cast<int>(result.chapters);
+        novel.downloadedchapters = static_cast<int>(result.chapters);
+        novel.progress.readchapters = 0;
+        novel.progress.progresspercentage = 0.0f;
+        AddNovel(novel);
+        imported = true;
+
+        char line[256];
+        snprintf(line, sizeof(line), "Imported %s: %zu chapters in %.0f ms", result.title.c_str(), result.chapters,
+            result.milliseconds);
+        importLog.push_back(line);
+    }
+    if (importLog.size() > 20) {
+        importLog.erase(importLog.begin(), importLog.end() - 20);
+    }
+
+    // New chapters are cleaned and tiered by the sweep and picked up by the indexer's scan
+    if (imported) {
+        if (chapterTiering) chapterTiering->RequestSweep();
+        if (indexingPipeline) indexingPipeline->RequestScan();
+    }
+}
+
+void Library::RenderImportPopup() {
+    if (!ImGui::BeginPopup("ImportBooks")) return;
+
+    ImGui::Text("%s Import Books", ICON_FA_FILE_IMPORT);
+    ImGui::Separator();
+    ImGui::TextDisabled("Drop .txt, .md or .epub files on the window, or enter a file or folder:");
+
+    ImGui::SetNextItemWidth(420);
+    bool submitted = ImGui::InputText("##ImportPath", importPathBuffer, sizeof(importPathBuffer),
+        ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    if ((ImGui::Button("Import", ImVec2(80, 0)) || submitted) && importPathBuffer[0] != '\0') {
+        QueueImport(importPathBuffer);
+        importPathBuffer[0] = '\0';
+    }
+
+    size_t queued = 0;
+    bool running = false;
+    {
+        std::lock_guard<std::mutex> lock(importMutex);
+        queued = importQueue.size();
+        running = importRunning;
+    }
+    if (running) {
+        ImGui::Text("Importing... %zu more queued", queued);
+    }
+
+    for (const std::string& line : importLog) {
+        ImGui::TextWrapped("%s", line.c_str());
+    }
+
+    ImGui::EndPopup();
+}
+
+// ============================================================================
+// Book export
+// ============================================================================
+
+void Library::StartExport(const Novel& novel) {
+    if (exportRunning) return;
+    if (exportWorker && exportWorker->joinable()) {
+        exportWorker->join();
+    }
+
+    BookExporter::Options options;
+    options.format = static_cast<BookExporter::Format>(exportFormat);
+    options.firstChapter = exportFirstChapter;
+    options.lastChapter = exportLastChapter;
+    options.title = novel.name;
+    options.author = novel.authorname;
+    options.synopsis = novel.synopsis;
+    options.coverPath = "Novels/" + novel.name + "/cover.jpg";
+
+    std::error_code ec;
+    std::filesystem::create_directories("Exports", ec);
+    std::string novelDir = "Novels/" + novel.name;
+    std::string outputPath = "Exports/" + novel.name + BookExporter::Extension(options.format);
+
+    exportWritten = 0;
+    exportTotal = 0;
+    exportRunning = true;
+    {
+        std::lock_guard<std::mutex> lock(exportMutex);
+        exportMessage.clear();
+    }
+    exportWorker = std::make_unique<std::thread>([this, novelDir, outputPath, options]() {
+        BookExporter::Result result;
+        bool exported = BookExporter::Export(novelDir, outputPath, options, result,
+            [this](size_t written, size_t total) {
+                exportWritten = written;
+                exportTotal = total;
+            });
+
+        char message[512];
+        if (exported) {
+            snprintf(message, sizeof(message), "Exported %zu chapters to %s (%.1f MB, %.1f s)%s", result.chapters,
+                outputPath.c_str(), result.bytes / (1024.0 * 1024.0), result.milliseconds / 1000.0,
+                result.skipped > 0 ? ", some chapters were unreadable" : "");
+        }
+        else {
+            snprintf(message, sizeof(message), "Export failed: %s", result.error.c_str());
+        }
+        {
+            std::lock_guard<std::mutex> lock(exportMutex);
+            exportMessage = message;
+        }
+        exportRunning = false;
+    });
+}
+
+void Library::RenderExportPopup(const Novel& novel) {
+    if (!ImGui::BeginPopup("ExportBook")) return;
+
+    ImGui::Text("%s Export %s", ICON_FA_FILE_EXPORT, novel.name.c_str());
+    ImGui::Separator();
+
+    const char* formats[] = { "EPUB", "Markdown", "Text" };
+    ImGui::SetNextItemWidth(200);
+    ImGui::Combo("Format", &exportFormat, formats, IM_ARRAYSIZE(formats));
+    ImGui::SetNextItemWidth(200);
+    ImGui::InputInt("From chapter", &exportFirstChapter);
+    ImGui::SetNextItemWidth(200);
+    ImGui::InputInt("To chapter", &exportLastChapter);
+    exportFirstChapter = std::max(exportFirstChapter, 1);
+    exportLastChapter = std::max(exportLastChapter, 0);
+
+    bool running = exportRunning;
+    ImGui::BeginDisabled(running);
+    if (ImGui::Button("Export", ImVec2(120, 0))) {
+        StartExport(novel);
+    }
+    ImGui::EndDisabled();
+
+    if (running) {
+        size_t total = exportTotal;
+        float fraction = total > 0 ? static_cast<float>(exportWritten) / total : 0.0f;
+        ImGui::ProgressBar(fraction, ImVec2(300, 0));
+    }
+    else {
+        std::lock_guard<std::mutex> lock(exportMutex);
+        if (!exportMessage.empty()) ImGui::TextWrapped("%s", exportMessage.c_str());
+    }
+
+    ImGui::EndPopup();
+}
+
+void Library::RedownloadDamaged(const std::vector<IntegrityScanner::Damage>& damage) {
+    // Only novels are downloaded from here; damaged manga pages stay in their journal
+    std::map<std::string, std::vector<int>> chaptersByNovel;
+    for (const auto& item : damage) {
+        if (!item.manga) chaptersByNovel[item.contentName].push_back(item.chapter);
+    }
+
+    for (auto& [novelName, chapters] : chaptersByNovel) {
+        auto novel = std::find_if(novellist.begin(), novellist.end(),
+            [&](const Novel& candidate) { return candidate.name == novelName; });
+        if (novel == novellist.end()) continue;
+
+        std::sort(chapters.begin(), chapters.end());
+        chapters.erase(std::unique(chapters.begin(), chapters.end()), chapters.end());
+
+        // The downloader skips chapters that are already on disk, so damaged files go first
+        std::string novelDir = "Novels/" + novelName;
+        for (int chapter : chapters) {
+            std::error_code ec;
+            std::filesystem::remove(novelDir + "/chapters/chapter" + std::to_string(chapter) + ".json", ec);
+        }
+
+        SearchResult result;
+        result.title = novel->name;
+        result.author = novel->authorname;
+        result.description = novel->synopsis;
+        result.totalChapters = novel->totalchapters;
+
+        // Each run of consecutive chapters is one download
+        for (size_t first = 0; first < chapters.size();) {
+            size_t last = first;
+            while (last + 1 < chapters.size() && chapters[last + 1] == chapters[last] + 1) last++;
+
+            StartDownload(result, chapters[first], chapters[last]);
+            for (size_t i = first; i <= last; i++) {
+                ChapterJournal::Entry entry;
+                entry.chapter = chapters[i];
+                entry.event = ChapterJournal::REDOWNLOAD;
+                entry.detail = "damaged file removed";
+                ChapterJournal::Append(novelDir, entry);
+            }
+            first = last + 1;
+        }
+        std::cout << "Queued " << chapters.size() << " damaged chapters of " << novelName << " for re-download" << std::endl;
+    }
+}
+
 void Library::AddNewDownloadSource() {
     DownloadSource newSource;
     newSource.name = "New Source";
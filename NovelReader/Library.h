@@ -17,23 +17,32 @@
 #include <mutex>
 #include <Windows.h>
 #include <chrono>
+#include <ctime>
+#include <filesystem>
+#include "TrigramIndex.h"
+#include "CatalogSearch.h"
+#include "SearchIndex.h"
+#include "IndexingPipeline.h"
+#include "OnlineSearch.h"
+#include "ThumbnailCache.h"
+#include "ChapterStore.h"
+#include "ChapterTiering.h"
+#include "JsonReader.h"
+#include "BatchReader.h"
+#include "BlobStore.h"
+#include "ChapterJournal.h"
+#include "IntegrityScanner.h"
+#include "ChapterText.h"
+#include "BookImporter.h"
+#include "Catalog.h"
+#include "DownloadJob.h"
+#include "DownloadDaemon.h"
+#include "BookExporter.h"
+#include "TaskScheduler.h"
 
 class Library {
 public:
-    class Novel {
-    public:
-        struct Progress {
-            int readchapters;
-            float progresspercentage;
-        };
-        std::string name;
-        std::string authorname;
-        std::string coverpath;
-        std::string synopsis;
-        int totalchapters;        // Total chapters available online
-        int downloadedchapters;   // Actually downloaded chapters
-        Progress progress;
-    };
+    using Novel = Catalog::Novel;
 
     enum class UIState {
         LIBRARY,     // Show library with tabs (Library/Downloads)
@@ -153,11 +162,22 @@ private:
     std::vector<SearchResult> searchResults;
     std::string searchQuery = "";
     bool isSearching = false;
+
+    // Online search runs off the UI thread and streams results in per source
+    OnlineSearch onlineSearch;
+    char onlineSearchBuffer[256] = "";
+    std::chrono::steady_clock::time_point onlineSearchEditedAt;
+    bool onlineSearchEditPending = false;
+    std::vector<std::string> onlineSearchErrors;
+    // Result covers prefetched by the script, shrunk and cached on disk; uploaded as "thumb:<key>" textures
+    ThumbnailCache coverThumbnails{ "Novels/.cache/covers" };
     std::unique_ptr<std::thread> downloadThread;
     bool downloadManagerRunning = false;
 
     // Member variables
     std::vector<Novel> novellist;
+    std::vector<std::string> removedNovelNames;   // Removed since the last save; not taken back from the file
+    std::vector<Novel> pendingCatalogued;         // Catalogued by another process, listed by the next PollDaemon
     std::unordered_map<std::string, CoverTexture> coverTextures;
     int selectedNovelIndex = -1;
     bool showInfoPanel = false;
@@ -168,7 +188,7 @@ private:
     bool pendingFontUpdate = false;
 
     // UI State
-    int currentLibraryTab = 0; // 0=Library, 1=Downloads
+    int currentLibraryTab = 0; // 0=Library, 1=Downloads, 2=Search
     bool showGrid = true; // true=grid view, false=list view
 
 
@@ -194,7 +214,8 @@ public:
     // Core Library Functions
     // ============================================================================
     void Render();
-    bool SaveNovels(const std::vector<Novel>& novels);
+    // Saves novellist, taking in novels another process (the daemon, the CLI) catalogued meanwhile
+    bool SaveNovels();
     bool AddNovel(const Novel& novel);
     bool RemoveNovel(const std::string& novelName, const std::string& authorName);
     void LoadAllNovelsFromFile();
@@ -202,6 +223,9 @@ public:
     void SwitchToLibrary();
     void RefreshNovelChapterCounts();
 
+    // Imports a local book (or every book in a folder) in the background; thread-safe
+    void QueueImport(const std::string& path);
+
     void LoadFontSizesWithFontAwesome(const char* path);
     void LoadDefaultFontsWithFontAwesome();
     void LoadUIFontWithFontAwesome(const char* path, float size, ImFont** target);
@@ -241,7 +265,13 @@ public:
     void RenderGridHeader();
     void RenderNovelGridView();
     void RenderNovelListView();
+    void RenderLibraryFilterInput();
+    void ApplyLibraryFilter();
+    void EnsureCatalogSearch();
+    int FilteredNovelCount() const;
+    int FilteredNovelAt(int position) const;
     int CalculateGridColumns(float availableWidth);
+    void PrefetchCoverTextures(int startIndex, int endIndex);
 
     // Novel Card Rendering
     void RenderNovelCard(const Novel& novel, int index);
@@ -255,6 +285,8 @@ public:
 
     // Table Rendering
     void SetupTableColumns();
+    void RebuildListSortKeys();
+    void SortListRows();
     void RenderTableRow(const Novel& novel, int index);
     void RenderProgressBar(float percentage);
 
@@ -274,6 +306,12 @@ public:
     void RenderSmallActionButtons(const Novel& novel, float buttonWidth);
     void RenderSynopsisSection(const Novel& novel);
     void RenderChapterOverview(const Novel& novel);
+    void RebuildChapterReadBits(const Novel& novel);
+    void RefreshTextStats(const Novel& novel);
+    bool IsChapterRead(int chapterNum) const;
+    int CountReadChapters(int firstChapter, int lastChapter) const;
+    void RenderChapterJumpBar(const Novel& novel);
+    void RenderChapterMinimap(const Novel& novel);
     void RenderChapterButton(const Novel& novel, int chapterNum, float buttonWidth, float buttonHeight);
     std::tuple<ImVec4, ImVec4, ImVec4, ImVec4> GetChapterButtonColors(bool isRead, bool isCurrentChapter);
     void RenderChapterTooltip(int chapterNum, bool isRead, bool isCurrentChapter);
@@ -302,6 +340,9 @@ public:
 
     // Search functionality
     bool SearchNovels(const std::string& query);
+    bool StartOnlineSearch(const std::string& query, const std::vector<std::string>& args);
+    void PollOnlineSearch();
+    void UploadReadyThumbnails();
     bool ParseSearchResults(const std::string& output);
     void RenderSearchTab();
     void RenderSearchInput();
@@ -325,6 +366,14 @@ public:
     void CancelDownload(const std::string& downloadId);
     bool IsValidTaskIndex(int taskIndex);
 
+    // Download daemon: when one is running it downloads, and the app enqueues and shows its jobs
+    void AttachToDaemon();
+    void PollDaemon();
+    void ListCataloguedNovels(std::vector<Novel>& catalogued);
+    bool EnqueueWithDaemon(const SearchResult& result, int startChapter, int endChapter);
+    void RenderDaemonJobs();
+    void RenderDaemonJobActions(const DownloadDaemon::Job& job);
+
     // Download Queue UI
     void RenderDownloadQueue();
     void RenderDownloadTable();
@@ -342,10 +391,21 @@ public:
     void RenderSourcesTableRow(DownloadSource& source, size_t index);
     void RenderSourcesManagement();
     void AddNewDownloadSource();
+    void RenderStorageSettings();
+    void SaveStorageSettings();
+    void LoadStorageSettings();
+    void PollIntegrityScanner();
+    void PollImports();
+    void ImportWorkerLoop();
+    void RenderImportPopup();
+    void StartExport(const Novel& novel);
+    void RenderExportPopup(const Novel& novel);
+    void RedownloadDamaged(const std::vector<IntegrityScanner::Damage>& damage);
 
     void ParseProgressLine(const std::string& line, DownloadTask& task);
-
-    void CleanupStopSignals();
+    // Returns the novel's folder name, or "" if the line is malformed
+    std::string ParseChapterSavedLine(const std::string& line);
+    void CompactDownloadedNovel(const std::string& novelDirName);
 
     bool CallPythonScriptAsync(const std::string& scriptName, const std::vector<std::string>& args,
         std::function<void(const std::string&)> progressCallback,
@@ -409,6 +469,7 @@ public:
         std::string language = "";
         bool showAdult = false;
         int maxResults = 2;
+        int cacheTtlMinutes = 360;   // How long download_manager.py reuses a source's answer; 0 disables
     };
 
     struct DownloadState {
@@ -455,6 +516,7 @@ public:
 
     struct ProcessInfo {
         std::shared_ptr<std::thread> thread;
+        std::shared_ptr<DownloadJob::Control> control;   // The script's stdin: pause, resume, cancel, stop
         std::atomic<bool> shouldStop;
         std::atomic<bool> shouldTerminate;
         std::string contentName;
@@ -466,6 +528,7 @@ public:
         // Move constructor
         ProcessInfo(ProcessInfo&& other) noexcept
             : thread(std::move(other.thread))
+            , control(std::move(other.control))
             , shouldStop(other.shouldStop.load())
             , shouldTerminate(other.shouldTerminate.load())
             , contentName(std::move(other.contentName))
@@ -482,6 +545,7 @@ public:
                 }
 
                 thread = std::move(other.thread);
+                control = std::move(other.control);
                 shouldStop.store(other.shouldStop.load());
                 shouldTerminate.store(other.shouldTerminate.load());
                 contentName = std::move(other.contentName);
@@ -545,6 +609,16 @@ public:
     void CleanupPartialDownload(const std::string& downloadId, const std::string& contentName, ContentType type);
     void SaveAllReadingProgress();
 
+    // ============================================================================
+    // Library Full-Text Search
+    // ============================================================================
+    void RenderLibrarySearch();
+    void RenderLibrarySearchResults();
+    void PollSearchIndex();
+    void RefreshSearchIndex();
+    void RunLibrarySearch();
+    void OpenSearchHit(const SearchIndex::Hit& hit);
+
     // ============================================================================
     // Font Management
     // ============================================================================
@@ -620,4 +694,124 @@ private:
     };
     MangaViewer mangaViewer;
 
+    // Chapter overview state, rebuilt only when the selected novel's progress changes
+    struct ChapterOverviewState {
+        std::string novelName;
+        int readChapters = -1;
+        int downloadedChapters = -1;
+        std::vector<uint64_t> readBits;
+        int jumpTarget = 1;
+        int scrollToChapter = 0;
+    };
+    ChapterOverviewState chapterOverview;
+
+    // The selected novel's word counts from ingest (ChapterText), reloaded when the file changes
+    struct TextStatsState {
+        std::string novelName;
+        std::filesystem::file_time_type written;
+        std::chrono::steady_clock::time_point checked;
+        ChapterText::NovelStats stats;
+    };
+    TextStatsState textStatsView;
+
+    // Bumped whenever novellist or reading positions change; cached views compare against it
+    uint64_t catalogVersion = 0;
+
+    // List view snapshot: keys are computed once per catalog version, sorts reuse them
+    struct ListSortKey {
+        std::string foldedTitle;
+        std::string foldedAuthor;
+        int titleRank = 0;
+        int authorRank = 0;
+        float progress = 0.0f;
+        std::time_t lastRead = 0;
+        int chapters = 0;
+    };
+
+    struct ListViewState {
+        uint64_t keysVersion = ~0ULL;
+        std::vector<ListSortKey> keys;
+
+        ImGuiID sortColumn = 1;
+        bool sortAscending = true;
+        bool sortValid = false;
+        std::vector<int> sortedOrder;
+        bool rankByRelevance = false;   // Set by typing a filter, cleared by clicking a column header
+
+        bool rowsValid = false;
+        std::vector<int> rows;  // novellist indices, sorted and filtered
+    };
+    ListViewState listView;
+
+    // Fuzzy filter shared by the grid and list views. The index is built on first use and
+    // then kept in step by AddNovel, RemoveNovel and StartDownload.
+    CatalogSearch catalogSearch;
+    bool catalogSearchBuilt = false;
+
+    struct LibraryFilterState {
+        char buffer[128] = "";
+        std::string appliedQuery;
+        uint64_t appliedVersion = ~0ULL;
+        bool active = false;                     // Query has at least one word
+        std::vector<int> ranked;                 // novellist indices, best match first
+        std::vector<uint8_t> mask;               // Per novellist index, for the sorted list view
+        std::unordered_map<std::string, int> indexByKey;   // (title, author) -> novellist index
+        uint64_t indexVersion = ~0ULL;
+        double millis = 0.0;
+    };
+    LibraryFilterState libraryFilter;
+
+    // Full-text search; the pipeline writes the index on a worker, another worker prepares each
+    // reopen and the UI thread swaps it in
+    SearchIndex searchIndex;
+    std::unique_ptr<IndexingPipeline> indexingPipeline;
+    TaskScheduler::TaskHandle searchIndexRefreshTask;
+    std::shared_ptr<SearchIndex::Refresh> preparedSearchIndex;   // Written by searchIndexRefreshTask
+    bool searchIndexRefreshAgain = false;                        // Requested while one was running
+
+    // Keeps chapters near each reading position uncompressed and compresses the rest
+    std::unique_ptr<ChapterTiering> chapterTiering;
+
+    // Verifies chapter files and manga pages in the background
+    std::unique_ptr<IntegrityScanner> integrityScanner;
+    bool redownloadDamaged = false;
+
+    // Shared TaskScheduler settings, applied on the next start
+    int schedulerWorkers = 0;   // 0 = one per hardware thread
+    bool pinSchedulerWorkers = false;
+
+    // Local book imports, one at a time on a worker started when something is queued
+    std::unique_ptr<std::thread> importWorker;
+    std::mutex importMutex;
+    std::vector<std::string> importQueue;              // Guarded by importMutex
+    std::vector<BookImporter::Result> importResults;   // Guarded by importMutex
+    bool importRunning = false;                        // Guarded by importMutex
+    std::vector<std::string> importLog;                // UI thread only; newest last
+    char importPathBuffer[512] = "";
+
+    // Book export, one at a time, to Exports/
+    std::unique_ptr<std::thread> exportWorker;
+    std::atomic<bool> exportRunning{ false };
+    std::atomic<size_t> exportWritten{ 0 };
+    std::atomic<size_t> exportTotal{ 0 };
+    std::mutex exportMutex;
+    std::string exportMessage;                         // Guarded by exportMutex
+    int exportFormat = 0;                              // BookExporter::Format
+    int exportFirstChapter = 1;
+    int exportLastChapter = 0;                         // 0 = last downloaded
+
+    // Download daemon connection, watched on its own thread; detached if the daemon goes away
+    std::unique_ptr<DownloadDaemon::Client> daemonWatch;
+    std::unique_ptr<std::thread> daemonWatcher;
+    std::atomic<bool> daemonAttached{ false };
+    std::atomic<bool> daemonChaptersChanged{ false };
+    std::mutex daemonJobsMutex;
+    std::vector<DownloadDaemon::Job> daemonJobs;       // Guarded by daemonJobsMutex
+    std::string daemonMessage;                         // UI thread only
+    char librarySearchBuffer[256] = "";
+    int librarySearchScope = -1; // -1 = whole library, otherwise novellist index
+    std::vector<SearchIndex::Hit> librarySearchHits;
+    double librarySearchMillis = 0.0;
+    bool librarySearchRan = false;
+
 };
\ No newline at end of file
@@ -1,8 +1,107 @@
 ﻿#define IMGUI_APP_IMPLEMENTATION
 #include "WindowManagment.h"
 #include "Library.h"
+#include <filesystem>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    // Headless search benchmark: NovelReader --bench-search [megabytes]
+    if (argc > 1 && std::string(argv[1]) == "--bench-search") {
+        uint64_t megabytes = (argc > 2) ? std::stoull(argv[2]) : 2048;
+        SearchIndex::RunBenchmark("bench", megabytes * 1024 * 1024);
+        return 0;
+    }
+
+    // Headless search index format tests: NovelReader --test-search
+    if (argc > 1 && std::string(argv[1]) == "--test-search") {
+        return SearchIndex::RunTests("test_search") ? 0 : 1;
+    }
+
+    // Headless regex conformance tests: NovelReader --test-regex
+    if (argc > 1 && std::string(argv[1]) == "--test-regex") {
+        return Regex::RunTests() ? 0 : 1;
+    }
+
+    // Headless storage benchmark: NovelReader --bench-chapters [megabytes]
+    if (argc > 1 && std::string(argv[1]) == "--bench-chapters") {
+        uint64_t megabytes = (argc > 2) ? std::stoull(argv[2]) : 512;
+        ChapterStore::RunBenchmark("bench_chapters", megabytes * 1024 * 1024);
+        return 0;
+    }
+
+    // Headless JSON benchmark over the downloaded chapters: NovelReader --bench-json [megabytes]
+    if (argc > 1 && std::string(argv[1]) == "--bench-json") {
+        uint64_t megabytes = (argc > 2) ? std::stoull(argv[2]) : 256;
+        JsonReader::RunBenchmark("Novels", megabytes * 1024 * 1024);
+        return 0;
+    }
+
+    // Headless JSON reader tests: NovelReader --test-json
+    if (argc > 1 && std::string(argv[1]) == "--test-json") {
+        return JsonReader::RunTests() ? 0 : 1;
+    }
+
+    // Headless blob store tests: NovelReader --test-blobs
+    if (argc > 1 && std::string(argv[1]) == "--test-blobs") {
+        return BlobStore::RunTests("test_blobs") ? 0 : 1;
+    }
+
+    // Headless chapter open benchmark (copies and peak RSS): NovelReader --bench-open [passes]
+    if (argc > 1 && std::string(argv[1]) == "--bench-open") {
+        int passes = (argc > 2) ? std::stoi(argv[2]) : 200;
+        ChapterStore::RunOpenBenchmark("Novels", passes);
+        return 0;
+    }
+
+    // Headless bulk read benchmark, cold and warm cache: NovelReader --bench-io [passes]
+    if (argc > 1 && std::string(argv[1]) == "--bench-io") {
+        int passes = (argc > 2) ? std::stoi(argv[2]) : 3;
+        BatchReader::RunBenchmark("Novels", passes);
+        return 0;
+    }
+
+    // Headless import benchmark on a generated text book: NovelReader --bench-import [megabytes] [chapters]
+    if (argc > 1 && std::string(argv[1]) == "--bench-import") {
+        uint64_t megabytes = (argc > 2) ? std::stoull(argv[2]) : 10;
+        int chapters = (argc > 3) ? std::stoi(argv[3]) : 3000;
+        BookImporter::RunBenchmark("bench_import", megabytes * 1024 * 1024, chapters);
+        return 0;
+    }
+
+    // Headless export benchmark on a generated novel: NovelReader --bench-export [chapters]
+    if (argc > 1 && std::string(argv[1]) == "--bench-export") {
+        int chapters = (argc > 2) ? std::stoi(argv[2]) : 2500;
+        BookExporter::RunBenchmark("bench_export", chapters);
+        return 0;
+    }
+
+    // Headless scheduling overhead benchmark: NovelReader --bench-scheduler [tasks]
+    if (argc > 1 && std::string(argv[1]) == "--bench-scheduler") {
+        int tasks = (argc > 2) ? std::stoi(argv[2]) : 200000;
+        TaskScheduler::RunBenchmark(tasks);
+        return 0;
+    }
+
+    // Headless scheduler stress test: NovelReader --test-scheduler [rounds]
+    if (argc > 1 && std::string(argv[1]) == "--test-scheduler") {
+        int rounds = (argc > 2) ? std::stoi(argv[2]) : 20;
+        return TaskScheduler::RunTests(rounds) ? 0 : 1;
+    }
+
+    // One-off migration of an existing library: NovelReader --compact-library
+    if (argc > 1 && std::string(argv[1]) == "--compact-library") {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator("Novels", ec)) {
+            if (!std::filesystem::is_directory(entry.path() / "chapters")) continue;
+            ChapterStore::CompactStats stats;
+            if (ChapterStore::CompactNovel((entry.path() / "chapters").string(), &stats) && stats.chapters > 0) {
+                std::cout << entry.path().filename().string() << ": " << stats.bytesBefore / 1024 << " KB -> "
+                    << stats.bytesAfter / 1024 << " KB" << std::endl;
+            }
+        }
+        return 0;
+    }
 
-int main() {
     ImGuiApp::Config config;
     config.width = 1600;
     config.height = 900;
@@ -30,6 +129,13 @@ int main() {
         library.Render();
         });
 
+    // Books dropped on the window are imported
+    app.SetEventCallback([&](SDL_Event& event) {
+        if (event.type == SDL_EVENT_DROP_FILE && event.drop.data) {
+            library.QueueImport(event.drop.data);
+        }
+        });
+
     app.Run();
 
     // Save state before exit
@@ -0,0 +1,145 @@
+#include "MappedFile.h"
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+#ifdef _WIN32
+        fileHandle = other.fileHandle;
+        mappingHandle = other.mappingHandle;
+#else
+        fileDescriptor = other.fileDescriptor;
+#endif
+        data = other.data;
+        size = other.size;
+        opened = other.opened;
+        other.Reset();
+    }
+    return *this;
+}
+
+void MappedFile::Reset() {
+#ifdef _WIN32
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    fileDescriptor = -1;
+#endif
+    data = nullptr;
+    size = 0;
+    opened = false;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+    HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cout << "Failed to open file for mapping: " << path << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    size = static_cast<size_t>(fileSize.QuadPart);
+    opened = true;
+
+    // Empty files cannot be mapped, but are still valid (empty view)
+    if (size == 0) {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        std::cout << "Failed to create file mapping: " << path << std::endl;
+        Close();
+        return false;
+    }
+    mappingHandle = mapping;
+
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        std::cout << "Failed to map view of file: " << path << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+    Reset();
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "Failed to open file for mapping: " << path << std::endl;
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    fileDescriptor = fd;
+    size = static_cast<size_t>(fileStat.st_size);
+    opened = true;
+
+    if (size == 0) {
+        return true;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cout << "Failed to map file: " << path << std::endl;
+        Close();
+        return false;
+    }
+    data = static_cast<const char*>(mapped);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data) munmap(const_cast<char*>(data), size);
+    if (fileDescriptor >= 0) ::close(fileDescriptor);
+    Reset();
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file.
+// The view stays valid until Close() or destruction.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return opened; }
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+    std::string_view View() const { return std::string_view(data, size); }
+
+private:
+    void Reset();
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+    const char* data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+};
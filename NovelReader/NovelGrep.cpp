@@ -0,0 +1,174 @@
+#include "NovelGrep.h"
+#include "ChapterStore.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    constexpr size_t MAX_GREP_RESULTS = 10000;
+    constexpr size_t CONTEXT_BEFORE = 60;      // Bytes of the line kept around a match
+    constexpr size_t CONTEXT_AFTER = 100;
+
+    // Parses "chapter123.json" into 123, or returns 0
+    int ChapterNumberFromFile(const std::filesystem::path& path) {
+        std::string stem = path.stem().string();
+        if (path.extension() != ".json" || stem.rfind("chapter", 0) != 0) return 0;
+        try {
+            return std::stoi(stem.substr(7));
+        }
+        catch (...) {
+            return 0;
+        }
+    }
+
+    // Moves a byte position back onto the start of a UTF-8 sequence
+    size_t CharBoundary(std::string_view text, size_t position) {
+        while (position > 0 && position < text.size() && (static_cast<unsigned char>(text[position]) & 0xC0) == 0x80) {
+            position--;
+        }
+        return position;
+    }
+}
+
+NovelGrep::~NovelGrep() {
+    Cancel();
+}
+
+bool NovelGrep::Start(const std::string& chaptersDir, const std::string& pattern, bool caseInsensitive, std::string& error) {
+    Cancel();
+    idleMatchers.clear();   // They point into the previous pattern
+
+    if (!regex.Compile(pattern, caseInsensitive, &error)) {
+        return false;
+    }
+
+    files.clear();
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(chaptersDir, ec)) {
+        int chapterNumber = ChapterNumberFromFile(entry.path());
+        if (chapterNumber > 0) {
+            files.push_back({ entry.path().string(), chapterNumber });
+        }
+    }
+    if (ec) {
+        error = "Cannot read " + chaptersDir;
+        return false;
+    }
+
+    // Submitted in chapter order, so early chapters stream in first
+    std::sort(files.begin(), files.end(), [](const ChapterFile& a, const ChapterFile& b) {
+        return a.chapterNumber < b.chapterNumber;
+    });
+
+    filesDone = 0;
+    resultCount = 0;
+    truncated = false;
+    {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        pending.clear();
+    }
+
+    TaskScheduler& scheduler = TaskScheduler::Shared();
+    token = TaskScheduler::CancellationToken::Create();
+    settledTasks = 0;
+    tasks.reserve(files.size());
+    for (size_t index = 0; index < files.size(); index++) {
+        tasks.push_back(scheduler.Submit([this, index] { RunChapter(index); },
+            TaskScheduler::Priority::Interactive, token));
+    }
+    return true;
+}
+
+void NovelGrep::Cancel() {
+    token.Cancel();
+    for (const auto& task : tasks) {
+        task.Wait();
+    }
+    tasks.clear();
+    settledTasks = 0;
+}
+
+bool NovelGrep::IsRunning() const {
+    // Tasks finish roughly in submission order, so this walks each handle about once
+    while (settledTasks < tasks.size() && tasks[settledTasks].IsDone()) {
+        settledTasks++;
+    }
+    return settledTasks < tasks.size();
+}
+
+void NovelGrep::TakeResults(std::vector<Result>& out) {
+    std::lock_guard<std::mutex> lock(resultsMutex);
+    if (pending.empty()) return;
+    out.insert(out.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+    pending.clear();
+}
+
+void NovelGrep::RunChapter(size_t index) {
+    std::unique_ptr<Regex::Matcher> matcher;
+    {
+        std::lock_guard<std::mutex> lock(matchersMutex);
+        if (!idleMatchers.empty()) {
+            matcher = std::move(idleMatchers.back());
+            idleMatchers.pop_back();
+        }
+    }
+    if (!matcher) matcher = std::make_unique<Regex::Matcher>(regex);
+
+    std::vector<Result> found;
+    SearchChapter(*matcher, files[index].path, files[index].chapterNumber, found);
+    filesDone++;
+
+    if (!found.empty()) {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        pending.insert(pending.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    }
+    std::lock_guard<std::mutex> lock(matchersMutex);
+    idleMatchers.push_back(std::move(matcher));
+}
+
+void NovelGrep::SearchChapter(Regex::Matcher& matcher, const std::string& path, int chapterNumber, std::vector<Result>& found) {
+    // The regex runs over the mapped (or once-decoded) text; only matched lines are copied out
+    ChapterStore::MappedChapter chapter;
+    if (!ChapterStore::OpenChapter(path, chapter)) {
+        std::cout << "Grep: failed to read " << path << std::endl;
+        return;
+    }
+
+    // Same line splitting and trimming as ChapterManager::ParseMarkdownContent
+    std::string_view text = chapter.Body();
+    int paragraphIndex = 0;
+    size_t lineStart = 0;
+    while (lineStart <= text.size() && !token.IsCancelled()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = text.size();
+        std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos) continue;
+        line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+
+        size_t matchStart = 0;
+        size_t matchLength = 0;
+        if (matcher.Search(line, &matchStart, &matchLength)) {
+            if (resultCount.fetch_add(1) >= MAX_GREP_RESULTS) {
+                truncated = true;
+                token.Cancel();   // The chapters still queued are skipped
+                return;
+            }
+
+            size_t from = CharBoundary(line, matchStart > CONTEXT_BEFORE ? matchStart - CONTEXT_BEFORE : 0);
+            size_t to = CharBoundary(line, std::min(line.size(), matchStart + matchLength + CONTEXT_AFTER));
+
+            Result result;
+            result.chapterNumber = chapterNumber;
+            result.paragraphIndex = paragraphIndex;
+            result.context.assign(line.substr(from, to - from));
+            result.matchOffset = matchStart - from;
+            result.matchLength = std::min(matchLength, to - matchStart);
+            found.push_back(std::move(result));
+        }
+        paragraphIndex++;
+    }
+}
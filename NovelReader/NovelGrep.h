@@ -0,0 +1,67 @@
+#pragma once
+#include "Regex.h"
+#include "TaskScheduler.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+// Runs one regex over every chapter of a novel in parallel. The pattern is compiled once and
+// shared; every chapter is an interactive task on the shared TaskScheduler, so a few very
+// long chapters don't leave the other workers idle. Tasks borrow a Regex::Matcher from a
+// small pool, which keeps their lazily built DFAs warm across chapters. Results stream back
+// to the UI thread through TakeResults() while the search is still running.
+class NovelGrep {
+public:
+    struct Result {
+        int chapterNumber = 0;
+        int paragraphIndex = 0;     // Non-empty line index, as used by ChapterManager::ScrollToParagraph
+        std::string context;        // The matching line, trimmed to a window around the match
+        size_t matchOffset = 0;     // Byte range of the match within context
+        size_t matchLength = 0;
+    };
+
+    NovelGrep() = default;
+    ~NovelGrep();
+
+    NovelGrep(const NovelGrep&) = delete;
+    NovelGrep& operator=(const NovelGrep&) = delete;
+
+    // Compiles the pattern and submits the chapter tasks. Returns false with error set if the pattern is invalid.
+    bool Start(const std::string& chaptersDir, const std::string& pattern, bool caseInsensitive, std::string& error);
+    void Cancel();
+
+    bool IsRunning() const;
+    bool IsTruncated() const { return truncated.load(); }
+    size_t FilesDone() const { return filesDone.load(); }
+    size_t FileCount() const { return files.size(); }
+
+    // Moves results found since the last call onto the end of out
+    void TakeResults(std::vector<Result>& out);
+
+private:
+    void RunChapter(size_t index);
+    void SearchChapter(Regex::Matcher& matcher, const std::string& path, int chapterNumber, std::vector<Result>& found);
+
+    struct ChapterFile {
+        std::string path;
+        int chapterNumber = 0;
+    };
+
+    Regex regex;
+    std::vector<ChapterFile> files;
+    TaskScheduler::CancellationToken token;
+    std::vector<TaskScheduler::TaskHandle> tasks;   // One per file, in chapter order
+    mutable size_t settledTasks = 0;                // Leading tasks known to be done
+
+    std::mutex matchersMutex;
+    std::vector<std::unique_ptr<Regex::Matcher>> idleMatchers;   // Guarded by matchersMutex
+
+    std::atomic<size_t> filesDone{ 0 };
+    std::atomic<size_t> resultCount{ 0 };
+    std::atomic<bool> truncated{ false };
+
+    std::mutex resultsMutex;
+    std::vector<Result> pending;   // Guarded by resultsMutex
+};
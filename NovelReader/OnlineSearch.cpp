@@ -0,0 +1,100 @@
+#include "OnlineSearch.h"
+#include "Dependecies/json.h"
+#include <iostream>
+
+using json = nlohmann::json;
+
+OnlineSearch::~OnlineSearch() {
+    Cancel();
+}
+
+void OnlineSearch::Start(const std::vector<std::string>& args) {
+    Cancel();
+
+    current = std::make_shared<Query>();
+    reader = std::make_unique<std::thread>(&OnlineSearch::ReadOutput, current, args);
+}
+
+void OnlineSearch::Cancel() {
+    if (current) {
+        current->cancelled = true;
+        // Ends the scrape and the cover downloads; delivered on start if the script isn't up yet
+        current->control.Send(DownloadJob::Command::Stop);
+    }
+    // The script may be waiting on a slow source; never block the caller on it
+    if (reader && reader->joinable()) {
+        reader->detach();
+    }
+    reader.reset();
+    current.reset();
+}
+
+bool OnlineSearch::IsRunning() const {
+    return current && !current->finished.load();
+}
+
+bool OnlineSearch::IsSearchComplete() const {
+    return !current || current->searchDone.load() || current->finished.load();
+}
+
+int OnlineSearch::SourcesAnswered() const {
+    return current ? current->sourcesAnswered.load() : 0;
+}
+
+void OnlineSearch::Poll(std::vector<SourceBatch>& out, std::vector<CoverFile>& covers) {
+    if (!current) return;
+
+    std::lock_guard<std::mutex> lock(current->mutex);
+    for (SourceBatch& batch : current->batches) {
+        out.push_back(std::move(batch));
+    }
+    current->batches.clear();
+    for (CoverFile& cover : current->covers) {
+        covers.push_back(std::move(cover));
+    }
+    current->covers.clear();
+}
+
+void OnlineSearch::ReadOutput(std::shared_ptr<Query> query, std::vector<std::string> args) {
+    int exitCode = DownloadJob::Run(args, [&](const std::string& line) {
+        if (!query->cancelled) HandleLine(*query, line);
+    }, &query->control);
+
+    if (exitCode != 0 && !query->cancelled) {
+        std::cout << "Search process exited with code " << exitCode << std::endl;
+    }
+    query->finished = true;
+}
+
+void OnlineSearch::HandleLine(Query& query, const std::string& line) {
+    // stderr comes through too; the script's log lines are not ours to parse
+    if (line.empty() || line[0] != '{') return;
+
+    try {
+        json j = json::parse(line);
+        if (j.contains("done")) {
+            query.searchDone = true;
+            return;
+        }
+        if (j.contains("cover_url")) {
+            CoverFile cover;
+            cover.url = j.value("cover_url", "");
+            cover.path = j.value("path", "");
+            std::lock_guard<std::mutex> lock(query.mutex);
+            query.covers.push_back(std::move(cover));
+            return;
+        }
+
+        SourceBatch batch;
+        batch.sourceName = j.value("source", "");
+        batch.resultsJson = j.contains("results") ? j["results"].dump() : "[]";
+        batch.error = j.value("error", "");
+
+        query.sourcesAnswered++;
+        std::lock_guard<std::mutex> lock(query.mutex);
+        query.batches.push_back(std::move(batch));
+    }
+    catch (const std::exception& e) {
+        std::cout << "Ignoring search output line: " << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "DownloadJob.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// Runs "download_manager.py search --stream" off the UI thread. The script searches every
+// source concurrently and prints one JSON line per source as it answers; each line is handed
+// to the UI thread through Poll() without waiting for the slower sources.
+//
+// With --prefetch-covers the script also reports each result cover it downloaded, and keeps
+// running after the last source ("done") until the covers are in.
+//
+// Starting a new query cancels the previous one: it is sent Stop over its stdin, which makes
+// the script exit straight away instead of finishing the scrape and the cover downloads, and
+// its reader thread is detached so the caller never waits for that.
+class OnlineSearch {
+public:
+    struct SourceBatch {
+        std::string sourceName;
+        std::string resultsJson;   // JSON array of result objects
+        std::string error;
+    };
+
+    struct CoverFile {
+        std::string url;
+        std::string path;   // Downloaded image, named after ThumbnailCache::Key(url)
+    };
+
+    OnlineSearch() = default;
+    ~OnlineSearch();
+
+    OnlineSearch(const OnlineSearch&) = delete;
+    OnlineSearch& operator=(const OnlineSearch&) = delete;
+
+    // args as for DownloadJob::Run, starting with "search"
+    void Start(const std::vector<std::string>& args);
+    void Cancel();
+
+    bool IsRunning() const;
+    // Every source has answered, even if covers are still downloading
+    bool IsSearchComplete() const;
+    int SourcesAnswered() const;
+
+    // Moves the batches that arrived since the last call onto the end of out
+    void Poll(std::vector<SourceBatch>& out, std::vector<CoverFile>& covers);
+
+private:
+    // Shared with the reader thread so a cancelled query can outlive this object
+    struct Query {
+        std::mutex mutex;
+        std::vector<SourceBatch> batches;   // Guarded by mutex
+        std::vector<CoverFile> covers;      // Guarded by mutex
+        std::atomic<bool> searchDone{ false };
+        std::atomic<bool> cancelled{ false };
+        std::atomic<bool> finished{ false };
+        std::atomic<int> sourcesAnswered{ 0 };
+        DownloadJob::Control control;
+    };
+
+    static void ReadOutput(std::shared_ptr<Query> query, std::vector<std::string> args);
+    static void HandleLine(Query& query, const std::string& line);
+
+    std::shared_ptr<Query> current;
+    std::unique_ptr<std::thread> reader;
+};
@@ -0,0 +1,1023 @@
+#include "Regex.h"
+#include "TextSearch.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+    constexpr uint32_t MAX_CODEPOINT = 0x10FFFF;
+    constexpr int MAX_REPEAT = 1000;
+    constexpr size_t MAX_NFA_STATES = 200000;
+    constexpr size_t MAX_DFA_STATES = 4096;   // Per Matcher and mode; the cache is flushed beyond this
+
+    using Range = std::pair<uint32_t, uint32_t>;
+
+    // ============================================================================
+    // Syntax tree
+    // ============================================================================
+    struct Node {
+        enum Kind { Class, Concat, Alternate, Repeat, LineBegin, LineEnd, Empty };
+        Kind kind = Empty;
+        std::vector<Range> ranges;                    // Class: sorted, merged codepoint ranges
+        std::vector<std::unique_ptr<Node>> children;
+        int min = 0;
+        int max = -1;                                 // -1 = unbounded
+
+        explicit Node(Kind k) : kind(k) {}
+    };
+
+    void NormalizeRanges(std::vector<Range>& ranges) {
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<Range> merged;
+        for (const Range& range : ranges) {
+            if (!merged.empty() && range.first <= merged.back().second + 1) {
+                merged.back().second = std::max(merged.back().second, range.second);
+            }
+            else {
+                merged.push_back(range);
+            }
+        }
+        ranges.swap(merged);
+    }
+
+    std::vector<Range> ComplementRanges(const std::vector<Range>& ranges) {
+        std::vector<Range> result;
+        uint32_t next = 0;
+        for (const Range& range : ranges) {
+            if (range.first > next) result.push_back({ next, range.first - 1 });
+            next = range.second + 1;
+        }
+        if (next <= MAX_CODEPOINT) result.push_back({ next, MAX_CODEPOINT });
+        return result;
+    }
+
+    // Every codepoint that folds to the same character as another one, grouped by fold target
+    const std::unordered_map<uint32_t, std::vector<uint32_t>>& CaseVariants() {
+        static const std::unordered_map<uint32_t, std::vector<uint32_t>> variants = []() {
+            std::unordered_map<uint32_t, std::vector<uint32_t>> map;
+            for (uint32_t cp = 0; cp < 0x10000; cp++) {
+                uint32_t folded = TextSearch::FoldCodepoint(cp);
+                if (folded != cp) {
+                    auto& group = map[folded];
+                    if (group.empty()) group.push_back(folded);
+                    group.push_back(cp);
+                }
+            }
+            return map;
+        }();
+        return variants;
+    }
+
+    void AddCaseVariants(std::vector<Range>& ranges) {
+        auto contains = [&](uint32_t cp) {
+            auto it = std::upper_bound(ranges.begin(), ranges.end(), Range(cp, MAX_CODEPOINT));
+            return it != ranges.begin() && std::prev(it)->second >= cp;
+        };
+
+        std::vector<Range> extra;
+        for (const auto& [folded, group] : CaseVariants()) {
+            bool any = std::any_of(group.begin(), group.end(), contains);
+            if (!any) continue;
+            for (uint32_t cp : group) extra.push_back({ cp, cp });
+        }
+        ranges.insert(ranges.end(), extra.begin(), extra.end());
+        NormalizeRanges(ranges);
+    }
+
+    // ============================================================================
+    // Parser
+    // ============================================================================
+    class Parser {
+    public:
+        Parser(std::string_view pattern, bool caseInsensitive) : pattern(pattern), caseInsensitive(caseInsensitive) {}
+
+        std::unique_ptr<Node> Parse(std::string& error) {
+            std::unique_ptr<Node> root = ParseAlternation();
+            if (failed.empty() && position < pattern.size()) {
+                Fail(pattern[position] == ')' ? "unmatched ')'" : "unexpected character");
+            }
+            error = failed;
+            return failed.empty() ? std::move(root) : nullptr;
+        }
+
+    private:
+        bool AtEnd() const { return position >= pattern.size(); }
+        char Peek() const { return pattern[position]; }
+        void Fail(const std::string& message) {
+            if (failed.empty()) failed = message + " at position " + std::to_string(position);
+        }
+
+        uint32_t ReadCodepoint() {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(pattern.data()) + position;
+            const unsigned char* end = reinterpret_cast<const unsigned char*>(pattern.data()) + pattern.size();
+            const unsigned char* begin = p;
+            uint32_t cp = TextSearch::DecodeUtf8(p, end);
+            position += p - begin;
+            return cp;
+        }
+
+        std::unique_ptr<Node> MakeClass(std::vector<Range> ranges) {
+            NormalizeRanges(ranges);
+            if (caseInsensitive) AddCaseVariants(ranges);
+            auto node = std::make_unique<Node>(Node::Class);
+            node->ranges = std::move(ranges);
+            return node;
+        }
+
+        std::unique_ptr<Node> ParseAlternation() {
+            std::unique_ptr<Node> first = ParseSequence();
+            if (AtEnd() || Peek() != '|') return first;
+
+            auto node = std::make_unique<Node>(Node::Alternate);
+            node->children.push_back(std::move(first));
+            while (!AtEnd() && Peek() == '|' && failed.empty()) {
+                position++;
+                node->children.push_back(ParseSequence());
+            }
+            return node;
+        }
+
+        std::unique_ptr<Node> ParseSequence() {
+            auto node = std::make_unique<Node>(Node::Concat);
+            while (!AtEnd() && Peek() != '|' && Peek() != ')' && failed.empty()) {
+                node->children.push_back(ParseRepeat());
+            }
+            if (node->children.size() == 1) return std::move(node->children[0]);
+            if (node->children.empty()) return std::make_unique<Node>(Node::Empty);
+            return node;
+        }
+
+        bool ReadNumber(int& value) {
+            size_t start = position;
+            value = 0;
+            while (!AtEnd() && Peek() >= '0' && Peek() <= '9') {
+                value = std::min(value * 10 + (Peek() - '0'), MAX_REPEAT + 1);
+                position++;
+            }
+            return position > start;
+        }
+
+        std::unique_ptr<Node> ParseRepeat() {
+            std::unique_ptr<Node> atom = ParseAtom();
+
+            while (!AtEnd() && failed.empty()) {
+                int min = 0;
+                int max = -1;
+                char c = Peek();
+                if (c == '*') { position++; }
+                else if (c == '+') { position++; min = 1; }
+                else if (c == '?') { position++; max = 1; }
+                else if (c == '{') {
+                    size_t braceStart = position++;
+                    if (!ReadNumber(min)) {
+                        // Not a quantifier; treat the brace as a literal like most engines do
+                        position = braceStart;
+                        break;
+                    }
+                    max = min;
+                    if (!AtEnd() && Peek() == ',') {
+                        position++;
+                        if (!ReadNumber(max)) max = -1;
+                    }
+                    if (AtEnd() || Peek() != '}') {
+                        Fail("unterminated {m,n}");
+                        break;
+                    }
+                    position++;
+                    if (min > MAX_REPEAT || max > MAX_REPEAT || (max >= 0 && max < min)) {
+                        Fail("invalid repeat count");
+                        break;
+                    }
+                }
+                else {
+                    break;
+                }
+
+                if (atom->kind == Node::LineBegin || atom->kind == Node::LineEnd || atom->kind == Node::Empty) {
+                    Fail("nothing to repeat");
+                    break;
+                }
+
+                // Laziness doesn't change leftmost-longest results
+                if (!AtEnd() && Peek() == '?') position++;
+
+                auto repeat = std::make_unique<Node>(Node::Repeat);
+                repeat->min = min;
+                repeat->max = max;
+                repeat->children.push_back(std::move(atom));
+                atom = std::move(repeat);
+            }
+            return atom;
+        }
+
+        // Shorthand classes shared by escapes inside and outside brackets
+        bool ShorthandClass(char c, std::vector<Range>& ranges) {
+            std::vector<Range> set;
+            switch (c) {
+            case 'd': case 'D': set = { {'0', '9'} }; break;
+            case 'w': case 'W': set = { {'0', '9'}, {'A', 'Z'}, {'_', '_'}, {'a', 'z'} }; break;
+            case 's': case 'S': set = { {'\t', '\r'}, {' ', ' '} }; break;
+            default: return false;
+            }
+            if (c >= 'A' && c <= 'Z') set = ComplementRanges(set);
+            ranges.insert(ranges.end(), set.begin(), set.end());
+            return true;
+        }
+
+        uint32_t EscapedCodepoint() {
+            char c = Peek();
+            position++;
+            switch (c) {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'r': return '\r';
+            case 'f': return '\f';
+            case 'v': return '\v';
+            case '0': return 0;
+            case 'x': {
+                uint32_t value = 0;
+                for (int i = 0; i < 2; i++) {
+                    if (AtEnd() || !std::isxdigit(static_cast<unsigned char>(Peek()))) {
+                        Fail("bad \\x escape");
+                        return 0;
+                    }
+                    char h = Peek();
+                    value = value * 16 + static_cast<uint32_t>((h <= '9') ? h - '0' : (h | 0x20) - 'a' + 10);
+                    position++;
+                }
+                return value;
+            }
+            default:
+                if (std::isalnum(static_cast<unsigned char>(c))) {
+                    position--;
+                    Fail(std::string("unsupported escape \\") + c);
+                    return 0;
+                }
+                position--;
+                return ReadCodepoint();
+            }
+        }
+
+        std::unique_ptr<Node> ParseBracket() {
+            bool negate = false;
+            if (!AtEnd() && Peek() == '^') {
+                negate = true;
+                position++;
+            }
+
+            std::vector<Range> ranges;
+            bool first = true;
+            while (!AtEnd() && (Peek() != ']' || first) && failed.empty()) {
+                first = false;
+                uint32_t low;
+                if (Peek() == '\\') {
+                    position++;
+                    if (AtEnd()) break;
+                    if (ShorthandClass(Peek(), ranges)) {
+                        position++;
+                        continue;
+                    }
+                    low = EscapedCodepoint();
+                }
+                else {
+                    low = ReadCodepoint();
+                }
+
+                uint32_t high = low;
+                if (position + 1 < pattern.size() && Peek() == '-' && pattern[position + 1] != ']') {
+                    position++;
+                    if (Peek() == '\\') {
+                        position++;
+                        high = EscapedCodepoint();
+                    }
+                    else {
+                        high = ReadCodepoint();
+                    }
+                    if (high < low) {
+                        Fail("inverted range in class");
+                    }
+                }
+                ranges.push_back({ low, high });
+            }
+
+            if (AtEnd()) {
+                Fail("unterminated [");
+                return std::make_unique<Node>(Node::Empty);
+            }
+            position++;  // ']'
+
+            if (negate) {
+                // Fold first so [^a] also excludes 'A' when case-insensitive
+                NormalizeRanges(ranges);
+                if (caseInsensitive) AddCaseVariants(ranges);
+                ranges = ComplementRanges(ranges);
+                auto node = std::make_unique<Node>(Node::Class);
+                node->ranges = std::move(ranges);
+                return node;
+            }
+            return MakeClass(std::move(ranges));
+        }
+
+        std::unique_ptr<Node> ParseAtom() {
+            char c = Peek();
+            switch (c) {
+            case '(': {
+                position++;
+                if (position + 1 < pattern.size() && Peek() == '?' && pattern[position + 1] == ':') {
+                    position += 2;
+                }
+                std::unique_ptr<Node> inner = ParseAlternation();
+                if (AtEnd() || Peek() != ')') {
+                    Fail("missing ')'");
+                    return inner;
+                }
+                position++;
+                return inner;
+            }
+            case '[':
+                position++;
+                return ParseBracket();
+            case '.':
+                position++;
+                return MakeClass(ComplementRanges({ {'\n', '\n'} }));
+            case '^':
+                position++;
+                return std::make_unique<Node>(Node::LineBegin);
+            case '$':
+                position++;
+                return std::make_unique<Node>(Node::LineEnd);
+            case '*': case '+': case '?':
+                Fail("nothing to repeat");
+                return std::make_unique<Node>(Node::Empty);
+            case '\\': {
+                position++;
+                if (AtEnd()) {
+                    Fail("trailing backslash");
+                    return std::make_unique<Node>(Node::Empty);
+                }
+                std::vector<Range> ranges;
+                if (ShorthandClass(Peek(), ranges)) {
+                    position++;
+                    auto node = std::make_unique<Node>(Node::Class);
+                    node->ranges = std::move(ranges);
+                    NormalizeRanges(node->ranges);
+                    return node;
+                }
+                uint32_t cp = EscapedCodepoint();
+                return MakeClass({ {cp, cp} });
+            }
+            default: {
+                uint32_t cp = ReadCodepoint();
+                return MakeClass({ {cp, cp} });
+            }
+            }
+        }
+
+        std::string_view pattern;
+        bool caseInsensitive;
+        size_t position = 0;
+        std::string failed;
+    };
+
+    // ============================================================================
+    // UTF-8 byte sequences for codepoint ranges
+    // ============================================================================
+    using ByteSequence = std::vector<std::pair<uint8_t, uint8_t>>;
+
+    size_t EncodeUtf8(uint32_t cp, uint8_t* out) {
+        if (cp < 0x80) { out[0] = static_cast<uint8_t>(cp); return 1; }
+        if (cp < 0x800) {
+            out[0] = static_cast<uint8_t>(0xC0 | (cp >> 6));
+            out[1] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+            return 2;
+        }
+        if (cp < 0x10000) {
+            out[0] = static_cast<uint8_t>(0xE0 | (cp >> 12));
+            out[1] = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+            out[2] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+            return 3;
+        }
+        out[0] = static_cast<uint8_t>(0xF0 | (cp >> 18));
+        out[1] = static_cast<uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+        return 4;
+    }
+
+    // Splits [low, high] until both ends encode to the same length and differ only in
+    // whole trailing bytes; each piece is then a sequence of per-byte ranges
+    void SplitUtf8Range(uint32_t low, uint32_t high, std::vector<ByteSequence>& out) {
+        static const uint32_t lengthLimits[] = { 0x7F, 0x7FF, 0xFFFF };
+        for (uint32_t limit : lengthLimits) {
+            if (low <= limit && high > limit) {
+                SplitUtf8Range(low, limit, out);
+                SplitUtf8Range(limit + 1, high, out);
+                return;
+            }
+        }
+
+        for (int i = 1; i < 4; i++) {
+            uint32_t mask = (1u << (6 * i)) - 1;
+            if ((low & ~mask) != (high & ~mask)) {
+                if ((low & mask) != 0) {
+                    SplitUtf8Range(low, low | mask, out);
+                    SplitUtf8Range((low | mask) + 1, high, out);
+                    return;
+                }
+                if ((high & mask) != mask) {
+                    SplitUtf8Range(low, (high & ~mask) - 1, out);
+                    SplitUtf8Range(high & ~mask, high, out);
+                    return;
+                }
+            }
+        }
+
+        uint8_t a[4], b[4];
+        size_t length = EncodeUtf8(low, a);
+        EncodeUtf8(high, b);
+        ByteSequence sequence;
+        for (size_t i = 0; i < length; i++) sequence.push_back({ a[i], b[i] });
+        out.push_back(std::move(sequence));
+    }
+}
+
+// ============================================================================
+// NFA construction
+// ============================================================================
+struct Regex::Compiler {
+    struct Fragment {
+        int start = -1;
+        std::vector<std::pair<int, int>> outs;   // (state, 0 = out / 1 = out1) left dangling
+    };
+
+    Regex& regex;
+    bool tooLarge = false;
+
+    explicit Compiler(Regex& r) : regex(r) {}
+
+    int AddState(State::Type type, int byteSet = -1) {
+        if (regex.states.size() >= MAX_NFA_STATES) tooLarge = true;
+        State state;
+        state.type = type;
+        state.byteSet = byteSet;
+        regex.states.push_back(state);
+        return static_cast<int>(regex.states.size()) - 1;
+    }
+
+    void Patch(const std::vector<std::pair<int, int>>& outs, int target) {
+        for (const auto& [state, slot] : outs) {
+            if (slot == 0) regex.states[state].out = target;
+            else regex.states[state].out1 = target;
+        }
+    }
+
+    int AddByteSet(uint8_t low, uint8_t high) {
+        std::array<uint64_t, 4> set{};
+        for (int b = low; b <= high; b++) set[b >> 6] |= 1ull << (b & 63);
+        regex.byteSets.push_back(set);
+        return static_cast<int>(regex.byteSets.size()) - 1;
+    }
+
+    Fragment Epsilon() {
+        int state = AddState(State::Epsilon);
+        return { state, { {state, 0} } };
+    }
+
+    Fragment Alternate(std::vector<Fragment> parts) {
+        if (parts.empty()) return Epsilon();
+        Fragment result = std::move(parts[0]);
+        for (size_t i = 1; i < parts.size(); i++) {
+            int split = AddState(State::Split);
+            regex.states[split].out = result.start;
+            regex.states[split].out1 = parts[i].start;
+            result.start = split;
+            result.outs.insert(result.outs.end(), parts[i].outs.begin(), parts[i].outs.end());
+        }
+        return result;
+    }
+
+    Fragment CompileClass(const std::vector<Range>& ranges) {
+        std::vector<ByteSequence> sequences;
+        for (const Range& range : ranges) SplitUtf8Range(range.first, range.second, sequences);
+
+        // All single-byte pieces share one state; longer sequences become chains
+        std::array<uint64_t, 4> ascii{};
+        bool hasAscii = false;
+        std::vector<Fragment> parts;
+        for (const ByteSequence& sequence : sequences) {
+            if (sequence.size() == 1) {
+                for (int b = sequence[0].first; b <= sequence[0].second; b++) ascii[b >> 6] |= 1ull << (b & 63);
+                hasAscii = true;
+                continue;
+            }
+
+            Fragment chain;
+            int previous = -1;
+            for (const auto& [low, high] : sequence) {
+                int state = AddState(State::Bytes, AddByteSet(low, high));
+                if (previous < 0) chain.start = state;
+                else regex.states[previous].out = state;
+                previous = state;
+            }
+            chain.outs.push_back({ previous, 0 });
+            parts.push_back(std::move(chain));
+        }
+
+        if (hasAscii) {
+            regex.byteSets.push_back(ascii);
+            int state = AddState(State::Bytes, static_cast<int>(regex.byteSets.size()) - 1);
+            parts.insert(parts.begin(), Fragment{ state, { {state, 0} } });
+        }
+
+        if (parts.empty()) {
+            // Empty class: a state that never matches
+            int state = AddState(State::Bytes, static_cast<int>(regex.byteSets.size()));
+            regex.byteSets.push_back({});
+            return { state, { {state, 0} } };
+        }
+        return Alternate(std::move(parts));
+    }
+
+    Fragment Star(Fragment body) {
+        int split = AddState(State::Split);
+        regex.states[split].out = body.start;
+        Patch(body.outs, split);
+        return { split, { {split, 1} } };
+    }
+
+    Fragment Optional(Fragment body) {
+        int split = AddState(State::Split);
+        regex.states[split].out = body.start;
+        body.outs.push_back({ split, 1 });
+        return { split, std::move(body.outs) };
+    }
+
+    Fragment Concat(Fragment a, Fragment b) {
+        Patch(a.outs, b.start);
+        return { a.start, std::move(b.outs) };
+    }
+
+    Fragment Compile(const Node& node) {
+        if (tooLarge) return Epsilon();
+
+        switch (node.kind) {
+        case Node::Class:
+            return CompileClass(node.ranges);
+        case Node::LineBegin: {
+            int state = AddState(State::LineBegin);
+            return { state, { {state, 0} } };
+        }
+        case Node::LineEnd: {
+            int state = AddState(State::LineEnd);
+            return { state, { {state, 0} } };
+        }
+        case Node::Empty:
+            return Epsilon();
+        case Node::Concat: {
+            Fragment result = Compile(*node.children[0]);
+            for (size_t i = 1; i < node.children.size(); i++) {
+                result = Concat(std::move(result), Compile(*node.children[i]));
+            }
+            return result;
+        }
+        case Node::Alternate: {
+            std::vector<Fragment> parts;
+            for (const auto& child : node.children) parts.push_back(Compile(*child));
+            return Alternate(std::move(parts));
+        }
+        case Node::Repeat: {
+            // x{m,n} = m copies of x followed by (n - m) optional copies, or x* when unbounded
+            const Node& body = *node.children[0];
+            Fragment result = Epsilon();
+            for (int i = 0; i < node.min; i++) result = Concat(std::move(result), Compile(body));
+            if (node.max < 0) {
+                result = Concat(std::move(result), Star(Compile(body)));
+            }
+            else {
+                for (int i = node.min; i < node.max && !tooLarge; i++) {
+                    result = Concat(std::move(result), Optional(Compile(body)));
+                }
+            }
+            return result;
+        }
+        }
+        return Epsilon();
+    }
+};
+
+bool Regex::Compile(std::string_view pattern, bool caseInsensitive, std::string* error) {
+    states.clear();
+    byteSets.clear();
+    startState = -1;
+
+    std::string parseError;
+    Parser parser(pattern, caseInsensitive);
+    std::unique_ptr<Node> root = parser.Parse(parseError);
+    if (!root) {
+        if (error) *error = parseError;
+        return false;
+    }
+
+    Compiler compiler(*this);
+    Compiler::Fragment fragment = compiler.Compile(*root);
+    int match = compiler.AddState(State::Match);
+    compiler.Patch(fragment.outs, match);
+
+    if (compiler.tooLarge) {
+        states.clear();
+        byteSets.clear();
+        if (error) *error = "pattern is too large";
+        return false;
+    }
+
+    startState = fragment.start;
+    return true;
+}
+
+// ============================================================================
+// Lazy DFA
+// ============================================================================
+Regex::Matcher::Matcher(const Regex& r) : regex(r) {
+    visitMark.assign(regex.states.size(), 0);
+    if (regex.IsValid()) {
+        Closure({ regex.startState }, false, unanchoredRestart);
+    }
+}
+
+void Regex::Matcher::Closure(const std::vector<int>& seeds, bool atLineStart, std::vector<int>& out) {
+    out.clear();
+    if (++visitGeneration == 0) {
+        std::fill(visitMark.begin(), visitMark.end(), 0);
+        visitGeneration = 1;
+    }
+
+    stack.assign(seeds.begin(), seeds.end());
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        if (id < 0 || visitMark[id] == visitGeneration) continue;
+        visitMark[id] = visitGeneration;
+
+        const State& state = regex.states[id];
+        switch (state.type) {
+        case State::Split:
+            stack.push_back(state.out1);
+            stack.push_back(state.out);
+            break;
+        case State::Epsilon:
+            stack.push_back(state.out);
+            break;
+        case State::LineBegin:
+            if (atLineStart) stack.push_back(state.out);
+            break;
+        case State::Bytes:
+        case State::LineEnd:
+        case State::Match:
+            out.push_back(id);
+            break;
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
+
+bool Regex::Matcher::ReachesMatchAtEnd(const std::vector<int>& nfaStates, bool atLineStart) {
+    std::vector<int> seeds;
+    for (int id : nfaStates) {
+        const State& state = regex.states[id];
+        if (state.type == State::Match) return true;
+        if (state.type == State::LineEnd) seeds.push_back(state.out);
+    }
+
+    // Several "$" in a row, or "$" followed by optional parts, still end at the line end.
+    // "^" after "$" only holds on an empty line, which Search checks separately.
+    while (!seeds.empty()) {
+        std::vector<int> reached;
+        Closure(seeds, atLineStart, reached);
+        seeds.clear();
+        for (int id : reached) {
+            const State& state = regex.states[id];
+            if (state.type == State::Match) return true;
+            if (state.type == State::LineEnd) seeds.push_back(state.out);
+        }
+    }
+    return false;
+}
+
+int Regex::Matcher::AddState(Dfa& dfa, std::vector<int>&& nfaStates) {
+    auto it = dfa.lookup.find(nfaStates);
+    if (it != dfa.lookup.end()) return it->second;
+
+    DfaState state;
+    state.next.fill(-1);
+    state.accepting = std::any_of(nfaStates.begin(), nfaStates.end(),
+        [&](int id) { return regex.states[id].type == State::Match; });
+    state.acceptingAtEnd = state.accepting || ReachesMatchAtEnd(nfaStates, false);
+    state.nfaStates = nfaStates;
+
+    int index = static_cast<int>(dfa.states.size());
+    dfa.lookup.emplace(std::move(nfaStates), index);
+    dfa.states.push_back(std::move(state));
+    return index;
+}
+
+int Regex::Matcher::StartState(bool anchored, bool atLineStart) {
+    Dfa& dfa = dfas[anchored ? 1 : 0];
+    int& start = dfa.start[atLineStart ? 1 : 0];
+    if (start < 0) {
+        std::vector<int> set;
+        Closure({ regex.startState }, atLineStart, set);
+        start = AddState(dfa, std::move(set));
+    }
+    return start;
+}
+
+int Regex::Matcher::Step(bool anchored, int state, unsigned char byte) {
+    Dfa& dfa = dfas[anchored ? 1 : 0];
+    int cached = dfa.states[state].next[byte];
+    if (cached >= 0) return cached;
+
+    std::vector<int> seeds;
+    for (int id : dfa.states[state].nfaStates) {
+        const State& nfaState = regex.states[id];
+        if (nfaState.type == State::Bytes && (regex.byteSets[nfaState.byteSet][byte >> 6] >> (byte & 63)) & 1) {
+            seeds.push_back(nfaState.out);
+        }
+    }
+
+    std::vector<int> set;
+    Closure(seeds, false, set);
+    if (!anchored) {
+        // Unanchored search restarts the pattern at every position
+        std::vector<int> merged;
+        std::set_union(set.begin(), set.end(), unanchoredRestart.begin(), unanchoredRestart.end(), std::back_inserter(merged));
+        set.swap(merged);
+    }
+
+    // Bound memory on pathological patterns: drop the cache and keep going from this state
+    if (dfa.states.size() >= MAX_DFA_STATES) {
+        dfa.states.clear();
+        dfa.lookup.clear();
+        dfa.start[0] = dfa.start[1] = -1;
+        return AddState(dfa, std::move(set));
+    }
+
+    int next = AddState(dfa, std::move(set));
+    dfa.states[state].next[byte] = next;
+    return next;
+}
+
+bool Regex::Matcher::Search(std::string_view line, size_t* matchStart, size_t* matchLength) {
+    if (!regex.IsValid()) return false;
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(line.data());
+    const size_t size = line.size();
+
+    // Pass 1: unanchored scan to the end of the earliest match
+    int state = StartState(false, true);
+    size_t earliestEnd = SIZE_MAX;
+    if (size == 0) {
+        if (ReachesMatchAtEnd(dfas[0].states[state].nfaStates, true)) {
+            if (matchStart) *matchStart = 0;
+            if (matchLength) *matchLength = 0;
+            return true;
+        }
+        return false;
+    }
+    if (dfas[0].states[state].accepting) {
+        earliestEnd = 0;
+    }
+    else {
+        for (size_t i = 0; i < size; i++) {
+            state = Step(false, state, bytes[i]);
+            if (dfas[0].states[state].accepting) {
+                earliestEnd = i + 1;
+                break;
+            }
+        }
+        if (earliestEnd == SIZE_MAX && dfas[0].states[state].acceptingAtEnd) {
+            earliestEnd = size;
+        }
+    }
+    if (earliestEnd == SIZE_MAX) return false;
+    if (!matchStart && !matchLength) return true;
+
+    // Pass 2: the leftmost start that can match lies at or before that end; take its longest match
+    for (size_t start = 0; start <= earliestEnd; start++) {
+        state = StartState(true, start == 0);
+        size_t lastEnd = SIZE_MAX;
+        if (dfas[1].states[state].accepting) lastEnd = start;
+
+        size_t i = start;
+        for (; i < size; i++) {
+            state = Step(true, state, bytes[i]);
+            if (dfas[1].states[state].nfaStates.empty()) break;
+            if (dfas[1].states[state].accepting) lastEnd = i + 1;
+        }
+        if (i == size && dfas[1].states[state].acceptingAtEnd) lastEnd = size;
+
+        if (lastEnd != SIZE_MAX) {
+            if (matchStart) *matchStart = start;
+            if (matchLength) *matchLength = lastEnd - start;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Self-test
+// ============================================================================
+bool Regex::RunTests() {
+    struct Case {
+        const char* pattern;
+        bool caseInsensitive;
+        const char* line;
+        int start;      // -1: no match
+        int length;
+    };
+
+    // Expected spans are leftmost-longest, in bytes
+    static const Case cases[] = {
+        // Literals and concatenation
+        { "abc", false, "xxabcxx", 2, 3 },
+        { "abc", false, "ab", -1, 0 },
+        { "", false, "abc", 0, 0 },
+        { "", false, "", 0, 0 },
+        { "a", false, "", -1, 0 },
+
+        // Alternation takes the longest, not the first, alternative
+        { "a|ab", false, "abc", 0, 2 },
+        { "ab|a", false, "abc", 0, 2 },
+        { "cat|dog", false, "hotdog", 3, 3 },
+        { "(a|b|c)d", false, "xcd", 1, 2 },
+        { "x(|y)z", false, "xz xyz", 0, 2 },
+
+        // Quantifiers
+        { "a*", false, "bbb", 0, 0 },
+        { "a*", false, "aaab", 0, 3 },
+        { "ba*", false, "xbaaa", 1, 4 },
+        { "a+", false, "bbaab", 2, 2 },
+        { "colou?r", false, "color colour", 0, 5 },
+        { "a{3}", false, "aaaa", 0, 3 },
+        { "a{2,}", false, "aaaaa", 0, 5 },
+        { "a{2,3}", false, "a aa aaaa", 2, 2 },
+        { "a{0}b", false, "ab", 1, 1 },
+        { "(ab){2}", false, "ababab", 0, 4 },
+        { "a{,2}", false, "a{,2}", 0, 5 },   // Not a quantifier: a literal brace
+        { "x{", false, "x{", 0, 2 },
+        { "a+?", false, "aaa", 0, 3 },       // Lazy suffix is accepted, matching stays longest
+        { "a*?b", false, "aab", 0, 3 },
+        { "(a*)*b", false, "aaab", 0, 4 },
+        { "(a|aa)*c", false, "aaaac", 0, 5 },
+
+        // Leftmost wins over longest
+        { "b+|a+b+", false, "aabbb", 0, 5 },
+        { "bc|abcd", false, "abcd", 0, 4 },
+        { "b|abc", false, "xabc", 1, 3 },
+
+        // Classes and shorthands
+        { "[abc]+", false, "xxcabz", 2, 3 },
+        { "[^abc]+", false, "abxyc", 2, 2 },
+        { "[a-c]+", false, "dcbad", 1, 3 },
+        { "[-a]+", false, "x-a-", 1, 3 },
+        { "[a-]+", false, "x-a-", 1, 3 },
+        { "[]a]+", false, "x]a]", 1, 3 },
+        { "[^]a]", false, "]ab", 2, 1 },
+        { "\\d+", false, "ch 123a", 3, 3 },
+        { "\\D+", false, "12ab3", 2, 2 },
+        { "\\w+", false, "  foo_9 ", 2, 5 },
+        { "\\W+", false, "ab, cd", 2, 2 },
+        { "\\s+", false, "a \t b", 1, 3 },
+        { "\\S+", false, "  xy ", 2, 2 },
+        { "[\\d.]+", false, "v1.25!", 1, 4 },
+        { "[\\s\\d]+", false, "a 1 2b", 1, 4 },
+        { "[\\]]", false, "a]", 1, 1 },
+
+        // Escapes
+        { "a\\.b", false, "axb a.b", 4, 3 },
+        { "\\(x\\)", false, "f(x)", 1, 3 },
+        { "\\x41\\x62", false, "zAb", 1, 2 },
+        { "\\t", false, "a\tb", 1, 1 },
+        { "\\*\\+\\?\\|\\{", false, "*+?|{", 0, 5 },
+        { "\\\\", false, "a\\b", 1, 1 },
+
+        // Anchors are line anchors
+        { "^ab", false, "ab ab", 0, 2 },
+        { "^ab", false, "xab", -1, 0 },
+        { "ab$", false, "ab ab", 3, 2 },
+        { "ab$", false, "abx", -1, 0 },
+        { "^$", false, "", 0, 0 },
+        { "^$", false, "x", -1, 0 },
+        { "^a*$", false, "aaa", 0, 3 },
+        { "^a*$", false, "aab", -1, 0 },
+        { "x^", false, "x", -1, 0 },
+        { "$x", false, "x", -1, 0 },
+        { "a|^b", false, "cb", -1, 0 },
+        { "a|^b", false, "bc", 0, 1 },
+        { "(^|x)y", false, "y", 0, 1 },
+        { "(^|x)y", false, "zxy", 1, 2 },
+        { "y(x|$)", false, "zy", 1, 1 },
+        { "^(Chapter|CHAPTER) \\d+$", false, "Chapter 12", 0, 10 },
+        { "^(Chapter|CHAPTER) \\d+$", false, "Chapter 12 begins", -1, 0 },
+
+        // Groups
+        { "(?:ab)+", false, "xababy", 1, 4 },
+        { "((a)(b))c", false, "abc", 0, 3 },
+        { "()", false, "a", 0, 0 },
+
+        // UTF-8: "." and classes match whole characters
+        { "^.$", false, "\xC3\xA9", 0, 2 },
+        { "^.$", false, "\xE4\xBF\xAE", 0, 3 },
+        { "^.$", false, "\xF0\x9F\x98\x80", 0, 4 },
+        { "^..$", false, "\xE4\xBF\xAE", -1, 0 },
+        { "[\xE4\xB8\x80-\xE9\xBE\xA5]+", false, "Ch \xE7\xAC\xAC\xE5\x8D\x81\xE7\xAB\xA0!", 3, 9 },
+        { "[^a]", false, "a\xC3\xA9", 1, 2 },
+        { "\xE7\xAC\xAC.\xE7\xAB\xA0", false, "\xE7\xAC\xAC\xE5\x8D\x81\xE7\xAB\xA0", 0, 9 },
+        { "caf.", false, "caf\xC3\xA9", 0, 5 },
+        { "\\w", false, "\xC3\xA9", -1, 0 },
+
+        // Case folding, ASCII and beyond
+        { "hello", true, "Say HeLLo", 4, 5 },
+        { "HELLO", true, "hello", 0, 5 },
+        { "hello", false, "HELLO", -1, 0 },
+        { "[a-c]+", true, "xABCa", 1, 4 },
+        { "[^a]", true, "Ab", 1, 1 },
+        { "\xC3\xA9t\xC3\xA9", true, "\xC3\x89T\xC3\x89", 0, 5 },
+        { "\xD0\xB4", true, "\xD0\x94", 0, 2 },
+        { "\xCF\x83", true, "\xCE\xA3", 0, 2 },
+    };
+
+    static const char* invalidPatterns[] = {
+        "(", "(ab", "ab)", ")", "[ab", "[", "*a", "+", "a**b|?", "^*", "$+", "a{2", "a{3,2}", "a{1001}",
+        "\\", "\\q", "\\x4", "[z-a]", "(?:a",
+    };
+
+    int failures = 0;
+    for (const Case& test : cases) {
+        Regex regex;
+        std::string error;
+        if (!regex.Compile(test.pattern, test.caseInsensitive, &error)) {
+            std::cout << "FAILED: /" << test.pattern << "/ does not compile: " << error << std::endl;
+            failures++;
+            continue;
+        }
+
+        Matcher matcher(regex);
+        size_t start = 0, length = 0;
+        bool found = matcher.Search(test.line, &start, &length);
+        bool foundAny = Matcher(regex).Search(test.line);
+        bool pass = found == (test.start >= 0) && foundAny == found &&
+            (!found || (start == static_cast<size_t>(test.start) && length == static_cast<size_t>(test.length)));
+        if (!pass) {
+            std::cout << "FAILED: /" << test.pattern << "/" << (test.caseInsensitive ? "i" : "") << " on \"" << test.line
+                << "\": expected " << test.start << "+" << test.length << ", got "
+                << (found ? std::to_string(start) + "+" + std::to_string(length) : std::string("no match")) << std::endl;
+            failures++;
+        }
+    }
+
+    for (const char* pattern : invalidPatterns) {
+        Regex regex;
+        std::string error;
+        if (regex.Compile(pattern, false, &error) || error.empty() || regex.IsValid()) {
+            std::cout << "FAILED: /" << pattern << "/ should not compile" << std::endl;
+            failures++;
+        }
+    }
+
+    // More DFA states than a Matcher caches: (a|b)*a(a|b){12} needs 2^13 of them. The earliest
+    // match ends 13 bytes after the first 'a', the longest at the last 'a' that still has 12 after it.
+    {
+        Regex regex;
+        regex.Compile("(a|b)*a(a|b){12}", false);
+        Matcher matcher(regex);
+        uint32_t seed = 7;
+        for (int line = 0; line < 200; line++) {
+            std::string text;
+            int size = 1 + line * 3;
+            for (int i = 0; i < size; i++) {
+                seed = seed * 1103515245 + 12345;
+                text.push_back((seed >> 16) & 1 ? 'a' : 'b');
+            }
+
+            int lastA = -1;
+            for (int i = 0; i + 13 <= size; i++) {
+                if (text[i] == 'a') lastA = i;
+            }
+            size_t start = 0, length = 0;
+            bool found = matcher.Search(text, &start, &length);
+            if (found != (lastA >= 0) || (found && (start != 0 || length != static_cast<size_t>(lastA) + 13))) {
+                std::cout << "FAILED: DFA cache flush, line of " << size << " bytes" << std::endl;
+                failures++;
+                break;
+            }
+        }
+    }
+
+    std::cout << (failures == 0 ? "Regex tests passed (" + std::to_string(std::size(cases)) + " cases)" :
+        "Regex tests FAILED (" + std::to_string(failures) + ")") << std::endl;
+    return failures == 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+// Regular expressions for searching text one line at a time.
+//
+// A pattern is compiled once into a byte-level NFA (UTF-8 aware, so "." and classes match whole
+// characters). Each Matcher runs that NFA as a lazily built DFA: every input byte is one table
+// lookup once the states it needs exist, there is no backtracking, and matching is linear.
+// Matches are leftmost-longest.
+//
+// Syntax: literals, . [abc] [^a-z] \d \w \s \D \W \S, escapes (\. \n \t \xHH ...),
+// groups ( ) (?: ), alternation |, quantifiers * + ? {m} {m,} {m,n} (lazy suffix accepted),
+// and ^ $ as line anchors. Backreferences and lookaround are not supported.
+class Regex {
+public:
+    bool Compile(std::string_view pattern, bool caseInsensitive, std::string* error = nullptr);
+    bool IsValid() const { return startState >= 0; }
+
+    // Conformance table (syntax, leftmost-longest spans, anchors, UTF-8, case folding, invalid
+    // patterns) and a DFA cache overflow check; prints failures
+    static bool RunTests();
+
+    // Per-thread matching state over a shared compiled Regex
+    class Matcher {
+    public:
+        explicit Matcher(const Regex& regex);
+
+        // Finds the leftmost-longest match in line. Pass nullptr for the span when only a yes/no is needed.
+        bool Search(std::string_view line, size_t* matchStart = nullptr, size_t* matchLength = nullptr);
+
+    private:
+        struct DfaState {
+            std::vector<int> nfaStates;       // Sorted; consuming, end-anchor and match states only
+            bool accepting = false;
+            bool acceptingAtEnd = false;      // Accepting once "$" is satisfied
+            std::array<int, 256> next;
+        };
+
+        struct Dfa {
+            std::vector<DfaState> states;
+            std::map<std::vector<int>, int> lookup;
+            int start[2] = { -1, -1 };        // [atLineStart]
+        };
+
+        int StartState(bool anchored, bool atLineStart);
+        int Step(bool anchored, int state, unsigned char byte);
+        int AddState(Dfa& dfa, std::vector<int>&& nfaStates);
+        void Closure(const std::vector<int>& seeds, bool atLineStart, std::vector<int>& out);
+        bool ReachesMatchAtEnd(const std::vector<int>& nfaStates, bool atLineStart);
+
+        const Regex& regex;
+        Dfa dfas[2];                           // [anchored]
+        std::vector<uint32_t> visitMark;
+        uint32_t visitGeneration = 0;
+        std::vector<int> stack;
+        std::vector<int> unanchoredRestart;    // Closure of the start state away from the line start
+    };
+
+private:
+    friend class Matcher;
+
+    struct State {
+        enum Type { Bytes, Split, Epsilon, LineBegin, LineEnd, Match };
+        Type type = Epsilon;
+        int out = -1;
+        int out1 = -1;
+        int byteSet = -1;   // Index into byteSets for Bytes
+    };
+
+    std::vector<State> states;
+    std::vector<std::array<uint64_t, 4>> byteSets;
+    int startState = -1;
+
+    struct Compiler;
+};
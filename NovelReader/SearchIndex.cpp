@@ -0,0 +1,2221 @@
+#include "SearchIndex.h"
+#include "BatchReader.h"
+#include "ChapterStore.h"
+#include "FileLock.h"
+#include "MappedFile.h"
+#include "TextSearch.h"
+#include "Dependecies/json.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr uint32_t INDEX_FORMAT_VERSION = 2;
+    constexpr char TERMS_MAGIC[4] = { 'N', 'R', 'T', 'D' };
+    constexpr char DOCS_MAGIC[4] = { 'N', 'R', 'D', 'C' };
+    constexpr size_t MAX_TERM_BYTES = 64;
+    constexpr size_t RUN_MEMORY_BUDGET = 256ull * 1024 * 1024;
+    constexpr size_t INDEX_READ_BATCH = 256;   // Chapters read ahead of the tokenizer
+
+    // Size-tiered merging: MERGE_FACTOR adjacent segments of one tier are merged into the next
+    constexpr size_t MERGE_FACTOR = 4;
+    constexpr size_t MAX_SEGMENTS = 12;
+    constexpr uint64_t SMALLEST_TIER_BYTES = 64 * 1024;
+
+    // A staging directory nobody has written to for this long was left by a writer that died
+    constexpr auto STAGING_ABANDONED_AFTER = std::chrono::hours(24);
+
+    // BM25 parameters
+    constexpr float BM25_K1 = 1.2f;
+    constexpr float BM25_B = 0.75f;
+
+    struct TermFileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t termCount;
+        uint32_t reserved;
+    };
+
+    // Fixed-size so the dictionary can be binary searched straight out of the mapping
+    struct TermEntry {
+        uint32_t stringOffset;
+        uint32_t stringLength;
+        uint32_t docFreq;
+        uint32_t postingsLength;
+        uint64_t postingsOffset;
+    };
+    static_assert(sizeof(TermEntry) == 24, "TermEntry is an on-disk format");
+
+    struct DocFileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t novelCount;
+        uint32_t docCount;
+        uint64_t totalTokens;
+    };
+
+    // ============================================================================
+    // Varint encoding
+    // ============================================================================
+    void WriteVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    bool ReadVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            uint8_t byte = *p++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    bool ReadVarint32(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+        uint64_t wide;
+        if (!ReadVarint(p, end, wide) || wide > UINT32_MAX) return false;
+        value = static_cast<uint32_t>(wide);
+        return true;
+    }
+
+    // Zigzag keeps small negative values (file clock epochs differ per platform) short
+    uint64_t ZigZag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    int64_t UnZigZag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    // ============================================================================
+    // Tokenizer
+    // ============================================================================
+    enum class CharClass { Separator, Word, Ideograph };
+
+    CharClass ClassifyCodepoint(uint32_t cp) {
+        if (cp < 0x80) {
+            bool alnum = (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+            return alnum ? CharClass::Word : CharClass::Separator;
+        }
+        if (cp < 0xC0) return (cp == 0xAA || cp == 0xB5 || cp == 0xBA) ? CharClass::Word : CharClass::Separator;
+        if (cp == 0xD7 || cp == 0xF7) return CharClass::Separator;
+
+        // Han, kana and halfwidth katakana have no word breaks; index them one character per term
+        if ((cp >= 0x3040 && cp <= 0x30FF) || (cp >= 0x3400 && cp <= 0x4DBF) ||
+            (cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+            (cp >= 0xFF66 && cp <= 0xFF9F) || (cp >= 0x20000 && cp <= 0x3FFFF)) {
+            return CharClass::Ideograph;
+        }
+
+        // Punctuation, symbols, private use and emoji blocks
+        if ((cp >= 0x2000 && cp <= 0x2BFF) || (cp >= 0x2E00 && cp <= 0x2E7F) ||
+            (cp >= 0x3000 && cp <= 0x303F) || (cp >= 0xE000 && cp <= 0xF8FF) ||
+            (cp >= 0xFE00 && cp <= 0xFE0F) || (cp >= 0xFE30 && cp <= 0xFE4F) ||
+            (cp >= 0xFF01 && cp <= 0xFF0F) || (cp >= 0xFF1A && cp <= 0xFF20) ||
+            (cp >= 0xFF3B && cp <= 0xFF40) || (cp >= 0xFF5B && cp <= 0xFF65) ||
+            cp == 0xFEFF || cp == 0xFFFD || (cp >= 0x1F000 && cp <= 0x1FAFF)) {
+            return CharClass::Separator;
+        }
+        return CharClass::Word;
+    }
+
+    void FlushTerm(std::string& current, std::vector<std::string>& terms) {
+        // Overlong runs are almost always URLs or garbage; drop them rather than bloat the dictionary
+        if (!current.empty() && current.size() <= MAX_TERM_BYTES) {
+            terms.push_back(current);
+        }
+        current.clear();
+    }
+
+    void TokenizeLine(std::string_view line, std::vector<std::string>& terms) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(line.data());
+        const unsigned char* end = p + line.size();
+        std::string current;
+
+        while (p < end) {
+            // ASCII fast path
+            if (*p < 0x80) {
+                unsigned char c = *p++;
+                if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+                    current.push_back(static_cast<char>(c));
+                }
+                else if (c >= 'A' && c <= 'Z') {
+                    current.push_back(static_cast<char>(c + 0x20));
+                }
+                else {
+                    FlushTerm(current, terms);
+                }
+                continue;
+            }
+
+            uint32_t cp = TextSearch::DecodeUtf8(p, end);
+            switch (ClassifyCodepoint(cp)) {
+            case CharClass::Word:
+                if (cp == 0xDF) {
+                    current += "ss";
+                }
+                else {
+                    TextSearch::AppendUtf8(current, TextSearch::FoldCodepoint(cp));
+                }
+                break;
+            case CharClass::Ideograph:
+                FlushTerm(current, terms);
+                TextSearch::AppendUtf8(current, TextSearch::FoldCodepoint(cp));
+                FlushTerm(current, terms);
+                break;
+            case CharClass::Separator:
+                FlushTerm(current, terms);
+                break;
+            }
+        }
+        FlushTerm(current, terms);
+    }
+
+    bool IsBlankLine(std::string_view line) {
+        return line.find_first_not_of(" \t\r") == std::string_view::npos;
+    }
+
+    // ============================================================================
+    // File helpers
+    // ============================================================================
+    bool ReadWholeFile(const std::filesystem::path& path, std::string& out) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+
+        file.seekg(0, std::ios::end);
+        std::streamoff length = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (length < 0) return false;
+
+        out.resize(static_cast<size_t>(length));
+        file.read(out.data(), length);
+        return static_cast<bool>(file) || file.eof();
+    }
+
+    bool WriteWholeFile(const std::filesystem::path& path, const std::string& header, const std::string& body) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cout << "Failed to write index file: " << path << std::endl;
+            return false;
+        }
+        file.write(header.data(), header.size());
+        file.write(body.data(), body.size());
+        return static_cast<bool>(file);
+    }
+
+    template <typename T>
+    std::string AsBytes(const T& value) {
+        return std::string(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    // Parses "chapter123.json" into 123, or returns 0
+    int ChapterNumberFromFilename(const std::filesystem::path& path) {
+        std::string stem = path.stem().string();
+        if (stem.rfind("chapter", 0) != 0) return 0;
+        try {
+            return std::stoi(stem.substr(7));
+        }
+        catch (...) {
+            return 0;
+        }
+    }
+
+    struct ChapterFile {
+        std::string novelName;
+        int chapterNumber;
+        std::filesystem::path path;
+    };
+
+    int64_t FileModifiedTime(const std::filesystem::path& path) {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(path, ec);
+        if (ec) return 0;
+        return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+    }
+
+    std::vector<ChapterFile> CollectChapterFiles(const std::string& novelsRoot) {
+        std::vector<ChapterFile> files;
+        std::error_code ec;
+
+        for (const auto& novelDir : std::filesystem::directory_iterator(novelsRoot, ec)) {
+            if (!novelDir.is_directory()) continue;
+
+            std::filesystem::path chaptersDir = novelDir.path() / "chapters";
+            if (!std::filesystem::exists(chaptersDir)) continue;
+
+            std::string novelName = novelDir.path().filename().string();
+            for (const auto& entry : std::filesystem::directory_iterator(chaptersDir, ec)) {
+                if (entry.path().extension() != ".json") continue;
+                int chapterNumber = ChapterNumberFromFilename(entry.path());
+                if (chapterNumber > 0) {
+                    files.push_back({ novelName, chapterNumber, entry.path() });
+                }
+            }
+        }
+
+        std::sort(files.begin(), files.end(), [](const ChapterFile& a, const ChapterFile& b) {
+            if (a.novelName != b.novelName) return a.novelName < b.novelName;
+            return a.chapterNumber < b.chapterNumber;
+        });
+        return files;
+    }
+
+    // ============================================================================
+    // Posting list cursor
+    // ============================================================================
+    struct PostingCursor {
+        const uint8_t* p;
+        const uint8_t* end;
+        uint32_t doc = 0;
+        uint32_t tf = 0;
+        const uint8_t* positions = nullptr;
+        uint32_t positionsLength = 0;
+
+        PostingCursor(const uint8_t* begin, const uint8_t* finish) : p(begin), end(finish) {}
+
+        bool Next() {
+            uint32_t delta, length;
+            if (p >= end) return false;
+            if (!ReadVarint32(p, end, delta) || !ReadVarint32(p, end, tf) || !ReadVarint32(p, end, length)) return false;
+            if (static_cast<size_t>(end - p) < length) return false;
+
+            doc += delta;
+            positions = p;
+            positionsLength = length;
+            p += length;
+            return true;
+        }
+    };
+
+    void DecodePositions(const uint8_t* p, uint32_t length, std::vector<uint32_t>& out) {
+        out.clear();
+        const uint8_t* end = p + length;
+        uint32_t position = 0;
+        uint32_t delta;
+        while (p < end && ReadVarint32(p, end, delta)) {
+            position += delta;
+            out.push_back(position);
+        }
+    }
+
+    // ============================================================================
+    // Segment builder (in-memory run, written out as one segment)
+    // ============================================================================
+    class SegmentBuilder {
+    public:
+        void AddDocument(const std::string& novelName, int chapterNumber, int64_t modifiedTime,
+            const std::vector<std::string>& terms, const std::vector<uint32_t>& paragraphStarts) {
+            uint32_t docId = docCount++;
+
+            auto novelIt = novelIds.find(novelName);
+            if (novelIt == novelIds.end()) {
+                novelIt = novelIds.emplace(novelName, static_cast<uint32_t>(novelNames.size())).first;
+                novelNames.push_back(novelName);
+            }
+
+            WriteVarint(docBytes, novelIt->second);
+            WriteVarint(docBytes, static_cast<uint64_t>(chapterNumber));
+            WriteVarint(docBytes, ZigZag(modifiedTime));
+            WriteVarint(docBytes, terms.size());
+            WriteVarint(docBytes, paragraphStarts.size());
+            uint32_t previousStart = 0;
+            for (uint32_t start : paragraphStarts) {
+                WriteVarint(docBytes, start - previousStart);
+                previousStart = start;
+            }
+            totalTokens += terms.size();
+
+            // Group positions by term for this document
+            docPositions.clear();
+            for (uint32_t position = 0; position < terms.size(); position++) {
+                docPositions[terms[position]].push_back(position);
+            }
+
+            for (const auto& [term, positions] : docPositions) {
+                TermAccumulator& accumulator = termAccumulators[std::string(term)];
+                size_t sizeBefore = accumulator.bytes.size();
+
+                scratch.clear();
+                uint32_t previous = 0;
+                for (uint32_t position : positions) {
+                    WriteVarint(scratch, position - previous);
+                    previous = position;
+                }
+
+                WriteVarint(accumulator.bytes, docId - accumulator.lastDoc);
+                WriteVarint(accumulator.bytes, positions.size());
+                WriteVarint(accumulator.bytes, scratch.size());
+                accumulator.bytes += scratch;
+                accumulator.lastDoc = docId;
+                accumulator.docFreq++;
+
+                postingBytes += accumulator.bytes.size() - sizeBefore;
+            }
+        }
+
+        size_t MemoryUsage() const {
+            // Rough: encoded postings plus per-term map overhead
+            return postingBytes + termAccumulators.size() * 96 + docBytes.size();
+        }
+
+        bool Empty() const { return docCount == 0; }
+
+        bool Write(const std::filesystem::path& directory) const {
+            std::error_code ec;
+            std::filesystem::create_directories(directory, ec);
+
+            std::vector<const std::pair<const std::string, TermAccumulator>*> sorted;
+            sorted.reserve(termAccumulators.size());
+            for (const auto& entry : termAccumulators) {
+                sorted.push_back(&entry);
+            }
+            std::sort(sorted.begin(), sorted.end(),
+                [](const auto* a, const auto* b) { return a->first < b->first; });
+
+            std::string postings;
+            postings.reserve(postingBytes);
+            std::string entries;
+            std::string strings;
+            entries.reserve(sorted.size() * sizeof(TermEntry));
+
+            for (const auto* entry : sorted) {
+                TermEntry termEntry;
+                termEntry.stringOffset = static_cast<uint32_t>(strings.size());
+                termEntry.stringLength = static_cast<uint32_t>(entry->first.size());
+                termEntry.docFreq = entry->second.docFreq;
+                termEntry.postingsLength = static_cast<uint32_t>(entry->second.bytes.size());
+                termEntry.postingsOffset = postings.size();
+
+                strings += entry->first;
+                postings += entry->second.bytes;
+                entries += AsBytes(termEntry);
+            }
+
+            TermFileHeader termHeader;
+            std::memcpy(termHeader.magic, TERMS_MAGIC, 4);
+            termHeader.version = INDEX_FORMAT_VERSION;
+            termHeader.termCount = static_cast<uint32_t>(sorted.size());
+            termHeader.reserved = 0;
+
+            std::string novels;
+            for (const std::string& name : novelNames) {
+                WriteVarint(novels, name.size());
+                novels += name;
+            }
+
+            DocFileHeader docHeader;
+            std::memcpy(docHeader.magic, DOCS_MAGIC, 4);
+            docHeader.version = INDEX_FORMAT_VERSION;
+            docHeader.novelCount = static_cast<uint32_t>(novelNames.size());
+            docHeader.docCount = docCount;
+            docHeader.totalTokens = totalTokens;
+
+            return WriteWholeFile(directory / "postings.bin", "", postings) &&
+                WriteWholeFile(directory / "terms.bin", AsBytes(termHeader) + entries, strings) &&
+                WriteWholeFile(directory / "docs.bin", AsBytes(docHeader) + novels, docBytes);
+        }
+
+    private:
+        struct TermAccumulator {
+            uint32_t lastDoc = 0;
+            uint32_t docFreq = 0;
+            std::string bytes;
+        };
+
+        std::unordered_map<std::string, TermAccumulator> termAccumulators;
+        std::vector<std::string> novelNames;
+        std::unordered_map<std::string, uint32_t> novelIds;
+        std::string docBytes;
+        uint32_t docCount = 0;
+        uint64_t totalTokens = 0;
+        size_t postingBytes = 0;
+
+        // Scratch reused across documents
+        std::unordered_map<std::string_view, std::vector<uint32_t>> docPositions;
+        std::string scratch;
+    };
+}
+
+// ============================================================================
+// Segment reader
+// ============================================================================
+struct IndexSegment {
+    struct DocInfo {
+        uint32_t novelId;
+        int chapterNumber;
+        int64_t modifiedTime;
+        uint32_t tokenCount;
+        uint32_t paragraphOffset;
+        uint32_t paragraphCount;
+    };
+
+    std::string name;
+    uint64_t seq = 0;
+    uint64_t bytes = 0;
+    MappedFile termsFile;
+    MappedFile postingsFile;
+    const TermEntry* entries = nullptr;
+    uint32_t termCount = 0;
+    const char* strings = nullptr;
+    size_t stringsSize = 0;
+
+    std::vector<std::string> novelNames;
+    std::vector<DocInfo> docs;
+    std::vector<uint32_t> paragraphStarts;
+    uint64_t totalTokens = 0;
+
+    // Docs superseded by a newer segment or removed with their novel; filled by MarkDeadDocs
+    std::vector<uint8_t> dead;
+    uint32_t liveDocs = 0;
+    uint64_t liveTokens = 0;
+
+    bool Open(const std::filesystem::path& path) {
+        name = path.filename().string();
+
+        if (!termsFile.Open((path / "terms.bin").string()) || !postingsFile.Open((path / "postings.bin").string())) {
+            return false;
+        }
+
+        // Term dictionary is used in place
+        if (termsFile.Size() < sizeof(TermFileHeader)) return false;
+        TermFileHeader header;
+        std::memcpy(&header, termsFile.Data(), sizeof(header));
+        if (std::memcmp(header.magic, TERMS_MAGIC, 4) != 0 || header.version != INDEX_FORMAT_VERSION) {
+            std::cout << "Unsupported index segment: " << path << std::endl;
+            return false;
+        }
+
+        size_t entriesEnd = sizeof(TermFileHeader) + static_cast<size_t>(header.termCount) * sizeof(TermEntry);
+        if (termsFile.Size() < entriesEnd) return false;
+        termCount = header.termCount;
+        entries = reinterpret_cast<const TermEntry*>(termsFile.Data() + sizeof(TermFileHeader));
+        strings = termsFile.Data() + entriesEnd;
+        stringsSize = termsFile.Size() - entriesEnd;
+        bytes = termsFile.Size() + postingsFile.Size();
+
+        return LoadDocs(path / "docs.bin");
+    }
+
+    bool LoadDocs(const std::filesystem::path& path) {
+        std::string fileBytes;
+        if (!ReadWholeFile(path, fileBytes) || fileBytes.size() < sizeof(DocFileHeader)) return false;
+
+        DocFileHeader header;
+        std::memcpy(&header, fileBytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, DOCS_MAGIC, 4) != 0 || header.version != INDEX_FORMAT_VERSION) return false;
+        totalTokens = header.totalTokens;
+        bytes += fileBytes.size();
+
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(fileBytes.data()) + sizeof(DocFileHeader);
+        const uint8_t* end = reinterpret_cast<const uint8_t*>(fileBytes.data()) + fileBytes.size();
+
+        novelNames.resize(header.novelCount);
+        for (std::string& novelName : novelNames) {
+            uint32_t length;
+            if (!ReadVarint32(p, end, length) || static_cast<size_t>(end - p) < length) return false;
+            novelName.assign(reinterpret_cast<const char*>(p), length);
+            p += length;
+        }
+
+        docs.resize(header.docCount);
+        for (DocInfo& doc : docs) {
+            uint32_t chapterNumber;
+            uint64_t modified;
+            if (!ReadVarint32(p, end, doc.novelId) || !ReadVarint32(p, end, chapterNumber) ||
+                !ReadVarint(p, end, modified) ||
+                !ReadVarint32(p, end, doc.tokenCount) || !ReadVarint32(p, end, doc.paragraphCount)) {
+                return false;
+            }
+            if (doc.novelId >= novelNames.size()) return false;
+            doc.chapterNumber = static_cast<int>(chapterNumber);
+            doc.modifiedTime = UnZigZag(modified);
+            doc.paragraphOffset = static_cast<uint32_t>(paragraphStarts.size());
+
+            uint32_t start = 0;
+            for (uint32_t i = 0; i < doc.paragraphCount; i++) {
+                uint32_t delta;
+                if (!ReadVarint32(p, end, delta)) return false;
+                start += delta;
+                paragraphStarts.push_back(start);
+            }
+        }
+
+        dead.assign(docs.size(), 0);
+        liveDocs = static_cast<uint32_t>(docs.size());
+        liveTokens = totalTokens;
+        return true;
+    }
+
+    std::string_view TermAt(uint32_t index) const {
+        const TermEntry& entry = entries[index];
+        if (static_cast<size_t>(entry.stringOffset) + entry.stringLength > stringsSize) return {};
+        return std::string_view(strings + entry.stringOffset, entry.stringLength);
+    }
+
+    const TermEntry* FindTerm(std::string_view term) const {
+        uint32_t low = 0;
+        uint32_t high = termCount;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            int cmp = TermAt(mid).compare(term);
+            if (cmp == 0) return &entries[mid];
+            if (cmp < 0) low = mid + 1;
+            else high = mid;
+        }
+        return nullptr;
+    }
+
+    PostingCursor Cursor(const TermEntry& entry) const {
+        const uint8_t* base = reinterpret_cast<const uint8_t*>(postingsFile.Data());
+        if (!base || entry.postingsOffset + entry.postingsLength > postingsFile.Size()) {
+            return PostingCursor(nullptr, nullptr);
+        }
+        return PostingCursor(base + entry.postingsOffset, base + entry.postingsOffset + entry.postingsLength);
+    }
+
+    int ParagraphForPosition(uint32_t docId, uint32_t position) const {
+        const DocInfo& doc = docs[docId];
+        auto begin = paragraphStarts.begin() + doc.paragraphOffset;
+        auto end = begin + doc.paragraphCount;
+        auto it = std::upper_bound(begin, end, position);
+        return (it == begin) ? 0 : static_cast<int>(it - begin) - 1;
+    }
+};
+
+namespace {
+    // ============================================================================
+    // Manifest
+    // ============================================================================
+    struct ManifestSegment {
+        std::string name;
+        uint64_t seq = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct Manifest {
+        std::string novelsRoot = "Novels";
+        uint64_t nextSeq = 1;
+        std::vector<ManifestSegment> segments;                  // oldest first
+        std::map<std::string, uint64_t> removedNovels;          // novel -> docs in segments with seq <= value are gone
+    };
+
+    bool ReadManifest(const std::filesystem::path& indexDir, Manifest& manifest) {
+        try {
+            std::ifstream file(indexDir / "manifest.json");
+            if (!file.is_open()) return false;
+
+            json j;
+            file >> j;
+            if (j.value("version", 0u) != INDEX_FORMAT_VERSION) {
+                std::cout << "Search index format changed; rebuild required" << std::endl;
+                return false;
+            }
+
+            manifest.novelsRoot = j.value("novelsRoot", std::string("Novels"));
+            manifest.nextSeq = j.value("nextSeq", 1ull);
+            manifest.segments.clear();
+            for (const auto& entry : j.value("segments", json::array())) {
+                ManifestSegment segment;
+                segment.name = entry.value("name", "");
+                segment.seq = entry.value("seq", 0ull);
+                segment.bytes = entry.value("bytes", 0ull);
+                manifest.segments.push_back(segment);
+            }
+            manifest.removedNovels = j.value("removedNovels", std::map<std::string, uint64_t>());
+            return true;
+        }
+        catch (const std::exception& e) {
+            std::cout << "Error reading index manifest: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool WriteManifest(const std::filesystem::path& indexDir, const Manifest& manifest) {
+        json j;
+        j["version"] = INDEX_FORMAT_VERSION;
+        j["novelsRoot"] = manifest.novelsRoot;
+        j["nextSeq"] = manifest.nextSeq;
+        j["segments"] = json::array();
+        for (const ManifestSegment& segment : manifest.segments) {
+            j["segments"].push_back({ {"name", segment.name}, {"seq", segment.seq}, {"bytes", segment.bytes} });
+        }
+        j["removedNovels"] = manifest.removedNovels;
+
+        // Write-then-rename so readers never observe a half-written manifest
+        std::filesystem::path tempPath = indexDir / "manifest.json.tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file.is_open()) return false;
+            file << j.dump(4);
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, indexDir / "manifest.json", ec);
+        if (ec) {
+            std::cout << "Failed to publish index manifest: " << ec.message() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string NextSegmentName(const std::filesystem::path& indexDir, uint64_t seq) {
+        std::string name = "seg_" + std::to_string(seq);
+        for (int suffix = 1; std::filesystem::exists(indexDir / name); suffix++) {
+            name = "seg_" + std::to_string(seq) + "_" + std::to_string(suffix);
+        }
+        return name;
+    }
+
+    uint64_t DirectorySize(const std::filesystem::path& directory) {
+        uint64_t total = 0;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            if (entry.is_regular_file()) total += entry.file_size(ec);
+        }
+        return total;
+    }
+
+    // Every process that writes this index (the app, novelreader-cli, the download daemon) holds
+    // this lock while it reads, changes and writes the manifest, and while it collects garbage
+    std::string IndexLockPath(const std::filesystem::path& indexDir) {
+        return (indexDir / "index.lock").string();
+    }
+
+    // New segments are written under a staging name and only become seg_* under the lock, in the
+    // same step that lists them in the manifest, so a collector never sees an unpublished seg_*
+    std::filesystem::path NewStagingDir(const std::filesystem::path& indexDir) {
+        static std::atomic<uint64_t> counter{ 0 };
+        std::random_device random;
+        return indexDir / ("staging_" + std::to_string(random()) + "_" + std::to_string(counter.fetch_add(1)));
+    }
+
+    // Renames a staged segment into place; the caller holds the index lock
+    bool PublishStaged(const std::filesystem::path& indexDir, const std::filesystem::path& staging, uint64_t seq,
+        ManifestSegment& published) {
+        std::string name = NextSegmentName(indexDir, seq);
+        std::error_code ec;
+        std::filesystem::rename(staging, indexDir / name, ec);
+        if (ec) {
+            std::cout << "Failed to publish index segment: " << ec.message() << std::endl;
+            return false;
+        }
+        published = { name, seq, DirectorySize(indexDir / name) };
+        return true;
+    }
+
+    struct DocMarks {
+        std::vector<uint8_t> dead;
+        uint32_t liveDocs = 0;
+        uint64_t liveTokens = 0;
+    };
+
+    // Newest version of a chapter wins; removed novels hide everything indexed before the removal.
+    // marks[i] receives the marks for segmentsBySeq[i], which are only read.
+    void MarkDeadDocs(const std::vector<const IndexSegment*>& segmentsBySeq, const std::map<std::string, uint64_t>& removedNovels,
+        std::vector<DocMarks>& marks) {
+        std::unordered_map<std::string, std::unordered_set<int>> seenChapters;
+        marks.assign(segmentsBySeq.size(), DocMarks());
+
+        for (size_t s = segmentsBySeq.size(); s-- > 0;) {
+            const IndexSegment& segment = *segmentsBySeq[s];
+            DocMarks& mark = marks[s];
+            mark.dead.assign(segment.docs.size(), 0);
+
+            // Per novel of this segment: its chapters seen in newer segments, and whether it was removed
+            std::vector<std::unordered_set<int>*> seen(segment.novelNames.size());
+            std::vector<uint8_t> removed(segment.novelNames.size(), 0);
+            for (size_t n = 0; n < segment.novelNames.size(); n++) {
+                seen[n] = &seenChapters[segment.novelNames[n]];
+                auto removal = removedNovels.find(segment.novelNames[n]);
+                removed[n] = removal != removedNovels.end() && segment.seq <= removal->second;
+            }
+
+            for (size_t d = 0; d < segment.docs.size(); d++) {
+                const IndexSegment::DocInfo& doc = segment.docs[d];
+                bool isDead = removed[doc.novelId] || seen[doc.novelId]->count(doc.chapterNumber) > 0;
+
+                mark.dead[d] = isDead ? 1 : 0;
+                if (!isDead) {
+                    mark.liveDocs++;
+                    mark.liveTokens += doc.tokenCount;
+                }
+            }
+
+            // Register after the whole segment so duplicates inside one segment don't shadow each other
+            for (const auto& doc : segment.docs) {
+                seen[doc.novelId]->insert(doc.chapterNumber);
+            }
+        }
+    }
+
+    void MarkDeadDocs(const std::vector<IndexSegment*>& segmentsBySeq, const std::map<std::string, uint64_t>& removedNovels) {
+        std::vector<DocMarks> marks;
+        MarkDeadDocs(std::vector<const IndexSegment*>(segmentsBySeq.begin(), segmentsBySeq.end()), removedNovels, marks);
+        for (size_t i = 0; i < segmentsBySeq.size(); i++) {
+            segmentsBySeq[i]->dead = std::move(marks[i].dead);
+            segmentsBySeq[i]->liveDocs = marks[i].liveDocs;
+            segmentsBySeq[i]->liveTokens = marks[i].liveTokens;
+        }
+    }
+
+    // Merges segments (oldest first) into one, dropping their dead docs
+    bool MergeSegments(const std::vector<const IndexSegment*>& sources, const std::filesystem::path& output) {
+        // Documents: concatenate live docs, remapping ids and novel ids
+        std::vector<std::string> novelNames;
+        std::unordered_map<std::string, uint32_t> novelIds;
+        std::vector<std::vector<uint32_t>> docRemap(sources.size());
+        std::string docBytes;
+        uint32_t docCount = 0;
+        uint64_t totalTokens = 0;
+
+        for (size_t s = 0; s < sources.size(); s++) {
+            const IndexSegment& segment = *sources[s];
+            docRemap[s].assign(segment.docs.size(), UINT32_MAX);
+
+            for (size_t d = 0; d < segment.docs.size(); d++) {
+                if (segment.dead[d]) continue;
+
+                const auto& doc = segment.docs[d];
+                const std::string& novelName = segment.novelNames[doc.novelId];
+                auto it = novelIds.find(novelName);
+                if (it == novelIds.end()) {
+                    it = novelIds.emplace(novelName, static_cast<uint32_t>(novelNames.size())).first;
+                    novelNames.push_back(novelName);
+                }
+
+                WriteVarint(docBytes, it->second);
+                WriteVarint(docBytes, static_cast<uint64_t>(doc.chapterNumber));
+                WriteVarint(docBytes, ZigZag(doc.modifiedTime));
+                WriteVarint(docBytes, doc.tokenCount);
+                WriteVarint(docBytes, doc.paragraphCount);
+                uint32_t previous = 0;
+                for (uint32_t i = 0; i < doc.paragraphCount; i++) {
+                    uint32_t start = segment.paragraphStarts[doc.paragraphOffset + i];
+                    WriteVarint(docBytes, start - previous);
+                    previous = start;
+                }
+
+                totalTokens += doc.tokenCount;
+                docRemap[s][d] = docCount++;
+            }
+        }
+
+        // Terms: k-way merge of the sorted dictionaries
+        using HeapItem = std::pair<std::string_view, size_t>;  // term, source
+        auto greater = [](const HeapItem& a, const HeapItem& b) {
+            return a.first != b.first ? a.first > b.first : a.second > b.second;
+        };
+        std::priority_queue<HeapItem, std::vector<HeapItem>, decltype(greater)> heap(greater);
+        std::vector<uint32_t> nextTerm(sources.size(), 0);
+        for (size_t s = 0; s < sources.size(); s++) {
+            if (sources[s]->termCount > 0) heap.push({ sources[s]->TermAt(0), s });
+        }
+
+        std::string postings;
+        std::string entries;
+        std::string strings;
+        uint32_t termCount = 0;
+
+        while (!heap.empty()) {
+            std::string term(heap.top().first);
+            TermEntry merged{};
+            merged.stringOffset = static_cast<uint32_t>(strings.size());
+            merged.stringLength = static_cast<uint32_t>(term.size());
+            merged.postingsOffset = postings.size();
+            uint32_t lastDoc = 0;
+
+            while (!heap.empty() && heap.top().first == term) {
+                size_t s = heap.top().second;
+                heap.pop();
+
+                const IndexSegment& segment = *sources[s];
+                const TermEntry& entry = segment.entries[nextTerm[s]];
+
+                // Doc ids are re-encoded; position bytes are copied verbatim
+                PostingCursor cursor = segment.Cursor(entry);
+                while (cursor.Next()) {
+                    if (cursor.doc >= docRemap[s].size()) break;
+                    uint32_t newDoc = docRemap[s][cursor.doc];
+                    if (newDoc == UINT32_MAX) continue;
+
+                    WriteVarint(postings, newDoc - lastDoc);
+                    WriteVarint(postings, cursor.tf);
+                    WriteVarint(postings, cursor.positionsLength);
+                    postings.append(reinterpret_cast<const char*>(cursor.positions), cursor.positionsLength);
+                    lastDoc = newDoc;
+                    merged.docFreq++;
+                }
+
+                if (++nextTerm[s] < segment.termCount) {
+                    heap.push({ segment.TermAt(nextTerm[s]), s });
+                }
+            }
+
+            // Terms that only occurred in dropped docs vanish with them
+            if (merged.docFreq == 0) continue;
+
+            merged.postingsLength = static_cast<uint32_t>(postings.size() - merged.postingsOffset);
+            strings += term;
+            entries += AsBytes(merged);
+            termCount++;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(output, ec);
+
+        TermFileHeader termHeader;
+        std::memcpy(termHeader.magic, TERMS_MAGIC, 4);
+        termHeader.version = INDEX_FORMAT_VERSION;
+        termHeader.termCount = termCount;
+        termHeader.reserved = 0;
+
+        std::string novels;
+        for (const std::string& novelName : novelNames) {
+            WriteVarint(novels, novelName.size());
+            novels += novelName;
+        }
+
+        DocFileHeader docHeader;
+        std::memcpy(docHeader.magic, DOCS_MAGIC, 4);
+        docHeader.version = INDEX_FORMAT_VERSION;
+        docHeader.novelCount = static_cast<uint32_t>(novelNames.size());
+        docHeader.docCount = docCount;
+        docHeader.totalTokens = totalTokens;
+
+        return WriteWholeFile(output / "postings.bin", "", postings) &&
+            WriteWholeFile(output / "terms.bin", AsBytes(termHeader) + entries, strings) &&
+            WriteWholeFile(output / "docs.bin", AsBytes(docHeader) + novels, docBytes);
+    }
+
+    // Opens every segment listed in the manifest, oldest first, and marks dead docs
+    bool OpenManifestSegments(const std::filesystem::path& indexDir, const Manifest& manifest,
+        std::vector<std::unique_ptr<IndexSegment>>& segments) {
+        segments.clear();
+        for (const ManifestSegment& entry : manifest.segments) {
+            auto segment = std::make_unique<IndexSegment>();
+            if (!segment->Open(indexDir / entry.name)) return false;
+            segment->seq = entry.seq;
+            segments.push_back(std::move(segment));
+        }
+
+        std::vector<IndexSegment*> bySeq;
+        for (auto& segment : segments) bySeq.push_back(segment.get());
+        MarkDeadDocs(bySeq, manifest.removedNovels);
+        return true;
+    }
+
+    // Tokenizes chapter files into a new segment directory, spilling and merging runs as needed
+    bool IndexChapterFiles(const std::vector<ChapterFile>& files, const std::filesystem::path& segmentDir,
+        std::atomic<float>* progress, const std::atomic<bool>* cancel, SearchIndex::BuildStats& stats) {
+        std::filesystem::path buildDir = segmentDir.string() + ".building";
+        std::filesystem::remove_all(buildDir);
+
+        SegmentBuilder builder;
+        std::vector<std::filesystem::path> runs;
+
+        std::vector<std::string> terms;
+        std::vector<uint32_t> paragraphStarts;
+
+        auto flushRun = [&]() {
+            std::filesystem::path runDir = buildDir / ("run_" + std::to_string(runs.size()));
+            if (!builder.Write(runDir)) return false;
+            runs.push_back(runDir);
+            builder = SegmentBuilder();
+            return true;
+        };
+
+        std::vector<std::string> fileBytes;
+        std::vector<char> readOk;
+
+        for (size_t i = 0; i < files.size(); i++) {
+            if (cancel && cancel->load()) {
+                std::filesystem::remove_all(buildDir);
+                std::cout << "Index build cancelled" << std::endl;
+                return false;
+            }
+
+            // Chapters are read a batch at a time with many reads in flight, then indexed in order
+            size_t batchIndex = i % INDEX_READ_BATCH;
+            if (batchIndex == 0) {
+                std::vector<BatchReader::Request> requests;
+                for (size_t k = i; k < std::min(files.size(), i + INDEX_READ_BATCH); k++) {
+                    BatchReader::Request request;
+                    request.path = files[k].path.string();
+                    requests.push_back(std::move(request));
+                }
+                fileBytes.assign(requests.size(), std::string());
+                readOk.assign(requests.size(), 0);
+                BatchReader::ReadBatch(requests, [&](size_t index, bool ok, std::string& data) {
+                    fileBytes[index] = std::move(data);
+                    readOk[index] = ok;
+                });
+            }
+
+            const ChapterFile& chapterFile = files[i];
+            ChapterStore::MappedChapter chapter;
+            if (!readOk[batchIndex] ||
+                !ChapterStore::OpenChapterBytes(chapterFile.path.string(), std::move(fileBytes[batchIndex]), chapter)) {
+                std::cout << "Skipping unreadable chapter " << chapterFile.path << std::endl;
+                continue;
+            }
+
+            // Tokenized straight from the buffer it was read into
+            int chapterNumber = chapter.Number() > 0 ? chapter.Number() : chapterFile.chapterNumber;
+            SearchIndex::Tokenize(chapter.Body(), terms, &paragraphStarts);
+            builder.AddDocument(chapterFile.novelName, chapterNumber, FileModifiedTime(chapterFile.path),
+                terms, paragraphStarts);
+
+            stats.documents++;
+            stats.tokens += terms.size();
+            stats.inputBytes += chapter.JsonBytes();
+
+            // Spill to disk when the in-memory run grows too large; runs are merged at the end
+            if (builder.MemoryUsage() > RUN_MEMORY_BUDGET && !flushRun()) {
+                std::filesystem::remove_all(buildDir);
+                return false;
+            }
+
+            if (progress) progress->store(0.95f * static_cast<float>(i + 1) / static_cast<float>(files.size()));
+        }
+
+        if (!builder.Empty() || runs.empty()) {
+            if (!flushRun()) {
+                std::filesystem::remove_all(buildDir);
+                return false;
+            }
+        }
+
+        bool ok = true;
+        if (runs.size() == 1) {
+            std::filesystem::rename(runs[0], segmentDir);
+        }
+        else {
+            // Runs never overlap, so a plain merge with nothing dead concatenates them
+            std::vector<std::unique_ptr<IndexSegment>> opened;
+            std::vector<const IndexSegment*> sources;
+            for (const auto& run : runs) {
+                auto segment = std::make_unique<IndexSegment>();
+                if (!segment->Open(run)) {
+                    ok = false;
+                    break;
+                }
+                sources.push_back(segment.get());
+                opened.push_back(std::move(segment));
+            }
+            ok = ok && MergeSegments(sources, segmentDir);
+        }
+
+        std::filesystem::remove_all(buildDir);
+        if (!ok) std::filesystem::remove_all(segmentDir);
+        return ok;
+    }
+
+    struct ParsedQuery {
+        std::vector<std::string> terms;               // unique terms
+        std::vector<std::vector<size_t>> phrases;     // indices into terms, in phrase order
+    };
+
+    ParsedQuery ParseQuery(const std::string& query) {
+        ParsedQuery parsed;
+        std::vector<std::string> tokens;
+
+        auto termIndex = [&parsed](const std::string& term) {
+            auto it = std::find(parsed.terms.begin(), parsed.terms.end(), term);
+            if (it != parsed.terms.end()) return static_cast<size_t>(it - parsed.terms.begin());
+            parsed.terms.push_back(term);
+            return parsed.terms.size() - 1;
+        };
+
+        size_t pos = 0;
+        bool inQuotes = false;
+        while (pos <= query.size()) {
+            size_t next = query.find('"', pos);
+            if (next == std::string::npos) next = query.size();
+
+            SearchIndex::Tokenize(std::string_view(query).substr(pos, next - pos), tokens);
+            if (inQuotes && tokens.size() > 1) {
+                std::vector<size_t> phrase;
+                for (const std::string& token : tokens) phrase.push_back(termIndex(token));
+                parsed.phrases.push_back(std::move(phrase));
+            }
+            else {
+                for (const std::string& token : tokens) termIndex(token);
+            }
+
+            inQuotes = !inQuotes;
+            pos = next + 1;
+        }
+        return parsed;
+    }
+
+    // First position where the phrase occurs, or -1
+    long long FindPhrase(const std::vector<std::vector<uint32_t>>& termPositions, const std::vector<size_t>& phrase) {
+        for (uint32_t start : termPositions[phrase[0]]) {
+            bool matched = true;
+            for (size_t k = 1; k < phrase.size() && matched; k++) {
+                const std::vector<uint32_t>& positions = termPositions[phrase[k]];
+                matched = std::binary_search(positions.begin(), positions.end(), start + static_cast<uint32_t>(k));
+            }
+            if (matched) return start;
+        }
+        return -1;
+    }
+
+    std::string BuildSnippet(const std::string& novelsRoot, const SearchIndex::Hit& hit,
+        const std::vector<std::string>& terms) {
+        std::filesystem::path chapterPath = std::filesystem::path(novelsRoot) / hit.novelName / "chapters" /
+            ("chapter" + std::to_string(hit.chapterNumber) + ".json");
+
+        ChapterStore::MappedChapter chapter;
+        if (!ChapterStore::OpenChapter(chapterPath.string(), chapter)) return "";
+
+        // Walk to the hit's paragraph (non-empty lines, same rule as the reader)
+        std::istringstream stream{ std::string(chapter.Body()) };
+        std::string line;
+        int paragraph = 0;
+        while (std::getline(stream, line)) {
+            if (IsBlankLine(line)) continue;
+            if (paragraph++ == hit.paragraphIndex) break;
+        }
+
+        std::string folded = line;
+        for (char& c : folded) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c + 0x20);
+        }
+
+        size_t matchAt = std::string::npos;
+        for (const std::string& term : terms) {
+            matchAt = std::min(matchAt, folded.find(term));
+        }
+        if (matchAt == std::string::npos) matchAt = 0;
+
+        constexpr size_t SNIPPET_BEFORE = 60;
+        constexpr size_t SNIPPET_LENGTH = 180;
+        size_t start = matchAt > SNIPPET_BEFORE ? matchAt - SNIPPET_BEFORE : 0;
+        while (start > 0 && (static_cast<unsigned char>(line[start]) & 0xC0) == 0x80) start--;
+        size_t end = std::min(line.size(), start + SNIPPET_LENGTH);
+        while (end < line.size() && (static_cast<unsigned char>(line[end]) & 0xC0) == 0x80) end++;
+
+        std::string snippet = (start > 0 ? "..." : "") + line.substr(start, end - start);
+        if (end < line.size()) snippet += "...";
+        return snippet;
+    }
+}
+
+// ============================================================================
+// SearchIndex
+// ============================================================================
+SearchIndex::SearchIndex() = default;
+SearchIndex::~SearchIndex() = default;
+
+void SearchIndex::Tokenize(std::string_view text, std::vector<std::string>& terms,
+    std::vector<uint32_t>* paragraphStarts) {
+    terms.clear();
+    if (paragraphStarts) paragraphStarts->clear();
+
+    size_t lineStart = 0;
+    while (lineStart <= text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = text.size();
+
+        std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        if (!IsBlankLine(line)) {
+            if (paragraphStarts) paragraphStarts->push_back(static_cast<uint32_t>(terms.size()));
+            TokenizeLine(line, terms);
+        }
+
+        if (lineEnd == text.size()) break;
+        lineStart = lineEnd + 1;
+    }
+}
+
+bool SearchIndex::Build(const std::string& novelsRoot, const std::string& indexDir,
+    std::atomic<float>* progress, const std::atomic<bool>* cancel, BuildStats* stats) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    try {
+        std::filesystem::path root(indexDir);
+        std::filesystem::create_directories(root);
+
+        std::vector<ChapterFile> files = CollectChapterFiles(novelsRoot);
+        std::filesystem::path staging = NewStagingDir(root);
+        BuildStats localStats;
+
+        if (!IndexChapterFiles(files, staging, progress, cancel, localStats)) {
+            return false;
+        }
+
+        {
+            FileLock lock(IndexLockPath(root));
+
+            // Only the sequence counter survives a rebuild so segment names never repeat
+            Manifest previous;
+            ReadManifest(root, previous);
+
+            Manifest manifest;
+            manifest.novelsRoot = novelsRoot;
+            uint64_t seq = previous.nextSeq;
+            manifest.nextSeq = seq + 1;
+
+            ManifestSegment published;
+            if (!PublishStaged(root, staging, seq, published)) {
+                std::filesystem::remove_all(staging);
+                return false;
+            }
+            manifest.segments.push_back(published);
+            if (!WriteManifest(root, manifest)) {
+                std::filesystem::remove_all(root / published.name);
+                return false;
+            }
+        }
+
+        localStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (stats) *stats = localStats;
+        if (progress) progress->store(1.0f);
+
+        std::cout << "Indexed " << localStats.documents << " chapters (" << localStats.tokens << " tokens) in "
+            << localStats.seconds << "s" << std::endl;
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error building search index: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+// ============================================================================
+// Incremental updates
+// ============================================================================
+bool SearchIndex::AddChapters(const std::string& novelsRoot, const std::string& indexDir,
+    const std::vector<ChapterRef>& chapters, BuildStats* stats) {
+    try {
+        std::filesystem::path root(indexDir);
+        std::filesystem::create_directories(root);
+
+        std::vector<ChapterFile> files;
+        for (const ChapterRef& chapter : chapters) {
+            std::filesystem::path path = std::filesystem::path(novelsRoot) / chapter.novelName / "chapters" /
+                ("chapter" + std::to_string(chapter.chapterNumber) + ".json");
+            if (std::filesystem::exists(path)) {
+                files.push_back({ chapter.novelName, chapter.chapterNumber, path });
+            }
+        }
+        if (files.empty()) return true;
+
+        // Within a batch the last write of a chapter is the one that counts
+        std::stable_sort(files.begin(), files.end(), [](const ChapterFile& a, const ChapterFile& b) {
+            if (a.novelName != b.novelName) return a.novelName < b.novelName;
+            return a.chapterNumber < b.chapterNumber;
+        });
+        files.erase(std::unique(files.begin(), files.end(), [](const ChapterFile& a, const ChapterFile& b) {
+            return a.novelName == b.novelName && a.chapterNumber == b.chapterNumber;
+        }), files.end());
+
+        std::filesystem::path staging = NewStagingDir(root);
+        BuildStats localStats;
+        if (!IndexChapterFiles(files, staging, nullptr, nullptr, localStats)) {
+            return false;
+        }
+
+        // Sequence numbers are handed out at publication, so the segment published last shadows the rest
+        {
+            FileLock lock(IndexLockPath(root));
+            Manifest manifest;
+            if (!ReadManifest(root, manifest)) {
+                manifest = Manifest();
+            }
+            manifest.novelsRoot = novelsRoot;
+
+            ManifestSegment published;
+            if (!PublishStaged(root, staging, manifest.nextSeq++, published)) {
+                std::filesystem::remove_all(staging);
+                return false;
+            }
+            manifest.segments.push_back(published);
+            if (!WriteManifest(root, manifest)) {
+                std::filesystem::remove_all(root / published.name);
+                return false;
+            }
+        }
+
+        if (stats) *stats = localStats;
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error adding chapters to search index: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SearchIndex::BeginRebuild(const std::string& novelsRoot, const std::string& indexDir, uint64_t& firstSeq) {
+    try {
+        std::filesystem::path root(indexDir);
+        std::filesystem::create_directories(root);
+
+        FileLock lock(IndexLockPath(root));
+        Manifest manifest;
+        if (ReadManifest(root, manifest)) {
+            firstSeq = manifest.nextSeq;
+            return true;
+        }
+
+        // Nothing readable to keep serving meanwhile (first run, or an older format): start empty
+        manifest = Manifest();
+        manifest.novelsRoot = novelsRoot;
+        firstSeq = manifest.nextSeq;
+        return WriteManifest(root, manifest);
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error starting search index rebuild: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SearchIndex::FinishRebuild(const std::string& indexDir, uint64_t firstSeq) {
+    try {
+        std::filesystem::path root(indexDir);
+        FileLock lock(IndexLockPath(root));
+        Manifest manifest;
+        if (!ReadManifest(root, manifest)) return false;
+
+        // Tombstones only hide docs of the dropped segments, so they go too; CollectGarbage deletes the files
+        manifest.segments.erase(std::remove_if(manifest.segments.begin(), manifest.segments.end(),
+            [&](const ManifestSegment& segment) { return segment.seq < firstSeq; }), manifest.segments.end());
+        for (auto it = manifest.removedNovels.begin(); it != manifest.removedNovels.end();) {
+            it = it->second < firstSeq ? manifest.removedNovels.erase(it) : std::next(it);
+        }
+        return WriteManifest(root, manifest);
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error finishing search index rebuild: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<SearchIndex::ChapterRef> SearchIndex::ListChapters(const std::string& novelsRoot) {
+    std::vector<ChapterRef> chapters;
+    for (const ChapterFile& file : CollectChapterFiles(novelsRoot)) {
+        chapters.push_back({ file.novelName, file.chapterNumber });
+    }
+    return chapters;
+}
+
+bool SearchIndex::RemoveNovel(const std::string& indexDir, const std::string& novelName) {
+    try {
+        std::filesystem::path root(indexDir);
+        if (!std::filesystem::exists(root / "manifest.json")) return true;
+
+        FileLock lock(IndexLockPath(root));
+        Manifest manifest;
+        if (!ReadManifest(root, manifest)) return true;
+
+        // Tombstone: everything indexed so far for this novel is hidden, later segments are not
+        manifest.removedNovels[novelName] = manifest.nextSeq - 1;
+        return WriteManifest(root, manifest);
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error removing novel from search index: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SearchIndex::Compact(const std::string& indexDir, const std::atomic<bool>* cancel, size_t maxMerges) {
+    try {
+        std::filesystem::path root(indexDir);
+        bool changed = false;
+        size_t merges = 0;
+        while (merges < maxMerges && !(cancel && cancel->load())) {
+            std::vector<std::unique_ptr<IndexSegment>> opened;
+            {
+                // Segments are opened under the lock so none of them is collected in between;
+                // once mapped they stay readable
+                FileLock lock(IndexLockPath(root));
+                Manifest manifest;
+                if (!ReadManifest(root, manifest)) return changed;
+                if (!OpenManifestSegments(root, manifest, opened)) return changed;
+
+                // Tombstones are dropped once no older segment still mentions the novel
+                size_t tombstones = manifest.removedNovels.size();
+                for (auto it = manifest.removedNovels.begin(); it != manifest.removedNovels.end();) {
+                    bool referenced = std::any_of(opened.begin(), opened.end(), [&](const std::unique_ptr<IndexSegment>& segment) {
+                        return segment->seq <= it->second &&
+                            std::find(segment->novelNames.begin(), segment->novelNames.end(), it->first) != segment->novelNames.end();
+                    });
+                    it = referenced ? std::next(it) : manifest.removedNovels.erase(it);
+                }
+                if (manifest.removedNovels.size() != tombstones) {
+                    if (!WriteManifest(root, manifest)) return false;
+                    changed = true;
+                }
+
+                // Segments with nothing live left are simply dropped
+                size_t emptyIndex = 0;
+                while (emptyIndex < opened.size() && opened[emptyIndex]->liveDocs > 0) emptyIndex++;
+                if (emptyIndex < opened.size()) {
+                    manifest.segments.erase(manifest.segments.begin() + emptyIndex);
+                    if (!WriteManifest(root, manifest)) return false;
+                    changed = true;
+                    continue;
+                }
+            }
+
+            const size_t count = opened.size();
+            auto tierOf = [](uint64_t bytes) {
+                int tier = 0;
+                for (uint64_t limit = SMALLEST_TIER_BYTES; bytes > limit && tier < 32; limit *= MERGE_FACTOR) tier++;
+                return tier;
+            };
+
+            // Newest run of MERGE_FACTOR adjacent same-tier segments
+            size_t mergeBegin = 0;
+            size_t mergeEnd = 0;
+            for (size_t end = count; end >= MERGE_FACTOR && mergeEnd == 0; end--) {
+                int tier = tierOf(opened[end - 1]->bytes);
+                size_t begin = end - MERGE_FACTOR;
+                bool sameTier = true;
+                for (size_t i = begin; i < end && sameTier; i++) sameTier = tierOf(opened[i]->bytes) == tier;
+                if (sameTier) {
+                    mergeBegin = begin;
+                    mergeEnd = end;
+                }
+            }
+
+            // Too many segments: merge the cheapest adjacent window
+            if (mergeEnd == 0 && count > MAX_SEGMENTS) {
+                uint64_t bestBytes = UINT64_MAX;
+                for (size_t begin = 0; begin + MERGE_FACTOR <= count; begin++) {
+                    uint64_t bytes = 0;
+                    for (size_t i = begin; i < begin + MERGE_FACTOR; i++) bytes += opened[i]->bytes;
+                    if (bytes < bestBytes) {
+                        bestBytes = bytes;
+                        mergeBegin = begin;
+                        mergeEnd = begin + MERGE_FACTOR;
+                    }
+                }
+            }
+
+            // A segment that is mostly shadowed is rewritten on its own
+            if (mergeEnd == 0) {
+                for (size_t i = 0; i < count; i++) {
+                    if (!opened[i]->docs.empty() && opened[i]->liveDocs * 2 < opened[i]->docs.size()) {
+                        mergeBegin = i;
+                        mergeEnd = i + 1;
+                        break;
+                    }
+                }
+            }
+            if (mergeEnd == 0) break;
+
+            std::vector<const IndexSegment*> sources;
+            for (size_t i = mergeBegin; i < mergeEnd; i++) sources.push_back(opened[i].get());
+
+            std::filesystem::path staging = NewStagingDir(root);
+            if (!MergeSegments(sources, staging)) {
+                std::filesystem::remove_all(staging);
+                return false;
+            }
+
+            // Another process may have changed the index during the merge: the output replaces its
+            // inputs only if they are all still listed, side by side
+            FileLock lock(IndexLockPath(root));
+            Manifest manifest;
+            if (!ReadManifest(root, manifest)) {
+                std::filesystem::remove_all(staging);
+                return changed;
+            }
+            auto first = std::find_if(manifest.segments.begin(), manifest.segments.end(),
+                [&](const ManifestSegment& segment) { return segment.name == sources.front()->name; });
+            bool inputsListed = static_cast<size_t>(manifest.segments.end() - first) >= sources.size();
+            for (size_t i = 0; inputsListed && i < sources.size(); i++) {
+                inputsListed = first[i].name == sources[i]->name;
+            }
+            if (!inputsListed) {
+                std::filesystem::remove_all(staging);
+                continue;
+            }
+
+            // Adjacent inputs keep shadowing order intact, so the output takes the newest sequence
+            ManifestSegment published;
+            if (!PublishStaged(root, staging, sources.back()->seq, published)) {
+                std::filesystem::remove_all(staging);
+                return false;
+            }
+            size_t position = first - manifest.segments.begin();
+            manifest.segments.erase(first, first + sources.size());
+            manifest.segments.insert(manifest.segments.begin() + position, published);
+
+            if (!WriteManifest(root, manifest)) {
+                std::filesystem::remove_all(root / published.name);
+                return false;
+            }
+            changed = true;
+            merges++;
+        }
+
+        return changed;
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error compacting search index: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void SearchIndex::CollectGarbage(const std::string& indexDir) {
+    std::filesystem::path root(indexDir);
+    if (!std::filesystem::exists(root / "manifest.json")) return;
+
+    FileLock lock(IndexLockPath(root));
+    Manifest manifest;
+    if (!ReadManifest(root, manifest)) return;
+
+    // Segments dropped from the manifest are deleted; on Windows a segment still mapped by a reader
+    // fails to delete and is retried on the next pass. Staging directories belong to a writer that is
+    // still working, unless they have not been touched for a long time.
+    auto abandoned = std::filesystem::file_time_type::clock::now() - STAGING_ABANDONED_AFTER;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(root, ec)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_directory()) continue;
+
+        bool unused = false;
+        if (name.rfind("seg_", 0) == 0) {
+            unused = std::none_of(manifest.segments.begin(), manifest.segments.end(),
+                [&](const ManifestSegment& segment) { return segment.name == name; });
+        }
+        else if (name.rfind("staging_", 0) == 0) {
+            std::error_code timeError;
+            auto modified = std::filesystem::last_write_time(entry.path(), timeError);
+            unused = !timeError && modified < abandoned;
+        }
+        if (unused) {
+            std::error_code removeError;
+            std::filesystem::remove_all(entry.path(), removeError);
+        }
+    }
+}
+
+std::vector<SearchIndex::ChapterRef> SearchIndex::FindStaleChapters(const std::string& novelsRoot,
+    const std::string& indexDir, std::vector<std::string>* vanishedNovels) {
+    std::vector<ChapterRef> stale;
+
+    try {
+        std::filesystem::path root(indexDir);
+        Manifest manifest;
+        std::vector<std::unique_ptr<IndexSegment>> opened;
+        std::map<std::pair<std::string, int>, int64_t> indexed;
+
+        bool listed = false;
+        if (std::filesystem::exists(root / "manifest.json")) {
+            FileLock lock(IndexLockPath(root));
+            listed = ReadManifest(root, manifest) && OpenManifestSegments(root, manifest, opened);
+        }
+        if (listed) {
+            for (const auto& segment : opened) {
+                for (size_t d = 0; d < segment->docs.size(); d++) {
+                    if (segment->dead[d]) continue;
+                    const auto& doc = segment->docs[d];
+                    indexed[{ segment->novelNames[doc.novelId], doc.chapterNumber }] = doc.modifiedTime;
+                }
+            }
+        }
+
+        std::map<std::string, bool> novelsOnDisk;
+        for (const ChapterFile& file : CollectChapterFiles(novelsRoot)) {
+            novelsOnDisk[file.novelName] = true;
+            auto it = indexed.find({ file.novelName, file.chapterNumber });
+            if (it == indexed.end() || it->second != FileModifiedTime(file.path)) {
+                stale.push_back({ file.novelName, file.chapterNumber });
+            }
+        }
+
+        if (vanishedNovels) {
+            vanishedNovels->clear();
+            for (const auto& [key, modified] : indexed) {
+                if (!novelsOnDisk.count(key.first) &&
+                    (vanishedNovels->empty() || vanishedNovels->back() != key.first)) {
+                    vanishedNovels->push_back(key.first);
+                }
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error scanning for unindexed chapters: " << e.what() << std::endl;
+    }
+    return stale;
+}
+
+struct SearchIndex::Refresh {
+    std::string novelsRoot;
+    std::vector<std::string> names;                      // Manifest order, skipped segments left out
+    std::vector<std::unique_ptr<IndexSegment>> opened;   // Parallel to names; null where already open
+    std::vector<DocMarks> marks;                         // Parallel to names
+};
+
+std::shared_ptr<SearchIndex::Refresh> SearchIndex::PrepareRefresh(const std::string& indexDir) const {
+    try {
+        std::filesystem::path root(indexDir);
+        Manifest manifest;
+        std::vector<std::unique_ptr<IndexSegment>> fresh;
+        std::vector<uint8_t> missing;
+
+        auto findOpen = [&](const std::string& name) -> const IndexSegment* {
+            auto it = std::find_if(segments.begin(), segments.end(),
+                [&](const std::unique_ptr<IndexSegment>& segment) { return segment->name == name; });
+            return it != segments.end() ? it->get() : nullptr;
+        };
+
+        // Segments that are already mapped are reused, so a refresh only opens new deltas.
+        // A segment that is missing or fails to open was usually collected after another process
+        // replaced this manifest, so the manifest is read once more; one that still fails is left out.
+        for (int attempt = 0; ; attempt++) {
+            if (!ReadManifest(root, manifest)) {
+                return nullptr;
+            }
+            fresh.clear();
+            fresh.resize(manifest.segments.size());
+            missing.assign(manifest.segments.size(), 0);
+
+            bool anyMissing = false;
+            for (size_t i = 0; i < manifest.segments.size(); i++) {
+                const ManifestSegment& entry = manifest.segments[i];
+                if (findOpen(entry.name)) continue;
+
+                fresh[i] = std::make_unique<IndexSegment>();
+                if (!std::filesystem::exists(root / entry.name) || !fresh[i]->Open(root / entry.name)) {
+                    fresh[i].reset();
+                    missing[i] = 1;
+                    anyMissing = true;
+                }
+            }
+            if (!anyMissing || attempt > 0) break;
+        }
+
+        auto refresh = std::make_shared<Refresh>();
+        refresh->novelsRoot = manifest.novelsRoot;
+        std::vector<const IndexSegment*> bySeq;
+        for (size_t i = 0; i < manifest.segments.size(); i++) {
+            if (missing[i]) {
+                std::cout << "Index segment missing or unreadable, skipped: " << manifest.segments[i].name << std::endl;
+                continue;
+            }
+            if (fresh[i]) {
+                fresh[i]->seq = manifest.segments[i].seq;
+                bySeq.push_back(fresh[i].get());
+            }
+            else {
+                bySeq.push_back(findOpen(manifest.segments[i].name));
+            }
+            refresh->names.push_back(manifest.segments[i].name);
+            refresh->opened.push_back(std::move(fresh[i]));
+        }
+
+        // Marks go into the refresh: the open segments may be serving a search right now
+        MarkDeadDocs(bySeq, manifest.removedNovels, refresh->marks);
+        return refresh;
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error opening search index: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+void SearchIndex::ApplyRefresh(Refresh& refresh) {
+    std::vector<std::unique_ptr<IndexSegment>> next;
+    for (size_t i = 0; i < refresh.names.size(); i++) {
+        std::unique_ptr<IndexSegment> segment = std::move(refresh.opened[i]);
+        if (!segment) {
+            auto it = std::find_if(segments.begin(), segments.end(),
+                [&](const std::unique_ptr<IndexSegment>& open) { return open && open->name == refresh.names[i]; });
+            if (it == segments.end()) continue;   // Closed since the refresh was prepared
+            segment = std::move(*it);
+        }
+        segment->dead = std::move(refresh.marks[i].dead);
+        segment->liveDocs = refresh.marks[i].liveDocs;
+        segment->liveTokens = refresh.marks[i].liveTokens;
+        next.push_back(std::move(segment));
+    }
+
+    segments = std::move(next);
+    novelsRoot = refresh.novelsRoot;
+    totalDocuments = 0;
+    totalTokens = 0;
+    for (const auto& segment : segments) {
+        totalDocuments += segment->liveDocs;
+        totalTokens += segment->liveTokens;
+    }
+}
+
+bool SearchIndex::Open(const std::string& indexDir) {
+    std::shared_ptr<Refresh> refresh = PrepareRefresh(indexDir);
+    if (!refresh) return false;
+    ApplyRefresh(*refresh);
+    return true;
+}
+
+void SearchIndex::Close() {
+    segments.clear();
+    totalDocuments = 0;
+    totalTokens = 0;
+}
+
+std::vector<SearchIndex::Hit> SearchIndex::Search(const std::string& query, const std::string& novelFilter,
+    size_t maxResults) const {
+    std::vector<Hit> hits;
+    if (segments.empty() || totalDocuments == 0) return hits;
+
+    ParsedQuery parsed = ParseQuery(query);
+    if (parsed.terms.empty()) return hits;
+
+    const size_t termCount = parsed.terms.size();
+    const float averageLength = static_cast<float>(totalTokens) / static_cast<float>(totalDocuments);
+
+    // Library-wide document frequencies so scores are comparable across segments.
+    // Shadowed docs still count here until compaction drops them; the skew is small.
+    std::vector<float> idf(termCount);
+    for (size_t t = 0; t < termCount; t++) {
+        uint64_t df = 0;
+        for (const auto& segment : segments) {
+            if (const TermEntry* entry = segment->FindTerm(parsed.terms[t])) df += entry->docFreq;
+        }
+        if (df == 0) return hits;  // conjunctive: a missing term means no results
+        idf[t] = std::log(1.0f + (static_cast<float>(totalDocuments) - df + 0.5f) / (df + 0.5f));
+    }
+
+    std::vector<std::vector<uint32_t>> termPositions(termCount);
+
+    for (const auto& segmentPtr : segments) {
+        const IndexSegment& segment = *segmentPtr;
+
+        uint32_t filterId = UINT32_MAX;
+        if (!novelFilter.empty()) {
+            auto it = std::find(segment.novelNames.begin(), segment.novelNames.end(), novelFilter);
+            if (it == segment.novelNames.end()) continue;
+            filterId = static_cast<uint32_t>(it - segment.novelNames.begin());
+        }
+
+        std::vector<const TermEntry*> termEntries(termCount);
+        bool allPresent = true;
+        for (size_t t = 0; t < termCount && allPresent; t++) {
+            termEntries[t] = segment.FindTerm(parsed.terms[t]);
+            allPresent = termEntries[t] != nullptr;
+        }
+        if (!allPresent) continue;
+
+        // Walk terms rarest first; candidates only ever shrink
+        std::vector<size_t> order(termCount);
+        for (size_t t = 0; t < termCount; t++) order[t] = t;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return termEntries[a]->docFreq < termEntries[b]->docFreq;
+        });
+
+        std::vector<uint32_t> candidates;
+        std::vector<const uint8_t*> positionPtr;   // candidate * termCount + term
+        std::vector<uint32_t> positionLen;
+        std::vector<uint32_t> termFreq;
+
+        PostingCursor first = segment.Cursor(*termEntries[order[0]]);
+        while (first.Next()) {
+            if (first.doc >= segment.docs.size()) break;
+            if (segment.dead[first.doc]) continue;
+            if (filterId != UINT32_MAX && segment.docs[first.doc].novelId != filterId) continue;
+
+            candidates.push_back(first.doc);
+            positionPtr.resize(candidates.size() * termCount);
+            positionLen.resize(candidates.size() * termCount);
+            termFreq.resize(candidates.size() * termCount);
+            size_t slot = (candidates.size() - 1) * termCount + order[0];
+            positionPtr[slot] = first.positions;
+            positionLen[slot] = first.positionsLength;
+            termFreq[slot] = first.tf;
+        }
+
+        for (size_t k = 1; k < termCount && !candidates.empty(); k++) {
+            size_t t = order[k];
+            PostingCursor cursor = segment.Cursor(*termEntries[t]);
+            size_t kept = 0;
+            bool more = cursor.Next();
+
+            for (size_t c = 0; c < candidates.size(); c++) {
+                while (more && cursor.doc < candidates[c]) more = cursor.Next();
+                if (!more) break;
+                if (cursor.doc != candidates[c]) continue;
+
+                // Keep this candidate, compacting in place
+                if (kept != c) {
+                    candidates[kept] = candidates[c];
+                    std::copy_n(positionPtr.begin() + c * termCount, termCount, positionPtr.begin() + kept * termCount);
+                    std::copy_n(positionLen.begin() + c * termCount, termCount, positionLen.begin() + kept * termCount);
+                    std::copy_n(termFreq.begin() + c * termCount, termCount, termFreq.begin() + kept * termCount);
+                }
+                size_t slot = kept * termCount + t;
+                positionPtr[slot] = cursor.positions;
+                positionLen[slot] = cursor.positionsLength;
+                termFreq[slot] = cursor.tf;
+                kept++;
+            }
+            candidates.resize(kept);
+        }
+
+        for (size_t c = 0; c < candidates.size(); c++) {
+            uint32_t docId = candidates[c];
+            const IndexSegment::DocInfo& doc = segment.docs[docId];
+
+            // Decode positions only for surviving documents
+            for (size_t t = 0; t < termCount; t++) {
+                DecodePositions(positionPtr[c * termCount + t], positionLen[c * termCount + t], termPositions[t]);
+            }
+
+            long long bestPosition = -1;
+            bool phrasesMatch = true;
+            for (const auto& phrase : parsed.phrases) {
+                long long at = FindPhrase(termPositions, phrase);
+                if (at < 0) {
+                    phrasesMatch = false;
+                    break;
+                }
+                if (bestPosition < 0) bestPosition = at;
+            }
+            if (!phrasesMatch) continue;
+
+            float score = 0.0f;
+            float lengthNorm = BM25_K1 * (1.0f - BM25_B + BM25_B * doc.tokenCount / averageLength);
+            for (size_t t = 0; t < termCount; t++) {
+                float tf = static_cast<float>(termFreq[c * termCount + t]);
+                score += idf[t] * (tf * (BM25_K1 + 1.0f)) / (tf + lengthNorm);
+            }
+
+            if (bestPosition < 0 && !termPositions[order[0]].empty()) {
+                bestPosition = termPositions[order[0]].front();
+            }
+
+            Hit hit;
+            hit.novelName = segment.novelNames[doc.novelId];
+            hit.chapterNumber = doc.chapterNumber;
+            hit.paragraphIndex = segment.ParagraphForPosition(docId, static_cast<uint32_t>(std::max(0LL, bestPosition)));
+            hit.score = score;
+            hits.push_back(std::move(hit));
+        }
+    }
+
+    size_t keep = std::min(maxResults, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(),
+        [](const Hit& a, const Hit& b) { return a.score > b.score; });
+    hits.resize(keep);
+
+    for (Hit& hit : hits) {
+        hit.snippet = BuildSnippet(novelsRoot, hit, parsed.terms);
+    }
+    return hits;
+}
+
+// ============================================================================
+// Self-test
+// ============================================================================
+namespace {
+    using ChapterContents = std::map<std::pair<std::string, int>, std::string>;
+
+    // Every live doc of the index must be one of the expected chapters, each exactly once, and
+    // its postings, token count and paragraph starts must decode to what tokenizing it gives
+    bool CheckIndexContents(const std::filesystem::path& indexDir, const ChapterContents& expected, std::string& error) {
+        Manifest manifest;
+        std::vector<std::unique_ptr<IndexSegment>> opened;
+        if (!ReadManifest(indexDir, manifest) || !OpenManifestSegments(indexDir, manifest, opened)) {
+            error = "index does not open";
+            return false;
+        }
+
+        using TermPositions = std::map<std::string, std::vector<uint32_t>>;
+        std::map<std::pair<std::string, int>, TermPositions> decoded;
+        for (const auto& segment : opened) {
+            for (size_t d = 0; d < segment->docs.size(); d++) {
+                if (segment->dead[d]) continue;
+                const IndexSegment::DocInfo& doc = segment->docs[d];
+                auto key = std::make_pair(segment->novelNames[doc.novelId], doc.chapterNumber);
+                auto it = expected.find(key);
+                if (it == expected.end() || decoded.count(key)) {
+                    error = "unexpected or duplicate doc " + key.first + " #" + std::to_string(key.second);
+                    return false;
+                }
+                decoded[key];
+
+                std::vector<std::string> terms;
+                std::vector<uint32_t> paragraphStarts;
+                SearchIndex::Tokenize(it->second, terms, &paragraphStarts);
+                std::vector<uint32_t> storedStarts(segment->paragraphStarts.begin() + doc.paragraphOffset,
+                    segment->paragraphStarts.begin() + doc.paragraphOffset + doc.paragraphCount);
+                if (doc.tokenCount != terms.size() || storedStarts != paragraphStarts) {
+                    error = "doc header of " + key.first + " #" + std::to_string(key.second) + " differs";
+                    return false;
+                }
+            }
+
+            std::vector<uint32_t> positions;
+            for (uint32_t t = 0; t < segment->termCount; t++) {
+                std::string term(segment->TermAt(t));
+                if (t > 0 && segment->TermAt(t - 1) >= term) {
+                    error = "term dictionary of " + segment->name + " is not sorted";
+                    return false;
+                }
+                PostingCursor cursor = segment->Cursor(segment->entries[t]);
+                uint32_t docFreq = 0;
+                while (cursor.Next()) {
+                    docFreq++;
+                    if (cursor.doc >= segment->docs.size()) {
+                        error = "posting of \"" + term + "\" points past the docs";
+                        return false;
+                    }
+                    DecodePositions(cursor.positions, cursor.positionsLength, positions);
+                    if (positions.size() != cursor.tf) {
+                        error = "term frequency of \"" + term + "\" differs from its positions";
+                        return false;
+                    }
+                    if (segment->dead[cursor.doc]) continue;
+                    const IndexSegment::DocInfo& doc = segment->docs[cursor.doc];
+                    decoded[{ segment->novelNames[doc.novelId], doc.chapterNumber }][term] = positions;
+                }
+                if (docFreq != segment->entries[t].docFreq) {
+                    error = "document frequency of \"" + term + "\" differs from its postings";
+                    return false;
+                }
+            }
+        }
+
+        for (const auto& [key, content] : expected) {
+            auto found = decoded.find(key);
+            if (found == decoded.end()) {
+                error = "chapter " + key.first + " #" + std::to_string(key.second) + " is missing";
+                return false;
+            }
+            std::vector<std::string> terms;
+            SearchIndex::Tokenize(content, terms);
+            TermPositions positions;
+            for (uint32_t i = 0; i < terms.size(); i++) positions[terms[i]].push_back(i);
+            if (positions != found->second) {
+                error = "postings of " + key.first + " #" + std::to_string(key.second) + " differ";
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool SearchIndex::RunTests(const std::string& workDir) {
+    int failures = 0;
+    auto check = [&failures](bool condition, const std::string& what) {
+        if (!condition) {
+            std::cout << "FAILED: " << what << std::endl;
+            failures++;
+        }
+    };
+
+    // Varints and zigzag, at every byte length boundary
+    {
+        const uint64_t values[] = { 0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, UINT32_MAX, 1ull << 32, 1ull << 63, UINT64_MAX };
+        std::string bytes;
+        for (uint64_t value : values) WriteVarint(bytes, value);
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(bytes.data());
+        const uint8_t* end = p + bytes.size();
+        for (uint64_t value : values) {
+            uint64_t decoded = 0;
+            check(ReadVarint(p, end, decoded) && decoded == value, "varint round trip of " + std::to_string(value));
+        }
+        check(p == end, "varints consume exactly their bytes");
+
+        std::string wide;
+        WriteVarint(wide, 1ull << 32);
+        const uint8_t* q = reinterpret_cast<const uint8_t*>(wide.data());
+        uint32_t narrow;
+        check(!ReadVarint32(q, q + wide.size(), narrow), "32-bit varint rejects a wider value");
+        q = reinterpret_cast<const uint8_t*>(wide.data());
+        uint64_t truncated;
+        check(!ReadVarint(q, q + wide.size() - 1, truncated), "truncated varint is rejected");
+
+        const int64_t signedValues[] = { 0, 1, -1, 63, -64, 64, -65, INT64_MAX, INT64_MIN };
+        for (int64_t value : signedValues) {
+            check(UnZigZag(ZigZag(value)) == value, "zigzag round trip of " + std::to_string(value));
+        }
+        check(ZigZag(-1) == 1 && ZigZag(1) == 2, "zigzag keeps small values small");
+    }
+
+    std::filesystem::path root(workDir);
+    std::filesystem::path novelsDir = root / "Novels";
+    std::filesystem::path indexDir = root / "index";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(indexDir);
+
+    // Manifest
+    {
+        Manifest written;
+        written.novelsRoot = "Some Library";
+        written.nextSeq = 42;
+        written.segments = { { "seg_3", 3, 1000 }, { "seg_41_1", 41, 5ull << 32 } };
+        written.removedNovels = { { "Gone", 40 }, { "Novel \"quoted\" \xE5\xB0\x8F\xE8\xAF\xB4", 7 } };
+        Manifest read;
+        bool ok = WriteManifest(indexDir, written) && ReadManifest(indexDir, read);
+        check(ok && read.novelsRoot == written.novelsRoot && read.nextSeq == written.nextSeq &&
+            read.removedNovels == written.removedNovels && read.segments.size() == written.segments.size(),
+            "manifest round trip");
+        for (size_t i = 0; ok && i < read.segments.size() && i < written.segments.size(); i++) {
+            check(read.segments[i].name == written.segments[i].name && read.segments[i].seq == written.segments[i].seq &&
+                read.segments[i].bytes == written.segments[i].bytes, "manifest segment " + written.segments[i].name);
+        }
+        check(!std::filesystem::exists(indexDir / "manifest.json.tmp"), "manifest leaves no temporary file");
+
+        json stale = { {"version", INDEX_FORMAT_VERSION + 1}, {"segments", json::array()} };
+        std::ofstream(indexDir / "manifest.json", std::ios::trunc) << stale.dump();
+        check(!ReadManifest(indexDir, read), "manifest of another format version is refused");
+        std::filesystem::remove_all(indexDir);
+    }
+
+    // Segments: a small corpus with long paragraphs (multi-byte position deltas), blank lines and
+    // non-ASCII text, taken through build, deltas, removal, compaction and a sliced rebuild
+    ChapterContents chapters;
+    std::mt19937 rng(99);
+    const char* words[] = { "lantern", "river", "sect", "elder", "jade", "sword", "qi", "mountain", "Caf\xC3\xA9",
+        "\xE4\xBF\xAE\xE7\x82\xBC", "storm", "x7", "DAWN", "ember" };
+    auto writeChapter = [&](const std::string& novel, int number, const std::string& marker) {
+        std::string content = marker + " opens the chapter.\n\n";
+        int paragraphs = 2 + static_cast<int>(rng() % 4);
+        for (int p = 0; p < paragraphs; p++) {
+            int count = 20 + static_cast<int>(rng() % 200);
+            for (int w = 0; w < count; w++) {
+                if (w > 0) content += ' ';
+                content += words[rng() % (sizeof(words) / sizeof(words[0]))];
+            }
+            content += p % 2 ? ".\n" : ".\n\n \n";
+        }
+        std::filesystem::path chapterDir = novelsDir / novel / "chapters";
+        std::filesystem::create_directories(chapterDir);
+        json j;
+        j["chapterNumber"] = number;
+        j["title"] = "Chapter " + std::to_string(number);
+        j["content"] = content;
+        std::ofstream(chapterDir / ("chapter" + std::to_string(number) + ".json"), std::ios::binary | std::ios::trunc) << j.dump(2);
+        chapters[{ novel, number }] = content;
+    };
+    for (int number = 1; number <= 6; number++) writeChapter("Alpha", number, "alphaopening" + std::to_string(number));
+    for (int number = 1; number <= 4; number++) writeChapter("Beta \xE5\xB0\x8F\xE8\xAF\xB4", number, "betaopening");
+
+    std::string error;
+    auto checkIndex = [&](const char* stage) {
+        check(CheckIndexContents(indexDir, chapters, error), std::string(stage) + ": " + error);
+        SearchIndex index;
+        check(index.Open(indexDir.string()) && index.DocumentCount() == chapters.size(),
+            std::string(stage) + ": opened document count");
+    };
+    auto hitsFor = [&](const std::string& query, const std::string& filter = "") {
+        SearchIndex index;
+        index.Open(indexDir.string());
+        return index.Search(query, filter, 100);
+    };
+
+    check(Build(novelsDir.string(), indexDir.string()), "build");
+    checkIndex("build");
+    {
+        std::vector<Hit> hits = hitsFor("alphaopening3");
+        check(hits.size() == 1 && hits[0].novelName == "Alpha" && hits[0].chapterNumber == 3 && hits[0].paragraphIndex == 0,
+            "search finds a term in its chapter and paragraph");
+        check(hitsFor("\"opens the chapter\"").size() == chapters.size(), "phrase search matches every chapter");
+        check(hitsFor("betaopening", "Alpha").empty(), "novel filter excludes other novels");
+    }
+
+    // Deltas: rewritten chapters shadow their older copies, one new segment per call
+    for (int number = 1; number <= 3; number++) {
+        writeChapter("Alpha", number, "rewritten" + std::to_string(number));
+        check(AddChapters(novelsDir.string(), indexDir.string(), { { "Alpha", number } }), "add chapter " + std::to_string(number));
+    }
+    checkIndex("deltas");
+    check(hitsFor("alphaopening2").empty() && hitsFor("rewritten2").size() == 1, "a delta shadows the older copy");
+    check(FindStaleChapters(novelsDir.string(), indexDir.string()).empty(), "nothing stale after the deltas");
+
+    // Four small segments of one tier are merged into one, with the same live contents
+    {
+        Manifest before;
+        ReadManifest(indexDir, before);
+        check(Compact(indexDir.string()), "compaction merges");
+        CollectGarbage(indexDir.string());
+        Manifest after;
+        ReadManifest(indexDir, after);
+        check(before.segments.size() == 4 && after.segments.size() == 1, "compaction leaves one segment");
+        checkIndex("compaction");
+    }
+
+    // Removal is a tombstone until the segments that mention the novel are rewritten
+    check(RemoveNovel(indexDir.string(), "Beta \xE5\xB0\x8F\xE8\xAF\xB4"), "remove novel");
+    for (auto it = chapters.begin(); it != chapters.end();) {
+        it = it->first.first == "Alpha" ? std::next(it) : chapters.erase(it);
+    }
+    checkIndex("removal");
+    check(hitsFor("betaopening").empty(), "a removed novel is not found");
+
+    // Sliced rebuild: the novel's files are still on disk, so it comes back
+    for (int number = 1; number <= 4; number++) writeChapter("Beta \xE5\xB0\x8F\xE8\xAF\xB4", number, "betaopening");
+    uint64_t firstSeq = 0;
+    std::vector<ChapterRef> all = ListChapters(novelsDir.string());
+    check(all.size() == chapters.size(), "chapter listing");
+    check(BeginRebuild(novelsDir.string(), indexDir.string(), firstSeq), "begin rebuild");
+    for (size_t begin = 0; begin < all.size(); begin += 3) {
+        std::vector<ChapterRef> slice(all.begin() + begin, all.begin() + std::min(all.size(), begin + 3));
+        check(AddChapters(novelsDir.string(), indexDir.string(), slice), "rebuild slice");
+    }
+    check(FinishRebuild(indexDir.string(), firstSeq), "finish rebuild");
+    CollectGarbage(indexDir.string());
+    checkIndex("rebuild");
+    {
+        Manifest manifest;
+        ReadManifest(indexDir, manifest);
+        bool allNew = manifest.removedNovels.empty();
+        for (const ManifestSegment& segment : manifest.segments) allNew = allNew && segment.seq >= firstSeq;
+        check(allNew, "rebuild drops older segments and tombstones");
+    }
+    check(hitsFor("betaopening").size() == 4, "a rebuilt novel is found again");
+
+    std::filesystem::remove_all(root);
+    std::cout << (failures == 0 ? "Search index tests passed" : "Search index tests FAILED (" +
+        std::to_string(failures) + ")") << std::endl;
+    return failures == 0;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+void SearchIndex::RunBenchmark(const std::string& workDir, uint64_t targetBytes) {
+    std::filesystem::path root(workDir);
+    std::filesystem::path novelsDir = root / "Novels";
+    std::filesystem::path indexDir = root / "index";
+    std::filesystem::path marker = root / "corpus.json";
+
+    constexpr int VOCABULARY_SIZE = 50000;
+    constexpr int CHAPTERS_PER_NOVEL = 500;
+    constexpr size_t CHAPTER_BYTES = 20000;
+
+    // Zipf-distributed pseudo-words approximate natural-language term frequencies
+    std::mt19937 rng(1234);
+    std::vector<std::string> vocabulary;
+    const char* syllables[] = { "ka", "ri", "to", "shen", "mo", "ra", "lin", "vel", "dor", "an",
+        "sa", "ul", "thi", "gor", "ne", "qi", "xu", "ya", "zen", "bo" };
+    for (int i = 0; i < VOCABULARY_SIZE; i++) {
+        std::string word;
+        int v = i;
+        do {
+            word += syllables[v % 20];
+            v /= 20;
+        } while (v > 0);
+        vocabulary.push_back(word);
+    }
+    std::vector<double> weights(VOCABULARY_SIZE);
+    for (int i = 0; i < VOCABULARY_SIZE; i++) weights[i] = 1.0 / (i + 1);
+    std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+
+    uint64_t existingBytes = 0;
+    try {
+        std::ifstream markerFile(marker);
+        if (markerFile.is_open()) existingBytes = json::parse(markerFile).value("bytes", 0ull);
+    }
+    catch (...) {}
+
+    std::vector<std::string> phraseSamples;
+    if (existingBytes < targetBytes) {
+        std::cout << "Generating synthetic corpus (" << targetBytes / (1024 * 1024) << " MB) in " << novelsDir << std::endl;
+        std::filesystem::remove_all(novelsDir);
+
+        uint64_t written = 0;
+        for (int novel = 0; written < targetBytes; novel++) {
+            std::filesystem::path chapterDir = novelsDir / ("Bench Novel " + std::to_string(novel)) / "chapters";
+            std::filesystem::create_directories(chapterDir);
+
+            for (int chapter = 1; chapter <= CHAPTERS_PER_NOVEL && written < targetBytes; chapter++) {
+                std::string content;
+                while (content.size() < CHAPTER_BYTES) {
+                    int words = 40 + static_cast<int>(rng() % 80);
+                    for (int w = 0; w < words; w++) {
+                        if (w > 0) content += ' ';
+                        content += vocabulary[zipf(rng)];
+                    }
+                    content += ".\n\n";
+                }
+
+                json j;
+                j["chapterNumber"] = chapter;
+                j["title"] = "Chapter " + std::to_string(chapter);
+                j["content"] = content;
+                std::string text = j.dump(2);
+
+                std::ofstream file(chapterDir / ("chapter" + std::to_string(chapter) + ".json"), std::ios::binary);
+                file << text;
+                written += text.size();
+            }
+        }
+
+        std::ofstream markerFile(marker);
+        markerFile << json{ {"bytes", written} }.dump();
+    }
+
+    // Phrase samples: three consecutive words from a real chapter, so they are guaranteed to hit
+    for (const ChapterFile& file : CollectChapterFiles(novelsDir.string())) {
+        std::string bytes;
+        if (!ChapterStore::ReadChapterJson(file.path.string(), bytes)) continue;
+        std::vector<std::string> terms;
+        Tokenize(json::parse(bytes).value("content", ""), terms);
+        for (size_t i = 0; i + 3 < terms.size() && phraseSamples.size() < 50; i += 97) {
+            phraseSamples.push_back("\"" + terms[i] + " " + terms[i + 1] + " " + terms[i + 2] + "\"");
+        }
+        if (phraseSamples.size() >= 50) break;
+    }
+
+    BuildStats stats;
+    if (!Build(novelsDir.string(), indexDir.string(), nullptr, nullptr, &stats)) {
+        std::cout << "Benchmark index build failed" << std::endl;
+        return;
+    }
+    std::cout << "Indexing: " << stats.documents << " chapters, " << stats.tokens << " tokens, "
+        << stats.inputBytes / (1024.0 * 1024.0) << " MB in " << stats.seconds << " s ("
+        << stats.inputBytes / (1024.0 * 1024.0) / stats.seconds << " MB/s, "
+        << stats.documents / stats.seconds << " chapters/s)" << std::endl;
+
+    SearchIndex index;
+    if (!index.Open(indexDir.string())) return;
+
+    auto runQueries = [&index](const char* label, const std::vector<std::string>& queries) {
+        std::vector<double> latencies;
+        size_t totalHits = 0;
+        for (const std::string& query : queries) {
+            auto begin = std::chrono::steady_clock::now();
+            totalHits += index.Search(query, "", 20).size();
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+        }
+        if (latencies.empty()) return;
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << label << ": " << queries.size() << " queries, p50 " << latencies[latencies.size() / 2]
+            << " ms, p95 " << latencies[latencies.size() * 95 / 100] << " ms, max " << latencies.back()
+            << " ms, " << totalHits << " hits" << std::endl;
+    };
+
+    std::vector<std::string> common, rare, pairs;
+    for (int i = 0; i < 50; i++) {
+        common.push_back(vocabulary[i]);
+        rare.push_back(vocabulary[VOCABULARY_SIZE / 2 + i * 37]);
+        pairs.push_back(vocabulary[i * 3] + " " + vocabulary[200 + i * 11]);
+    }
+
+    runQueries("Common term", common);
+    runQueries("Rare term", rare);
+    runQueries("Two terms (AND)", pairs);
+    runQueries("Phrase", phraseSamples);
+}
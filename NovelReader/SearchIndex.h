@@ -0,0 +1,119 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+struct IndexSegment;
+
+// Full-text index over downloaded chapters.
+//
+// On disk an index is a directory holding a manifest.json and one or more segments.
+// Each segment is three files:
+//   terms.bin    - sorted term dictionary, fixed-size entries + string blob (memory-mapped)
+//   postings.bin - per term: for each doc (docDelta, tf, byteLength, positionDeltas...) as varints
+//   docs.bin     - novel names and per-doc chapter number, mtime, length and paragraph start positions
+//
+// Downloads add small delta segments; the manifest orders segments by sequence number and the
+// newest copy of a chapter shadows older ones. Compact() merges adjacent segments of similar size
+// in the background. The static writers may run in several threads and processes at once (the app,
+// novelreader-cli, the download daemon): segments are built under a staging name and published,
+// and garbage collected, under an exclusive lock on index.lock.
+class SearchIndex {
+public:
+    struct Hit {
+        std::string novelName;
+        int chapterNumber = 0;
+        int paragraphIndex = 0;   // Index of the non-empty line in the chapter content
+        float score = 0.0f;
+        std::string snippet;
+    };
+
+    struct BuildStats {
+        size_t documents = 0;
+        uint64_t tokens = 0;
+        uint64_t inputBytes = 0;
+        double seconds = 0.0;
+    };
+
+    struct ChapterRef {
+        std::string novelName;   // Directory name under novelsRoot
+        int chapterNumber = 0;
+    };
+
+    SearchIndex();
+    ~SearchIndex();
+
+    SearchIndex(const SearchIndex&) = delete;
+    SearchIndex& operator=(const SearchIndex&) = delete;
+
+    // Indexes every Novels/<name>/chapters/chapterN.json under novelsRoot into indexDir.
+    // Safe to run on a worker thread; progress is 0..1, cancel aborts without touching indexDir.
+    static bool Build(const std::string& novelsRoot, const std::string& indexDir,
+        std::atomic<float>* progress = nullptr, const std::atomic<bool>* cancel = nullptr,
+        BuildStats* stats = nullptr);
+
+    // Rebuilding in slices instead (the indexing pipeline): after BeginRebuild every chapter is added
+    // again with AddChapters, the new copies shadowing the old ones as they land, and FinishRebuild
+    // then drops every segment and tombstone from before the rebuild. firstSeq ties the two together.
+    static bool BeginRebuild(const std::string& novelsRoot, const std::string& indexDir, uint64_t& firstSeq);
+    static bool FinishRebuild(const std::string& indexDir, uint64_t firstSeq);
+    static std::vector<ChapterRef> ListChapters(const std::string& novelsRoot);
+
+    // Appends the given chapters as a new delta segment, replacing any older copies
+    static bool AddChapters(const std::string& novelsRoot, const std::string& indexDir,
+        const std::vector<ChapterRef>& chapters, BuildStats* stats = nullptr);
+    static bool RemoveNovel(const std::string& indexDir, const std::string& novelName);
+
+    // Size-tiered merge of delta segments, at most maxMerges of them; returns true if the manifest changed
+    static bool Compact(const std::string& indexDir, const std::atomic<bool>* cancel = nullptr,
+        size_t maxMerges = SIZE_MAX);
+
+    // Deletes segment directories the manifest no longer references, and abandoned staging directories
+    static void CollectGarbage(const std::string& indexDir);
+
+    // Chapters on disk that are missing from the index or changed since they were indexed
+    static std::vector<ChapterRef> FindStaleChapters(const std::string& novelsRoot, const std::string& indexDir,
+        std::vector<std::string>* vanishedNovels = nullptr);
+
+    // Opens or refreshes the index; segments that are already open are kept, listed ones that no
+    // longer exist or fail to open are skipped
+    bool Open(const std::string& indexDir);
+    void Close();
+
+    // Open in two steps, so the thread that searches never waits on the disk. PrepareRefresh maps
+    // the new segments and works out which docs are shadowed; it may run on another thread while
+    // this index serves searches, but not alongside Open, ApplyRefresh or Close. Null if the index
+    // can't be read. ApplyRefresh then swaps the result in.
+    struct Refresh;
+    std::shared_ptr<Refresh> PrepareRefresh(const std::string& indexDir) const;
+    void ApplyRefresh(Refresh& refresh);
+    bool IsOpen() const { return !segments.empty(); }
+    size_t DocumentCount() const { return totalDocuments; }
+
+    // Ranked (BM25) conjunctive search. Quoted parts of the query are phrases.
+    // An empty novelFilter searches the whole library.
+    std::vector<Hit> Search(const std::string& query, const std::string& novelFilter = "",
+        size_t maxResults = 50) const;
+
+    // Splits text into case-folded terms. When paragraphStarts is given it receives,
+    // for every non-empty line, the index of the first term on that line.
+    static void Tokenize(std::string_view text, std::vector<std::string>& terms,
+        std::vector<uint32_t>* paragraphStarts = nullptr);
+
+    // Generates a synthetic corpus of roughly targetBytes under workDir, indexes it
+    // and reports indexing throughput and query latency to stdout
+    static void RunBenchmark(const std::string& workDir, uint64_t targetBytes);
+
+    // Round trips of the on-disk format (varints, manifest, segments through build, deltas,
+    // removal, compaction and rebuild) on a small corpus in workDir; prints failures
+    static bool RunTests(const std::string& workDir);
+
+private:
+    std::vector<std::unique_ptr<IndexSegment>> segments;
+    std::string novelsRoot = "Novels";
+    uint64_t totalDocuments = 0;
+    uint64_t totalTokens = 0;
+};
@@ -0,0 +1,1243 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct TaskScheduler::Task {
+    std::function<void()> fn;
+    Priority priority = Priority::Background;
+    CancellationToken token;
+    TaskScheduler* scheduler = nullptr;
+    bool jobRun = false;                                // A Job pass, which waiters leave alone
+    std::weak_ptr<Task> after;                          // The task a Then() continuation waits for
+
+    std::atomic<bool> scheduled{ false };               // Queued for a worker, not on a timer or behind another task
+    std::atomic<bool> claimed{ false };                 // Set by whoever runs or skips it
+    std::atomic<bool> done{ false };                    // Waited on with atomic wait/notify
+    std::atomic<bool> skipped{ false };
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Task>> continuations;   // Guarded by mutex, until done
+};
+
+struct TaskScheduler::TaskGroup::State {
+    // A task counts itself in before it checks closed, and Close() closes before it reads the
+    // count, so either the task sees closed or Close() waits for it
+    std::atomic<size_t> running{ 0 };
+    std::atomic<bool> closed{ false };
+};
+
+namespace {
+    constexpr int SPIN_ROUNDS = 64;   // Yields before an idle worker goes to sleep
+
+    // Which scheduler and worker the current thread belongs to, if any
+    thread_local TaskScheduler* currentScheduler = nullptr;
+    thread_local size_t currentWorker = 0;
+    thread_local size_t currentLane = TaskScheduler::PRIORITIES - 1;   // Of the task this worker is running
+    thread_local uint32_t stealSeed = 0;
+
+    uint32_t NextVictim(uint32_t& seed) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    std::mutex sharedMutex;
+    std::unique_ptr<TaskScheduler> sharedScheduler;   // Guarded by sharedMutex
+    TaskScheduler::Options sharedOptions;             // Guarded by sharedMutex
+}
+
+// ==================================================================================
+// CancellationToken / TaskHandle
+// ==================================================================================
+
+TaskScheduler::CancellationToken TaskScheduler::CancellationToken::Create() {
+    CancellationToken token;
+    token.cancelled = std::make_shared<std::atomic<bool>>(false);
+    return token;
+}
+
+void TaskScheduler::CancellationToken::Cancel() const {
+    if (cancelled) cancelled->store(true);
+}
+
+bool TaskScheduler::CancellationToken::IsCancelled() const {
+    return cancelled && cancelled->load(std::memory_order_relaxed);
+}
+
+bool TaskScheduler::TaskHandle::IsDone() const {
+    return !task || task->done.load(std::memory_order_acquire);
+}
+
+bool TaskScheduler::TaskHandle::WasSkipped() const {
+    return task && task->done.load(std::memory_order_acquire) && task->skipped.load();
+}
+
+void TaskScheduler::TaskHandle::Wait() const {
+    if (!task) return;
+    TaskScheduler* scheduler = task->scheduler;
+
+    // Cancelled and not started: it would only be skipped whenever a worker got to it
+    if (task->token.IsCancelled()) scheduler->Skip(task);
+
+    if (currentScheduler == scheduler) {
+        // Blocking here would take a worker away from the task we are waiting for, which may be
+        // sitting in this worker's own deque, so once it (or, for a continuation, what it runs
+        // after) is queued and nobody has taken it we run it ourselves. Otherwise we only help
+        // with tasks at least as urgent as our own and never with Job passes: anything else may
+        // run far longer than what we wait for, take a lock we hold, or run interactive work
+        // inside our background scope. Once it runs elsewhere we block.
+        size_t lane = currentLane;
+        int idleRounds = 0;
+        while (!task->done.load(std::memory_order_acquire)) {
+            if (task->claimed.load()) {
+                task->done.wait(false, std::memory_order_acquire);
+                break;
+            }
+            std::shared_ptr<Task> next = task;
+            while (next && !next->scheduled.load(std::memory_order_acquire)) {
+                next = next->after.lock();
+            }
+
+            if (next && !next->claimed.load()) {
+                scheduler->Execute(next);   // Left in its queue, where it is dropped as claimed
+                idleRounds = 0;
+            }
+            else if (QueuedTask other; scheduler->FindTask(currentWorker, other, lane + 1, false)) {
+                scheduler->Execute(other);
+                idleRounds = 0;
+            }
+            else if (++idleRounds < SPIN_ROUNDS) {
+                std::this_thread::yield();
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        return;
+    }
+
+    task->done.wait(false, std::memory_order_acquire);
+}
+
+TaskScheduler::TaskHandle TaskScheduler::TaskHandle::Then(std::function<void()> fn, Priority priority,
+    CancellationToken token) const {
+    if (!task) return {};
+
+    auto next = std::make_shared<Task>();
+    next->fn = std::move(fn);
+    next->priority = priority;
+    next->token = std::move(token);
+    next->scheduler = task->scheduler;
+    next->after = task;
+
+    bool skipped;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        if (!task->done.load()) {
+            task->continuations.push_back(next);
+            return TaskHandle(next);
+        }
+        skipped = task->skipped.load();
+    }
+    if (skipped) task->scheduler->Skip(next);
+    else task->scheduler->Schedule(next);
+    return TaskHandle(next);
+}
+
+TaskScheduler::TaskGroup::TaskGroup() : state(std::make_shared<State>()) {
+}
+
+TaskScheduler::TaskGroup::~TaskGroup() {
+    Close();
+}
+
+void TaskScheduler::TaskGroup::Close() {
+    state->closed.store(true);
+    size_t running;
+    while ((running = state->running.load()) != 0) {
+        state->running.wait(running);
+    }
+}
+
+// ==================================================================================
+// Scheduler
+// ==================================================================================
+
+TaskScheduler::TaskScheduler() : TaskScheduler(Options{}) {
+}
+
+TaskScheduler::TaskScheduler(Options options) {
+    size_t count = options.workers;
+    if (count == 0) count = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+    for (size_t index = 0; index < count; index++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t index = 0; index < count; index++) {
+        workers[index]->thread = std::make_unique<std::thread>(&TaskScheduler::WorkerLoop, this, index);
+        if (options.pinWorkers) PinWorker(index);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    std::unique_ptr<std::thread> timer;
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        timersStopping = true;
+        timer = std::move(timerThread);
+    }
+    timerWake.notify_all();
+    if (timer && timer->joinable()) timer->join();
+
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        stopping = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_all();
+    }
+    for (auto& worker : workers) {
+        if (worker->thread && worker->thread->joinable()) worker->thread->join();
+    }
+
+    // Nothing runs any more; wake whoever waits on what was left. Posted tasks are just dropped.
+    std::vector<std::shared_ptr<Task>> left;
+    auto collect = [&left](std::deque<QueuedTask>& lane) {
+        for (QueuedTask& entry : lane) {
+            if (entry.task) left.push_back(std::move(entry.task));
+        }
+        lane.clear();
+    };
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        for (auto& [due, task] : timers) {
+            left.push_back(std::move(task));
+        }
+        timers.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        for (auto& lane : injected) collect(lane);
+    }
+    for (auto& worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        for (auto& lane : worker->lanes) collect(lane);
+    }
+    for (const auto& task : left) {
+        Skip(task);
+    }
+}
+
+TaskScheduler::TaskHandle TaskScheduler::Submit(std::function<void()> fn, Priority priority, CancellationToken token) {
+    auto task = std::make_shared<Task>();
+    task->fn = std::move(fn);
+    task->priority = priority;
+    task->token = std::move(token);
+    task->scheduler = this;
+    Schedule(task);
+    return TaskHandle(task);
+}
+
+void TaskScheduler::Post(TaskGroup& group, std::function<void()> fn, Priority priority) {
+    QueuedTask entry;
+    entry.fn = std::move(fn);
+    entry.group = group.state;
+    entry.priority = priority;
+    Enqueue(std::move(entry));
+}
+
+TaskScheduler::TaskHandle TaskScheduler::SubmitJobRun(std::function<void()> fn, Priority priority, CancellationToken token) {
+    auto task = std::make_shared<Task>();
+    task->fn = std::move(fn);
+    task->priority = priority;
+    task->token = std::move(token);
+    task->scheduler = this;
+    task->jobRun = true;
+    Schedule(task);
+    return TaskHandle(task);
+}
+
+TaskScheduler::TaskHandle TaskScheduler::SubmitAfter(std::chrono::steady_clock::duration delay, std::function<void()> fn,
+    Priority priority, CancellationToken token) {
+    auto task = std::make_shared<Task>();
+    task->fn = std::move(fn);
+    task->priority = priority;
+    task->token = std::move(token);
+    task->scheduler = this;
+    if (delay <= std::chrono::steady_clock::duration::zero()) {
+        Schedule(task);
+        return TaskHandle(task);
+    }
+
+    auto due = std::chrono::steady_clock::now() + delay;
+    std::unique_lock<std::mutex> lock(timerMutex);
+    if (timersStopping) {
+        lock.unlock();
+        Skip(task);
+        return TaskHandle(task);
+    }
+    if (!timerThread) {
+        timerThread = std::make_unique<std::thread>(&TaskScheduler::TimerLoop, this);
+    }
+    bool earliest = timers.empty() || due < timers.begin()->first;
+    timers.emplace(due, task);
+    lock.unlock();
+    if (earliest) timerWake.notify_one();
+    return TaskHandle(task);
+}
+
+void TaskScheduler::ParallelFor(size_t count, size_t maxSlots, const std::function<void(size_t slot, size_t index)>& body,
+    Priority priority) {
+    if (count == 0) return;
+
+    // A worker calling this is one of the runners already
+    size_t available = workers.size() + (currentScheduler == this ? 0 : 1);
+    size_t slots = std::max<size_t>(std::min({ maxSlots, count, available }), 1);
+
+    std::atomic<size_t> next{ 0 };
+    auto runSlot = [&](size_t slot) {
+        size_t index;
+        while ((index = next.fetch_add(1)) < count) body(slot, index);
+    };
+
+    // Helpers that never got a worker have nothing left to do once the caller runs dry; the
+    // ones still running reference this frame, so closing the group waits for them either way
+    TaskGroup helpers;
+    for (size_t slot = 1; slot < slots; slot++) {
+        Post(helpers, [&runSlot, slot] { runSlot(slot); }, priority);
+    }
+    try {
+        runSlot(0);
+    }
+    catch (...) {
+        next = count;
+        throw;
+    }
+}
+
+void TaskScheduler::Schedule(std::shared_ptr<Task> task) {
+    task->scheduled.store(true, std::memory_order_release);
+    QueuedTask entry;
+    entry.priority = task->priority;
+    entry.task = std::move(task);
+    Enqueue(std::move(entry));
+}
+
+void TaskScheduler::Enqueue(QueuedTask entry) {
+    size_t lane = static_cast<size_t>(entry.priority);
+
+    if (currentScheduler == this) {
+        Worker& worker = *workers[currentWorker];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.lanes[lane].push_back(std::move(entry));
+        worker.queued[lane].fetch_add(1);
+    }
+    else {
+        std::unique_lock<std::mutex> lock(injectMutex);
+        if (stopping) {
+            lock.unlock();
+            if (entry.task) Skip(entry.task);
+            return;
+        }
+        injected[lane].push_back(std::move(entry));
+        injectedCount[lane].fetch_add(1);
+    }
+
+    // Pairs with the sleeper raising `sleepers` before it checks `pending`: one of the two
+    // always sees the other, so a task never waits for a worker that is going to sleep
+    pending.fetch_add(1);
+    if (sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+bool TaskScheduler::FindTask(size_t index, QueuedTask& found, size_t lanes, bool jobRuns) {
+    if (pending.load() == 0) return false;
+
+    // A queue whose next task is a Job pass counts as empty when jobRuns is false
+    auto takeable = [jobRuns](const std::deque<QueuedTask>& queue, bool newest) {
+        if (queue.empty()) return false;
+        const QueuedTask& next = newest ? queue.back() : queue.front();
+        return jobRuns || !next.task || !next.task->jobRun;
+    };
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        // Own deque, newest first: its data is most likely still in this core's cache
+        if (index < workers.size()) {
+            Worker& own = *workers[index];
+            if (own.queued[lane].load() > 0) {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (takeable(own.lanes[lane], true)) {
+                    found = std::move(own.lanes[lane].back());
+                    own.lanes[lane].pop_back();
+                    own.queued[lane].fetch_sub(1);
+                    pending.fetch_sub(1);
+                    return true;
+                }
+            }
+        }
+
+        if (injectedCount[lane].load() > 0) {
+            std::lock_guard<std::mutex> lock(injectMutex);
+            if (takeable(injected[lane], false)) {
+                found = std::move(injected[lane].front());
+                injected[lane].pop_front();
+                injectedCount[lane].fetch_sub(1);
+                pending.fetch_sub(1);
+                return true;
+            }
+        }
+
+        // Steal the oldest task of another worker, starting from a random one so thieves spread out
+        size_t count = workers.size();
+        size_t start = NextVictim(stealSeed) % count;
+        for (size_t offset = 0; offset < count; offset++) {
+            size_t victimIndex = (start + offset) % count;
+            if (victimIndex == index) continue;
+            Worker& victim = *workers[victimIndex];
+            if (victim.queued[lane].load() == 0) continue;
+
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (takeable(victim.lanes[lane], false)) {
+                found = std::move(victim.lanes[lane].front());
+                victim.lanes[lane].pop_front();
+                victim.queued[lane].fetch_sub(1);
+                pending.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+namespace {
+    void RunTaskFunction(const std::function<void()>& fn, TaskScheduler::Priority priority) {
+        // Tasks run nested when a worker waits, so restore the outer task's lane afterwards
+        size_t outerLane = currentLane;
+        currentLane = static_cast<size_t>(priority);
+        try {
+            fn();
+        }
+        catch (const std::exception& e) {
+            std::cout << "Background task failed: " << e.what() << std::endl;
+        }
+        catch (...) {
+            std::cout << "Background task failed" << std::endl;
+        }
+        currentLane = outerLane;
+    }
+}
+
+void TaskScheduler::Execute(QueuedTask& entry) {
+    if (entry.task) {
+        Execute(entry.task);
+        return;
+    }
+
+    TaskGroup::State& group = *entry.group;
+    group.running.fetch_add(1);
+    if (!group.closed.load()) {
+        RunTaskFunction(entry.fn, entry.priority);
+    }
+    entry.fn = nullptr;
+    // entry still holds the group, so notifying after Close() returns is safe
+    if (group.running.fetch_sub(1) == 1) group.running.notify_all();
+}
+
+void TaskScheduler::Execute(const std::shared_ptr<Task>& task) {
+    if (task->claimed.exchange(true)) return;   // Skipped by a waiter while it sat in a queue
+    if (task->token.IsCancelled()) {
+        Finish(task, false);
+        return;
+    }
+
+    RunTaskFunction(task->fn, task->priority);
+    task->fn = nullptr;   // Drop captures now, not when the last handle goes
+    Finish(task, true);
+}
+
+void TaskScheduler::Finish(const std::shared_ptr<Task>& task, bool ran) {
+    std::vector<std::shared_ptr<Task>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->skipped = !ran;
+        task->done.store(true, std::memory_order_release);
+        continuations.swap(task->continuations);
+    }
+    task->done.notify_all();
+
+    for (auto& next : continuations) {
+        if (ran) Schedule(std::move(next));
+        else Skip(next);
+    }
+}
+
+void TaskScheduler::Skip(const std::shared_ptr<Task>& task) {
+    if (!task->claimed.exchange(true)) Finish(task, false);
+}
+
+void TaskScheduler::WorkerLoop(size_t index) {
+    currentScheduler = this;
+    currentWorker = index;
+    stealSeed = static_cast<uint32_t>(index) * 2654435761u + 1;
+    const int spinRounds = std::thread::hardware_concurrency() > 1 ? SPIN_ROUNDS : 0;
+
+    while (!stopping.load()) {
+        if (QueuedTask entry; FindTask(index, entry)) {
+            Execute(entry);
+            continue;
+        }
+
+        // Short bursts of tasks arrive back to back, so spin a little before sleeping; with a
+        // single core that only takes time from whoever would submit them
+        bool found = false;
+        for (int round = 0; round < spinRounds && !found; round++) {
+            std::this_thread::yield();
+            found = pending.load() > 0 || stopping.load();
+        }
+        if (found) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1);
+        wake.wait(lock, [&] { return pending.load() > 0 || stopping.load(); });
+        sleepers.fetch_sub(1);
+    }
+
+    currentScheduler = nullptr;
+}
+
+void TaskScheduler::TimerLoop() {
+    std::unique_lock<std::mutex> lock(timerMutex);
+    while (!timersStopping) {
+        if (timers.empty()) {
+            timerWake.wait(lock, [&] { return timersStopping || !timers.empty(); });
+            continue;
+        }
+
+        auto due = timers.begin()->first;
+        if (std::chrono::steady_clock::now() < due) {
+            timerWake.wait_until(lock, due);
+            continue;
+        }
+        std::shared_ptr<Task> task = std::move(timers.begin()->second);
+        timers.erase(timers.begin());
+        lock.unlock();
+        Schedule(std::move(task));
+        lock.lock();
+    }
+}
+
+void TaskScheduler::PinWorker(size_t index) {
+    unsigned cores = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    size_t core = index % cores;
+#ifdef _WIN32
+    if (core < 64) {
+        SetThreadAffinityMask(workers[index]->thread->native_handle(), DWORD_PTR(1) << core);
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    if (pthread_setaffinity_np(workers[index]->thread->native_handle(), sizeof(set), &set) != 0) {
+        std::cout << "Could not pin scheduler worker " << index << " to core " << core << std::endl;
+    }
+#else
+    (void)core;
+#endif
+}
+
+TaskScheduler& TaskScheduler::Shared() {
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (!sharedScheduler) {
+        sharedScheduler = std::make_unique<TaskScheduler>(sharedOptions);
+    }
+    return *sharedScheduler;
+}
+
+bool TaskScheduler::Configure(const Options& options) {
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (sharedScheduler) {
+        std::cout << "Task scheduler already running, new worker settings apply after a restart" << std::endl;
+        return false;
+    }
+    sharedOptions = options;
+    return true;
+}
+
+// ==================================================================================
+// Job
+// ==================================================================================
+
+struct TaskScheduler::Job::State {
+    std::function<void()> run;
+    Priority priority = Priority::Background;
+
+    std::mutex mutex;
+    bool accepting = false;   // Everything below is guarded by mutex
+    bool queued = false;
+    bool running = false;
+    bool again = false;       // Requested while running
+    std::chrono::steady_clock::time_point timerAt = std::chrono::steady_clock::time_point::max();
+    CancellationToken token;  // Replaced on every Start
+    TaskHandle latest;
+};
+
+TaskScheduler::Job::Job(std::function<void()> run, Priority priority) : state(std::make_shared<State>()) {
+    state->run = std::move(run);
+    state->priority = priority;
+}
+
+TaskScheduler::Job::~Job() {
+    Stop();
+}
+
+void TaskScheduler::Job::Start() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->accepting) return;
+    state->accepting = true;
+    state->queued = false;
+    state->again = false;
+    state->token = CancellationToken::Create();
+}
+
+void TaskScheduler::Job::Stop() {
+    TaskHandle latest;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->accepting = false;
+        state->again = false;
+        state->timerAt = std::chrono::steady_clock::time_point::max();
+        state->token.Cancel();
+        latest = state->latest;
+    }
+    // Returns at once if it hasn't started; a run never requests another once stopped
+    latest.Wait();
+}
+
+void TaskScheduler::Job::Request() {
+    RequestState(state);
+}
+
+void TaskScheduler::Job::RequestAt(std::chrono::steady_clock::time_point when) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (!state->accepting || when >= state->timerAt) return;   // A sooner request covers it
+    state->timerAt = when;
+
+    // The timer must not keep a stopped or destroyed Job's state around, nor run it
+    std::weak_ptr<State> weak = state;
+    Shared().SubmitAfter(when - std::chrono::steady_clock::now(), [weak, when] {
+        std::shared_ptr<State> locked = weak.lock();
+        if (!locked) return;
+        {
+            std::lock_guard<std::mutex> lock(locked->mutex);
+            if (locked->timerAt == when) locked->timerAt = std::chrono::steady_clock::time_point::max();
+        }
+        RequestState(locked);
+    }, state->priority, state->token);
+}
+
+void TaskScheduler::Job::RequestState(const std::shared_ptr<State>& state) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (!state->accepting || state->queued) return;
+    if (state->running) {
+        state->again = true;
+        return;
+    }
+    SubmitRun(state);
+}
+
+void TaskScheduler::Job::SubmitRun(const std::shared_ptr<State>& state) {
+    state->queued = true;
+    state->latest = Shared().SubmitJobRun([state] { Run(state); }, state->priority, state->token);
+}
+
+void TaskScheduler::Job::Run(const std::shared_ptr<State>& state) {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->queued = false;
+        if (!state->accepting) return;
+        state->running = true;
+    }
+
+    try {
+        state->run();
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->running = false;
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->running = false;
+    if (state->again && state->accepting) {
+        state->again = false;
+        SubmitRun(state);
+    }
+}
+
+// ==================================================================================
+// Benchmark
+// ==================================================================================
+
+namespace {
+    // The baseline: a fixed pool where every worker takes from one locked queue
+    class SharedQueuePool {
+    public:
+        explicit SharedQueuePool(size_t count) {
+            for (size_t index = 0; index < count; index++) {
+                threads.push_back(std::make_unique<std::thread>([this] { WorkerLoop(); }));
+            }
+        }
+
+        ~SharedQueuePool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            available.notify_all();
+            for (auto& thread : threads) {
+                thread->join();
+            }
+        }
+
+        void Submit(std::function<void()> fn) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(std::move(fn));
+            }
+            available.notify_one();
+        }
+
+    private:
+        void WorkerLoop() {
+            while (true) {
+                std::function<void()> fn;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    available.wait(lock, [&] { return stopping || !queue.empty(); });
+                    if (queue.empty()) return;
+                    fn = std::move(queue.front());
+                    queue.pop_front();
+                }
+                fn();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable available;
+        std::deque<std::function<void()>> queue;
+        bool stopping = false;
+        std::vector<std::unique_ptr<std::thread>> threads;
+    };
+
+    // Counts finished tasks and wakes the benchmark when all of them are in
+    class Latch {
+    public:
+        explicit Latch(size_t count) : remaining(count) {}
+
+        void CountDown() {
+            if (remaining.fetch_sub(1) == 1) {
+                // Notify under the lock: Wait() may return and destroy the latch right after
+                std::lock_guard<std::mutex> lock(mutex);
+                released = true;
+                zero.notify_all();
+            }
+        }
+
+        void Wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            zero.wait(lock, [&] { return released; });
+        }
+
+    private:
+        std::atomic<size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable zero;
+        bool released = false;   // Guarded by mutex
+    };
+
+    std::atomic<uint64_t> benchmarkSink{ 0 };
+    uint64_t workIterations = 0;   // Calibrated to about a microsecond
+
+    void DoWork(uint64_t iterations) {
+        uint64_t value = iterations;
+        for (uint64_t i = 0; i < iterations; i++) {
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        if (value == 42) benchmarkSink.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t CalibrateWork() {
+        const uint64_t probe = 1000000;
+        auto start = std::chrono::steady_clock::now();
+        DoWork(probe);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return std::max<uint64_t>(1, static_cast<uint64_t>(probe * 1e-6 / std::max(seconds, 1e-9)));
+    }
+
+    template <typename Body>
+    double NanosecondsPerTask(size_t tasks, Body&& body) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / static_cast<double>(tasks);
+    }
+
+    // Each task of the fan-out workload spawns FAN_OUT children until `tasks` have been spawned
+    constexpr size_t FAN_OUT = 4;
+
+    template <typename SubmitFn>
+    void SpawnTree(std::atomic<size_t>& spawned, size_t tasks, uint64_t iterations, Latch& latch, SubmitFn& submit) {
+        for (size_t child = 0; child < FAN_OUT; child++) {
+            if (spawned.fetch_add(1) >= tasks) break;
+            submit([&spawned, tasks, iterations, &latch, &submit] {
+                DoWork(iterations);
+                SpawnTree(spawned, tasks, iterations, latch, submit);
+                latch.CountDown();
+            });
+        }
+    }
+}
+
+void TaskScheduler::RunBenchmark(int tasks) {
+    size_t taskCount = static_cast<size_t>(std::max(tasks, 1));
+    size_t threadTasks = std::min<size_t>(taskCount, 20000);   // Thread per task gets slow quickly
+    size_t workerCount = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    workIterations = CalibrateWork();
+
+    std::cout << taskCount << " tasks on " << workerCount << " workers (" << threadTasks
+        << " for thread per task), ns per task" << std::endl;
+
+    TaskScheduler scheduler;
+    SharedQueuePool pool(workerCount);
+
+    for (uint64_t iterations : { uint64_t(0), workIterations }) {
+        std::cout << (iterations == 0 ? "Empty tasks" : "~1 us tasks") << std::endl;
+
+        // std::thread per task, at most workerCount * 4 alive at a time
+        double naive = NanosecondsPerTask(threadTasks, [&] {
+            std::vector<std::thread> batch;
+            for (size_t task = 0; task < threadTasks; task++) {
+                batch.emplace_back([iterations] { DoWork(iterations); });
+                if (batch.size() == workerCount * 4) {
+                    for (auto& thread : batch) thread.join();
+                    batch.clear();
+                }
+            }
+            for (auto& thread : batch) thread.join();
+        });
+        std::cout << "  thread per task:            " << naive << std::endl;
+
+        // Everything submitted from this thread
+        double sharedExternal = NanosecondsPerTask(taskCount, [&] {
+            Latch latch(taskCount);
+            for (size_t task = 0; task < taskCount; task++) {
+                pool.Submit([&latch, iterations] { DoWork(iterations); latch.CountDown(); });
+            }
+            latch.Wait();
+        });
+        double stealingExternal = NanosecondsPerTask(taskCount, [&] {
+            Latch latch(taskCount);
+            for (size_t task = 0; task < taskCount; task++) {
+                scheduler.Submit([&latch, iterations] { DoWork(iterations); latch.CountDown(); });
+            }
+            latch.Wait();
+        });
+        double postedExternal = NanosecondsPerTask(taskCount, [&] {
+            Latch latch(taskCount);
+            TaskGroup group;
+            for (size_t task = 0; task < taskCount; task++) {
+                scheduler.Post(group, [&latch, iterations] { DoWork(iterations); latch.CountDown(); });
+            }
+            latch.Wait();
+        });
+        std::cout << "  submitted from outside:     shared queue " << sharedExternal
+            << ", work stealing " << stealingExternal << ", posted " << postedExternal << std::endl;
+
+        // Tasks spawning tasks, the shape of parse -> index -> prefetch chains
+        double sharedFanOut = NanosecondsPerTask(taskCount, [&] {
+            Latch latch(taskCount);
+            std::atomic<size_t> spawned{ 0 };
+            auto submit = [&](std::function<void()> fn) { pool.Submit(std::move(fn)); };
+            SpawnTree(spawned, taskCount, iterations, latch, submit);
+            latch.Wait();
+        });
+        double stealingFanOut = NanosecondsPerTask(taskCount, [&] {
+            Latch latch(taskCount);
+            std::atomic<size_t> spawned{ 0 };
+            auto submit = [&](std::function<void()> fn) { scheduler.Submit(std::move(fn)); };
+            SpawnTree(spawned, taskCount, iterations, latch, submit);
+            latch.Wait();
+        });
+        double postedFanOut = NanosecondsPerTask(taskCount, [&] {
+            Latch latch(taskCount);
+            std::atomic<size_t> spawned{ 0 };
+            TaskGroup group;
+            auto submit = [&](std::function<void()> fn) { scheduler.Post(group, std::move(fn)); };
+            SpawnTree(spawned, taskCount, iterations, latch, submit);
+            latch.Wait();
+        });
+        std::cout << "  spawned from tasks:         shared queue " << sharedFanOut
+            << ", work stealing " << stealingFanOut << ", posted " << postedFanOut << std::endl;
+    }
+
+    // Priority lanes: time until an interactive task runs behind a full background backlog
+    {
+        CancellationToken backlog = CancellationToken::Create();
+        std::vector<TaskHandle> handles;
+        for (size_t task = 0; task < taskCount; task++) {
+            handles.push_back(scheduler.Submit([] { DoWork(workIterations); }, Priority::Background, backlog));
+        }
+        auto start = std::chrono::steady_clock::now();
+        scheduler.Submit([] {}, Priority::Interactive).Wait();
+        double latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        backlog.Cancel();
+        size_t skipped = 0;
+        for (const auto& handle : handles) {
+            handle.Wait();
+            if (handle.WasSkipped()) skipped++;
+        }
+        std::cout << "Interactive task behind " << taskCount << " background tasks: " << latency
+            << " us, " << skipped << " background tasks cancelled" << std::endl;
+    }
+}
+
+// ==================================================================================
+// Self-test
+// ==================================================================================
+
+namespace {
+    // Holds every worker of a scheduler in a task until opened, so what is queued behind is
+    // known not to have started
+    class WorkerGate {
+    public:
+        explicit WorkerGate(TaskScheduler& scheduler) {
+            for (size_t worker = 0; worker < scheduler.WorkerCount(); worker++) {
+                handles.push_back(scheduler.Submit([this] {
+                    holding++;
+                    while (!opened.load()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }, TaskScheduler::Priority::Interactive));
+            }
+            while (holding.load() < scheduler.WorkerCount()) std::this_thread::yield();
+        }
+        ~WorkerGate() { Open(); }
+
+        void Open() {
+            opened = true;
+            for (const auto& handle : handles) handle.Wait();
+        }
+
+    private:
+        std::atomic<bool> opened{ false };
+        std::atomic<size_t> holding{ 0 };
+        std::vector<TaskScheduler::TaskHandle> handles;
+    };
+
+    // Ends the process when a stage stops making progress, since a deadlocked scheduler would
+    // otherwise hang the test forever
+    class Watchdog {
+    public:
+        Watchdog() : thread([this] { Watch(); }) {}
+        ~Watchdog() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished = true;
+            }
+            changed.notify_all();
+            thread.join();
+        }
+
+        void Stage(std::string name) {
+            std::lock_guard<std::mutex> lock(mutex);
+            stage = std::move(name);
+            generation++;
+            changed.notify_all();
+        }
+
+    private:
+        void Watch() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!finished) {
+                uint64_t seen = generation;
+                if (!changed.wait_for(lock, std::chrono::seconds(60), [&] { return finished || generation != seen; })) {
+                    std::cout << "FAILED: " << stage << " made no progress in 60 s" << std::endl;
+                    std::_Exit(1);
+                }
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::string stage = "start";
+        uint64_t generation = 0;
+        bool finished = false;
+        std::thread thread;
+    };
+}
+
+bool TaskScheduler::RunTests(int rounds) {
+    using Clock = std::chrono::steady_clock;
+    int failures = 0;
+    auto check = [&failures](bool condition, const std::string& what) {
+        if (!condition) {
+            std::cout << "FAILED: " << what << std::endl;
+            failures++;
+        }
+    };
+    const Priority lanes[] = { Priority::Interactive, Priority::Prefetch, Priority::Background };
+    Watchdog watchdog;
+
+    std::vector<size_t> workerCounts = { 1, 2, 4 };
+    if (std::thread::hardware_concurrency() > 4) workerCounts.push_back(std::thread::hardware_concurrency());
+
+    for (size_t workerCount : workerCounts) {
+        Options options;
+        options.workers = workerCount;
+        TaskScheduler scheduler(options);
+        const std::string on = " on " + std::to_string(workerCount) + " workers";
+
+        // Nested waits: every task waits on children in all lanes and on a continuation, from
+        // roots submitted outside and in every lane
+        watchdog.Stage("nested waits" + on);
+        for (int round = 0; round < rounds; round++) {
+            std::atomic<int> ran{ 0 };
+            std::function<void(int)> spawn = [&](int depth) {
+                ran++;
+                if (depth == 0) return;
+                std::vector<TaskHandle> children;
+                for (Priority lane : lanes) children.push_back(scheduler.Submit([&spawn, depth] { spawn(depth - 1); }, lane));
+                TaskHandle after = children[depth % 3].Then([&ran] { ran++; }, lanes[(depth + 1) % 3]);
+                for (size_t i = children.size(); i-- > 0;) children[i].Wait();
+                after.Wait();
+            };
+            std::vector<TaskHandle> roots;
+            for (Priority lane : lanes) roots.push_back(scheduler.Submit([&spawn] { spawn(4); }, lane));
+            for (const auto& root : roots) root.Wait();
+            // Per root: 1 + 3 + 9 + 27 + 81 tasks, plus one continuation for each of the 40 that spawn
+            check(ran.load() == 3 * (121 + 40), "nested waits ran " + std::to_string(ran.load()) + " tasks" + on);
+        }
+
+        // Then: a chain runs in order across lanes, waited on from a task or from outside
+        watchdog.Stage("continuations" + on);
+        for (int round = 0; round < rounds * 10; round++) {
+            std::atomic<int> step{ 0 };
+            bool inOrder = true;
+            auto expect = [&step, &inOrder](int value) {
+                return [&step, &inOrder, value] { inOrder = inOrder && step.exchange(value + 1) == value; };
+            };
+            TaskHandle first = scheduler.Submit(expect(0), lanes[round % 3]);
+            TaskHandle last = first;
+            for (int link = 1; link < 5; link++) last = last.Then(expect(link), lanes[(round + link) % 3]);
+            if (round % 2) scheduler.Submit([&last] { last.Wait(); }, Priority::Interactive).Wait();
+            else last.Wait();
+            check(inOrder && step.load() == 5 && !last.WasSkipped(), "continuations run in order" + on);
+
+            TaskHandle late = first.Then(expect(5));
+            late.Wait();
+            check(step.load() == 6, "a continuation of a finished task runs" + on);
+        }
+
+        // Cancellation, with every worker busy so nothing cancelled can have started
+        watchdog.Stage("cancellation" + on);
+        for (int round = 0; round < rounds; round++) {
+            std::atomic<int> ran{ 0 };
+            CancellationToken token = CancellationToken::Create();
+            CancellationToken continuationToken = CancellationToken::Create();
+            std::vector<TaskHandle> cancelled;
+            TaskHandle keeper, keeperContinuation;
+            {
+                WorkerGate gate(scheduler);
+                for (int i = 0; i < 200; i++) {
+                    TaskHandle handle = scheduler.Submit([&ran] { ran++; }, lanes[i % 3], token);
+                    cancelled.push_back(handle);
+                    cancelled.push_back(handle.Then([&ran] { ran++; }));
+                }
+                cancelled.push_back(scheduler.SubmitAfter(std::chrono::hours(1), [&ran] { ran++; }, Priority::Background, token));
+                keeper = scheduler.Submit([&ran] { ran += 1000; });
+                keeperContinuation = keeper.Then([&ran] { ran++; }, Priority::Background, continuationToken);
+                token.Cancel();
+                continuationToken.Cancel();
+
+                // Waiting on a cancelled task returns at once, while the workers are still held
+                size_t skipped = 0;
+                for (const auto& handle : cancelled) {
+                    handle.Wait();
+                    if (handle.WasSkipped()) skipped++;
+                }
+                check(skipped == cancelled.size(), "cancelled tasks and their continuations are skipped" + on);
+            }
+            keeper.Wait();
+            keeperContinuation.Wait();
+            check(ran.load() == 1000 && !keeper.WasSkipped() && keeperContinuation.WasSkipped(),
+                "only what was not cancelled runs" + on);
+
+            // A running task sees the cancellation and stops itself
+            CancellationToken stop = CancellationToken::Create();
+            std::atomic<bool> started{ false };
+            TaskHandle polling = scheduler.Submit([&stop, &started] {
+                started = true;
+                while (!stop.IsCancelled()) std::this_thread::yield();
+            }, Priority::Background, stop);
+            while (!started.load()) std::this_thread::yield();
+            stop.Cancel();
+            polling.Wait();
+            check(!polling.WasSkipped(), "a started task is not skipped" + on);
+        }
+
+        // Posted tasks: all of them run, and closing the group drops those not started
+        watchdog.Stage("posted tasks" + on);
+        for (int round = 0; round < rounds; round++) {
+            std::atomic<int> ran{ 0 };
+            {
+                TaskGroup group;
+                std::function<void(int)> fanOut = [&](int depth) {
+                    ran++;
+                    for (int i = 0; depth > 0 && i < 4; i++) {
+                        scheduler.Post(group, [&fanOut, depth] { fanOut(depth - 1); }, lanes[i % 3]);
+                    }
+                };
+                scheduler.Post(group, [&fanOut] { fanOut(4); });
+                while (ran.load() < 341) std::this_thread::yield();   // 1 + 4 + 16 + 64 + 256
+            }
+            check(ran.load() == 341, "posted fan-out ran " + std::to_string(ran.load()) + " tasks" + on);
+
+            ran = 0;
+            {
+                TaskGroup group;
+                WorkerGate gate(scheduler);
+                for (int i = 0; i < 100; i++) scheduler.Post(group, [&ran] { ran++; }, lanes[i % 3]);
+                group.Close();
+                scheduler.Post(group, [&ran] { ran++; });
+            }
+            check(ran.load() == 0, "a closed group's tasks don't run" + on);
+        }
+
+        // ParallelFor: every index exactly once, nested and from a task
+        watchdog.Stage("parallel for" + on);
+        for (int round = 0; round < rounds; round++) {
+            std::vector<std::atomic<int>> visits(1000);
+            std::atomic<bool> slotsInRange{ true };
+            scheduler.Submit([&] {
+                scheduler.ParallelFor(100, 4, [&](size_t outerSlot, size_t outer) {
+                    if (outerSlot >= 4) slotsInRange = false;
+                    scheduler.ParallelFor(10, 3, [&](size_t innerSlot, size_t inner) {
+                        if (innerSlot >= 3) slotsInRange = false;
+                        visits[outer * 10 + inner]++;
+                    }, lanes[outer % 3]);
+                });
+            }, lanes[round % 3]).Wait();
+            bool once = std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& count) { return count.load() == 1; });
+            check(once && slotsInRange.load(), "parallel for visits every index once" + on);
+        }
+
+        // SubmitAfter: nothing runs early, and the due times order the runs
+        watchdog.Stage("timers" + on);
+        {
+            std::mutex mutex;
+            std::vector<int> order;
+            bool early = false;
+            std::vector<TaskHandle> timed;
+            auto start = Clock::now();
+            for (int i = 4; i >= 1; i--) {
+                auto delay = std::chrono::milliseconds(i * 15);
+                timed.push_back(scheduler.SubmitAfter(delay, [&, i, delay] {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    early = early || Clock::now() - start < delay;
+                    order.push_back(i);
+                }));
+            }
+            for (const auto& handle : timed) handle.Wait();
+            check(!early && order == std::vector<int>({ 1, 2, 3, 4 }), "timed tasks run when due, in order" + on);
+        }
+
+        // Shutting down skips what has not started
+        watchdog.Stage("shutdown" + on);
+        {
+            std::atomic<int> ran{ 0 };
+            std::vector<TaskHandle> left;
+            {
+                TaskScheduler doomed(options);
+                std::atomic<size_t> holding{ 0 };
+                for (size_t worker = 0; worker < workerCount; worker++) {
+                    doomed.Submit([&holding] {
+                        holding++;
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    }, Priority::Interactive);
+                }
+                while (holding.load() < workerCount) std::this_thread::yield();
+                for (int i = 0; i < 100; i++) left.push_back(doomed.Submit([&ran] { ran++; }, lanes[i % 3]));
+                left.push_back(doomed.SubmitAfter(std::chrono::hours(1), [&ran] { ran++; }));
+                left.push_back(left.front().Then([&ran] { ran++; }));
+            }
+            size_t finished = 0, skipped = 0;
+            for (const auto& handle : left) {
+                finished += handle.IsDone();
+                skipped += handle.WasSkipped();
+            }
+            check(finished == left.size() && skipped + ran.load() == left.size(), "shutdown finishes every handle" + on);
+        }
+    }
+
+    // Job, on the shared scheduler: requests from several threads never overlap passes, a request
+    // made during a pass gets one more, and nothing runs once stopped
+    watchdog.Stage("job");
+    {
+        std::atomic<int> running{ 0 }, passes{ 0 }, requests{ 0 }, lastSeen{ 0 };
+        std::atomic<bool> overlapped{ false };
+        Job job([&] {
+            if (running.fetch_add(1) != 0) overlapped = true;
+            lastSeen = requests.load();
+            passes++;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            running--;
+        });
+        job.Request();
+        check(passes.load() == 0, "a stopped job ignores requests");
+        job.Start();
+
+        std::vector<std::thread> requesters;
+        for (int thread = 0; thread < 4; thread++) {
+            requesters.emplace_back([&] {
+                for (int i = 0; i < rounds * 25; i++) {
+                    requests++;
+                    job.Request();
+                    if (i % 16 == 0) std::this_thread::sleep_for(std::chrono::microseconds(300));
+                }
+            });
+        }
+        for (auto& thread : requesters) thread.join();
+
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (lastSeen.load() < requests.load() && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        check(lastSeen.load() == requests.load(), "a pass follows the last request");
+        check(!overlapped.load(), "job passes never overlap");
+
+        job.RequestAt(Clock::now() + std::chrono::hours(1));
+        job.Stop();
+        int stoppedAt = passes.load();
+        job.Request();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        check(passes.load() == stoppedAt && running.load() == 0, "a stopped job does not run");
+    }
+
+    watchdog.Stage("done");
+    std::cout << (failures == 0 ? "Scheduler tests passed" : "Scheduler tests FAILED (" +
+        std::to_string(failures) + ")") << std::endl;
+    return failures == 0;
+}
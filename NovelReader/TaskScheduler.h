@@ -0,0 +1,216 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Work-stealing thread pool shared by the CPU-bound background work (conversion, parsing,
+// indexing, tiering, grep, thumbnails, prefetch). Every worker owns a deque per priority lane:
+// tasks submitted from a worker go on its own deque and run newest first, idle workers steal
+// the oldest task from another worker, and tasks submitted from other threads wait in a
+// shared injection queue. Workers always take the most urgent lane that has work anywhere.
+//
+// Timed work waits on one timer thread (SubmitAfter, Job::RequestAt), not on a worker.
+// Work that waits on the outside world (downloads, sockets, child processes) keeps its own
+// threads; a task that blocks for long holds a worker the rest of the app is counting on.
+// Short file reads and writes are fine.
+class TaskScheduler {
+public:
+    enum class Priority {
+        Interactive,   // The reader is waiting on it
+        Prefetch,      // Likely needed soon
+        Background     // Bulk work
+    };
+    static constexpr size_t PRIORITIES = 3;
+
+    struct Options {
+        size_t workers = 0;        // 0 = one per hardware thread
+        bool pinWorkers = false;   // Pin worker N to core N
+    };
+
+    // Shared cancel flag. Tasks cancelled before they start are skipped with their
+    // continuations, and waiting on one returns at once; a running task polls IsCancelled()
+    // itself if it wants to stop early.
+    class CancellationToken {
+    public:
+        CancellationToken() = default;   // Never cancelled
+        static CancellationToken Create();
+
+        void Cancel() const;
+        bool IsCancelled() const;
+
+    private:
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    struct Task;
+
+    class TaskHandle {
+    public:
+        TaskHandle() = default;
+
+        bool IsValid() const { return task != nullptr; }
+        bool IsDone() const;
+        bool WasSkipped() const;   // Done without running: cancelled, or the scheduler shut down
+
+        // Blocks until the task is done. On a worker thread it runs the task itself if no one has
+        // taken it yet, and meanwhile helps with tasks at least as urgent as the waiting one
+        void Wait() const;
+
+        // Runs fn after this task has run; skipped if this task was skipped
+        TaskHandle Then(std::function<void()> fn, Priority priority = Priority::Background,
+            CancellationToken token = {}) const;
+
+    private:
+        friend class TaskScheduler;
+        explicit TaskHandle(std::shared_ptr<Task> task) : task(std::move(task)) {}
+
+        std::shared_ptr<Task> task;
+    };
+
+    // Owner of tasks posted without a handle (Post): far cheaper than Submit for fire-and-forget
+    // work, and the owner waits for all of them at once. Close() drops the ones that haven't
+    // started and waits for the ones running, so they may reference the owner.
+    class TaskGroup {
+    public:
+        TaskGroup();
+        ~TaskGroup();   // Close()
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void Close();   // Not from inside one of the group's tasks
+
+    private:
+        friend class TaskScheduler;
+        struct State;
+        std::shared_ptr<State> state;
+    };
+
+    TaskScheduler();
+    explicit TaskScheduler(Options options);
+    ~TaskScheduler();   // Skips whatever has not started and joins the workers
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Thread-safe, including from inside a task
+    TaskHandle Submit(std::function<void()> fn, Priority priority = Priority::Background,
+        CancellationToken token = {});
+
+    // Thread-safe, including from inside a task; dropped if group is closed before it starts
+    void Post(TaskGroup& group, std::function<void()> fn, Priority priority = Priority::Background);
+
+    // Submits fn once delay has passed. Until then it sits with the timer thread; a token
+    // cancelled meanwhile skips it when it comes due, or as soon as someone waits on it.
+    TaskHandle SubmitAfter(std::chrono::steady_clock::duration delay, std::function<void()> fn,
+        Priority priority = Priority::Background, CancellationToken token = {});
+
+    // Runs body(slot, index) for every index below count on the calling thread (slot 0) and
+    // up to maxSlots - 1 tasks (slots 1 and up), which claim indices as they go; slot lets a
+    // body keep per-runner state without locking. Returns once every index is done. Safe to
+    // call from a task; whatever the workers don't get to, the caller does itself.
+    void ParallelFor(size_t count, size_t maxSlots, const std::function<void(size_t slot, size_t index)>& body,
+        Priority priority = Priority::Background);
+
+    size_t WorkerCount() const { return workers.size(); }
+
+    // The app-wide scheduler, created on first use
+    static TaskScheduler& Shared();
+
+    // Options for Shared(); false once it has been created
+    static bool Configure(const Options& options);
+
+    // A pass that runs as tasks on the shared scheduler, never two at once, for housekeeping
+    // that would otherwise be a thread sleeping on a condition variable. Request() runs it
+    // soon, or once more after the run in progress. RequestAt() requests it at a given time,
+    // unless a sooner one is already pending; a pass re-arms its next deadline itself.
+    // The scheduler is looked up on the first request, so Configure() still applies.
+    class Job {
+    public:
+        explicit Job(std::function<void()> run, Priority priority = Priority::Background);
+        ~Job();   // Stop()
+
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+        // Thread-safe; ignored while stopped
+        void Request();
+        void RequestAt(std::chrono::steady_clock::time_point when);
+
+        void Start();   // A new Job is stopped
+        void Stop();    // Drops pending requests and waits for the run in progress
+
+    private:
+        struct State;
+        static void RequestState(const std::shared_ptr<State>& state);
+        static void SubmitRun(const std::shared_ptr<State>& state);   // Caller holds state->mutex
+        static void Run(const std::shared_ptr<State>& state);
+
+        std::shared_ptr<State> state;
+    };
+
+    // Headless benchmark: scheduling overhead per task, submitted and posted, against a thread
+    // per task and a pool with a single shared queue, for empty and ~1 us tasks
+    static void RunBenchmark(int tasks);
+
+    // Stress test on 1, 2, 4 and all hardware workers: nested waits across lanes, Then chains,
+    // cancellation, posted tasks and closed groups, ParallelFor, timers, shutdown, and a Job on
+    // the shared scheduler; rounds scales the repetitions. Prints failures.
+    static bool RunTests(int rounds);
+
+private:
+    // A queue entry: a submitted task, or a posted one that carries just its function and group
+    struct QueuedTask {
+        std::shared_ptr<Task> task;
+        std::function<void()> fn;
+        std::shared_ptr<TaskGroup::State> group;
+        Priority priority = Priority::Background;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<QueuedTask> lanes[PRIORITIES];              // Guarded by mutex
+        std::atomic<size_t> queued[PRIORITIES] = {};           // Per lane, read without the lock
+        std::unique_ptr<std::thread> thread;
+    };
+
+    void WorkerLoop(size_t index);
+    void TimerLoop();
+    // index = workers.size() for non-workers. Looks at the first `lanes` lanes only, and passes
+    // over Job runs unless jobRuns is set.
+    bool FindTask(size_t index, QueuedTask& found, size_t lanes = PRIORITIES, bool jobRuns = true);
+    TaskHandle SubmitJobRun(std::function<void()> fn, Priority priority, CancellationToken token);
+    void Schedule(std::shared_ptr<Task> task);
+    void Enqueue(QueuedTask entry);
+    void Execute(QueuedTask& entry);
+    void Execute(const std::shared_ptr<Task>& task);
+    void Finish(const std::shared_ptr<Task>& task, bool ran);
+    void Skip(const std::shared_ptr<Task>& task);   // Finishes it unrun, unless it was taken already
+    void PinWorker(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex injectMutex;
+    std::deque<QueuedTask> injected[PRIORITIES];              // Guarded by injectMutex
+    std::atomic<size_t> injectedCount[PRIORITIES] = {};
+
+    std::atomic<size_t> pending{ 0 };   // Queued anywhere, not yet taken
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> sleepers{ 0 };
+    std::atomic<bool> stopping{ false };
+
+    std::mutex timerMutex;
+    std::condition_variable timerWake;
+    std::multimap<std::chrono::steady_clock::time_point, std::shared_ptr<Task>> timers;   // Guarded by timerMutex
+    std::unique_ptr<std::thread> timerThread;   // Started by the first SubmitAfter; guarded by timerMutex
+    bool timersStopping = false;                // Guarded by timerMutex
+};
@@ -0,0 +1,241 @@
+#include "TextSearch.h"
+#include <algorithm>
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXT_SEARCH_SSE2 1
+#endif
+
+namespace {
+    inline unsigned char FoldAscii(unsigned char c) {
+        return (static_cast<unsigned char>(c - 'A') < 26) ? static_cast<unsigned char>(c | 0x20) : c;
+    }
+
+#ifdef TEXT_SEARCH_SSE2
+    // 'A'..'Z' -> 'a'..'z' for 16 bytes; bytes >= 0x80 compare negative and are left alone
+    inline __m128i FoldAscii16(__m128i v) {
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    }
+#endif
+
+    bool EqualsFolded(const unsigned char* text, const unsigned char* foldedNeedle, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            if (FoldAscii(text[i]) != foldedNeedle[i]) return false;
+        }
+        return true;
+    }
+
+    bool IsAscii(std::string_view text) {
+        return std::all_of(text.begin(), text.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+    }
+}
+
+// ============================================================================
+// UTF-8 and case folding
+// ============================================================================
+uint32_t TextSearch::DecodeUtf8(const unsigned char*& p, const unsigned char* end) {
+    unsigned char c = *p++;
+    if (c < 0x80) return c;
+
+    int extra = (c >= 0xF0) ? 3 : (c >= 0xE0) ? 2 : (c >= 0xC0) ? 1 : -1;
+    if (extra < 0 || end - p < extra) return 0xFFFD;
+
+    uint32_t cp = c & (0x3F >> extra);
+    for (int i = 0; i < extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    p += extra;
+    return cp;
+}
+
+void TextSearch::AppendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    }
+    else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+    else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Simple case folding for Latin, Greek, Cyrillic, Armenian and fullwidth forms
+uint32_t TextSearch::FoldCodepoint(uint32_t cp) {
+    if (cp < 0x80) return (cp >= 'A' && cp <= 'Z') ? cp + 0x20 : cp;
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20;
+    if (cp >= 0x100 && cp <= 0x137) return cp | 1;
+    if (cp >= 0x139 && cp <= 0x148) return (cp & 1) ? cp + 1 : cp;
+    if (cp >= 0x14A && cp <= 0x177) return cp | 1;
+    if (cp == 0x178) return 0xFF;
+    if (cp >= 0x179 && cp <= 0x17E) return (cp & 1) ? cp + 1 : cp;
+    if (cp == 0x386) return 0x3AC;
+    if (cp >= 0x388 && cp <= 0x38A) return cp + 0x25;
+    if (cp == 0x38C) return 0x3CC;
+    if (cp == 0x38E || cp == 0x38F) return cp + 0x3F;
+    if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) return cp + 0x20;
+    if (cp == 0x3C2) return 0x3C3;
+    if (cp >= 0x400 && cp <= 0x40F) return cp + 0x50;
+    if (cp >= 0x410 && cp <= 0x42F) return cp + 0x20;
+    if ((cp >= 0x460 && cp <= 0x481) || (cp >= 0x48A && cp <= 0x4BF)) return cp | 1;
+    if (cp >= 0x531 && cp <= 0x556) return cp + 0x30;
+    if ((cp >= 0x1E00 && cp <= 0x1E95) || (cp >= 0x1EA0 && cp <= 0x1EFF)) return cp | 1;
+    if (cp >= 0xFF10 && cp <= 0xFF19) return '0' + (cp - 0xFF10);
+    if (cp >= 0xFF21 && cp <= 0xFF3A) return 'a' + (cp - 0xFF21);
+    if (cp >= 0xFF41 && cp <= 0xFF5A) return 'a' + (cp - 0xFF41);
+    return cp;
+}
+
+std::string TextSearch::FoldUtf8(std::string_view input, std::vector<uint32_t>* sourceOffsets) {
+    // None of the folds above lengthen a character and everything else is copied,
+    // so the output never outgrows the input
+    std::string folded(input.size(), '\0');
+    if (sourceOffsets) sourceOffsets->resize(input.size() + 1);
+
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(input.data());
+    const unsigned char* end = begin + input.size();
+    const unsigned char* p = begin;
+    size_t length = 0;
+    std::string encoded;
+
+    while (p < end) {
+        const uint32_t start = static_cast<uint32_t>(p - begin);
+        if (*p < 0x80) {
+            if (sourceOffsets) (*sourceOffsets)[length] = start;
+            folded[length++] = static_cast<char>(FoldAscii(*p++));
+            continue;
+        }
+
+        // Unchanged (and malformed) characters are copied byte for byte
+        uint32_t cp = DecodeUtf8(p, end);
+        uint32_t foldedCp = FoldCodepoint(cp);
+        encoded.clear();
+        if (foldedCp == cp) encoded.assign(reinterpret_cast<const char*>(begin + start), p - (begin + start));
+        else AppendUtf8(encoded, foldedCp);
+
+        for (char c : encoded) {
+            if (sourceOffsets) (*sourceOffsets)[length] = start;
+            folded[length++] = c;
+        }
+    }
+
+    folded.resize(length);
+    if (sourceOffsets) {
+        sourceOffsets->resize(length + 1);
+        (*sourceOffsets)[length] = static_cast<uint32_t>(input.size());
+    }
+    return folded;
+}
+
+// ============================================================================
+// Search
+// ============================================================================
+void TextSearch::SetText(std::string newText) {
+    text = std::move(newText);
+    foldedText.clear();
+    foldedOffsets.clear();
+    foldedValid = false;
+}
+
+void TextSearch::EnsureFolded() const {
+    if (foldedValid) return;
+    foldedText = FoldUtf8(text, &foldedOffsets);
+    foldedValid = true;
+}
+
+size_t TextSearch::ScanAsciiFolded(std::string_view haystack, std::string_view foldedNeedle,
+    std::vector<size_t>* offsets, size_t maxMatches) {
+    const size_t n = foldedNeedle.size();
+    if (n == 0 || n > haystack.size() || maxMatches == 0) return 0;
+
+    const unsigned char* h = reinterpret_cast<const unsigned char*>(haystack.data());
+    const unsigned char* needle = reinterpret_cast<const unsigned char*>(foldedNeedle.data());
+    const size_t lastStart = haystack.size() - n;
+
+    size_t count = 0;
+    size_t nextAllowed = 0;  // matches don't overlap
+    size_t i = 0;
+
+    auto accept = [&](size_t position) {
+        if (position < nextAllowed) return false;
+        if (n > 2 && !EqualsFolded(h + position + 1, needle + 1, n - 2)) return false;
+        if (offsets) offsets->push_back(position);
+        nextAllowed = position + n;
+        return ++count >= maxMatches;
+    };
+
+#ifdef TEXT_SEARCH_SSE2
+    // Compare the needle's first and last byte against 16 candidate starts at once;
+    // only positions where both agree are verified byte by byte
+    const __m128i firstByte = _mm_set1_epi8(static_cast<char>(needle[0]));
+    const __m128i lastByte = _mm_set1_epi8(static_cast<char>(needle[n - 1]));
+    for (; i + 16 <= lastStart + 1; i += 16) {
+        __m128i blockFirst = FoldAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i)));
+        __m128i blockLast = FoldAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + n - 1)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blockFirst, firstByte), _mm_cmpeq_epi8(blockLast, lastByte))));
+
+        while (mask != 0) {
+            size_t position = i + std::countr_zero(mask);
+            mask &= mask - 1;
+            if (accept(position)) return count;
+        }
+    }
+#endif
+
+    for (; i <= lastStart; i++) {
+        if (FoldAscii(h[i]) == needle[0] && FoldAscii(h[i + n - 1]) == needle[n - 1] && accept(i)) {
+            return count;
+        }
+    }
+    return count;
+}
+
+size_t TextSearch::FindAll(std::string_view needle, std::vector<Match>& out, size_t maxMatches) const {
+    out.clear();
+    if (needle.empty()) return 0;
+
+    std::vector<size_t> offsets;
+
+    // ASCII bytes never occur inside a multi-byte UTF-8 sequence, so an ASCII needle
+    // can be matched against the raw buffer and every hit lands on a character boundary
+    if (IsAscii(needle)) {
+        std::string folded(needle);
+        for (char& c : folded) c = static_cast<char>(FoldAscii(static_cast<unsigned char>(c)));
+
+        ScanAsciiFolded(text, folded, &offsets, maxMatches);
+        out.reserve(offsets.size());
+        for (size_t offset : offsets) {
+            out.push_back({ offset, needle.size() });
+        }
+        return out.size();
+    }
+
+    EnsureFolded();
+    std::string folded = FoldUtf8(needle);
+    ScanAsciiFolded(foldedText, folded, &offsets, maxMatches);
+    out.reserve(offsets.size());
+    for (size_t offset : offsets) {
+        size_t begin = foldedOffsets[offset];
+        size_t end = foldedOffsets[offset + folded.size()];
+        out.push_back({ begin, end - begin });
+    }
+    return out.size();
+}
+
+size_t TextSearch::Count(std::string_view needle) const {
+    std::vector<Match> matches;
+    return FindAll(needle, matches);
+}
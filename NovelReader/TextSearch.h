@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Case-insensitive substring search over one UTF-8 buffer.
+// ASCII needles are matched directly against the buffer with a 16-byte SSE2 scan
+// (first/last byte filter, then verify). Needles with other characters are matched
+// against a case-folded copy of the buffer that is built on first use and cached.
+class TextSearch {
+public:
+    struct Match {
+        size_t offset = 0;   // Byte offset into Text()
+        size_t length = 0;   // Byte length in Text(); may differ from the needle after folding
+    };
+
+    void SetText(std::string newText);
+    const std::string& Text() const { return text; }
+
+    // Non-overlapping matches in buffer order; returns the number found
+    size_t FindAll(std::string_view needle, std::vector<Match>& out, size_t maxMatches = SIZE_MAX) const;
+    size_t Count(std::string_view needle) const;
+
+    // UTF-8 helpers shared with the full-text indexer
+    static uint32_t DecodeUtf8(const unsigned char*& p, const unsigned char* end);
+    static void AppendUtf8(std::string& out, uint32_t cp);
+    static uint32_t FoldCodepoint(uint32_t cp);
+    static std::string FoldUtf8(std::string_view input, std::vector<uint32_t>* sourceOffsets = nullptr);
+
+private:
+    static size_t ScanAsciiFolded(std::string_view haystack, std::string_view foldedNeedle,
+        std::vector<size_t>* offsets, size_t maxMatches);
+    void EnsureFolded() const;
+
+    std::string text;
+
+    // Unicode-folded copy of text; foldedOffsets maps each folded byte back to its source character
+    mutable std::string foldedText;
+    mutable std::vector<uint32_t> foldedOffsets;
+    mutable bool foldedValid = false;
+};
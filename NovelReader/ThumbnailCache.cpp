@@ -0,0 +1,182 @@
+#include "ThumbnailCache.h"
+#include "Dependecies/stb_image.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    constexpr char THUMB_MAGIC[4] = { 'N', 'R', 'T', 'H' };
+    constexpr int MAX_THUMB_SIDE = 1024;   // Sanity bound when reading a .thumb header
+}
+
+ThumbnailCache::ThumbnailCache(std::string directory) : directory(std::move(directory)) {
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    // Queued covers are skipped; the ones being decoded finish first
+    tasks.Close();
+}
+
+std::string ThumbnailCache::Key(const std::string& url) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    static const char digits[] = "0123456789abcdef";
+    std::string key(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        key[i] = digits[hash & 0xF];
+        hash >>= 4;
+    }
+    return key;
+}
+
+void ThumbnailCache::Request(const std::string& url) {
+    if (url.empty()) return;
+    std::string key = Key(url);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (finished.count(key)) return;
+    if (!queued.insert(key).second) {
+        // Its task may already have looked for the file; the script reports a cover once it is there
+        retry.insert(key);
+        return;
+    }
+    SubmitLocked(key);
+}
+
+void ThumbnailCache::SubmitLocked(const std::string& key) {
+    TaskScheduler::Shared().Post(tasks, [this, key] { Process(key); }, TaskScheduler::Priority::Prefetch);
+}
+
+void ThumbnailCache::TakeReady(std::vector<Thumbnail>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Thumbnail& thumbnail : ready) {
+        out.push_back(std::move(thumbnail));
+    }
+    ready.clear();
+}
+
+void ThumbnailCache::Process(const std::string& key) {
+    std::string base = (std::filesystem::path(directory) / key).string();
+    Thumbnail thumbnail;
+    thumbnail.key = key;
+
+    bool loaded = LoadThumbnail(base + ".thumb", thumbnail);
+    if (!loaded && std::filesystem::exists(base + ".img")) {
+        loaded = BuildThumbnail(base + ".img", base + ".thumb", thumbnail);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bool again = retry.erase(key) > 0;
+    if (loaded) {
+        finished.insert(key);
+        ready.push_back(std::move(thumbnail));
+    }
+    else if (again) {
+        SubmitLocked(key);
+        return;
+    }
+    // Not on disk yet and not finished: the cover_url line from the script can retry it
+    queued.erase(key);
+}
+
+bool ThumbnailCache::LoadThumbnail(const std::string& path, Thumbnail& thumbnail) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    int32_t width = 0, height = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    if (!file || std::memcmp(magic, THUMB_MAGIC, sizeof(magic)) != 0 ||
+        width <= 0 || height <= 0 || width > MAX_THUMB_SIDE || height > MAX_THUMB_SIDE) {
+        std::cout << "Ignoring invalid thumbnail: " << path << std::endl;
+        return false;
+    }
+
+    thumbnail.width = width;
+    thumbnail.height = height;
+    thumbnail.rgba.resize(static_cast<size_t>(width) * height * 4);
+    file.read(reinterpret_cast<char*>(thumbnail.rgba.data()), thumbnail.rgba.size());
+    return static_cast<bool>(file);
+}
+
+bool ThumbnailCache::BuildThumbnail(const std::string& imagePath, const std::string& thumbPath, Thumbnail& thumbnail) {
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load(imagePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        std::cout << "Failed to decode cover: " << imagePath << std::endl;
+        std::error_code ec;
+        std::filesystem::remove(imagePath, ec);
+        return false;
+    }
+
+    // Keep the aspect ratio; never upscale
+    float scale = std::min({ 1.0f,
+        static_cast<float>(THUMB_WIDTH) / width,
+        static_cast<float>(THUMB_HEIGHT) / height });
+    int thumbWidth = std::max(1, static_cast<int>(width * scale));
+    int thumbHeight = std::max(1, static_cast<int>(height * scale));
+
+    // Box filter: each output pixel averages the source pixels it covers
+    thumbnail.width = thumbWidth;
+    thumbnail.height = thumbHeight;
+    thumbnail.rgba.assign(static_cast<size_t>(thumbWidth) * thumbHeight * 4, 0);
+    for (int y = 0; y < thumbHeight; y++) {
+        int y0 = y * height / thumbHeight;
+        int y1 = std::max(y0 + 1, (y + 1) * height / thumbHeight);
+        for (int x = 0; x < thumbWidth; x++) {
+            int x0 = x * width / thumbWidth;
+            int x1 = std::max(x0 + 1, (x + 1) * width / thumbWidth);
+
+            uint32_t sum[4] = { 0, 0, 0, 0 };
+            for (int sy = y0; sy < y1; sy++) {
+                const stbi_uc* row = pixels + (static_cast<size_t>(sy) * width + x0) * 4;
+                for (int sx = x0; sx < x1; sx++, row += 4) {
+                    sum[0] += row[0];
+                    sum[1] += row[1];
+                    sum[2] += row[2];
+                    sum[3] += row[3];
+                }
+            }
+            uint32_t count = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+            unsigned char* out = thumbnail.rgba.data() + (static_cast<size_t>(y) * thumbWidth + x) * 4;
+            for (int c = 0; c < 4; c++) {
+                out[c] = static_cast<unsigned char>(sum[c] / count);
+            }
+        }
+    }
+    stbi_image_free(pixels);
+
+    // Write to a temp file first so a crash never leaves a truncated .thumb behind
+    std::string tempPath = thumbPath + ".tmp";
+    bool written;
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        int32_t header[2] = { thumbWidth, thumbHeight };
+        file.write(THUMB_MAGIC, sizeof(THUMB_MAGIC));
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(thumbnail.rgba.data()), thumbnail.rgba.size());
+        written = static_cast<bool>(file);
+    }
+
+    std::error_code ec;
+    if (written) {
+        std::filesystem::rename(tempPath, thumbPath, ec);
+    }
+    if (!written || ec) {
+        // The pixels are still good for this session; the original stays for next time
+        std::cout << "Failed to write thumbnail: " << thumbPath << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return true;
+    }
+    std::filesystem::remove(imagePath, ec);
+    return true;
+}
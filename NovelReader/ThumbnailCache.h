@@ -0,0 +1,59 @@
+#pragma once
+#include "TaskScheduler.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_set>
+
+// Turns downloaded search result covers into small thumbnails off the UI thread.
+//
+// download_manager.py drops each cover at <dir>/<Key(url)>.img. A prefetch task on the
+// shared TaskScheduler decodes it,
+// box-filters it down to at most THUMB_WIDTH x THUMB_HEIGHT, stores the pixels as
+// <Key(url)>.thumb and deletes the full-size image. Later searches that hit the same cover
+// load the .thumb directly, which is a plain read with no decoding.
+//
+// The UI thread uploads finished thumbnails to the GPU; see TakeReady().
+class ThumbnailCache {
+public:
+    struct Thumbnail {
+        std::string key;
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> rgba;
+    };
+
+    static constexpr int THUMB_WIDTH = 120;
+    static constexpr int THUMB_HEIGHT = 160;
+
+    explicit ThumbnailCache(std::string directory);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    // FNV-1a 64 of the URL in hex, matching cover_cache_key() in download_manager.py
+    static std::string Key(const std::string& url);
+
+    // Queues the cover for this URL. Each key is only processed once per session; a cover that
+    // isn't on disk yet can be requested again when the script reports it.
+    void Request(const std::string& url);
+
+    // Moves thumbnails finished since the last call onto the end of out
+    void TakeReady(std::vector<Thumbnail>& out);
+
+private:
+    void SubmitLocked(const std::string& key);   // Caller holds mutex
+    void Process(const std::string& key);
+    bool LoadThumbnail(const std::string& path, Thumbnail& thumbnail);
+    bool BuildThumbnail(const std::string& imagePath, const std::string& thumbPath, Thumbnail& thumbnail);
+
+    std::string directory;
+    TaskScheduler::TaskGroup tasks;               // Closed by the destructor
+
+    std::mutex mutex;
+    std::unordered_set<std::string> queued;       // Guarded by mutex; waiting or being processed
+    std::unordered_set<std::string> retry;        // Guarded by mutex; requested again meanwhile
+    std::unordered_set<std::string> finished;     // Guarded by mutex
+    std::vector<Thumbnail> ready;                 // Guarded by mutex
+};
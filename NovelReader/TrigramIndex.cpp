@@ -0,0 +1,188 @@
+#include "TrigramIndex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    bool IsWordByte(unsigned char c) {
+        // Bytes of multi-byte UTF-8 sequences count as word characters
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c >= 0x80;
+    }
+
+    uint32_t PackGram(unsigned char a, unsigned char b, unsigned char c) {
+        return (static_cast<uint32_t>(a) << 16) | (static_cast<uint32_t>(b) << 8) | c;
+    }
+}
+
+std::string TrigramIndex::FoldCase(std::string_view text) {
+    std::string folded(text);
+    for (char& c : folded) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return folded;
+}
+
+std::vector<std::string> TrigramIndex::SplitWords(std::string_view foldedText) {
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < foldedText.size()) {
+        while (i < foldedText.size() && !IsWordByte(static_cast<unsigned char>(foldedText[i]))) i++;
+        size_t start = i;
+        while (i < foldedText.size() && IsWordByte(static_cast<unsigned char>(foldedText[i]))) i++;
+        if (i > start) {
+            words.emplace_back(foldedText.substr(start, i - start));
+        }
+    }
+    return words;
+}
+
+void TrigramIndex::CollectGrams(std::string_view foldedText, std::vector<uint32_t>& grams) {
+    for (const std::string& word : SplitWords(foldedText)) {
+        unsigned char prev2 = ' ';
+        unsigned char prev1 = ' ';
+        for (char ch : word) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            grams.push_back(PackGram(prev2, prev1, c));
+            prev2 = prev1;
+            prev1 = c;
+        }
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+void TrigramIndex::Add(uint32_t id, std::string_view text) {
+    Remove(id);
+
+    std::vector<uint32_t> grams;
+    CollectGrams(FoldCase(text), grams);
+
+    for (uint32_t gram : grams) {
+        std::vector<uint32_t>& ids = postings[gram];
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+    }
+    documentGrams[id] = std::move(grams);
+    idLimit = std::max(idLimit, id + 1);
+}
+
+void TrigramIndex::Remove(uint32_t id) {
+    auto it = documentGrams.find(id);
+    if (it == documentGrams.end()) return;
+
+    for (uint32_t gram : it->second) {
+        auto postingIt = postings.find(gram);
+        if (postingIt == postings.end()) continue;
+
+        std::vector<uint32_t>& ids = postingIt->second;
+        auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+        if (pos != ids.end() && *pos == id) {
+            ids.erase(pos);
+        }
+        if (ids.empty()) {
+            postings.erase(postingIt);
+        }
+    }
+    documentGrams.erase(it);
+}
+
+void TrigramIndex::Clear() {
+    postings.clear();
+    documentGrams.clear();
+    idLimit = 0;
+}
+
+size_t TrigramIndex::QueryFuzzy(std::string_view query, bool allowTypos, std::vector<FuzzyHit>& out) const {
+    out.clear();
+
+    std::vector<uint32_t> grams;
+    CollectGrams(FoldCase(query), grams);
+    const size_t gramCount = grams.size();
+    if (gramCount == 0) return 0;
+
+    // Short queries must match exactly; longer ones may miss about three grams per typo,
+    // one typo per eight grams, but never more than half of them
+    size_t maxMissing = 0;
+    if (allowTypos && gramCount >= 4) {
+        maxMissing = std::min(gramCount / 2, 3 * ((gramCount + 7) / 8));
+    }
+    const size_t required = gramCount - maxMissing;
+
+    static const std::vector<uint32_t> emptyList;
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (uint32_t gram : grams) {
+        auto it = postings.find(gram);
+        lists.push_back(it != postings.end() ? &it->second : &emptyList);
+    }
+    std::sort(lists.begin(), lists.end(),
+        [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    if (maxMissing == 0) {
+        // Exact: plain intersection, rarest list first
+        std::vector<uint32_t> result = *lists[0];
+        std::vector<uint32_t> scratch;
+        for (size_t i = 1; i < lists.size() && !result.empty(); i++) {
+            scratch.clear();
+            std::set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+                std::back_inserter(scratch));
+            result.swap(scratch);
+        }
+        out.reserve(result.size());
+        for (uint32_t id : result) out.push_back({ id, static_cast<uint32_t>(gramCount) });
+        return gramCount;
+    }
+
+    // An id with at least `required` grams must appear in one of the maxMissing + 1 shortest
+    // lists. Count those densely, then check only the surviving candidates against the rest.
+    if (gramCounts.size() < idLimit) gramCounts.resize(idLimit, 0);
+    touchedIds.clear();
+
+    const size_t candidateLists = maxMissing + 1;
+    for (size_t i = 0; i < candidateLists; i++) {
+        for (uint32_t id : *lists[i]) {
+            if (gramCounts[id]++ == 0) touchedIds.push_back(id);
+        }
+    }
+    if (candidateLists > 1) {
+        std::sort(touchedIds.begin(), touchedIds.end());
+    }
+
+    for (size_t i = candidateLists; i < gramCount && !touchedIds.empty(); i++) {
+        const std::vector<uint32_t>& list = *lists[i];
+
+        // Few candidates against a long list: search ahead from the last hit; otherwise merge
+        auto cursor = list.begin();
+        bool search = touchedIds.size() * 16 < list.size();
+        for (uint32_t id : touchedIds) {
+            if (search) {
+                cursor = std::lower_bound(cursor, list.end(), id);
+            }
+            else {
+                while (cursor != list.end() && *cursor < id) ++cursor;
+            }
+            if (cursor == list.end()) break;
+            if (*cursor == id) gramCounts[id]++;
+        }
+
+        // Drop candidates that can no longer reach the threshold with the lists left
+        const size_t listsLeft = gramCount - i - 1;
+        size_t kept = 0;
+        for (uint32_t id : touchedIds) {
+            if (gramCounts[id] + listsLeft >= required) {
+                touchedIds[kept++] = id;
+            }
+            else {
+                gramCounts[id] = 0;
+            }
+        }
+        touchedIds.resize(kept);
+    }
+
+    for (uint32_t id : touchedIds) {
+        if (gramCounts[id] >= required) {
+            out.push_back({ id, gramCounts[id] });
+        }
+        gramCounts[id] = 0;
+    }
+    return gramCount;
+}
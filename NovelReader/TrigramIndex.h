@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Word-prefix trigram index over catalog text (titles, authors, synopses).
+// Each word is padded with two leading spaces before it is cut into trigrams,
+// so a query of any length maps onto a word-prefix lookup:
+// "sh" -> {"  s", " sh"}, "shad" -> {"  s", " sh", "sha", "had"}.
+//
+// QueryFuzzy tolerates typos: one wrong, missing or swapped character breaks at most three
+// of a word's trigrams, so ids that share most of the query's trigrams are near matches.
+class TrigramIndex {
+public:
+    struct FuzzyHit {
+        uint32_t id = 0;
+        uint32_t matchedGrams = 0;
+    };
+
+    // Adds (or replaces) the text indexed under id. Text is case-folded here.
+    void Add(uint32_t id, std::string_view text);
+    void Remove(uint32_t id);
+    void Clear();
+    size_t Size() const { return documentGrams.size(); }
+
+    // Ids sharing enough of the query's trigrams (all of them unless allowTypos), unsorted.
+    // Returns the number of distinct trigrams in the query.
+    size_t QueryFuzzy(std::string_view query, bool allowTypos, std::vector<FuzzyHit>& out) const;
+
+    static std::string FoldCase(std::string_view text);
+    static std::vector<std::string> SplitWords(std::string_view foldedText);
+
+private:
+    static void CollectGrams(std::string_view foldedText, std::vector<uint32_t>& grams);
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings;       // gram -> sorted ids
+    std::unordered_map<uint32_t, std::vector<uint32_t>> documentGrams;  // id -> its unique grams
+    uint32_t idLimit = 0;                                               // Above every id added
+
+    // QueryFuzzy scratch, indexed by id; all zero between queries
+    mutable std::vector<uint16_t> gramCounts;
+    mutable std::vector<uint32_t> touchedIds;
+};
@@ -0,0 +1,284 @@
+#include "ZipArchive.h"
+#include "Deflate.h"
+#include <algorithm>
+#include <array>
+#include <ctime>
+
+namespace {
+    constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+    constexpr uint32_t END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+    constexpr size_t LOCAL_HEADER_SIZE = 30;
+    constexpr size_t CENTRAL_HEADER_SIZE = 46;
+    constexpr size_t END_OF_DIRECTORY_SIZE = 22;
+    constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+    constexpr uint16_t VERSION_NEEDED = 20;           // 2.0: deflate
+    constexpr uint16_t UTF8_NAMES_FLAG = 0x0800;
+    constexpr uint64_t MAX_ZIP_SIZE = 0xFFFFFFFFull;
+    constexpr size_t MAX_ENTRIES = 0xFFFF;
+
+    uint16_t ReadU16(const char* p) {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return static_cast<uint16_t>(b[0] | (b[1] << 8));
+    }
+
+    uint32_t ReadU32(const char* p) {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+            (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+    }
+
+    void AppendU16(std::string& out, uint16_t value) {
+        out += static_cast<char>(value & 0xFF);
+        out += static_cast<char>(value >> 8);
+    }
+
+    void AppendU32(std::string& out, uint32_t value) {
+        AppendU16(out, static_cast<uint16_t>(value & 0xFFFF));
+        AppendU16(out, static_cast<uint16_t>(value >> 16));
+    }
+
+    std::array<uint32_t, 256> MakeCrcTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return table;
+    }
+
+    const std::array<uint32_t, 256> CRC_TABLE = MakeCrcTable();
+}
+
+uint32_t ZipReader::Crc32(std::string_view bytes, uint32_t crc) {
+    crc = ~crc;
+    for (unsigned char c : bytes) crc = CRC_TABLE[(crc ^ c) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+bool ZipReader::Open(const std::string& path, std::string* error) {
+    Close();
+    auto fail = [&](const char* message) {
+        if (error) *error = message;
+        Close();
+        return false;
+    };
+
+    if (!file.Open(path)) return fail("Could not open the file");
+    std::string_view data = file.View();
+    if (data.size() < END_OF_DIRECTORY_SIZE) return fail("Not a ZIP archive");
+
+    // The end record sits in the last 22 bytes plus at most a 64 KB comment
+    size_t searchFrom = data.size() - END_OF_DIRECTORY_SIZE;
+    size_t searchTo = data.size() > END_OF_DIRECTORY_SIZE + MAX_COMMENT_SIZE ?
+        data.size() - END_OF_DIRECTORY_SIZE - MAX_COMMENT_SIZE : 0;
+    size_t endRecord = std::string_view::npos;
+    for (size_t at = searchFrom + 1; at-- > searchTo;) {
+        if (ReadU32(data.data() + at) == END_OF_DIRECTORY_SIGNATURE) {
+            endRecord = at;
+            break;
+        }
+    }
+    if (endRecord == std::string_view::npos) return fail("Not a ZIP archive");
+
+    const char* end = data.data() + endRecord;
+    uint16_t entryCount = ReadU16(end + 10);
+    uint32_t directorySize = ReadU32(end + 12);
+    uint32_t directoryOffset = ReadU32(end + 16);
+    if (entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF) return fail("ZIP64 archives are not supported");
+    if (static_cast<uint64_t>(directoryOffset) + directorySize > endRecord) return fail("Damaged ZIP directory");
+
+    entries.reserve(entryCount);
+    size_t at = directoryOffset;
+    for (uint16_t i = 0; i < entryCount; i++) {
+        if (at + CENTRAL_HEADER_SIZE > endRecord || ReadU32(data.data() + at) != CENTRAL_HEADER_SIGNATURE) {
+            return fail("Damaged ZIP directory");
+        }
+        const char* header = data.data() + at;
+        uint16_t flags = ReadU16(header + 8);
+        uint16_t nameLength = ReadU16(header + 28);
+        uint16_t extraLength = ReadU16(header + 30);
+        uint16_t commentLength = ReadU16(header + 32);
+        size_t next = at + CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        if (next > endRecord) return fail("Damaged ZIP directory");
+
+        Entry entry;
+        entry.method = ReadU16(header + 10);
+        entry.crc = ReadU32(header + 16);
+        entry.compressedSize = ReadU32(header + 20);
+        entry.size = ReadU32(header + 24);
+        entry.localHeaderOffset = ReadU32(header + 42);
+        entry.name.assign(header + CENTRAL_HEADER_SIZE, nameLength);
+        if (flags & 1) entry.method = 0xFFFF;   // Encrypted; Read refuses it
+        entries.push_back(std::move(entry));
+        at = next;
+    }
+    return true;
+}
+
+void ZipReader::Close() {
+    entries.clear();
+    file.Close();
+}
+
+const ZipReader::Entry* ZipReader::Find(std::string_view name) const {
+    for (const Entry& entry : entries) {
+        if (entry.name == name) return &entry;
+    }
+    return nullptr;
+}
+
+bool ZipReader::Read(const Entry& entry, std::string& out) const {
+    out.clear();
+    std::string_view data = file.View();
+    if (entry.localHeaderOffset + LOCAL_HEADER_SIZE > data.size()) return false;
+    const char* header = data.data() + entry.localHeaderOffset;
+    if (ReadU32(header) != LOCAL_HEADER_SIGNATURE) return false;
+
+    // The local header repeats the name and may carry its own extra field
+    uint64_t start = entry.localHeaderOffset + LOCAL_HEADER_SIZE + ReadU16(header + 26) + ReadU16(header + 28);
+    if (start + entry.compressedSize > data.size()) return false;
+    std::string_view stored = data.substr(start, entry.compressedSize);
+
+    if (entry.method == 0) {
+        out.assign(stored);
+    }
+    else if (entry.method == 8) {
+        if (!Deflate::Inflate(stored, {}, out, entry.size)) return false;
+    }
+    else {
+        return false;
+    }
+    return out.size() == entry.size && Crc32(out) == entry.crc;
+}
+
+// ============================================================================
+// ZipWriter
+// ============================================================================
+ZipWriter::~ZipWriter() {
+    if (out.is_open()) out.close();
+}
+
+bool ZipWriter::Open(const std::string& path) {
+    records.clear();
+    offset = 0;
+    failed = false;
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    // Every entry gets the time the archive was written, in MS-DOS format
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    dosTime = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+    dosDate = static_cast<uint16_t>((std::max(local.tm_year - 80, 0) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+    return true;
+}
+
+ZipWriter::Prepared ZipWriter::Prepare(std::string_view bytes, int level) {
+    Prepared entry;
+    entry.crc = ZipReader::Crc32(bytes);
+    entry.size = bytes.size();
+    if (level > 0) {
+        Deflate::Compress(bytes, {}, entry.data, level);
+        if (entry.data.size() < bytes.size()) {
+            entry.method = 8;
+            return entry;
+        }
+    }
+    entry.method = 0;
+    entry.data.assign(bytes);
+    return entry;
+}
+
+void ZipWriter::Write(std::string_view bytes) {
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out.good()) failed = true;
+    offset += bytes.size();
+}
+
+bool ZipWriter::Add(std::string_view name, const Prepared& entry) {
+    if (failed || !out.is_open()) return false;
+    if (records.size() >= MAX_ENTRIES || name.size() > 0xFFFF || entry.size > MAX_ZIP_SIZE ||
+        offset + LOCAL_HEADER_SIZE + name.size() + entry.data.size() > MAX_ZIP_SIZE) {
+        failed = true;   // Would need ZIP64
+        return false;
+    }
+
+    Record record;
+    record.name.assign(name);
+    record.method = entry.method;
+    record.crc = entry.crc;
+    record.compressedSize = static_cast<uint32_t>(entry.data.size());
+    record.size = static_cast<uint32_t>(entry.size);
+    record.localHeaderOffset = static_cast<uint32_t>(offset);
+
+    std::string header;
+    header.reserve(LOCAL_HEADER_SIZE + name.size());
+    AppendU32(header, LOCAL_HEADER_SIGNATURE);
+    AppendU16(header, VERSION_NEEDED);
+    AppendU16(header, UTF8_NAMES_FLAG);
+    AppendU16(header, record.method);
+    AppendU16(header, dosTime);
+    AppendU16(header, dosDate);
+    AppendU32(header, record.crc);
+    AppendU32(header, record.compressedSize);
+    AppendU32(header, record.size);
+    AppendU16(header, static_cast<uint16_t>(name.size()));
+    AppendU16(header, 0);   // Extra field
+    header += name;
+    Write(header);
+    Write(entry.data);
+
+    records.push_back(std::move(record));
+    return !failed;
+}
+
+bool ZipWriter::Finish() {
+    if (!out.is_open()) return false;
+
+    uint64_t directoryOffset = offset;
+    std::string directory;
+    for (const Record& record : records) {
+        AppendU32(directory, CENTRAL_HEADER_SIGNATURE);
+        AppendU16(directory, VERSION_NEEDED);   // Made by
+        AppendU16(directory, VERSION_NEEDED);
+        AppendU16(directory, UTF8_NAMES_FLAG);
+        AppendU16(directory, record.method);
+        AppendU16(directory, dosTime);
+        AppendU16(directory, dosDate);
+        AppendU32(directory, record.crc);
+        AppendU32(directory, record.compressedSize);
+        AppendU32(directory, record.size);
+        AppendU16(directory, static_cast<uint16_t>(record.name.size()));
+        AppendU16(directory, 0);   // Extra field
+        AppendU16(directory, 0);   // Comment
+        AppendU16(directory, 0);   // Disk number
+        AppendU16(directory, 0);   // Internal attributes
+        AppendU32(directory, 0);   // External attributes
+        AppendU32(directory, record.localHeaderOffset);
+        directory += record.name;
+    }
+    uint64_t directorySize = directory.size();
+    if (directoryOffset + directorySize > MAX_ZIP_SIZE) failed = true;
+
+    AppendU32(directory, END_OF_DIRECTORY_SIGNATURE);
+    AppendU16(directory, 0);   // This disk
+    AppendU16(directory, 0);   // Disk with the directory
+    AppendU16(directory, static_cast<uint16_t>(records.size()));
+    AppendU16(directory, static_cast<uint16_t>(records.size()));
+    AppendU32(directory, static_cast<uint32_t>(directorySize));
+    AppendU32(directory, static_cast<uint32_t>(directoryOffset));
+    AppendU16(directory, 0);   // Comment
+    Write(directory);
+
+    out.close();
+    records.clear();
+    return !failed && !out.fail();
+}
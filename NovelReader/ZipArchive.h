@@ -0,0 +1,89 @@
+#pragma once
+#include "MappedFile.h"
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// ZIP archives for EPUB books: ZipReader for import, ZipWriter for export.
+//
+// Reads ZIP archives (EPUB books) without extracting them. The archive is mapped and only its
+// central directory is parsed up front; an entry is inflated (Deflate) or copied when it is
+// asked for, and its CRC-32 checked, so reading a book holds one entry at a time no matter how
+// large the archive is. Stored and deflated entries are supported; ZIP64 and encryption are not.
+// Read may be called from several threads at once.
+class ZipReader {
+public:
+    struct Entry {
+        std::string name;             // Path inside the archive, '/' separated
+        uint16_t method = 0;          // 0 stored, 8 deflated
+        uint32_t crc = 0;
+        uint64_t compressedSize = 0;
+        uint64_t size = 0;
+        uint64_t localHeaderOffset = 0;
+    };
+
+    bool Open(const std::string& path, std::string* error = nullptr);
+    void Close();
+
+    const std::vector<Entry>& Entries() const { return entries; }
+    const Entry* Find(std::string_view name) const;
+
+    // Replaces out with the entry's bytes; false if it is damaged or uses an unsupported method
+    bool Read(const Entry& entry, std::string& out) const;
+
+    static uint32_t Crc32(std::string_view bytes, uint32_t crc = 0);
+
+private:
+    MappedFile file;
+    std::vector<Entry> entries;
+};
+
+// Writes a ZIP archive front to back without holding it: every entry goes straight to the file
+// and only its central directory record (name, sizes, CRC) is kept until Finish. Entries can be
+// prepared (compressed and checksummed) on other threads and added in whatever order the
+// archive needs. No ZIP64: entries and the archive stay under 4 GB and 65535 entries.
+class ZipWriter {
+public:
+    struct Prepared {
+        uint16_t method = 0;          // 0 stored, 8 deflated
+        uint32_t crc = 0;
+        uint64_t size = 0;            // Uncompressed
+        std::string data;             // As stored in the archive
+    };
+
+    ~ZipWriter();
+
+    bool Open(const std::string& path);
+
+    // Compresses at level (1-9), or stores when level is 0 or compression doesn't help
+    static Prepared Prepare(std::string_view bytes, int level = 6);
+
+    bool Add(std::string_view name, const Prepared& entry);
+    bool Add(std::string_view name, std::string_view bytes, int level = 6) { return Add(name, Prepare(bytes, level)); }
+
+    // Writes the central directory and closes the file; false if any write failed
+    bool Finish();
+
+    uint64_t BytesWritten() const { return offset; }
+
+private:
+    struct Record {
+        std::string name;
+        uint16_t method = 0;
+        uint32_t crc = 0;
+        uint32_t compressedSize = 0;
+        uint32_t size = 0;
+        uint32_t localHeaderOffset = 0;
+    };
+
+    void Write(std::string_view bytes);
+
+    std::ofstream out;
+    std::vector<Record> records;
+    uint64_t offset = 0;
+    uint16_t dosTime = 0;
+    uint16_t dosDate = 0;
+    bool failed = false;
+};
@@ -6,13 +6,18 @@ Works with the C++ Library management system
 
 import json
 import os
+import hashlib
+import threading
+import struct
+import zlib
 import sys
 import time
 import argparse
 import re
 import logging
 from datetime import datetime
-from typing import List, Dict, Optional, Tuple
+from typing import List, Dict, Optional, Tuple, Callable
+from concurrent.futures import ThreadPoolExecutor, as_completed
 from enum import Enum
 from dataclasses import dataclass
 from urllib.parse import urljoin, urlparse, quote
@@ -41,6 +46,312 @@ logging.basicConfig(
 )
 logger = logging.getLogger(__name__)
 
+# Sources are searched in parallel; each one is a handful of blocking HTTP requests
+SEARCH_WORKERS = 8
+
+# Search responses are cached per source; result covers are cached by URL for the app's thumbnailer
+SEARCH_CACHE_DIR = os.path.join('Novels', '.cache', 'search')
+COVER_CACHE_DIR = os.path.join('Novels', '.cache', 'covers')
+DEFAULT_SEARCH_CACHE_TTL = 6 * 60 * 60
+COVER_WORKERS = 4
+
+def cover_cache_key(url: str) -> str:
+    """FNV-1a 64 of the URL; the app's ThumbnailCache derives the same file name"""
+    h = 0xcbf29ce484222325
+    for b in url.encode('utf-8'):
+        h ^= b
+        h = (h * 0x100000001b3) & 0xFFFFFFFFFFFFFFFF
+    return f"{h:016x}"
+
+# Chapters are written as the frames the app's ChapterStore reads:
+#   b"NRZ1" | u32 dictionary id | u32 JSON size | raw DEFLATE of the compact JSON
+# The app trains chapters/dictionary.bin once a novel has enough chapters; later chapters use it.
+CHAPTER_FRAME_MAGIC = b'NRZ1'
+CHAPTER_DICTIONARY_FILE = 'dictionary.bin'
+CHAPTER_COMPRESSION_LEVEL = 6
+
+_chapter_dictionaries = {}
+
+def chapter_dictionary_id(dictionary: bytes) -> int:
+    """FNV-1a 32 of the dictionary, never 0 (0 marks a frame without one)"""
+    h = 2166136261
+    for b in dictionary:
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h or 1
+
+def load_chapter_dictionary(chapters_dir: str) -> Tuple[bytes, int]:
+    path = os.path.join(chapters_dir, CHAPTER_DICTIONARY_FILE)
+    try:
+        mtime = os.path.getmtime(path)
+    except OSError:
+        return b'', 0
+    cached = _chapter_dictionaries.get(chapters_dir)
+    if cached and cached[0] == mtime:
+        return cached[1], cached[2]
+    with open(path, 'rb') as f:
+        dictionary = f.read()
+    dictionary_id = chapter_dictionary_id(dictionary) if dictionary else 0
+    _chapter_dictionaries[chapters_dir] = (mtime, dictionary, dictionary_id)
+    return dictionary, dictionary_id
+
+# Chapters, manga pages and covers are entries of the library's content-addressed store, the
+# same one the app's BlobStore manages: every blob is kept once as
+#   <library>/.store/blobs/<first two hex digits>/<BLAKE2b-128 hex>
+# and entries are hard links to it. Identical downloads share their bytes, and the link count is
+# the reference count the app's garbage collection goes by once a novel is removed.
+BLOB_STORE_DIR_NAME = '.store'
+
+def blob_id(data: bytes) -> str:
+    return hashlib.blake2b(data, digest_size=16).hexdigest()
+
+class BlobStore:
+    def __init__(self, root: str):
+        self.root = root
+    
+    @staticmethod
+    def for_chapter_file(chapter_file: str) -> 'BlobStore':
+        """The store of the library <library>/<novel>/chapters/<file> is in"""
+        library = os.path.dirname(os.path.dirname(os.path.dirname(chapter_file)))
+        return BlobStore(os.path.join(library, BLOB_STORE_DIR_NAME))
+    
+    def blob_path(self, blob: str) -> str:
+        return os.path.join(self.root, 'blobs', blob[:2], blob)
+    
+    def _link_entry(self, blob: str, path: str, size: int) -> bool:
+        """Replaces path with a link to an existing blob of the expected size"""
+        blob_file = self.blob_path(blob)
+        link_path = path + '.link'
+        try:
+            if os.path.getsize(blob_file) != size:
+                return False
+            if os.path.exists(path) and os.path.samefile(blob_file, path):
+                return True
+            if os.path.exists(link_path):
+                os.remove(link_path)
+            os.link(blob_file, link_path)
+            os.replace(link_path, path)
+            return True
+        except OSError:
+            if os.path.exists(link_path):
+                os.remove(link_path)
+            return False
+    
+    def put_file(self, path: str, temp_path: str, blob: str) -> str:
+        """Moves a finished temp file into place as an entry of blob, its BLAKE2b-128 hex"""
+        size = os.path.getsize(temp_path)
+        if self._link_entry(blob, path, size):
+            os.remove(temp_path)
+            return blob
+        try:
+            os.makedirs(os.path.dirname(self.blob_path(blob)), exist_ok=True)
+            os.link(temp_path, self.blob_path(blob))
+        except FileExistsError:
+            # Stored by someone else in the meantime
+            if self._link_entry(blob, path, size):
+                os.remove(temp_path)
+                return blob
+        except OSError:
+            pass  # No links on this volume: the entry stays a private file
+        os.replace(temp_path, path)
+        return blob
+    
+    def put(self, path: str, data: bytes) -> str:
+        blob = blob_id(data)
+        if self._link_entry(blob, path, len(data)):
+            return blob
+        temp_path = path + '.tmp'
+        with open(temp_path, 'wb') as f:
+            f.write(data)
+        return self.put_file(path, temp_path, blob)
+    
+    def put_stream(self, path: str, chunks) -> str:
+        """Writes a download as it arrives, hashing along the way"""
+        digest = hashlib.blake2b(digest_size=16)
+        temp_path = path + '.tmp'
+        with open(temp_path, 'wb') as f:
+            for chunk in chunks:
+                if chunk:
+                    digest.update(chunk)
+                    f.write(chunk)
+        return self.put_file(path, temp_path, digest.hexdigest())
+    
+    def adopt(self, path: str) -> str:
+        """Turns a file saved before the store existed into an entry"""
+        with open(path, 'rb') as f:
+            data = f.read()
+        blob = blob_id(data)
+        if self._link_entry(blob, path, len(data)):
+            return blob
+        try:
+            os.makedirs(os.path.dirname(self.blob_path(blob)), exist_ok=True)
+            os.link(path, self.blob_path(blob))
+        except OSError:
+            pass
+        return blob
+    
+    def has_entry(self, path: str) -> bool:
+        """The file is there and linked into the store; a stat, no reading"""
+        try:
+            return os.stat(path).st_nlink > 1
+        except OSError:
+            return False
+    
+    def is_entry_of(self, path: str, blob: str) -> bool:
+        """path still holds the bytes recorded as blob; two stats, no reading"""
+        try:
+            return os.path.samefile(path, self.blob_path(blob))
+        except OSError:
+            return False
+
+def write_chapter_file(chapter_file: str, chapter_data: Dict):
+    """Compresses one chapter into its own frame and stores it, replacing any older file in one step"""
+    text = json.dumps(chapter_data, ensure_ascii=False, separators=(',', ':')).encode('utf-8')
+    dictionary, dictionary_id = load_chapter_dictionary(os.path.dirname(chapter_file))
+    if dictionary:
+        compressor = zlib.compressobj(CHAPTER_COMPRESSION_LEVEL, zlib.DEFLATED, -15, zdict=dictionary)
+    else:
+        compressor = zlib.compressobj(CHAPTER_COMPRESSION_LEVEL, zlib.DEFLATED, -15)
+    body = compressor.compress(text) + compressor.flush()
+    
+    frame = struct.pack('<4sII', CHAPTER_FRAME_MAGIC, dictionary_id, len(text)) + body
+    BlobStore.for_chapter_file(chapter_file).put(chapter_file, frame)
+
+class SearchCache:
+    """One file per (source, normalized query, filters), valid for ttl seconds"""
+    
+    def __init__(self, directory: str, ttl: int):
+        self.directory = directory
+        self.ttl = ttl
+    
+    def _path(self, source_name: str, query: str, filters: List) -> str:
+        normalized = " ".join(query.lower().split())
+        key = json.dumps([source_name, normalized, filters], ensure_ascii=True)
+        return os.path.join(self.directory, hashlib.sha1(key.encode('utf-8')).hexdigest() + '.json')
+    
+    def get(self, source_name: str, query: str, filters: List) -> Optional[List[Dict]]:
+        if self.ttl <= 0:
+            return None
+        path = self._path(source_name, query, filters)
+        try:
+            if time.time() - os.path.getmtime(path) > self.ttl:
+                return None
+            with open(path, 'r', encoding='utf-8') as f:
+                return json.load(f)
+        except (OSError, ValueError):
+            return None
+    
+    def put(self, source_name: str, query: str, filters: List, results: List[Dict]):
+        if self.ttl <= 0:
+            return
+        path = self._path(source_name, query, filters)
+        try:
+            os.makedirs(self.directory, exist_ok=True)
+            temp_path = path + '.tmp'
+            with open(temp_path, 'w', encoding='utf-8') as f:
+                json.dump(results, f, ensure_ascii=True)
+            os.replace(temp_path, path)
+        except OSError as e:
+            logger.error(f"Could not cache search results: {e}")
+    
+    def prune(self):
+        """Drop entries past their TTL so the cache doesn't grow without bound"""
+        if not os.path.isdir(self.directory):
+            return
+        now = time.time()
+        for name in os.listdir(self.directory):
+            path = os.path.join(self.directory, name)
+            try:
+                if now - os.path.getmtime(path) > max(self.ttl, 0):
+                    os.remove(path)
+            except OSError:
+                pass
+
+class CoverPrefetcher:
+    """Downloads search result covers into COVER_CACHE_DIR in the background.
+    
+    on_cover(url, path) runs on a worker thread for each cover that lands on disk.
+    """
+    
+    def __init__(self, session, on_cover: Callable[[str, str], None]):
+        self.session = session
+        self.on_cover = on_cover
+        self.pool = ThreadPoolExecutor(max_workers=COVER_WORKERS)
+        self.seen = set()
+        os.makedirs(COVER_CACHE_DIR, exist_ok=True)
+    
+    def submit(self, results: List[Dict]):
+        for result in results:
+            url = result.get('cover_url', '')
+            if url and url not in self.seen:
+                self.seen.add(url)
+                self.pool.submit(self._fetch, url)
+    
+    def _fetch(self, url: str):
+        key = cover_cache_key(url)
+        path = os.path.join(COVER_CACHE_DIR, key + '.img')
+        # The app keeps only the thumbnail once it has made one
+        if os.path.exists(path) or os.path.exists(os.path.join(COVER_CACHE_DIR, key + '.thumb')):
+            return
+        try:
+            response = self.session.get(url, timeout=30)
+            response.raise_for_status()
+            temp_path = path + '.tmp'
+            with open(temp_path, 'wb') as f:
+                f.write(response.content)
+            os.replace(temp_path, path)
+            self.on_cover(url, path)
+        except Exception as e:
+            logger.error(f"Error prefetching cover {url}: {e}")
+    
+    def wait(self):
+        self.pool.shutdown(wait=True)
+
+class ControlChannel:
+    """Commands from the app on stdin, one per line: pause, resume, cancel, stop.
+
+    A reader thread turns them into events, so the download loops check them between network
+    requests without blocking, and rate-limit waits and pauses end the moment one arrives.
+    stdin closing means the app has gone, which counts as stop. on_stop, if given, is called
+    with the reason on the reader thread the first time a stop or cancel arrives.
+    """
+
+    def __init__(self, stream, on_stop=None):
+        self.running = threading.Event()
+        self.running.set()
+        self.stopped = threading.Event()
+        self.reason = ''
+        self.on_stop = on_stop
+        threading.Thread(target=self._read, args=(stream,), daemon=True).start()
+
+    def _read(self, stream):
+        for line in iter(stream.readline, ''):
+            command = line.strip().lower()
+            if command == 'pause':
+                self.running.clear()
+            elif command == 'resume':
+                self.running.set()
+            elif command in ('cancel', 'stop'):
+                self._stop(command)
+        self._stop('stop')
+
+    def _stop(self, reason: str):
+        if not self.stopped.is_set():
+            self.reason = reason
+            self.stopped.set()
+            if self.on_stop:
+                self.on_stop(reason)
+        self.running.set()
+
+    def should_stop(self) -> bool:
+        """Waits out a pause; True once cancelled or stopped"""
+        self.running.wait()
+        return self.stopped.is_set()
+
+    def wait(self, seconds: float):
+        """Sleeps, unless a stop or cancel comes first"""
+        self.stopped.wait(seconds)
+
 class ContentType(Enum):
     ALL = "all"
     NOVEL = "novel"
@@ -84,6 +395,7 @@ class UniversalDownloader:
         self.load_sources(config_path)
         self.download_states = {}
         self.should_stop = {}
+        self.control = None       # ControlChannel when the app started us with --control-stdin
     
     def load_sources(self, config_path: str):
         """Load source configurations"""
@@ -98,36 +410,77 @@ class UniversalDownloader:
     
     def search_content(self, query: str, content_type: str = "all", 
                       language: str = "", include_adult: bool = False,
-                      max_results_per_source: int = 2) -> List[Dict]:
-        """Search for content across all enabled sources"""
-        results = []
-        
+                      max_results_per_source: int = 2,
+                      on_source_done: Optional[Callable[[str, List[Dict], str], None]] = None,
+                      cache: Optional[SearchCache] = None) -> List[Dict]:
+        """Search for content across all enabled sources concurrently.
+
+        on_source_done(source_name, results, error) is called as each source answers,
+        from the calling thread, in completion order. Sources answered from cache come first.
+        """
+        sources = []
         for source_name, source in self.sources.items():
-            try:
-                # Check content type compatibility
-                if content_type != "all":
-                    source_types = source.get('content_types', ['novel'])
-                    if content_type not in source_types:
-                        continue
-                
-                logger.info(f"Searching {source_name} for: {query}")
-                
-                if source_name == "NovelFire":
-                    source_results = self._search_novelfire(query, source)
-                elif source_name == "Comick":
-                    source_results = self._search_comick(query, source, content_type)
-                else:
-                    source_results = self._generic_search(query, source)
-                
-                # Limit results per source
-                results.extend(source_results[:max_results_per_source])
-                
-            except Exception as e:
-                logger.error(f"Error searching {source_name}: {e}")
+            # Check content type compatibility
+            if content_type != "all":
+                source_types = source.get('content_types', ['novel'])
+                if content_type not in source_types:
+                    continue
+            sources.append((source_name, source))
+        
+        if not sources:
+            return []
+        
+        results_by_source = {}
+        filters = [content_type, language, include_adult, max_results_per_source]
+        
+        pending = []
+        for source_name, source in sources:
+            cached = cache.get(source_name, query, filters) if cache else None
+            if cached is None:
+                pending.append((source_name, source))
                 continue
+            logger.info(f"Using cached results from {source_name} for: {query}")
+            results_by_source[source_name] = cached
+            if on_source_done:
+                on_source_done(source_name, cached, "")
+        
+        if pending:
+            with ThreadPoolExecutor(max_workers=min(len(pending), SEARCH_WORKERS)) as pool:
+                futures = {
+                    pool.submit(self._search_source, query, source_name, source, content_type): source_name
+                    for source_name, source in pending
+                }
+                for future in as_completed(futures):
+                    source_name = futures[future]
+                    error = ""
+                    try:
+                        source_results = future.result()[:max_results_per_source]
+                        if cache:
+                            cache.put(source_name, query, filters, [search_result_to_dict(r) for r in source_results])
+                    except Exception as e:
+                        logger.error(f"Error searching {source_name}: {e}")
+                        source_results = []
+                        error = str(e)
+                
+                    results_by_source[source_name] = source_results
+                    if on_source_done:
+                        on_source_done(source_name, source_results, error)
         
+        # Keep the configured source order in the combined list
+        results = []
+        for source_name, _ in sources:
+            results.extend(results_by_source.get(source_name, []))
         return results
     
+    def _search_source(self, query: str, source_name: str, source: Dict, content_type: str) -> List[Dict]:
+        logger.info(f"Searching {source_name} for: {query}")
+        
+        if source_name == "NovelFire":
+            return self._search_novelfire(query, source)
+        elif source_name == "Comick":
+            return self._search_comick(query, source, content_type)
+        return self._generic_search(query, source)
+    
     def _search_novelfire(self, query: str, source: Dict) -> List[Dict]:
         """Search NovelFire for novels"""
         results = []
@@ -517,10 +870,12 @@ class UniversalDownloader:
             logger.info("Saving novel metadata...")
             self._save_novel_metadata(content_info, novel_dir)
         
+            store = BlobStore(os.path.join(output_dir, BLOB_STORE_DIR_NAME))
+        
             # Download cover
             if content_info.get('cover_url'):
                 logger.info("Downloading cover image...")
-                self._download_cover(content_info['cover_url'], novel_dir)
+                self._download_cover(content_info['cover_url'], novel_dir, store)
         
             # Determine chapter range
             total_chapters = content_info.get('total_chapters', 0)
@@ -562,8 +917,10 @@ class UniversalDownloader:
                 
                     chapter_file = os.path.join(chapters_dir, f"chapter{chapter_num}.json")
                 
-                    # Skip if already exists
+                    # Skip if already exists; chapters saved before the store existed join it now
                     if os.path.exists(chapter_file):
+                        if not store.has_entry(chapter_file):
+                            store.adopt(chapter_file)
                         logger.info(f"Chapter {chapter_num} already exists, skipping...")
                         downloaded_count += 1
                         progress = (downloaded_count / total_to_download) * 100
@@ -590,8 +947,10 @@ class UniversalDownloader:
                         continue
                 
                     # Save chapter
-                    with open(chapter_file, 'w', encoding='utf-8') as f:
-                        json.dump(chapter_data, f, indent=2, ensure_ascii=False)
+                    write_chapter_file(chapter_file, chapter_data)
+                
+                    # Let the app index the chapter while the download continues
+                    print(f"ChapterSaved: {chapter_num} {os.path.basename(novel_dir)}", file=sys.stderr, flush=True)
                 
                     downloaded_count += 1
                     progress = (downloaded_count / total_to_download) * 100
@@ -610,9 +969,9 @@ class UniversalDownloader:
                     # Rate limiting
                     if downloaded_count % 10 == 0:
                         logger.info(f"Downloaded {downloaded_count} chapters, pausing for 5 seconds...")
-                        time.sleep(5)
+                        self._wait(5)
                     else:
-                        time.sleep(1)
+                        self._wait(1)
                 
                 except Exception as e:
                     logger.error(f"Error downloading chapter {chapter_num}: {str(e)}")
@@ -664,9 +1023,11 @@ class UniversalDownloader:
         # Save metadata
         self._save_manga_metadata(content_info, manga_dir)
         
+        store = BlobStore(os.path.join(output_dir, BLOB_STORE_DIR_NAME))
+        
         # Download cover
         if content_info['cover_url']:
-            self._download_cover(content_info['cover_url'], manga_dir)
+            self._download_cover(content_info['cover_url'], manga_dir, store)
         
         # Get chapter providers
         providers = self._get_chapter_providers(content_info['url'], source)
@@ -694,7 +1055,7 @@ class UniversalDownloader:
             chapter_dir = os.path.join(manga_dir, f"Chapter_{chapter_num:03d}")
             
             # Skip if already downloaded
-            if self._chapter_already_downloaded(chapter_dir):
+            if self._chapter_already_downloaded(chapter_dir, store):
                 downloaded_count += 1
                 continue
             
@@ -707,7 +1068,8 @@ class UniversalDownloader:
                     logger.error(f"No images found for chapter {chapter_num}")
                     continue
                 
-                # Download each image
+                # Download each image; pages re-uploaded unchanged share the blob they already have
+                pages = []
                 for i, image_url in enumerate(images):
                     if self._should_stop_download(download_id):
                         return False
@@ -715,14 +1077,19 @@ class UniversalDownloader:
                     ext = self._get_image_extension(image_url)
                     image_path = os.path.join(chapter_dir, f"page_{i:03d}{ext}")
                     
-                    if not os.path.exists(image_path):
-                        self._download_image(image_url, image_path)
+                    if os.path.exists(image_path):
+                        blob = store.adopt(image_path)
+                    else:
+                        blob = self._download_image(image_url, image_path, store)
+                    if blob:
+                        pages.append({'file': os.path.basename(image_path), 'blob': blob})
                 
                 # Save chapter metadata
                 chapter_meta = {
                     'chapter_number': chapter_num,
                     'title': f"Chapter {chapter_num}",
                     'page_count': len(images),
+                    'pages': pages,
                     'provider': selected_provider.name,
                     'language': selected_provider.language,
                     'download_date': datetime.now().isoformat()
@@ -740,7 +1107,7 @@ class UniversalDownloader:
                 logger.info(f"Progress: {downloaded_count}/{total_chapters} ({progress:.1f}%) - Chapter {chapter_num}")
                 
                 # Rate limiting
-                time.sleep(2)
+                self._wait(2)
                 
             except Exception as e:
                 logger.error(f"Error downloading chapter {chapter_num}: {e}")
@@ -891,29 +1258,26 @@ class UniversalDownloader:
             logger.error(f"Error getting chapter images: {e}")
             return []
     
-    def _download_image(self, image_url: str, output_path: str, max_retries: int = 3):
-        """Download image with retry logic"""
+    def _download_image(self, image_url: str, output_path: str, store: BlobStore, max_retries: int = 3) -> str:
+        """Download image with retry logic; returns its blob id, or '' on failure"""
         for attempt in range(max_retries):
+            if self.control and self.control.stopped.is_set():
+                return ''
             try:
                 response = self.session.get(image_url, timeout=30, stream=True)
                 response.raise_for_status()
                 
-                with open(output_path, 'wb') as f:
-                    for chunk in response.iter_content(chunk_size=8192):
-                        if chunk:
-                            f.write(chunk)
-                
-                return True
+                return store.put_stream(output_path, response.iter_content(chunk_size=8192))
                 
             except Exception as e:
                 if attempt < max_retries - 1:
-                    time.sleep(2 ** attempt)
+                    self._wait(2 ** attempt)
                 else:
                     logger.error(f"Failed to download image {image_url}: {e}")
         
-        return False
+        return ''
     
-    def _download_cover(self, cover_url: str, output_dir: str):
+    def _download_cover(self, cover_url: str, output_dir: str, store: BlobStore):
         """Download cover image"""
         try:
             response = self.session.get(cover_url, timeout=30, stream=True)
@@ -931,10 +1295,7 @@ class UniversalDownloader:
            
             cover_path = os.path.join(output_dir, f'cover{ext}')
            
-            with open(cover_path, 'wb') as f:
-               for chunk in response.iter_content(chunk_size=8192):
-                   if chunk:
-                       f.write(chunk)
+            store.put_stream(cover_path, response.iter_content(chunk_size=8192))
            
             logger.info(f"Downloaded cover to {cover_path}")
            
@@ -1035,7 +1396,7 @@ class UniversalDownloader:
        
        return '.jpg'  # Default
    
-    def _chapter_already_downloaded(self, chapter_dir: str) -> bool:
+    def _chapter_already_downloaded(self, chapter_dir: str, store: BlobStore) -> bool:
        """Check if chapter is already completely downloaded"""
        if not os.path.exists(chapter_dir):
            return False
@@ -1052,6 +1413,12 @@ class UniversalDownloader:
            if expected_pages == 0:
                return False
            
+           # Chapters saved with the store list each page's blob: every page must still be that blob
+           pages = metadata.get('pages')
+           if pages is not None:
+               return len(pages) >= expected_pages and all(
+                   store.is_entry_of(os.path.join(chapter_dir, page['file']), page['blob']) for page in pages)
+           
            # Count actual image files
            image_files = [f for f in os.listdir(chapter_dir) 
                          if f.startswith('page_') and f.endswith(('.jpg', '.png', '.gif', '.webp'))]
@@ -1077,9 +1444,19 @@ class UniversalDownloader:
        
        return filename
    
+    def _wait(self, seconds: float):
+       """Rate-limit and retry waits; a stop or cancel from the app cuts them short"""
+       if self.control:
+           self.control.wait(seconds)
+       else:
+           time.sleep(seconds)
+   
     def _should_stop_download(self, download_id: str) -> bool:
-       """Check if download should be stopped"""
-       # Check for stop signal files
+       """Check if download should be stopped; waits while paused"""
+       if self.control:
+           return self.control.should_stop()
+       
+       # Run on its own: the pause, resume and cancel actions leave signal files
        stop_file = f"downloads/.stop_{download_id}"
        pause_file = f"downloads/.pause_{download_id}"
        cancel_file = f"downloads/.cancel_{download_id}"
@@ -1176,6 +1553,20 @@ class UniversalDownloader:
        return downloads
 
 
+def search_result_to_dict(result) -> Dict:
+   """Search results are plain dicts, but some sources build SearchResult objects"""
+   if isinstance(result, dict):
+       return result
+   return {
+       "title": result.title,
+       "author": result.author,
+       "url": result.url,
+       "source_name": result.source_name,
+       "total_chapters": result.total_chapters,
+       "description": result.description,
+       "cover_url": result.cover_url
+   }
+
 def main():
    parser = argparse.ArgumentParser(description='Universal Content Download Manager')
    parser.add_argument('action', choices=['search', 'download', 'info', 'pause', 'resume', 'cancel', 'status', 'list'])
@@ -1193,11 +1584,27 @@ def main():
    parser.add_argument('--include-adult', action='store_true', help='Include adult content')
    parser.add_argument('--max-results', type=int, default=2, help='Max results per source')
    parser.add_argument('--download-id', help='Download ID')
+   parser.add_argument('--control-stdin', action='store_true',
+                      help='Download: take pause, resume, cancel and stop commands on stdin; '
+                           'search: exit on stop or cancel')
+   parser.add_argument('--stream', action='store_true',
+                      help='Search: print one JSON line per source as it answers instead of one array at the end')
+   parser.add_argument('--cache-ttl', type=int, default=DEFAULT_SEARCH_CACHE_TTL,
+                      help='Search: seconds a cached response stays valid (0 disables the cache)')
+   parser.add_argument('--prefetch-covers', action='store_true',
+                      help='Search (with --stream): download result covers and report each one')
    
    args = parser.parse_args()
    
    try:
        downloader = UniversalDownloader(args.config)
+       if args.control_stdin:
+           if args.action == 'search':
+               # The app moved on to another query; the source requests can't be interrupted, so
+               # leave them and any cover downloads behind rather than finish them
+               downloader.control = ControlChannel(sys.stdin, on_stop=lambda reason: os._exit(0))
+           else:
+               downloader.control = ControlChannel(sys.stdin)
        
        if args.action == 'search':
            if not args.query:
@@ -1205,30 +1612,52 @@ def main():
                print(json.dumps([]))
                return 1
            
+           cache = SearchCache(SEARCH_CACHE_DIR, args.cache_ttl)
+           cache.prune()
+           
+           on_source_done = None
+           prefetcher = None
+           if args.stream:
+               emit_lock = threading.Lock()
+               
+               def emit(line):
+                   try:
+                       with emit_lock:
+                           print(json.dumps(line, ensure_ascii=True), flush=True)
+                   except (BrokenPipeError, OSError):
+                       # The app dropped this search for a newer one; don't wait for the other sources
+                       os._exit(0)
+               
+               if args.prefetch_covers:
+                   prefetcher = CoverPrefetcher(downloader.session,
+                                                lambda url, path: emit({"cover_url": url, "path": path}))
+               
+               def on_source_done(source_name, source_results, error):
+                   line = {"source": source_name, "results": [search_result_to_dict(r) for r in source_results]}
+                   if error:
+                       line["error"] = error
+                   emit(line)
+                   if prefetcher:
+                       prefetcher.submit(line["results"])
+           
            results = downloader.search_content(
                query=args.query,
                content_type=args.content_type,
                language=args.language,
                include_adult=args.include_adult,
-               max_results_per_source=args.max_results
+               max_results_per_source=args.max_results,
+               on_source_done=on_source_done,
+               cache=cache
            )
+           if args.stream:
+               # Every source has answered; covers may still be arriving
+               emit({"done": True})
+               if prefetcher:
+                   prefetcher.wait()
+               return 0
            
            # Convert to list of dicts for JSON output
-           output = []
-           for result in results:
-               if isinstance(result, dict):
-                   output.append(result)
-               else:
-                   # Convert SearchResult to dict if needed
-                   output.append({
-                       "title": result.title,
-                       "author": result.author,
-                       "url": result.url,
-                       "source_name": result.source_name,
-                       "total_chapters": result.total_chapters,
-                       "description": result.description,
-                       "cover_url": result.cover_url
-                   })
+           output = [search_result_to_dict(result) for result in results]
            
            print(json.dumps(output, ensure_ascii=True))
        
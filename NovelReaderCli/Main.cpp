@@ -0,0 +1,538 @@
+#include "BookExporter.h"
+#include "BookImporter.h"
+#include "Catalog.h"
+#include "ChapterCleaner.h"
+#include "DownloadDaemon.h"
+#include "DownloadJob.h"
+#include "IntegrityScanner.h"
+#include "SearchIndex.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The image header checks in IntegrityScanner; the app compiles this into Library.cpp
+#define STB_IMAGE_IMPLEMENTATION
+#include "Dependecies/stb_image.h"
+
+// novelreader-cli: batch jobs on a library without the GUI. It works on the same folders as the
+// app (Novels/, index/, Manga/, download_manager.py), relative to --root or the current directory;
+// files named on the command line stay relative to the directory the command was run from.
+
+namespace {
+    const char* const NOVELS_ROOT = "Novels";
+    const char* const MANGA_ROOT = "Manga";
+    const char* const INDEX_DIR = "index";
+
+    // Where the command was typed; --root changes directory, file arguments stay relative to this
+    std::filesystem::path invocationDir;
+
+    const char* const USAGE =
+        "Usage: novelreader-cli [--root DIR] <command> [options]\n"
+        "\n"
+        "  list                                  Novels in the catalog\n"
+        "  import <file-or-folder>...            Import .txt, .md and .epub books\n"
+        "  export <novel> [--format epub|md|txt] [--from N] [--to N] [--output PATH]\n"
+        "  reindex [--full]                      Bring the search index up to date (or rebuild it)\n"
+        "  verify                                Check every chapter file and manga page\n"
+        "  update-check                          Novels with chapters left to download\n"
+        "  download --source S (--url U | --name N) [--start N] [--end N]\n"
+        "  queue <file> [--jobs N]               Run downloads listed one per line:\n"
+        "                                        source<TAB>url-or-name[<TAB>start[<TAB>end]]\n"
+        "\n"
+        "  daemon                                Run the download daemon until daemon-stop\n"
+        "  enqueue --source S (--url U | --name N) [--start N] [--end N] [--author A]\n"
+        "  jobs                                  Downloads the daemon knows about\n"
+        "  watch                                 Follow the daemon's downloads as they change\n"
+        "  pause|resume|cancel <job-id>\n"
+        "  daemon-stop\n"
+        "\n"
+        "Downloads run download_manager.py under $NOVELREADER_PYTHON, else python3, else python.\n";
+
+    // Command arguments: positional values and --name value options
+    struct Arguments {
+        std::vector<std::string> positional;
+        std::vector<std::pair<std::string, std::string>> options;
+
+        bool Has(const std::string& name) const {
+            return std::any_of(options.begin(), options.end(), [&](const auto& option) { return option.first == name; });
+        }
+
+        std::string Get(const std::string& name, const std::string& fallback = "") const {
+            for (const auto& [optionName, value] : options) {
+                if (optionName == name) return value;
+            }
+            return fallback;
+        }
+
+        int GetInt(const std::string& name, int fallback) const {
+            std::string value = Get(name);
+            try {
+                return value.empty() ? fallback : std::stoi(value);
+            }
+            catch (const std::exception&) {
+                return fallback;
+            }
+        }
+    };
+
+    // Flags that take no value
+    bool IsSwitch(const std::string& name) {
+        return name == "--full";
+    }
+
+    Arguments ParseArguments(int argc, char** argv, int first) {
+        Arguments arguments;
+        for (int i = first; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) == 0 && arg.size() > 2) {
+                std::string value = (!IsSwitch(arg) && i + 1 < argc) ? argv[++i] : "";
+                arguments.options.emplace_back(arg, value);
+            }
+            else {
+                arguments.positional.push_back(arg);
+            }
+        }
+        return arguments;
+    }
+
+    // A file named on the command line, as a path that still works after --root
+    std::string UserPath(const std::string& path) {
+        std::filesystem::path given(path);
+        if (given.is_absolute() || invocationDir.empty()) return path;
+        return (invocationDir / given).lexically_normal().string();
+    }
+
+    // Cleans the novels that changed and brings the search index up to date with them
+    void AfterNewChapters(const std::vector<std::string>& novelDirNames) {
+        for (const std::string& name : novelDirNames) {
+            ChapterCleaner::EnsureCleaned(Catalog::NovelDir(NOVELS_ROOT, name));
+        }
+
+        std::vector<SearchIndex::ChapterRef> stale = SearchIndex::FindStaleChapters(NOVELS_ROOT, INDEX_DIR);
+        if (!stale.empty()) {
+            SearchIndex::BuildStats stats;
+            SearchIndex::AddChapters(NOVELS_ROOT, INDEX_DIR, stale, &stats);
+            std::cout << "Indexed " << stats.documents << " chapters" << std::endl;
+        }
+    }
+
+    // ============================================================================
+    // Commands
+    // ============================================================================
+    int List() {
+        std::vector<Catalog::Novel> novels;
+        Catalog::Load(NOVELS_ROOT, novels);
+        for (const Catalog::Novel& novel : novels) {
+            std::cout << novel.name << "\t" << novel.authorname << "\t" << novel.downloadedchapters << "/"
+                << novel.totalchapters << " chapters\tread " << novel.progress.readchapters << std::endl;
+        }
+        return 0;
+    }
+
+    int Import(const Arguments& arguments) {
+        if (arguments.positional.empty()) {
+            std::cout << USAGE;
+            return 2;
+        }
+
+        std::vector<std::string> files;
+        for (const std::string& argument : arguments.positional) {
+            std::string path = UserPath(argument);
+            std::error_code ec;
+            if (std::filesystem::is_directory(path, ec)) {
+                std::vector<std::string> found;
+                for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+                    if (entry.is_regular_file(ec) && BookImporter::IsSupported(entry.path().string())) {
+                        found.push_back(entry.path().string());
+                    }
+                }
+                std::sort(found.begin(), found.end());
+                files.insert(files.end(), found.begin(), found.end());
+            }
+            else {
+                files.push_back(path);
+            }
+        }
+
+        std::vector<Catalog::Novel> novels;
+        Catalog::Load(NOVELS_ROOT, novels);
+        std::vector<std::string> imported;
+        int failures = 0;
+        for (const std::string& file : files) {
+            BookImporter::Result result;
+            if (!BookImporter::Import(file, NOVELS_ROOT, result)) {
+                failures++;
+                continue;
+            }
+
+            Catalog::Novel novel;
+            novel.name = result.title;
+            novel.authorname = result.author.empty() ? "Unknown" : result.author;
+            novel.synopsis = result.synopsis;
+            novel.totalchapters = static_cast<int>(result.chapters);
+            novel.downloadedchapters = static_cast<int>(result.chapters);
+            novel.progress.readchapters = 0;
+            novel.progress.progresspercentage = 0.0f;
+            Catalog::Add(NOVELS_ROOT, novels, novel);
+            imported.push_back(result.title);
+        }
+
+        AfterNewChapters(imported);
+        std::cout << imported.size() << " imported, " << failures << " failed" << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    int Export(const Arguments& arguments) {
+        if (arguments.positional.size() != 1) {
+            std::cout << USAGE;
+            return 2;
+        }
+        const std::string& name = arguments.positional[0];
+
+        BookExporter::Options options;
+        std::string format = arguments.Get("--format", "epub");
+        if (format == "md" || format == "markdown") options.format = BookExporter::Format::Markdown;
+        else if (format == "txt" || format == "text") options.format = BookExporter::Format::Text;
+        else if (format != "epub") {
+            std::cout << "Unknown format: " << format << std::endl;
+            return 2;
+        }
+        options.firstChapter = arguments.GetInt("--from", 1);
+        options.lastChapter = arguments.GetInt("--to", 0);
+        options.title = name;
+        options.coverPath = Catalog::CoverPath(NOVELS_ROOT, name);
+
+        std::vector<Catalog::Novel> novels;
+        Catalog::Load(NOVELS_ROOT, novels);
+        if (const Catalog::Novel* novel = Catalog::Find(novels, name)) {
+            options.author = novel->authorname;
+            options.synopsis = novel->synopsis;
+        }
+
+        std::string outputPath = UserPath(arguments.Get("--output", name + BookExporter::Extension(options.format)));
+        BookExporter::Result result;
+        size_t lastPercent = 0;
+        bool exported = BookExporter::Export(Catalog::NovelDir(NOVELS_ROOT, name), outputPath, options, result,
+            [&](size_t written, size_t total) {
+                size_t percent = written * 100 / total;
+                if (percent >= lastPercent + 10 || written == total) {
+                    std::cout << "  " << percent << "% (" << written << "/" << total << ")" << std::endl;
+                    lastPercent = percent;
+                }
+            });
+        return exported ? 0 : 1;
+    }
+
+    int Reindex(const Arguments& arguments) {
+        if (arguments.Has("--full")) {
+            SearchIndex::BuildStats stats;
+            if (!SearchIndex::Build(NOVELS_ROOT, INDEX_DIR, nullptr, nullptr, &stats)) {
+                std::cout << "Index build failed" << std::endl;
+                return 1;
+            }
+            std::cout << "Indexed " << stats.documents << " chapters in " << stats.seconds << " s" << std::endl;
+            return 0;
+        }
+
+        std::vector<std::string> vanished;
+        std::vector<SearchIndex::ChapterRef> stale = SearchIndex::FindStaleChapters(NOVELS_ROOT, INDEX_DIR, &vanished);
+        for (const std::string& name : vanished) {
+            SearchIndex::RemoveNovel(INDEX_DIR, name);
+        }
+        if (!stale.empty()) {
+            SearchIndex::BuildStats stats;
+            if (!SearchIndex::AddChapters(NOVELS_ROOT, INDEX_DIR, stale, &stats)) {
+                std::cout << "Index update failed" << std::endl;
+                return 1;
+            }
+        }
+        SearchIndex::Compact(INDEX_DIR);
+        SearchIndex::CollectGarbage(INDEX_DIR);
+        std::cout << stale.size() << " chapters indexed, " << vanished.size() << " novels removed" << std::endl;
+        return 0;
+    }
+
+    int Verify() {
+        IntegrityScanner scanner(NOVELS_ROOT, MANGA_ROOT);
+        std::time_t before = scanner.LastScanTime();
+        scanner.Start();
+        scanner.RequestScan();
+        while (scanner.LastScanTime() == before) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        scanner.Stop();
+
+        std::vector<IntegrityScanner::Damage> damage = scanner.CurrentDamage();
+        for (const IntegrityScanner::Damage& item : damage) {
+            std::cout << (item.manga ? "manga " : "novel ") << item.contentName << " chapter " << item.chapter;
+            if (!item.page.empty()) std::cout << " page " << item.page;
+            std::cout << ": " << item.reason << std::endl;
+        }
+        std::cout << scanner.CheckedItems() << " items checked, " << damage.size() << " damaged" << std::endl;
+        return damage.empty() ? 0 : 1;
+    }
+
+    // Offline: compares the chapters on disk with the totals the catalog last saw online
+    int UpdateCheck() {
+        std::vector<Catalog::Novel> novels;
+        Catalog::Load(NOVELS_ROOT, novels);
+        int behind = 0;
+        for (const Catalog::Novel& novel : novels) {
+            int onDisk = Catalog::CountChapters(NOVELS_ROOT, novel.name);
+            if (onDisk < novel.totalchapters) {
+                std::cout << novel.name << "\t" << novel.totalchapters - onDisk << " chapters to download ("
+                    << onDisk << "/" << novel.totalchapters << ")" << std::endl;
+                behind++;
+            }
+        }
+        std::cout << behind << " of " << novels.size() << " novels have chapters to download" << std::endl;
+        return 0;
+    }
+
+    // Runs the downloads on up to `jobs` threads; returns how many failed
+    int RunDownloads(const std::vector<DownloadJob::Request>& requests, size_t jobs) {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<int> failures{ 0 };
+        std::mutex outputMutex;
+        std::vector<std::string> novelDirNames;   // Guarded by outputMutex
+
+        auto workerLoop = [&]() {
+            size_t i;
+            while ((i = next.fetch_add(1)) < requests.size()) {
+                const DownloadJob::Request& request = requests[i];
+                std::string label = request.name.empty() ? request.url : request.name;
+                int exitCode = DownloadJob::Run(DownloadJob::BuildArgs(request), [&](const std::string& line) {
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    DownloadJob::ChapterSaved saved;
+                    if (DownloadJob::ParseChapterSaved(line, saved)) {
+                        if (std::find(novelDirNames.begin(), novelDirNames.end(), saved.novelDirName) == novelDirNames.end()) {
+                            novelDirNames.push_back(saved.novelDirName);
+                        }
+                    }
+                    else if (line.find("Progress:") != std::string::npos || line.find("rror") != std::string::npos) {
+                        std::cout << "[" << label << "] " << line;
+                    }
+                });
+
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cout << "[" << label << "] " << (exitCode == 0 ? "done" : "failed") << std::endl;
+                if (exitCode != 0) failures++;
+            }
+        };
+
+        std::vector<std::unique_ptr<std::thread>> workers;
+        for (size_t worker = 0; worker < std::min(jobs, requests.size()); worker++) {
+            workers.push_back(std::make_unique<std::thread>(workerLoop));
+        }
+        for (auto& thread : workers) {
+            thread->join();
+        }
+
+        AfterNewChapters(novelDirNames);
+        return failures;
+    }
+
+    int Download(const Arguments& arguments) {
+        DownloadJob::Request request;
+        request.source = arguments.Get("--source");
+        request.url = arguments.Get("--url");
+        request.name = arguments.Get("--name");
+        request.startChapter = arguments.GetInt("--start", 1);
+        request.endChapter = arguments.GetInt("--end", -1);
+        if (request.source.empty() || (request.url.empty() && request.name.empty())) {
+            std::cout << USAGE;
+            return 2;
+        }
+        return RunDownloads({ request }, 1) == 0 ? 0 : 1;
+    }
+
+    int Queue(const Arguments& arguments) {
+        if (arguments.positional.size() != 1) {
+            std::cout << USAGE;
+            return 2;
+        }
+        std::ifstream file(UserPath(arguments.positional[0]));
+        if (!file.is_open()) {
+            std::cout << "Could not open " << arguments.positional[0] << std::endl;
+            return 1;
+        }
+
+        std::vector<DownloadJob::Request> requests;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            std::vector<std::string> fields;
+            size_t start = 0;
+            while (true) {
+                size_t tab = line.find('\t', start);
+                fields.push_back(line.substr(start, tab - start));
+                if (tab == std::string::npos) break;
+                start = tab + 1;
+            }
+            if (fields.size() < 2) {
+                std::cout << "Skipping malformed line: " << line << std::endl;
+                continue;
+            }
+
+            DownloadJob::Request request;
+            request.source = fields[0];
+            request.url = fields[1];
+            request.name = fields[1];
+            try {
+                if (fields.size() > 2) request.startChapter = std::stoi(fields[2]);
+                if (fields.size() > 3) request.endChapter = std::stoi(fields[3]);
+            }
+            catch (const std::exception&) {
+                std::cout << "Skipping malformed line: " << line << std::endl;
+                continue;
+            }
+            requests.push_back(std::move(request));
+        }
+
+        size_t jobs = static_cast<size_t>(std::max(1, arguments.GetInt("--jobs", 2)));
+        int failures = RunDownloads(requests, jobs);
+        std::cout << requests.size() - failures << " of " << requests.size() << " downloads finished" << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    // ============================================================================
+    // Download daemon
+    // ============================================================================
+    int Daemon() {
+        DownloadDaemon daemon(NOVELS_ROOT, [](const std::vector<std::string>& novelDirNames) {
+            AfterNewChapters(novelDirNames);
+        });
+        if (!daemon.Start()) return 1;
+        daemon.Wait();
+        daemon.Stop();
+        return 0;
+    }
+
+    void PrintJob(const DownloadDaemon::Job& job) {
+        std::cout << job.id << "\t" << DownloadDaemon::StatusName(job.status) << "\t"
+            << job.currentChapter << "/" << job.totalChapters << "\t" << job.request.name;
+        if (!job.lastError.empty()) std::cout << "\t" << job.lastError;
+        std::cout << std::endl;
+    }
+
+    bool ConnectToDaemon(DownloadDaemon::Client& client) {
+        if (client.Connect()) return true;
+        std::cout << client.LastError() << "; start one with `novelreader-cli daemon`" << std::endl;
+        return false;
+    }
+
+    int Enqueue(const Arguments& arguments) {
+        DownloadDaemon::Enqueue enqueue;
+        enqueue.request.source = arguments.Get("--source");
+        enqueue.request.url = arguments.Get("--url");
+        enqueue.request.name = arguments.Get("--name");
+        enqueue.request.startChapter = arguments.GetInt("--start", 1);
+        enqueue.request.endChapter = arguments.GetInt("--end", -1);
+        enqueue.author = arguments.Get("--author");
+        if (enqueue.request.source.empty() || (enqueue.request.url.empty() && enqueue.request.name.empty())) {
+            std::cout << USAGE;
+            return 2;
+        }
+
+        DownloadDaemon::Client client;
+        std::string id;
+        if (!ConnectToDaemon(client)) return 1;
+        if (!client.Add(enqueue, id)) {
+            std::cout << client.LastError() << std::endl;
+            return 1;
+        }
+        std::cout << id << std::endl;
+        return 0;
+    }
+
+    int Jobs() {
+        DownloadDaemon::Client client;
+        std::vector<DownloadDaemon::Job> jobs;
+        if (!ConnectToDaemon(client)) return 1;
+        if (!client.Status(jobs)) {
+            std::cout << client.LastError() << std::endl;
+            return 1;
+        }
+        for (const DownloadDaemon::Job& job : jobs) PrintJob(job);
+        return 0;
+    }
+
+    int Watch() {
+        DownloadDaemon::Client client;
+        if (!ConnectToDaemon(client)) return 1;
+        if (!client.Watch(PrintJob)) {
+            std::cout << client.LastError() << std::endl;
+            return 1;
+        }
+        std::cout << "The download daemon has stopped" << std::endl;
+        return 0;
+    }
+
+    int JobCommand(const std::string& command, const Arguments& arguments) {
+        if (command != "daemon-stop" && arguments.positional.size() != 1) {
+            std::cout << USAGE;
+            return 2;
+        }
+
+        DownloadDaemon::Client client;
+        if (!ConnectToDaemon(client)) return 1;
+        bool done = command == "pause" ? client.Pause(arguments.positional[0])
+            : command == "resume" ? client.Resume(arguments.positional[0])
+            : command == "cancel" ? client.Cancel(arguments.positional[0])
+            : client.Shutdown();
+        if (!done) {
+            std::cout << client.LastError() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    int first = 1;
+    if (argc > 2 && std::string(argv[1]) == "--root") {
+        std::error_code ec;
+        invocationDir = std::filesystem::current_path(ec);
+        std::filesystem::current_path(argv[2], ec);
+        if (ec) {
+            std::cout << "Could not use " << argv[2] << " as the library root: " << ec.message() << std::endl;
+            return 1;
+        }
+        first = 3;
+    }
+    if (first >= argc) {
+        std::cout << USAGE;
+        return 2;
+    }
+
+    std::string command = argv[first];
+    Arguments arguments = ParseArguments(argc, argv, first + 1);
+    if (command == "list") return List();
+    if (command == "import") return Import(arguments);
+    if (command == "export") return Export(arguments);
+    if (command == "reindex") return Reindex(arguments);
+    if (command == "verify") return Verify();
+    if (command == "update-check") return UpdateCheck();
+    if (command == "download") return Download(arguments);
+    if (command == "queue") return Queue(arguments);
+    if (command == "daemon") return Daemon();
+    if (command == "enqueue") return Enqueue(arguments);
+    if (command == "jobs") return Jobs();
+    if (command == "watch") return Watch();
+    if (command == "pause" || command == "resume" || command == "cancel" || command == "daemon-stop") {
+        return JobCommand(command, arguments);
+    }
+
+    std::cout << USAGE;
+    return 2;
+}